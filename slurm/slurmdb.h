@@ -304,10 +304,16 @@ typedef struct {
 typedef struct {
 	List acct_list;		/* list of char * */
 	List associd_list;	/* list of char */
+	uint32_t chunk_size;	/* if set, return roughly this many jobs
+				 * following the cursor, 0 for all jobs */
 	List cluster_list;	/* list of char * */
 	List constraint_list; 	/* list of char * */
 	uint32_t cpus_max;      /* number of cpus high range */
 	uint32_t cpus_min;      /* number of cpus low range */
+	char *cursor_cluster;	/* with chunk_size, cluster of the last job
+				 * already received, NULL to start */
+	uint32_t cursor_jobid;	/* with chunk_size, highest job id already
+				 * received from cursor_cluster */
 	uint32_t db_flags;      /* flags sent from the slurmctld on the job */
 	int32_t exitcode;       /* exit code of job */
 	uint32_t flags;         /* Reporting flags*/
@@ -1330,6 +1336,10 @@ typedef struct {
 } slurmdb_rpc_obj_t;
 
 typedef struct {
+	uint32_t batch_cnt;		/* DBD_SEND_MULT_MSG processed */
+	uint64_t batch_msg_cnt;		/* messages in those */
+	uint64_t batch_time;		/* total usecs processing them */
+	uint64_t batch_time_max;	/* longest one in usecs */
 	slurmdb_rollup_stats_t *dbd_rollup_stats;
 	List rollup_stats;              /* List of Clusters rollup stats */
 	List rpc_list;                  /* list of RPCs sent to the dbd. */
@@ -50,8 +50,8 @@
 #include "src/common/slurmdbd_pack.h"
 #include "src/slurmdbd/read_config.h"
 
-#define ASSOC_HASH_SIZE 1000
-#define ASSOC_HASH_ID_INX(_assoc_id)	(_assoc_id % ASSOC_HASH_SIZE)
+#define ASSOC_HASH_SIZE 1024
+#define ASSOC_HASH_ID_INX(_assoc_id)	(_assoc_id & (assoc_hash_size - 1))
 
 slurmdb_assoc_rec_t *assoc_mgr_root_assoc = NULL;
 uint32_t g_qos_max_priority = 0;
@@ -73,11 +73,132 @@ static char *assoc_mgr_cluster_name = NULL;
 static int setup_children = 0;
 static pthread_rwlock_t assoc_mgr_locks[ASSOC_MGR_ENTITY_COUNT];
 
+/*
+ * Lists are fetched from the database without holding the assoc_mgr locks,
+ * so lock holders never wait on slurmdbd. Each update to a cached list bumps
+ * its counter, which lets the fetching thread notice the update would be
+ * lost by publishing its fetched list and fetch it again. It keeps doing so
+ * without the locks for a few tries, only then it fetches under the lock.
+ */
+#define ASSOC_MGR_FETCH_RETRIES 3
+static pthread_mutex_t update_cnt_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t update_cnt[ASSOC_MGR_ENTITY_COUNT];
+
 static assoc_init_args_t init_setup;
 static slurmdb_assoc_rec_t **assoc_hash_id = NULL;
 static slurmdb_assoc_rec_t **assoc_hash = NULL;
+static uint32_t assoc_hash_size = 0;	/* power of 2 */
+static uint32_t assoc_hash_cnt = 0;
 static int *assoc_mgr_tres_old_pos = NULL;
 
+/*
+ * Open addressed index into one of the assoc_mgr lists. An index is rebuilt
+ * whenever its list changes, with the list's write lock held, so lookups
+ * done under a read lock never have to walk the list.
+ */
+typedef struct {
+	void **slot;
+	uint32_t mask;
+} rec_index_t;
+
+/* Set hash and return true if rec is to be indexed */
+typedef bool (*rec_hash_f) (void *rec, uint32_t *hash);
+
+static rec_index_t qos_id_index;
+static rec_index_t qos_name_index;
+static rec_index_t user_name_index;
+static rec_index_t user_uid_index;
+static rec_index_t wckey_id_index;
+static rec_index_t wckey_index;
+
+static uint32_t _get_update_cnt(assoc_mgr_lock_datatype_t type)
+{
+	uint32_t cnt;
+
+	slurm_mutex_lock(&update_cnt_lock);
+	cnt = update_cnt[type];
+	slurm_mutex_unlock(&update_cnt_lock);
+
+	return cnt;
+}
+
+/* Call with the write lock on type held */
+static void _inc_update_cnt(assoc_mgr_lock_datatype_t type)
+{
+	xassert(verify_assoc_lock(type, WRITE_LOCK));
+
+	slurm_mutex_lock(&update_cnt_lock);
+	update_cnt[type]++;
+	slurm_mutex_unlock(&update_cnt_lock);
+}
+
+static List _fetch_list(void *db_conn, assoc_mgr_lock_datatype_t type,
+			void *cond)
+{
+	uid_t uid = getuid();
+
+
+	switch (type) {
+	case ASSOC_LOCK:
+		return acct_storage_g_get_assocs(db_conn, uid, cond);
+	case RES_LOCK:
+		return acct_storage_g_get_res(db_conn, uid, cond);
+	case QOS_LOCK:
+		return acct_storage_g_get_qos(db_conn, uid, cond);
+	case TRES_LOCK:
+		return acct_storage_g_get_tres(db_conn, uid, cond);
+	case USER_LOCK:
+		return acct_storage_g_get_users(db_conn, uid, cond);
+	case WCKEY_LOCK:
+		return acct_storage_g_get_wckeys(db_conn, uid, cond);
+	default:
+		error("%s: unknown list type %d", __func__, type);
+		return NULL;
+	}
+}
+
+/*
+ * Fetch the list of type without any assoc_mgr lock held, fetching again
+ * while it gets updated under us. Gives up after ASSOC_MGR_FETCH_RETRIES
+ * tries, leaving _fetch_list_locked() to fetch under the lock.
+ * OUT cnt - update counter the returned list was fetched at
+ */
+static List _fetch_list_unlocked(void *db_conn, assoc_mgr_lock_datatype_t type,
+				 void *cond, uint32_t *cnt)
+{
+	List list;
+	int tries = 0;
+
+	*cnt = _get_update_cnt(type);
+	while ((list = _fetch_list(db_conn, type, cond))) {
+		if ((*cnt == _get_update_cnt(type)) ||
+		    (++tries >= ASSOC_MGR_FETCH_RETRIES))
+			break;
+		FREE_NULL_LIST(list);
+		*cnt = _get_update_cnt(type);
+	}
+
+	return list;
+}
+
+/*
+ * Call with the write lock on type held. Returns list if it is still current,
+ * else fetches it again, which can only happen when _fetch_list_unlocked()
+ * ran out of tries or the list was updated before we got the lock.
+ */
+static List _fetch_list_locked(void *db_conn, assoc_mgr_lock_datatype_t type,
+			       void *cond, uint32_t cnt, List list)
+{
+	xassert(verify_assoc_lock(type, WRITE_LOCK));
+
+	if (list && (cnt != update_cnt[type])) {
+		FREE_NULL_LIST(list);
+		list = _fetch_list(db_conn, type, cond);
+	}
+
+	return list;
+}
+
 static bool _running_cache(void)
 {
 	if (init_setup.running_cache && *init_setup.running_cache)
@@ -86,59 +207,62 @@ static bool _running_cache(void)
 	return false;
 }
 
-static int _get_str_inx(char *name)
+/* Final mix of MurmurHash3, spreads every input bit over the whole hash */
+static uint32_t _hash_mix(uint32_t hash)
 {
-	int j, index = 0;
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6b;
+	hash ^= hash >> 13;
+	hash *= 0xc2b2ae35;
+	hash ^= hash >> 16;
 
+	return hash;
+}
+
+/*
+ * Continue hash over name with FNV-1a. Names are compared with
+ * xstrcasecmp() so case is ignored here as well.
+ */
+static uint32_t _hash_str(uint32_t hash, const char *name)
+{
 	if (!name)
-		return 0;
+		return hash;
 
-	for (j = 1; *name; name++, j++)
-		index += (int)tolower(*name) * j;
+	for (; *name; name++) {
+		hash ^= (uint32_t) tolower((unsigned char) *name);
+		hash *= 16777619;
+	}
+	/* Keep "ab" + "c" apart from "a" + "bc" */
+	hash ^= 0xff;
+	hash *= 16777619;
 
-	return index;
+	return hash;
 }
 
-static int _assoc_hash_index(slurmdb_assoc_rec_t *assoc)
+static uint32_t _assoc_hash_index(slurmdb_assoc_rec_t *assoc)
 {
-	int index;
+	uint32_t hash;
 
 	xassert(assoc);
 
-	/* Multiply each character by its numerical position in the
-	 * name string to add a bit of entropy.
-	 */
-
-	index = assoc->uid;
+	hash = _hash_mix(assoc->uid);
 
 	/* only set on the slurmdbd */
 	if (!assoc_mgr_cluster_name && assoc->cluster)
-		index += _get_str_inx(assoc->cluster);
+		hash = _hash_str(hash, assoc->cluster);
 
 	if (assoc->acct)
-		index += _get_str_inx(assoc->acct);
+		hash = _hash_str(hash, assoc->acct);
 
 	if (assoc->partition)
-		index += _get_str_inx(assoc->partition);
-
-	index %= ASSOC_HASH_SIZE;
-	if (index < 0)
-		index += ASSOC_HASH_SIZE;
-
-	return index;
+		hash = _hash_str(hash, assoc->partition);
 
+	return _hash_mix(hash) & (assoc_hash_size - 1);
 }
 
-static void _add_assoc_hash(slurmdb_assoc_rec_t *assoc)
+static void _link_assoc_hash(slurmdb_assoc_rec_t *assoc)
 {
-	int inx = ASSOC_HASH_ID_INX(assoc->id);
-
-	if (!assoc_hash_id)
-		assoc_hash_id = xcalloc(ASSOC_HASH_SIZE,
-					sizeof(slurmdb_assoc_rec_t *));
-	if (!assoc_hash)
-		assoc_hash = xcalloc(ASSOC_HASH_SIZE,
-				     sizeof(slurmdb_assoc_rec_t *));
+	uint32_t inx = ASSOC_HASH_ID_INX(assoc->id);
 
 	assoc->assoc_next_id = assoc_hash_id[inx];
 	assoc_hash_id[inx] = assoc;
@@ -148,6 +272,265 @@ static void _add_assoc_hash(slurmdb_assoc_rec_t *assoc)
 	assoc_hash[inx] = assoc;
 }
 
+/* Size the hash tables to keep the chains short for cnt associations */
+static void _alloc_assoc_hash(uint32_t cnt)
+{
+	slurmdb_assoc_rec_t **old_hash_id = assoc_hash_id;
+	slurmdb_assoc_rec_t *assoc, *next;
+	uint32_t i, old_size = assoc_hash_size;
+
+	assoc_hash_size = ASSOC_HASH_SIZE;
+	while (assoc_hash_size < cnt)
+		assoc_hash_size <<= 1;
+
+	assoc_hash_id = xcalloc(assoc_hash_size,
+				sizeof(slurmdb_assoc_rec_t *));
+	xfree(assoc_hash);
+	assoc_hash = xcalloc(assoc_hash_size, sizeof(slurmdb_assoc_rec_t *));
+
+	/* Every association is on exactly one of the id chains */
+	for (i = 0; i < old_size; i++) {
+		for (assoc = old_hash_id[i]; assoc; assoc = next) {
+			next = assoc->assoc_next_id;
+			_link_assoc_hash(assoc);
+		}
+	}
+	xfree(old_hash_id);
+}
+
+static void _free_assoc_hash(void)
+{
+	xfree(assoc_hash_id);
+	xfree(assoc_hash);
+	assoc_hash_size = 0;
+	assoc_hash_cnt = 0;
+}
+
+static void _add_assoc_hash(slurmdb_assoc_rec_t *assoc)
+{
+	if (!assoc_hash_id)
+		_alloc_assoc_hash(assoc_mgr_assoc_list ?
+				  list_count(assoc_mgr_assoc_list) : 0);
+	else if (assoc_hash_cnt >= (assoc_hash_size * 2))
+		_alloc_assoc_hash(assoc_hash_size * 4);
+
+	_link_assoc_hash(assoc);
+	assoc_hash_cnt++;
+}
+
+static void _index_free(rec_index_t *index)
+{
+	xfree(index->slot);
+	index->mask = 0;
+}
+
+/*
+ * Build index over the records of list, records hash skips are left out.
+ * Records sharing a key are found in list order.
+ */
+static void _index_build(rec_index_t *index, List list, rec_hash_f hash)
+{
+	ListIterator itr;
+	void *rec;
+	uint32_t size = 16, inx;
+
+	_index_free(index);
+	if (!list)
+		return;
+
+	/* Keep the table at most half full so probe runs stay short */
+	while (size < (list_count(list) * 2))
+		size <<= 1;
+	index->slot = xcalloc(size, sizeof(void *));
+	index->mask = size - 1;
+
+	itr = list_iterator_create(list);
+	while ((rec = list_next(itr))) {
+		if (!(hash)(rec, &inx))
+			continue;
+		for (inx &= index->mask; index->slot[inx];
+		     inx = (inx + 1) & index->mask)
+			;
+		index->slot[inx] = rec;
+	}
+	list_iterator_destroy(itr);
+}
+
+static void *_index_find(rec_index_t *index, uint32_t hash,
+			 ListFindF match, void *key)
+{
+	uint32_t inx;
+
+	if (!index->slot)
+		return NULL;
+
+	for (inx = hash & index->mask; index->slot[inx];
+	     inx = (inx + 1) & index->mask) {
+		if ((match)(index->slot[inx], key))
+			return index->slot[inx];
+	}
+
+	return NULL;
+}
+
+static bool _hash_qos_id(void *rec, uint32_t *hash)
+{
+	*hash = _hash_mix(((slurmdb_qos_rec_t *) rec)->id);
+	return true;
+}
+
+static bool _hash_qos_name(void *rec, uint32_t *hash)
+{
+	slurmdb_qos_rec_t *qos = rec;
+
+	if (!qos->name)
+		return false;
+	*hash = _hash_mix(_hash_str(0, qos->name));
+	return true;
+}
+
+static int _match_qos_id(void *x, void *key)
+{
+	return (((slurmdb_qos_rec_t *) x)->id == *(uint32_t *) key);
+}
+
+static int _match_qos_name(void *x, void *key)
+{
+	return !xstrcasecmp(((slurmdb_qos_rec_t *) x)->name, key);
+}
+
+/* Call with QOS write lock whenever assoc_mgr_qos_list changes */
+static void _build_qos_index(void)
+{
+	xassert(verify_assoc_lock(QOS_LOCK, WRITE_LOCK));
+
+	_index_build(&qos_id_index, assoc_mgr_qos_list, _hash_qos_id);
+	_index_build(&qos_name_index, assoc_mgr_qos_list, _hash_qos_name);
+}
+
+static slurmdb_qos_rec_t *_find_qos_id(uint32_t id)
+{
+	return _index_find(&qos_id_index, _hash_mix(id), _match_qos_id, &id);
+}
+
+static slurmdb_qos_rec_t *_find_qos_name(char *name)
+{
+	return _index_find(&qos_name_index, _hash_mix(_hash_str(0, name)),
+			   _match_qos_name, name);
+}
+
+static bool _hash_user_uid(void *rec, uint32_t *hash)
+{
+	slurmdb_user_rec_t *user = rec;
+
+	if (user->uid == NO_VAL)
+		return false;
+	*hash = _hash_mix(user->uid);
+	return true;
+}
+
+static bool _hash_user_name(void *rec, uint32_t *hash)
+{
+	slurmdb_user_rec_t *user = rec;
+
+	if (!user->name)
+		return false;
+	*hash = _hash_mix(_hash_str(0, user->name));
+	return true;
+}
+
+static int _match_user_uid(void *x, void *key)
+{
+	return (((slurmdb_user_rec_t *) x)->uid == *(uint32_t *) key);
+}
+
+static int _match_user_name(void *x, void *key)
+{
+	return !xstrcasecmp(((slurmdb_user_rec_t *) x)->name, key);
+}
+
+/* Call with user write lock whenever assoc_mgr_user_list changes */
+static void _build_user_index(void)
+{
+	xassert(verify_assoc_lock(USER_LOCK, WRITE_LOCK));
+
+	_index_build(&user_uid_index, assoc_mgr_user_list, _hash_user_uid);
+	_index_build(&user_name_index, assoc_mgr_user_list, _hash_user_name);
+}
+
+static slurmdb_user_rec_t *_find_user_uid(uint32_t uid)
+{
+	if (uid == NO_VAL)
+		return NULL;
+	return _index_find(&user_uid_index, _hash_mix(uid),
+			   _match_user_uid, &uid);
+}
+
+static slurmdb_user_rec_t *_find_user_name(char *name)
+{
+	return _index_find(&user_name_index, _hash_mix(_hash_str(0, name)),
+			   _match_user_name, name);
+}
+
+/* wckeys are looked up by name and uid, and cluster on the slurmdbd */
+static uint32_t _wckey_hash(char *name, uint32_t uid, char *cluster)
+{
+	uint32_t hash = _hash_str(_hash_mix(uid), name);
+
+	if (!assoc_mgr_cluster_name)
+		hash = _hash_str(hash, cluster);
+
+	return _hash_mix(hash);
+}
+
+static bool _hash_wckey_id(void *rec, uint32_t *hash)
+{
+	*hash = _hash_mix(((slurmdb_wckey_rec_t *) rec)->id);
+	return true;
+}
+
+static bool _hash_wckey(void *rec, uint32_t *hash)
+{
+	slurmdb_wckey_rec_t *wckey = rec;
+
+	if (!wckey->name || (wckey->uid == NO_VAL))
+		return false;
+	*hash = _wckey_hash(wckey->name, wckey->uid, wckey->cluster);
+	return true;
+}
+
+static int _match_wckey_id(void *x, void *key)
+{
+	slurmdb_wckey_rec_t *wckey = x, *want = key;
+
+	if (!assoc_mgr_cluster_name &&
+	    xstrcasecmp(want->cluster, wckey->cluster))
+		return 0;
+
+	return (want->id == wckey->id);
+}
+
+static int _match_wckey(void *x, void *key)
+{
+	slurmdb_wckey_rec_t *wckey = x, *want = key;
+
+	if (!assoc_mgr_cluster_name &&
+	    xstrcasecmp(want->cluster, wckey->cluster))
+		return 0;
+
+	return ((want->uid == wckey->uid) &&
+		!xstrcasecmp(want->name, wckey->name));
+}
+
+/* Call with wckey write lock whenever assoc_mgr_wckey_list changes */
+static void _build_wckey_index(void)
+{
+	xassert(verify_assoc_lock(WCKEY_LOCK, WRITE_LOCK));
+
+	_index_build(&wckey_id_index, assoc_mgr_wckey_list, _hash_wckey_id);
+	_index_build(&wckey_index, assoc_mgr_wckey_list, _hash_wckey);
+}
+
 static bool _remove_from_assoc_list(slurmdb_assoc_rec_t *assoc)
 {
 	slurmdb_assoc_rec_t *assoc_ptr;
@@ -317,6 +700,8 @@ static void _delete_assoc_hash(slurmdb_assoc_rec_t *assoc)
 		return;	/* Fix CLANG false positive error */
 	} else
 		*assoc_pptr = assoc_ptr->assoc_next;
+
+	assoc_hash_cnt--;
 }
 
 
@@ -668,12 +1053,9 @@ static void _set_user_default_acct(slurmdb_assoc_rec_t *assoc)
 
 	/* set up the default if this is it */
 	if ((assoc->is_def == 1) && (assoc->uid != NO_VAL)) {
-		slurmdb_user_rec_t *user = NULL;
-		ListIterator user_itr =
-			list_iterator_create(assoc_mgr_user_list);
-		while ((user = list_next(user_itr))) {
-			if (user->uid != assoc->uid)
-				continue;
+		slurmdb_user_rec_t *user = _find_user_uid(assoc->uid);
+
+		if (user) {
 			if (!user->default_acct
 			    || xstrcmp(user->default_acct, assoc->acct)) {
 				xfree(user->default_acct);
@@ -683,9 +1065,7 @@ static void _set_user_default_acct(slurmdb_assoc_rec_t *assoc)
 			}
 			/* cache user rec reference for backfill*/
 			assoc->user_rec = user;
-			break;
 		}
-		list_iterator_destroy(user_itr);
 	}
 }
 
@@ -698,22 +1078,15 @@ static void _set_user_default_wckey(slurmdb_wckey_rec_t *wckey)
 
 	/* set up the default if this is it */
 	if ((wckey->is_def == 1) && (wckey->uid != NO_VAL)) {
-		slurmdb_user_rec_t *user = NULL;
-		ListIterator user_itr =
-			list_iterator_create(assoc_mgr_user_list);
-		while ((user = list_next(user_itr))) {
-			if (user->uid != wckey->uid)
-				continue;
-			if (!user->default_wckey
-			    || xstrcmp(user->default_wckey, wckey->name)) {
-				xfree(user->default_wckey);
-				user->default_wckey = xstrdup(wckey->name);
-				debug2("user %s default wckey is %s",
-				       user->name, user->default_wckey);
-			}
-			break;
+		slurmdb_user_rec_t *user = _find_user_uid(wckey->uid);
+
+		if (user && (!user->default_wckey
+			     || xstrcmp(user->default_wckey, wckey->name))) {
+			xfree(user->default_wckey);
+			user->default_wckey = xstrdup(wckey->name);
+			debug2("user %s default wckey is %s",
+			       user->name, user->default_wckey);
 		}
-		list_iterator_destroy(user_itr);
 	}
 }
 
@@ -1003,8 +1376,7 @@ static int _post_assoc_list(void)
 	if (!assoc_mgr_assoc_list)
 		return SLURM_ERROR;
 
-	xfree(assoc_hash_id);
-	xfree(assoc_hash);
+	_free_assoc_hash();
 
 	itr = list_iterator_create(assoc_mgr_assoc_list);
 
@@ -1474,25 +1846,27 @@ extern int assoc_mgr_post_tres_list(List new_list)
 static int _get_assoc_mgr_tres_list(void *db_conn, int enforce)
 {
 	slurmdb_tres_cond_t tres_q;
-	uid_t uid = getuid();
 	List new_list = NULL;
 	char *tres_req_str;
 	int changed;
+	uint32_t cnt;
 	assoc_mgr_lock_t locks =
 		{ .assoc = WRITE_LOCK, .qos = WRITE_LOCK, .tres= WRITE_LOCK };
 
 	memset(&tres_q, 0, sizeof(slurmdb_tres_cond_t));
 
-	assoc_mgr_lock(&locks);
-
 	/* If this exists we only want/care about tracking/caching these TRES */
 	if ((tres_req_str = slurm_get_accounting_storage_tres())) {
 		tres_q.type_list = list_create(xfree_ptr);
 		slurm_addto_char_list(tres_q.type_list, tres_req_str);
 		xfree(tres_req_str);
 	}
-	new_list = acct_storage_g_get_tres(
-		db_conn, uid, &tres_q);
+
+	new_list = _fetch_list_unlocked(db_conn, TRES_LOCK, &tres_q, &cnt);
+
+	assoc_mgr_lock(&locks);
+	new_list = _fetch_list_locked(db_conn, TRES_LOCK, &tres_q, cnt,
+				      new_list);
 
 	FREE_NULL_LIST(tres_q.type_list);
 
@@ -1523,14 +1897,12 @@ static int _get_assoc_mgr_tres_list(void *db_conn, int enforce)
 static int _get_assoc_mgr_assoc_list(void *db_conn, int enforce)
 {
 	slurmdb_assoc_cond_t assoc_q;
-	uid_t uid = getuid();
 	assoc_mgr_lock_t locks = { .assoc = WRITE_LOCK, .qos = READ_LOCK,
 				   .tres = READ_LOCK, .user = WRITE_LOCK };
+	List new_list;
+	uint32_t cnt;
 
 //	DEF_TIMERS;
-	assoc_mgr_lock(&locks);
-	FREE_NULL_LIST(assoc_mgr_assoc_list);
-
 	memset(&assoc_q, 0, sizeof(slurmdb_assoc_cond_t));
 	if (assoc_mgr_cluster_name) {
 		assoc_q.cluster_list = list_create(NULL);
@@ -1542,12 +1914,17 @@ static int _get_assoc_mgr_assoc_list(void *db_conn, int enforce)
 	}
 
 //	START_TIMER;
-	assoc_mgr_assoc_list =
-		acct_storage_g_get_assocs(db_conn, uid, &assoc_q);
+	new_list = _fetch_list_unlocked(db_conn, ASSOC_LOCK, &assoc_q, &cnt);
 //	END_TIMER2("get_assocs");
 
+	assoc_mgr_lock(&locks);
+	new_list = _fetch_list_locked(db_conn, ASSOC_LOCK, &assoc_q, cnt,
+				      new_list);
 	FREE_NULL_LIST(assoc_q.cluster_list);
 
+	FREE_NULL_LIST(assoc_mgr_assoc_list);
+	assoc_mgr_assoc_list = new_list;
+
 	if (!assoc_mgr_assoc_list) {
 		/* create list so we don't keep calling this if there
 		   isn't anything there */
@@ -1575,11 +1952,9 @@ static int _get_assoc_mgr_assoc_list(void *db_conn, int enforce)
 static int _get_assoc_mgr_res_list(void *db_conn, int enforce)
 {
 	slurmdb_res_cond_t res_q;
-	uid_t uid = getuid();
 	assoc_mgr_lock_t locks = { .res = WRITE_LOCK };
-
-	assoc_mgr_lock(&locks);
-	FREE_NULL_LIST(assoc_mgr_res_list);
+	List new_list;
+	uint32_t cnt;
 
 	slurmdb_init_res_cond(&res_q, 0);
 	if (assoc_mgr_cluster_name) {
@@ -1592,10 +1967,15 @@ static int _get_assoc_mgr_res_list(void *db_conn, int enforce)
 		      "all associations.");
 	}
 
-	assoc_mgr_res_list = acct_storage_g_get_res(db_conn, uid, &res_q);
+	new_list = _fetch_list_unlocked(db_conn, RES_LOCK, &res_q, &cnt);
 
+	assoc_mgr_lock(&locks);
+	new_list = _fetch_list_locked(db_conn, RES_LOCK, &res_q, cnt, new_list);
 	FREE_NULL_LIST(res_q.cluster_list);
 
+	FREE_NULL_LIST(assoc_mgr_res_list);
+	assoc_mgr_res_list = new_list;
+
 	if (!assoc_mgr_res_list) {
 		assoc_mgr_unlock(&locks);
 		if (enforce & ACCOUNTING_ENFORCE_ASSOCS) {
@@ -1615,11 +1995,11 @@ static int _get_assoc_mgr_res_list(void *db_conn, int enforce)
 
 static int _get_assoc_mgr_qos_list(void *db_conn, int enforce)
 {
-	uid_t uid = getuid();
 	List new_list = NULL;
 	assoc_mgr_lock_t locks = { .qos = WRITE_LOCK };
+	uint32_t cnt;
 
-	new_list = acct_storage_g_get_qos(db_conn, uid, NULL);
+	new_list = _fetch_list_unlocked(db_conn, QOS_LOCK, NULL, &cnt);
 
 	if (!new_list) {
 		if (enforce & ACCOUNTING_ENFORCE_ASSOCS) {
@@ -1631,12 +2011,22 @@ static int _get_assoc_mgr_qos_list(void *db_conn, int enforce)
 	}
 
 	assoc_mgr_lock(&locks);
+	if (cnt != update_cnt[QOS_LOCK]) {
+		FREE_NULL_LIST(new_list);
+		if (!(new_list = _fetch_list(db_conn, QOS_LOCK, NULL))) {
+			assoc_mgr_unlock(&locks);
+			error("_get_assoc_mgr_qos_list: no list was made.");
+			return (enforce & ACCOUNTING_ENFORCE_ASSOCS) ?
+				SLURM_ERROR : SLURM_SUCCESS;
+		}
+	}
 
 	FREE_NULL_LIST(assoc_mgr_qos_list);
 	assoc_mgr_qos_list = new_list;
 	new_list = NULL;
 
 	_post_qos_list(assoc_mgr_qos_list);
+	_build_qos_index();
 
 	assoc_mgr_unlock(&locks);
 
@@ -1646,15 +2036,23 @@ static int _get_assoc_mgr_qos_list(void *db_conn, int enforce)
 static int _get_assoc_mgr_user_list(void *db_conn, int enforce)
 {
 	slurmdb_user_cond_t user_q;
-	uid_t uid = getuid();
 	assoc_mgr_lock_t locks = { .user = WRITE_LOCK };
+	List new_list;
+	uint32_t cnt;
 
 	memset(&user_q, 0, sizeof(slurmdb_user_cond_t));
 	user_q.with_coords = 1;
 
+	new_list = _fetch_list_unlocked(db_conn, USER_LOCK, &user_q, &cnt);
+
 	assoc_mgr_lock(&locks);
+	new_list = _fetch_list_locked(db_conn, USER_LOCK, &user_q, cnt,
+				      new_list);
 	FREE_NULL_LIST(assoc_mgr_user_list);
-	assoc_mgr_user_list = acct_storage_g_get_users(db_conn, uid, &user_q);
+	assoc_mgr_user_list = new_list;
+	if (assoc_mgr_user_list)
+		_post_user_list(assoc_mgr_user_list);
+	_build_user_index();
 
 	if (!assoc_mgr_user_list) {
 		assoc_mgr_unlock(&locks);
@@ -1667,8 +2065,6 @@ static int _get_assoc_mgr_user_list(void *db_conn, int enforce)
 		}
 	}
 
-	_post_user_list(assoc_mgr_user_list);
-
 	assoc_mgr_unlock(&locks);
 	return SLURM_SUCCESS;
 }
@@ -1677,13 +2073,11 @@ static int _get_assoc_mgr_user_list(void *db_conn, int enforce)
 static int _get_assoc_mgr_wckey_list(void *db_conn, int enforce)
 {
 	slurmdb_wckey_cond_t wckey_q;
-	uid_t uid = getuid();
 	assoc_mgr_lock_t locks = { .user = WRITE_LOCK, .wckey = WRITE_LOCK };
+	List new_list;
+	uint32_t cnt;
 
 //	DEF_TIMERS;
-	assoc_mgr_lock(&locks);
-	FREE_NULL_LIST(assoc_mgr_wckey_list);
-
 	memset(&wckey_q, 0, sizeof(slurmdb_wckey_cond_t));
 	if (assoc_mgr_cluster_name) {
 		wckey_q.cluster_list = list_create(NULL);
@@ -1695,16 +2089,22 @@ static int _get_assoc_mgr_wckey_list(void *db_conn, int enforce)
 	}
 
 //	START_TIMER;
-	assoc_mgr_wckey_list =
-		acct_storage_g_get_wckeys(db_conn, uid, &wckey_q);
+	new_list = _fetch_list_unlocked(db_conn, WCKEY_LOCK, &wckey_q, &cnt);
 //	END_TIMER2("get_wckeys");
 
+	assoc_mgr_lock(&locks);
+	new_list = _fetch_list_locked(db_conn, WCKEY_LOCK, &wckey_q, cnt,
+				      new_list);
 	FREE_NULL_LIST(wckey_q.cluster_list);
 
+	FREE_NULL_LIST(assoc_mgr_wckey_list);
+	assoc_mgr_wckey_list = new_list;
+
 	if (!assoc_mgr_wckey_list) {
 		/* create list so we don't keep calling this if there
 		   isn't anything there */
 		assoc_mgr_wckey_list = list_create(slurmdb_destroy_wckey_rec);
+		_build_wckey_index();
 		assoc_mgr_unlock(&locks);
 		if (enforce & ACCOUNTING_ENFORCE_WCKEYS) {
 			error("_get_assoc_mgr_wckey_list: "
@@ -1718,6 +2118,7 @@ static int _get_assoc_mgr_wckey_list(void *db_conn, int enforce)
 	}
 
 	_post_wckey_list(assoc_mgr_wckey_list);
+	_build_wckey_index();
 
 	assoc_mgr_unlock(&locks);
 
@@ -1738,8 +2139,8 @@ static int _refresh_assoc_mgr_tres_list(void *db_conn, int enforce)
 static int _refresh_assoc_mgr_assoc_list(void *db_conn, int enforce)
 {
 	slurmdb_assoc_cond_t assoc_q;
-	List current_assocs = NULL;
-	uid_t uid = getuid();
+	List current_assocs = NULL, new_list;
+	uint32_t cnt;
 	ListIterator curr_itr = NULL;
 	slurmdb_assoc_rec_t *curr_assoc = NULL, *assoc = NULL;
 	assoc_mgr_lock_t locks = { .assoc = WRITE_LOCK, .qos = READ_LOCK,
@@ -1756,19 +2157,16 @@ static int _refresh_assoc_mgr_assoc_list(void *db_conn, int enforce)
 		      "all associations.");
 	}
 
-	assoc_mgr_lock(&locks);
-
-	current_assocs = assoc_mgr_assoc_list;
-
 //	START_TIMER;
-	assoc_mgr_assoc_list =
-		acct_storage_g_get_assocs(db_conn, uid, &assoc_q);
+	new_list = _fetch_list_unlocked(db_conn, ASSOC_LOCK, &assoc_q, &cnt);
 //	END_TIMER2("get_assocs");
 
+	assoc_mgr_lock(&locks);
+	new_list = _fetch_list_locked(db_conn, ASSOC_LOCK, &assoc_q, cnt,
+				      new_list);
 	FREE_NULL_LIST(assoc_q.cluster_list);
 
-	if (!assoc_mgr_assoc_list) {
-		assoc_mgr_assoc_list = current_assocs;
+	if (!new_list) {
 		assoc_mgr_unlock(&locks);
 
 		error("_refresh_assoc_mgr_assoc_list: "
@@ -1776,6 +2174,9 @@ static int _refresh_assoc_mgr_assoc_list(void *db_conn, int enforce)
 		return SLURM_ERROR;
 	}
 
+	current_assocs = assoc_mgr_assoc_list;
+	assoc_mgr_assoc_list = new_list;
+
 	_post_assoc_list();
 
 	if (!current_assocs) {
@@ -1818,8 +2219,8 @@ static int _refresh_assoc_mgr_res_list(void *db_conn, int enforce)
 {
 	slurmdb_res_cond_t res_q;
 	List current_res = NULL;
-	uid_t uid = getuid();
 	assoc_mgr_lock_t locks = { .res = WRITE_LOCK };
+	uint32_t cnt;
 
 	slurmdb_init_res_cond(&res_q, 0);
 	if (assoc_mgr_cluster_name) {
@@ -1832,18 +2233,21 @@ static int _refresh_assoc_mgr_res_list(void *db_conn, int enforce)
 		      "all associations.");
 	}
 
-	current_res = acct_storage_g_get_res(db_conn, uid, &res_q);
+	current_res = _fetch_list_unlocked(db_conn, RES_LOCK, &res_q, &cnt);
+
+	assoc_mgr_lock(&locks);
+	current_res = _fetch_list_locked(db_conn, RES_LOCK, &res_q, cnt,
+					 current_res);
 
 	FREE_NULL_LIST(res_q.cluster_list);
 
 	if (!current_res) {
+		assoc_mgr_unlock(&locks);
 		error("_refresh_assoc_mgr_res_list: "
 		      "no new list given back keeping cached one.");
 		return SLURM_ERROR;
 	}
 
-	assoc_mgr_lock(&locks);
-
 	_post_res_list(current_res);
 
 	FREE_NULL_LIST(assoc_mgr_res_list);
@@ -1861,19 +2265,22 @@ static int _refresh_assoc_mgr_res_list(void *db_conn, int enforce)
 static int _refresh_assoc_mgr_qos_list(void *db_conn, int enforce)
 {
 	List current_qos = NULL;
-	uid_t uid = getuid();
 	assoc_mgr_lock_t locks = { .qos = WRITE_LOCK };
+	uint32_t cnt;
 
-	current_qos = acct_storage_g_get_qos(db_conn, uid, NULL);
+	current_qos = _fetch_list_unlocked(db_conn, QOS_LOCK, NULL, &cnt);
+
+	assoc_mgr_lock(&locks);
+	current_qos = _fetch_list_locked(db_conn, QOS_LOCK, NULL, cnt,
+					 current_qos);
 
 	if (!current_qos) {
+		assoc_mgr_unlock(&locks);
 		error("_refresh_assoc_mgr_qos_list: "
 		      "no new list given back keeping cached one.");
 		return SLURM_ERROR;
 	}
 
-	assoc_mgr_lock(&locks);
-
 	_post_qos_list(current_qos);
 
 	/* move usage from old list over to the new one */
@@ -1882,9 +2289,7 @@ static int _refresh_assoc_mgr_qos_list(void *db_conn, int enforce)
 		ListIterator itr = list_iterator_create(current_qos);
 
 		while ((curr_qos = list_next(itr))) {
-			if (!(qos_rec = list_find_first(assoc_mgr_qos_list,
-							slurmdb_find_qos_in_list,
-							&curr_qos->id)))
+			if (!(qos_rec = _find_qos_id(curr_qos->id)))
 				continue;
 			slurmdb_destroy_qos_usage(curr_qos->usage);
 			curr_qos->usage = qos_rec->usage;
@@ -1895,6 +2300,7 @@ static int _refresh_assoc_mgr_qos_list(void *db_conn, int enforce)
 	}
 
 	assoc_mgr_qos_list = current_qos;
+	_build_qos_index();
 
 	assoc_mgr_unlock(&locks);
 
@@ -1908,13 +2314,13 @@ static int _refresh_assoc_mgr_user_list(void *db_conn, int enforce)
 {
 	List current_users = NULL;
 	slurmdb_user_cond_t user_q;
-	uid_t uid = getuid();
 	assoc_mgr_lock_t locks = { .user = WRITE_LOCK };
+	uint32_t cnt;
 
 	memset(&user_q, 0, sizeof(slurmdb_user_cond_t));
 	user_q.with_coords = 1;
 
-	current_users = acct_storage_g_get_users(db_conn, uid, &user_q);
+	current_users = _fetch_list_unlocked(db_conn, USER_LOCK, &user_q, &cnt);
 
 	if (!current_users) {
 		error("_refresh_assoc_mgr_user_list: "
@@ -1924,10 +2330,22 @@ static int _refresh_assoc_mgr_user_list(void *db_conn, int enforce)
 	_post_user_list(current_users);
 
 	assoc_mgr_lock(&locks);
+	if (cnt != update_cnt[USER_LOCK]) {
+		FREE_NULL_LIST(current_users);
+		current_users = _fetch_list(db_conn, USER_LOCK, &user_q);
+		if (!current_users) {
+			assoc_mgr_unlock(&locks);
+			error("_refresh_assoc_mgr_user_list: "
+			      "no new list given back keeping cached one.");
+			return SLURM_ERROR;
+		}
+		_post_user_list(current_users);
+	}
 
 	FREE_NULL_LIST(assoc_mgr_user_list);
 
 	assoc_mgr_user_list = current_users;
+	_build_user_index();
 
 	assoc_mgr_unlock(&locks);
 
@@ -1941,8 +2359,8 @@ static int _refresh_assoc_wckey_list(void *db_conn, int enforce)
 {
 	slurmdb_wckey_cond_t wckey_q;
 	List current_wckeys = NULL;
-	uid_t uid = getuid();
 	assoc_mgr_lock_t locks = { .user = WRITE_LOCK, .wckey = WRITE_LOCK };
+	uint32_t cnt;
 
 	memset(&wckey_q, 0, sizeof(slurmdb_wckey_cond_t));
 	if (assoc_mgr_cluster_name) {
@@ -1954,22 +2372,29 @@ static int _refresh_assoc_wckey_list(void *db_conn, int enforce)
 		      "all wckeys.");
 	}
 
-	current_wckeys = acct_storage_g_get_wckeys(db_conn, uid, &wckey_q);
+	current_wckeys = _fetch_list_unlocked(db_conn, WCKEY_LOCK, &wckey_q,
+					      &cnt);
+
+	assoc_mgr_lock(&locks);
+	current_wckeys = _fetch_list_locked(db_conn, WCKEY_LOCK, &wckey_q, cnt,
+					    current_wckeys);
 
 	FREE_NULL_LIST(wckey_q.cluster_list);
 
 	if (!current_wckeys) {
+		assoc_mgr_unlock(&locks);
 		error("_refresh_assoc_wckey_list: "
 		      "no new list given back keeping cached one.");
 		return SLURM_ERROR;
 	}
 
+	/* This looks up users in the user index, so needs the lock */
 	_post_wckey_list(current_wckeys);
 
-	assoc_mgr_lock(&locks);
 	FREE_NULL_LIST(assoc_mgr_wckey_list);
 
 	assoc_mgr_wckey_list = current_wckeys;
+	_build_wckey_index();
 	assoc_mgr_unlock(&locks);
 
 	return SLURM_SUCCESS;
@@ -2101,8 +2526,13 @@ extern int assoc_mgr_fini(bool save_state)
 	if (_running_cache())
 		*init_setup.running_cache = 0;
 
-	xfree(assoc_hash_id);
-	xfree(assoc_hash);
+	_free_assoc_hash();
+	_index_free(&qos_id_index);
+	_index_free(&qos_name_index);
+	_index_free(&user_name_index);
+	_index_free(&user_uid_index);
+	_index_free(&wckey_id_index);
+	_index_free(&wckey_index);
 
 	assoc_mgr_unlock(&locks);
 
@@ -2605,7 +3035,6 @@ extern int assoc_mgr_fill_in_user(void *db_conn, slurmdb_user_rec_t *user,
 				  slurmdb_user_rec_t **user_pptr,
 				  bool locked)
 {
-	ListIterator itr = NULL;
 	slurmdb_user_rec_t * found_user = NULL;
 	assoc_mgr_lock_t locks = { .user = READ_LOCK };
 
@@ -2627,16 +3056,10 @@ extern int assoc_mgr_fill_in_user(void *db_conn, slurmdb_user_rec_t *user,
 		return SLURM_SUCCESS;
 	}
 
-	itr = list_iterator_create(assoc_mgr_user_list);
-	while ((found_user = list_next(itr))) {
-		if (user->uid != NO_VAL) {
-			if (user->uid == found_user->uid)
-				break;
-		} else if (user->name
-			   && !xstrcasecmp(user->name, found_user->name))
-			break;
-	}
-	list_iterator_destroy(itr);
+	if (user->uid != NO_VAL)
+		found_user = _find_user_uid(user->uid);
+	else if (user->name)
+		found_user = _find_user_name(user->name);
 
 	if (!found_user) {
 		if (!locked)
@@ -2682,7 +3105,6 @@ extern int assoc_mgr_fill_in_qos(void *db_conn, slurmdb_qos_rec_t *qos,
 				 int enforce,
 				 slurmdb_qos_rec_t **qos_pptr, bool locked)
 {
-	ListIterator itr = NULL;
 	slurmdb_qos_rec_t * found_qos = NULL;
 	assoc_mgr_lock_t locks = { .qos = READ_LOCK };
 
@@ -2717,14 +3139,8 @@ extern int assoc_mgr_fill_in_qos(void *db_conn, slurmdb_qos_rec_t *qos,
 		return SLURM_SUCCESS;
 	}
 
-	itr = list_iterator_create(assoc_mgr_qos_list);
-	while ((found_qos = list_next(itr))) {
-		if (qos->id == found_qos->id)
-			break;
-		else if (qos->name && !xstrcasecmp(qos->name, found_qos->name))
-			break;
-	}
-	list_iterator_destroy(itr);
+	if (!(found_qos = _find_qos_id(qos->id)) && qos->name)
+		found_qos = _find_qos_name(qos->name);
 
 	if (!found_qos) {
 		if (!locked)
@@ -2915,54 +3331,58 @@ extern int assoc_mgr_fill_in_wckey(void *db_conn, slurmdb_wckey_rec_t *wckey,
 
 	xassert(verify_assoc_lock(WCKEY_LOCK, READ_LOCK));
 
+	if (!assoc_mgr_cluster_name && !wckey->cluster) {
+		/* only and always check for on the slurmdbd */
+		error("No cluster name was given "
+		      "to check against, "
+		      "we need one to get a wckey.");
+		goto end_it;
+	} else if (wckey->id) {
+		ret_wckey = _index_find(&wckey_id_index,
+					_hash_mix(wckey->id),
+					_match_wckey_id, wckey);
+		goto end_it;
+	} else if ((wckey->uid != NO_VAL) && wckey->name) {
+		ret_wckey = _index_find(&wckey_index,
+					_wckey_hash(wckey->name, wckey->uid,
+						    wckey->cluster),
+					_match_wckey, wckey);
+		goto end_it;
+	}
+
+	/* Only looking up by user name needs to walk the list */
 	itr = list_iterator_create(assoc_mgr_wckey_list);
 	while ((found_wckey = list_next(itr))) {
-		/* only and always check for on the slurmdbd */
-		if (!assoc_mgr_cluster_name) {
-			if (!wckey->cluster) {
-				error("No cluster name was given "
-				      "to check against, "
-				      "we need one to get a wckey.");
-				continue;
-			}
-
-			if (xstrcasecmp(wckey->cluster, found_wckey->cluster)) {
-				debug4("not the right cluster");
-				continue;
-			}
+		/* only check for on the slurmdbd */
+		if (!assoc_mgr_cluster_name &&
+		    xstrcasecmp(wckey->cluster, found_wckey->cluster)) {
+			debug4("not the right cluster");
+			continue;
 		}
 
-		if (wckey->id) {
-			if (wckey->id == found_wckey->id) {
-				ret_wckey = found_wckey;
-				break;
+		if (wckey->uid != NO_VAL) {
+			if (wckey->uid != found_wckey->uid) {
+				debug4("not the right user %u != %u",
+				       wckey->uid, found_wckey->uid);
+				continue;
 			}
+		} else if (wckey->user &&
+			   xstrcasecmp(wckey->user, found_wckey->user))
 			continue;
-		} else {
-			if (wckey->uid != NO_VAL) {
-				if (wckey->uid != found_wckey->uid) {
-					debug4("not the right user %u != %u",
-					       wckey->uid, found_wckey->uid);
-					continue;
-				}
-			} else if (wckey->user &&
-				   xstrcasecmp(wckey->user, found_wckey->user))
-				continue;
 
-			if (wckey->name
-			    && (!found_wckey->name
-				|| xstrcasecmp(wckey->name,
-					       found_wckey->name))) {
-				debug4("not the right name %s != %s",
-				       wckey->name, found_wckey->name);
-				continue;
-			}
+		if (wckey->name
+		    && (!found_wckey->name
+			|| xstrcasecmp(wckey->name, found_wckey->name))) {
+			debug4("not the right name %s != %s",
+			       wckey->name, found_wckey->name);
+			continue;
 		}
 		ret_wckey = found_wckey;
 		break;
 	}
 	list_iterator_destroy(itr);
 
+end_it:
 	if (!ret_wckey) {
 		if (!locked)
 			assoc_mgr_unlock(&locks);
@@ -2998,8 +3418,8 @@ extern int assoc_mgr_fill_in_wckey(void *db_conn, slurmdb_wckey_rec_t *wckey,
 extern slurmdb_admin_level_t assoc_mgr_get_admin_level(void *db_conn,
 						       uint32_t uid)
 {
-	ListIterator itr = NULL;
 	slurmdb_user_rec_t * found_user = NULL;
+	slurmdb_admin_level_t admin_level = SLURMDB_ADMIN_NOTSET;
 	assoc_mgr_lock_t locks = { .user = READ_LOCK };
 
 	if (!assoc_mgr_user_list)
@@ -3012,18 +3432,11 @@ extern slurmdb_admin_level_t assoc_mgr_get_admin_level(void *db_conn,
 		return SLURMDB_ADMIN_NOTSET;
 	}
 
-	itr = list_iterator_create(assoc_mgr_user_list);
-	while ((found_user = list_next(itr))) {
-		if (uid == found_user->uid)
-			break;
-	}
-	list_iterator_destroy(itr);
+	if ((found_user = _find_user_uid(uid)))
+		admin_level = found_user->admin_level;
 	assoc_mgr_unlock(&locks);
 
-	if (found_user)
-		return found_user->admin_level;
-
-	return SLURMDB_ADMIN_NOTSET;
+	return admin_level;
 }
 
 extern bool assoc_mgr_is_user_acct_coord(void *db_conn,
@@ -3048,12 +3461,7 @@ extern bool assoc_mgr_is_user_acct_coord(void *db_conn,
 		return false;
 	}
 
-	itr = list_iterator_create(assoc_mgr_user_list);
-	while ((found_user = list_next(itr))) {
-		if (uid == found_user->uid)
-			break;
-	}
-	list_iterator_destroy(itr);
+	found_user = _find_user_uid(uid);
 
 	if (!found_user || !found_user->coord_accts) {
 		assoc_mgr_unlock(&locks);
@@ -3659,6 +4067,7 @@ extern int assoc_mgr_update_assocs(slurmdb_update_object_t *update, bool locked)
 
 	if (!locked)
 		assoc_mgr_lock(&locks);
+	_inc_update_cnt(ASSOC_LOCK);
 	if (!assoc_mgr_assoc_list) {
 		if (!locked)
 			assoc_mgr_unlock(&locks);
@@ -4150,6 +4559,7 @@ extern int assoc_mgr_update_wckeys(slurmdb_update_object_t *update, bool locked)
 
 	if (!locked)
 		assoc_mgr_lock(&locks);
+	_inc_update_cnt(WCKEY_LOCK);
 	if (!assoc_mgr_wckey_list) {
 		if (!locked)
 			assoc_mgr_unlock(&locks);
@@ -4254,6 +4664,7 @@ extern int assoc_mgr_update_wckeys(slurmdb_update_object_t *update, bool locked)
 		slurmdb_destroy_wckey_rec(object);
 	}
 	list_iterator_destroy(itr);
+	_build_wckey_index();
 	if (!locked)
 		assoc_mgr_unlock(&locks);
 
@@ -4273,6 +4684,7 @@ extern int assoc_mgr_update_users(slurmdb_update_object_t *update, bool locked)
 
 	if (!locked)
 		assoc_mgr_lock(&locks);
+	_inc_update_cnt(USER_LOCK);
 	if (!assoc_mgr_user_list) {
 		if (!locked)
 			assoc_mgr_unlock(&locks);
@@ -4378,6 +4790,9 @@ extern int assoc_mgr_update_users(slurmdb_update_object_t *update, bool locked)
 		slurmdb_destroy_user_rec(object);
 	}
 	list_iterator_destroy(itr);
+	_build_user_index();
+	/* Renaming a user renames its wckeys */
+	_build_wckey_index();
 	if (!locked)
 		assoc_mgr_unlock(&locks);
 
@@ -4401,6 +4816,7 @@ extern int assoc_mgr_update_qos(slurmdb_update_object_t *update, bool locked)
 
 	if (!locked)
 		assoc_mgr_lock(&locks);
+	_inc_update_cnt(QOS_LOCK);
 	if (!assoc_mgr_qos_list) {
 		if (!locked)
 			assoc_mgr_unlock(&locks);
@@ -4802,6 +5218,8 @@ extern int assoc_mgr_update_qos(slurmdb_update_object_t *update, bool locked)
 
 	list_iterator_destroy(itr);
 
+	_build_qos_index();
+
 	if (!locked)
 		assoc_mgr_unlock(&locks);
 
@@ -4844,6 +5262,7 @@ extern int assoc_mgr_update_res(slurmdb_update_object_t *update, bool locked)
 
 	if (!locked)
 		assoc_mgr_lock(&locks);
+	_inc_update_cnt(RES_LOCK);
 	if (!assoc_mgr_res_list) {
 		if (!locked)
 			assoc_mgr_unlock(&locks);
@@ -4995,6 +5414,7 @@ extern int assoc_mgr_update_tres(slurmdb_update_object_t *update, bool locked)
 				   .tres = WRITE_LOCK };
 	if (!locked)
 		assoc_mgr_lock(&locks);
+	_inc_update_cnt(TRES_LOCK);
 
 	if (!assoc_mgr_tres_list) {
 		tmp_list = list_create(slurmdb_destroy_tres_rec);
@@ -5961,6 +6381,7 @@ extern int load_assoc_mgr_state(bool only_tres)
 			FREE_NULL_LIST(assoc_mgr_user_list);
 			assoc_mgr_user_list = msg->my_list;
 			_post_user_list(assoc_mgr_user_list);
+			_build_user_index();
 			debug("Recovered %u users",
 			      list_count(assoc_mgr_user_list));
 			msg->my_list = NULL;
@@ -6000,6 +6421,7 @@ extern int load_assoc_mgr_state(bool only_tres)
 			FREE_NULL_LIST(assoc_mgr_qos_list);
 			assoc_mgr_qos_list = msg->my_list;
 			_post_qos_list(assoc_mgr_qos_list);
+			_build_qos_index();
 			debug("Recovered %u qos",
 			      list_count(assoc_mgr_qos_list));
 			msg->my_list = NULL;
@@ -6016,6 +6438,7 @@ extern int load_assoc_mgr_state(bool only_tres)
 			}
 			FREE_NULL_LIST(assoc_mgr_wckey_list);
 			assoc_mgr_wckey_list = msg->my_list;
+			_build_wckey_index();
 			debug("Recovered %u wckeys",
 			      list_count(assoc_mgr_wckey_list));
 			msg->my_list = NULL;
@@ -6166,6 +6589,8 @@ extern int assoc_mgr_set_missing_uids()
 		}
 		list_iterator_destroy(itr);
 	}
+	_build_user_index();
+	_build_wckey_index();
 	assoc_mgr_unlock(&locks);
 
 	return SLURM_SUCCESS;
@@ -52,10 +52,25 @@
 #include "src/common/slurm_route.h"
 #include "src/common/read_config.h"
 #include "src/common/slurm_protocol_interface.h"
+#include "src/common/timers.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
 
+#define FWD_DEADLINE_FACTOR	4	/* straggler deadline, in multiples of
+					 * the expected reply time */
+#define FWD_DEADLINE_MIN	2000	/* minimum straggler deadline, msec */
+
+/*
+ * CommunicationParameters=AdaptiveForward state. Averages are in usec and
+ * zero until measured.
+ */
+static int fwd_adaptive = -1;
+static double fwd_hop_usec = 0;		/* round trip of one tree level */
+static double fwd_spawn_usec = 0;	/* starting the send to one child */
+static pthread_mutex_t fwd_stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 typedef struct {
+	void *auth_cred;	/* credential shared by the fanout, or NULL */
 	pthread_cond_t *notify;
 	int            *p_thr_count;
 	slurm_msg_t *orig_msg;
@@ -63,11 +78,19 @@ typedef struct {
 	int timeout;
 	hostlist_t tree_hl;
 	pthread_mutex_t *tree_mutex;
+	uint16_t tree_width;	/* width used to split the tree, or zero */
 } fwd_tree_t;
 
+static bool _fwd_adaptive(void);
+static uint32_t _fwd_deadline(int host_count, uint16_t tree_width);
+static bool _fwd_resendable(uint16_t msg_type);
+static void _fwd_stat_add(double *avg, long usec);
+static uint16_t _fwd_tree_width(int host_count, uint16_t tree_width);
+static void _fwd_tree_reroute(fwd_tree_t *fwd_tree, char *straggler);
 static void _start_msg_tree_internal(hostlist_t hl, hostlist_t* sp_hl,
 				     fwd_tree_t *fwd_tree_in,
 				     int hl_count);
+static int _tree_levels(int host_count, uint16_t tree_width);
 static void _forward_msg_internal(hostlist_t hl, hostlist_t* sp_hl,
 				  forward_struct_t *fwd_struct,
 				  header_t *header, int timeout,
@@ -92,6 +115,144 @@ void _destroy_tree_fwd(fwd_tree_t *fwd_tree)
 	}
 }
 
+/* Test for CommunicationParameters=AdaptiveForward */
+static bool _fwd_adaptive(void)
+{
+	if (fwd_adaptive == -1) {
+		char *comm_params = slurm_get_comm_parameters();
+
+		slurm_mutex_lock(&fwd_stats_mutex);
+		if (xstrcasestr(comm_params, "AdaptiveForward"))
+			fwd_adaptive = 1;
+		else
+			fwd_adaptive = 0;
+		slurm_mutex_unlock(&fwd_stats_mutex);
+		xfree(comm_params);
+	}
+
+	return (fwd_adaptive == 1);
+}
+
+/* Add a sample to an exponentially weighted moving average */
+static void _fwd_stat_add(double *avg, long usec)
+{
+	if (usec < 0)
+		return;
+
+	slurm_mutex_lock(&fwd_stats_mutex);
+	if (*avg == 0)
+		*avg = usec;
+	else
+		*avg += (usec - *avg) / 8;
+	slurm_mutex_unlock(&fwd_stats_mutex);
+}
+
+/*
+ * Number of tree levels needed to reach host_count hosts when each
+ * forwarder sends to at most tree_width children
+ */
+static int _tree_levels(int host_count, uint16_t tree_width)
+{
+	int levels = 0;
+
+	if (!tree_width)
+		tree_width = 1;
+
+	while (host_count > 0) {
+		levels++;
+		if (host_count <= tree_width)
+			break;
+		/* each subtree's forwarder takes one host off the next level */
+		host_count = ((host_count + tree_width - 1) / tree_width) - 1;
+	}
+
+	return levels;
+}
+
+/*
+ * Pick the tree width used to forward to host_count hosts. Unless
+ * AdaptiveForward is configured this is the given tree_width (zero meaning
+ * TreeWidth). Otherwise pick the width up to tree_width minimizing the
+ * estimated time to reach every host: each level costs a round trip plus
+ * starting the send to every child of a forwarder. Until these are
+ * measured, use tree_width.
+ */
+static uint16_t _fwd_tree_width(int host_count, uint16_t tree_width)
+{
+	double hop_usec, spawn_usec, cost, best_cost = 0;
+	int width, best_width, max_width;
+
+	if (!_fwd_adaptive() || (host_count <= 1))
+		return tree_width;
+
+	if (!tree_width)
+		tree_width = slurm_get_tree_width();
+
+	slurm_mutex_lock(&fwd_stats_mutex);
+	hop_usec = fwd_hop_usec;
+	spawn_usec = fwd_spawn_usec;
+	slurm_mutex_unlock(&fwd_stats_mutex);
+
+	max_width = MIN(host_count, tree_width);
+	if ((hop_usec == 0) || (spawn_usec == 0))
+		return tree_width;
+
+	best_width = max_width;
+	for (width = 2; width <= max_width; width++) {
+		cost = _tree_levels(host_count, width) *
+		       (hop_usec + (width * spawn_usec));
+		if ((best_cost == 0) || (cost < best_cost)) {
+			best_cost = cost;
+			best_width = width;
+		}
+	}
+
+	return best_width;
+}
+
+/*
+ * Msec to wait for the reply of a forwarder to host_count hosts (itself
+ * included) before checking it still responds, and rerouting its subtree if
+ * not. Zero to wait for the full timeout.
+ */
+static uint32_t _fwd_deadline(int host_count, uint16_t tree_width)
+{
+	double hop_usec;
+	uint32_t deadline;
+
+	if (!_fwd_adaptive())
+		return 0;
+
+	if (!tree_width)
+		tree_width = slurm_get_tree_width();
+
+	slurm_mutex_lock(&fwd_stats_mutex);
+	hop_usec = fwd_hop_usec;
+	slurm_mutex_unlock(&fwd_stats_mutex);
+
+	deadline = (FWD_DEADLINE_FACTOR * hop_usec *
+		    _tree_levels(host_count, tree_width)) / 1000;
+
+	return MAX(deadline, FWD_DEADLINE_MIN);
+}
+
+/*
+ * Only messages which are harmless to receive twice may be resent to the
+ * subtree of a forwarder which may already have forwarded them.
+ */
+static bool _fwd_resendable(uint16_t msg_type)
+{
+	switch (msg_type) {
+	case REQUEST_PING:
+	case REQUEST_NODE_REGISTRATION_STATUS:
+	case REQUEST_HEALTH_CHECK:
+	case REQUEST_ACCT_GATHER_UPDATE:
+		return true;
+	default:
+		return false;
+	}
+}
+
 void *_forward_thread(void *arg)
 {
 	forward_msg_t *fwd_msg = (forward_msg_t *)arg;
@@ -101,11 +262,18 @@ void *_forward_thread(void *arg)
 	int fd = -1;
 	ret_data_info_t *ret_data_info = NULL;
 	char *name = NULL;
-	hostlist_t hl = hostlist_create(fwd_msg->header.forward.nodelist);
+	hostlist_t hl;
 	slurm_addr_t addr;
 	char *buf = NULL;
 	int steps = 0;
 	int start_timeout = fwd_msg->timeout;
+	DEF_TIMERS;
+
+	if (fwd_msg->hl) {
+		hl = fwd_msg->hl;
+		fwd_msg->hl = NULL;
+	} else
+		hl = hostlist_create(fwd_msg->header.forward.nodelist);
 
 	/* repeat until we are sure the message was sent */
 	while ((name = hostlist_shift(hl))) {
@@ -179,6 +347,7 @@ void *_forward_thread(void *arg)
 		/*
 		 * forward message
 		 */
+		START_TIMER;
 		if (slurm_msg_sendto(fd,
 				     get_buf_data(buffer),
 				     get_buf_offset(buffer)) < 0) {
@@ -251,6 +420,14 @@ void *_forward_thread(void *arg)
 		ret_list = slurm_receive_msgs(fd, steps, fwd_msg->timeout);
 		/* info("sent %d forwards got %d back", */
 		/*      fwd_msg->header.forward.cnt, list_count(ret_list)); */
+		if (_fwd_adaptive() && ret_list &&
+		    (list_count(ret_list) == fwd_msg->header.forward.cnt + 1)) {
+			END_TIMER;
+			_fwd_stat_add(&fwd_hop_usec, DELTA_TIMER /
+				      _tree_levels(
+					fwd_msg->header.forward.cnt + 1,
+					fwd_msg->header.forward.tree_width));
+		}
 
 		if (!ret_list || (fwd_msg->header.forward.cnt != 0
 				  && list_count(ret_list) <= 1)) {
@@ -351,6 +528,7 @@ void *_fwd_tree_thread(void *arg)
 	char *name = NULL;
 	char *buf = NULL;
 	slurm_msg_t send_msg;
+	DEF_TIMERS;
 
 	slurm_msg_t_init(&send_msg);
 	send_msg.msg_type = fwd_tree->orig_msg->msg_type;
@@ -358,6 +536,14 @@ void *_fwd_tree_thread(void *arg)
 	send_msg.data = fwd_tree->orig_msg->data;
 	send_msg.protocol_version = fwd_tree->orig_msg->protocol_version;
 
+	/*
+	 * A credential shared by the fanout may only be sent by our first
+	 * attempt. Hosts reached when retrying or abandoning the tree below
+	 * may have already received it from a failed forwarder.
+	 */
+	send_msg.auth_cred_shared = fwd_tree->auth_cred;
+	fwd_tree->auth_cred = NULL;
+
 	/* repeat until we are sure the message was sent */
 	while ((name = hostlist_shift(fwd_tree->tree_hl))) {
 		if (slurm_conf_get_addr(name, &send_msg.address, send_msg.flags)
@@ -375,10 +561,17 @@ void *_fwd_tree_thread(void *arg)
 		}
 
 		send_msg.forward.timeout = fwd_tree->timeout;
+		send_msg.forward.tree_width = fwd_tree->tree_width;
+		send_msg.forward.deadline = 0;
+		send_msg.forward.straggler = false;
 		if ((send_msg.forward.cnt = hostlist_count(fwd_tree->tree_hl))){
 			buf = hostlist_ranged_string_xmalloc(
 					fwd_tree->tree_hl);
 			send_msg.forward.nodelist = buf;
+			if (_fwd_resendable(send_msg.msg_type))
+				send_msg.forward.deadline = _fwd_deadline(
+					send_msg.forward.cnt + 1,
+					fwd_tree->tree_width);
 		} else
 			send_msg.forward.nodelist = NULL;
 
@@ -388,10 +581,34 @@ void *_fwd_tree_thread(void *arg)
 		} else
 			debug3("Tree sending to %s", name);
 
+		START_TIMER;
 		ret_list = slurm_send_addr_recv_msgs(&send_msg, name,
 						     fwd_tree->timeout);
 
 		xfree(send_msg.forward.nodelist);
+		send_msg.auth_cred_shared = NULL;
+
+		if (send_msg.forward.straggler) {
+			/*
+			 * The forwarder is hung, so reach its subtree, and
+			 * the forwarder itself, another way rather than
+			 * waiting out the full timeout.
+			 */
+			debug("fwd_tree_thread: %s did not reply within %u msec nor respond after, rerouting %d nodes",
+			      name, send_msg.forward.deadline,
+			      send_msg.forward.cnt);
+			FREE_NULL_LIST(ret_list);
+			_fwd_tree_reroute(fwd_tree, name);
+			free(name);
+			continue;
+		}
+		if (_fwd_adaptive() && ret_list &&
+		    (list_count(ret_list) == send_msg.forward.cnt + 1)) {
+			END_TIMER;
+			_fwd_stat_add(&fwd_hop_usec, DELTA_TIMER /
+				      _tree_levels(send_msg.forward.cnt + 1,
+						   send_msg.forward.tree_width));
+		}
 
 		if (ret_list) {
 			int ret_cnt = list_count(ret_list);
@@ -474,12 +691,48 @@ void *_fwd_tree_thread(void *arg)
 	return NULL;
 }
 
+/*
+ * Send the message again to the rest of a subtree whose forwarder did not
+ * reply by its deadline, split into a new tree, and to the forwarder itself
+ * with nothing to forward.
+ */
+static void _fwd_tree_reroute(fwd_tree_t *fwd_tree, char *straggler)
+{
+	hostlist_t *sp_hl;
+	hostlist_t hl;
+	int hl_count = 0;
+
+	/*
+	 * Take the subtree out of tree_hl, the caller goes on to its next
+	 * host and must not send to it again even if the split fails.
+	 */
+	hl = fwd_tree->tree_hl;
+	fwd_tree->tree_hl = hostlist_create(NULL);
+
+	if (route_g_split_hostlist(hl, &sp_hl, &hl_count,
+				   _fwd_tree_width(hostlist_count(hl),
+						   fwd_tree->tree_width))) {
+		error("unable to split forward hostlist");
+		_start_msg_tree_internal(hl, NULL, fwd_tree,
+					 hostlist_count(hl));
+	} else {
+		_start_msg_tree_internal(NULL, sp_hl, fwd_tree, hl_count);
+		xfree(sp_hl);
+	}
+	hostlist_destroy(hl);
+
+	hl = hostlist_create(straggler);
+	_start_msg_tree_internal(hl, NULL, fwd_tree, 1);
+	hostlist_destroy(hl);
+}
+
 static void _start_msg_tree_internal(hostlist_t hl, hostlist_t* sp_hl,
 				     fwd_tree_t *fwd_tree_in,
 				     int hl_count)
 {
 	int j;
 	fwd_tree_t *fwd_tree;
+	DEF_TIMERS;
 
 	xassert((hl || sp_hl) && !(hl && sp_hl));
 	xassert(fwd_tree_in);
@@ -495,6 +748,7 @@ static void _start_msg_tree_internal(hostlist_t hl, hostlist_t* sp_hl,
 		/* convert secs to msec */
 		fwd_tree_in->timeout  = slurm_get_msg_timeout() * 1000;
 
+	START_TIMER;
 	for (j = 0; j < hl_count; j++) {
 		fwd_tree = xmalloc(sizeof(fwd_tree_t));
 		memcpy(fwd_tree, fwd_tree_in, sizeof(fwd_tree_t));
@@ -521,6 +775,10 @@ static void _start_msg_tree_internal(hostlist_t hl, hostlist_t* sp_hl,
 
 		slurm_thread_create_detached(NULL, _fwd_tree_thread, fwd_tree);
 	}
+	if (_fwd_adaptive() && (hl_count > 0)) {
+		END_TIMER;
+		_fwd_stat_add(&fwd_spawn_usec, DELTA_TIMER / hl_count);
+	}
 }
 
 static void _forward_msg_internal(hostlist_t hl, hostlist_t* sp_hl,
@@ -530,12 +788,14 @@ static void _forward_msg_internal(hostlist_t hl, hostlist_t* sp_hl,
 {
 	int j;
 	forward_msg_t *fwd_msg = NULL;
-	char *buf = NULL, *tmp_char = NULL;
+	char *tmp_char = NULL;
+	DEF_TIMERS;
 
 	if (timeout <= 0)
 		/* convert secs to msec */
 		timeout  = slurm_get_msg_timeout() * 1000;
 
+	START_TIMER;
 	for (j = 0; j < hl_count; j++) {
 		fwd_msg = xmalloc(sizeof(forward_msg_t));
 
@@ -548,25 +808,40 @@ static void _forward_msg_internal(hostlist_t hl, hostlist_t* sp_hl,
 		       sizeof(slurm_addr_t));
 
 		fwd_msg->header.version = header->version;
-		fwd_msg->header.flags = header->flags;
+		/*
+		 * Our connections to the children are not reused, and their
+		 * replies come to us so advertise what we can decode
+		 */
+		fwd_msg->header.flags = header->flags &
+			~(SLURM_MSG_KEEP_CONN | SLURM_MSG_ACCEPT_ZLIB |
+			  SLURM_MSG_ACCEPT_LZ4);
+		if (header->version >= SLURM_20_02_PROTOCOL_VERSION)
+			fwd_msg->header.flags |= SLURM_MSG_ACCEPT_BUILD;
 		fwd_msg->header.msg_type = header->msg_type;
 		fwd_msg->header.body_length = header->body_length;
 		fwd_msg->header.ret_list = NULL;
 		fwd_msg->header.ret_cnt = 0;
 
+		forward_init(&fwd_msg->header.forward);
 		if (sp_hl) {
-			buf = hostlist_ranged_string_xmalloc(sp_hl[j]);
-			hostlist_destroy(sp_hl[j]);
+			/*
+			 * Hand the split hostlist to the thread rather than
+			 * converting it to a string which is parsed again.
+			 */
+			fwd_msg->hl = sp_hl[j];
+			sp_hl[j] = NULL;
 		} else {
 			tmp_char = hostlist_shift(hl);
-			buf = xstrdup(tmp_char);
+			fwd_msg->header.forward.nodelist = xstrdup(tmp_char);
 			free(tmp_char);
 		}
 
-		forward_init(&fwd_msg->header.forward);
-		fwd_msg->header.forward.nodelist = buf;
 		slurm_thread_create_detached(NULL, _forward_thread, fwd_msg);
 	}
+	if (_fwd_adaptive() && (hl_count > 0)) {
+		END_TIMER;
+		_fwd_stat_add(&fwd_spawn_usec, DELTA_TIMER / hl_count);
+	}
 }
 
 /*
@@ -606,7 +881,9 @@ extern int forward_msg(forward_struct_t *forward_struct, header_t *header)
 	hostlist_uniq(hl);
 
 	if (route_g_split_hostlist(
-		    hl, &sp_hl, &hl_count, header->forward.tree_width)) {
+		    hl, &sp_hl, &hl_count,
+		    _fwd_tree_width(hostlist_count(hl),
+				    header->forward.tree_width))) {
 		error("unable to split forward hostlist");
 		hostlist_destroy(hl);
 		return SLURM_ERROR;
@@ -643,15 +920,17 @@ extern List start_msg_tree(hostlist_t hl, slurm_msg_t *msg, int timeout)
 	int host_count = 0;
 	hostlist_t* sp_hl;
 	int hl_count = 0;
+	void *auth_cred = NULL;
+	uint16_t tree_width;
 
 	xassert(hl);
 	xassert(msg);
 
 	hostlist_uniq(hl);
 	host_count = hostlist_count(hl);
+	tree_width = _fwd_tree_width(host_count, msg->forward.tree_width);
 
-	if (route_g_split_hostlist(hl, &sp_hl, &hl_count,
-				   msg->forward.tree_width)) {
+	if (route_g_split_hostlist(hl, &sp_hl, &hl_count, tree_width)) {
 		error("unable to split forward hostlist");
 		return NULL;
 	}
@@ -667,6 +946,19 @@ extern List start_msg_tree(hostlist_t hl, slurm_msg_t *msg, int timeout)
 	fwd_tree.notify = &notify;
 	fwd_tree.p_thr_count = &thr_count;
 	fwd_tree.tree_mutex = &tree_mutex;
+	fwd_tree.tree_width = tree_width;
+
+#ifndef HAVE_FRONT_END
+	/*
+	 * Each subtree goes to distinct hosts, so they can share one
+	 * credential rather than each calling into the auth plugin. Front
+	 * end nodes share one host and must each get their own credential.
+	 */
+	if (msg->auth_cred_shared)
+		fwd_tree.auth_cred = msg->auth_cred_shared;
+	else if (hl_count > 1)
+		fwd_tree.auth_cred = auth_cred = slurm_msg_auth_create(msg);
+#endif
 
 	_start_msg_tree_internal(NULL, sp_hl, &fwd_tree, hl_count);
 
@@ -687,6 +979,8 @@ extern List start_msg_tree(hostlist_t hl, slurm_msg_t *msg, int timeout)
 
 	slurm_mutex_destroy(&tree_mutex);
 	slurm_cond_destroy(&notify);
+	if (auth_cred)
+		(void) g_slurm_auth_destroy(auth_cred);
 
 	return ret_list;
 }
@@ -6406,13 +6406,50 @@ static void _validate_gres_node_cores(gres_node_state_t *node_gres_ptr,
 	}
 }
 
+/*
+ * Build a node-relative copy of one node's cores from a cluster-wide
+ * core_bitmap so that topology bitmaps can be compared a word at a time
+ * IN core_bitmap    - cluster-wide bitmap of available cores
+ * IN core_start_bit - index into core_bitmap for this node's first core
+ * IN core_cnt       - count of cores on this node
+ * RET bitmap of size core_cnt, must be freed by caller
+ */
+static bitstr_t *_node_core_bitmap(bitstr_t *core_bitmap, int core_start_bit,
+				   int core_cnt)
+{
+	bitstr_t *node_core_bitmap = bit_alloc(core_cnt);
+	int i;
+
+	for (i = 0; i < core_cnt; i++) {
+		if (bit_test(core_bitmap, core_start_bit + i))
+			bit_set(node_core_bitmap, i);
+	}
+
+	return node_core_bitmap;
+}
+
+/*
+ * Clear bits in a cluster-wide core_bitmap for this node's cores which are
+ * not set in the node-relative node_core_bitmap
+ */
+static void _node_core_bitmap_and(bitstr_t *core_bitmap, int core_start_bit,
+				  bitstr_t *node_core_bitmap)
+{
+	int i, core_cnt = bit_size(node_core_bitmap);
+
+	for (i = 0; i < core_cnt; i++) {
+		if (!bit_test(node_core_bitmap, i))
+			bit_clear(core_bitmap, core_start_bit + i);
+	}
+}
+
 static void	_job_core_filter(void *job_gres_data, void *node_gres_data,
 				 bool use_total_gres, bitstr_t *core_bitmap,
 				 int core_start_bit, int core_end_bit,
 				 char *gres_name, char *node_name,
 				 uint32_t plugin_id)
 {
-	int i, j, core_ctld;
+	int i, core_ctld;
 	gres_job_state_t  *job_gres_ptr  = (gres_job_state_t *)  job_gres_data;
 	gres_node_state_t *node_gres_ptr = (gres_node_state_t *) node_gres_data;
 	bitstr_t *avail_core_bitmap = NULL;
@@ -6430,8 +6467,11 @@ static void	_job_core_filter(void *job_gres_data, void *node_gres_data,
 	}
 
 	/* Determine which specific cores can be used */
-	avail_core_bitmap = bit_copy(core_bitmap);
-	bit_nclear(avail_core_bitmap, core_start_bit, core_end_bit);
+	core_ctld = core_end_bit - core_start_bit + 1;
+	if (core_ctld < 1)
+		return;
+	_validate_gres_node_cores(node_gres_ptr, core_ctld, node_name);
+	avail_core_bitmap = bit_alloc(core_ctld);
 	for (i = 0; i < node_gres_ptr->topo_cnt; i++) {
 		if (node_gres_ptr->topo_gres_cnt_avail[i] == 0)
 			continue;
@@ -6450,16 +6490,9 @@ static void	_job_core_filter(void *job_gres_data, void *node_gres_data,
 			FREE_NULL_BITMAP(avail_core_bitmap);	/* No filter */
 			return;
 		}
-		core_ctld = core_end_bit - core_start_bit + 1;
-		_validate_gres_node_cores(node_gres_ptr, core_ctld, node_name);
-		core_ctld = bit_size(node_gres_ptr->topo_core_bitmap[i]);
-		for (j = 0; j < core_ctld; j++) {
-			if (bit_test(node_gres_ptr->topo_core_bitmap[i], j)) {
-				bit_set(avail_core_bitmap, core_start_bit + j);
-			}
-		}
+		bit_or(avail_core_bitmap, node_gres_ptr->topo_core_bitmap[i]);
 	}
-	bit_and(core_bitmap, avail_core_bitmap);
+	_node_core_bitmap_and(core_bitmap, core_start_bit, avail_core_bitmap);
 	FREE_NULL_BITMAP(avail_core_bitmap);
 }
 
@@ -6469,7 +6502,7 @@ static uint32_t _job_test(void *job_gres_data, void *node_gres_data,
 			  uint32_t job_id, char *node_name, char *gres_name,
 			  uint32_t plugin_id)
 {
-	int i, j, core_size, core_ctld, top_inx = -1;
+	int i, j, core_ctld, top_inx = -1;
 	uint64_t gres_avail = 0, gres_max = 0, gres_total, gres_tmp;
 	uint64_t min_gres_node = 0;
 	gres_job_state_t  *job_gres_ptr  = (gres_job_state_t *)  job_gres_data;
@@ -6479,6 +6512,7 @@ static uint32_t _job_test(void *job_gres_data, void *node_gres_data,
 	uint32_t core_cnt = 0;
 	bitstr_t *alloc_core_bitmap = NULL;
 	bitstr_t *avail_core_bitmap = NULL;
+	bitstr_t *node_core_bitmap = NULL;
 	bool shared_gres = _shared_gres(plugin_id);
 	bool use_busy_dev = false;
 
@@ -6513,6 +6547,9 @@ static uint32_t _job_test(void *job_gres_data, void *node_gres_data,
 			}
 			_validate_gres_node_cores(node_gres_ptr, core_ctld,
 						  node_name);
+			node_core_bitmap = _node_core_bitmap(core_bitmap,
+							     core_start_bit,
+							     core_ctld);
 		}
 		for (i = 0; i < node_gres_ptr->topo_cnt; i++) {
 			if (job_gres_ptr->type_name &&
@@ -6523,37 +6560,24 @@ static uint32_t _job_test(void *job_gres_data, void *node_gres_data,
 			if (use_busy_dev &&
 			    (node_gres_ptr->topo_gres_cnt_alloc[i] == 0))
 				continue;
-			if (!node_gres_ptr->topo_core_bitmap[i]) {
-				gres_avail += node_gres_ptr->
-					      topo_gres_cnt_avail[i];
-				if (!use_total_gres) {
-					gres_avail -= node_gres_ptr->
-						      topo_gres_cnt_alloc[i];
+			if (node_gres_ptr->topo_core_bitmap[i]) {
+				if (node_core_bitmap) {
+					if (!bit_overlap_any(node_core_bitmap,
+							     node_gres_ptr->
+							     topo_core_bitmap[i]))
+						continue; /* no usable cores */
+				} else if (bit_ffs(node_gres_ptr->
+						   topo_core_bitmap[i]) < 0) {
+					continue;	/* no cores */
 				}
-				if (shared_gres)
-					gres_max = MAX(gres_max, gres_avail);
-				continue;
-			}
-			core_ctld = bit_size(node_gres_ptr->
-					     topo_core_bitmap[i]);
-			for (j = 0; j < core_ctld; j++) {
-				if (core_bitmap &&
-				    !bit_test(core_bitmap, core_start_bit + j))
-					continue;
-				if (!bit_test(node_gres_ptr->
-					      topo_core_bitmap[i], j))
-					continue; /* not avail for this gres */
-				gres_avail += node_gres_ptr->
-					      topo_gres_cnt_avail[i];
-				if (!use_total_gres) {
-					gres_avail -= node_gres_ptr->
-						      topo_gres_cnt_alloc[i];
-				}
-				if (shared_gres)
-					gres_max = MAX(gres_max, gres_avail);
-				break;
 			}
+			gres_avail += node_gres_ptr->topo_gres_cnt_avail[i];
+			if (!use_total_gres)
+				gres_avail -= node_gres_ptr->topo_gres_cnt_alloc[i];
+			if (shared_gres)
+				gres_max = MAX(gres_max, gres_avail);
 		}
+		FREE_NULL_BITMAP(node_core_bitmap);
 		if (shared_gres)
 			gres_avail = gres_max;
 		if (min_gres_node > gres_avail)
@@ -6586,13 +6610,12 @@ static uint32_t _job_test(void *job_gres_data, void *node_gres_data,
 			}
 		}
 
-		alloc_core_bitmap = bit_alloc(core_ctld);
 		if (core_bitmap) {
-			for (j = 0; j < core_ctld; j++) {
-				if (bit_test(core_bitmap, core_start_bit + j))
-					bit_set(alloc_core_bitmap, j);
-			}
+			alloc_core_bitmap = _node_core_bitmap(core_bitmap,
+							      core_start_bit,
+							      core_ctld);
 		} else {
+			alloc_core_bitmap = bit_alloc(core_ctld);
 			bit_nset(alloc_core_bitmap, 0, core_ctld - 1);
 		}
 
@@ -6621,15 +6644,13 @@ static uint32_t _job_test(void *job_gres_data, void *node_gres_data,
 						 core_start_bit + 1;
 				continue;
 			}
-			core_size = bit_size(node_gres_ptr->topo_core_bitmap[i]);
-			for (j = 0; j < core_size; j++) {
-				if (core_bitmap &&
-				    !bit_test(core_bitmap, core_start_bit + j))
-					continue;
-				if (bit_test(node_gres_ptr->
-					     topo_core_bitmap[i], j)) {
-					cores_avail[i]++;
-				}
+			if (core_bitmap) {
+				cores_avail[i] = bit_overlap(avail_core_bitmap,
+							     node_gres_ptr->
+							     topo_core_bitmap[i]);
+			} else {
+				cores_avail[i] = bit_set_count(node_gres_ptr->
+							topo_core_bitmap[i]);
 			}
 		}
 
@@ -6725,12 +6746,8 @@ static uint32_t _job_test(void *job_gres_data, void *node_gres_data,
 		}
 		if (core_bitmap && (core_cnt > 0)) {
 			*topo_set = true;
-			for (i = 0; i < core_ctld; i++) {
-				if (!bit_test(alloc_core_bitmap, i)) {
-					bit_clear(core_bitmap,
-						  core_start_bit + i);
-				}
-			}
+			_node_core_bitmap_and(core_bitmap, core_start_bit,
+					      alloc_core_bitmap);
 		}
 		FREE_NULL_BITMAP(alloc_core_bitmap);
 		FREE_NULL_BITMAP(avail_core_bitmap);
@@ -2145,6 +2145,49 @@ int hostlist_pop_range_values(
 	return 1;
 }
 
+int hostlist_nth_range_values(hostlist_t hl, int n, char **prefix,
+			      unsigned long *lo, unsigned long *hi,
+			      int *width)
+{
+	hostrange_t hr;
+	int rc;
+
+	if (!hl || !prefix || !lo || !hi || !width)
+		return -1;
+
+	LOCK_HOSTLIST(hl);
+	if ((n < 0) || (n >= hl->nranges)) {
+		UNLOCK_HOSTLIST(hl);
+		return -1;
+	}
+
+	hr = hl->hr[n];
+	*prefix = hr->prefix;
+	if (hr->singlehost) {
+		*lo = 0;
+		*hi = 0;
+		*width = 0;
+		rc = 0;
+	} else {
+		*lo = hr->lo;
+		*hi = hr->hi;
+		*width = hr->width;
+		rc = 1;
+	}
+	UNLOCK_HOSTLIST(hl);
+
+	return rc;
+}
+
+int hostlist_push_range_values(hostlist_t hl, char *prefix,
+			       unsigned long lo, unsigned long hi, int width)
+{
+	if (!hl || !prefix || (hi < lo))
+		return -1;
+
+	return hostlist_push_hr(hl, prefix, lo, hi, width);
+}
+
 char *hostlist_shift_range(hostlist_t hl)
 {
 	int i;
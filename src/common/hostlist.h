@@ -244,6 +244,28 @@ char * hostlist_pop_range(hostlist_t hl);
 int hostlist_pop_range_values(
 	hostlist_t hl, unsigned long *lo, unsigned long *hi);
 
+/* hostlist_nth_range_values():
+ *
+ * Get the components of the n'th range of the hostlist hl without
+ * expanding it into individual hosts. On return *prefix points into hl
+ * and is only valid until hl is modified or destroyed.
+ * Returns 1 for a numeric range (lo, hi and width are set), 0 for a host
+ * without numeric suffix (prefix is set to the hostname) and -1 if n is
+ * out of range.
+ */
+int hostlist_nth_range_values(hostlist_t hl, int n, char **prefix,
+			      unsigned long *lo, unsigned long *hi,
+			      int *width);
+
+/* hostlist_push_range_values():
+ *
+ * Push the hosts "prefix[lo-hi]", with numeric suffixes zero padded to
+ * width, onto the hostlist hl without building their individual names.
+ * Returns the number of hosts in the hostlist or -1 on error.
+ */
+int hostlist_push_range_values(hostlist_t hl, char *prefix,
+			       unsigned long lo, unsigned long hi, int width);
+
 /* hostlist_shift_range():
  *
  * Shift the first bracketed hostlist (improperly: range) off the
@@ -49,6 +49,7 @@
 #include "src/common/slurm_auth.h"
 #include "src/common/slurm_route.h"
 #include "src/common/slurm_protocol_interface.h"
+#include "src/common/slurm_protocol_pack.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
 #include "src/slurmd/slurmd/slurmd.h"
@@ -57,9 +58,12 @@ typedef struct {
 	pthread_mutex_t	aggr_mutex;
 	pthread_cond_t	cond;
 	uint32_t        debug_flags;
+	struct timespec deadline;	/* earliest deadline of msg_list */
 	bool		max_msgs;
+	uint64_t        max_msg_bytes;
 	uint64_t        max_msg_cnt;
 	List            msg_aggr_list;
+	uint64_t        msg_bytes;	/* packed size of msg_list */
 	List            msg_list;
 	pthread_mutex_t	mutex;
 	slurm_addr_t    node_addr;
@@ -68,6 +72,26 @@ typedef struct {
 	uint64_t        window;
 } msg_collection_type_t;
 
+/*
+ * RPC types which may be aggregated. A message waits at most
+ * window / window_div before the collection window is closed, so types
+ * that something is blocked on can be sent sooner than the others.
+ */
+typedef struct {
+	uint16_t msg_type;
+	uint16_t window_div;
+} msg_aggr_type_t;
+
+static const msg_aggr_type_t msg_aggr_types[] = {
+	{ MESSAGE_COMPOSITE,			1 },
+	{ MESSAGE_EPILOG_COMPLETE,		1 },
+	{ MESSAGE_NODE_REGISTRATION_STATUS,	1 },
+	{ REQUEST_COMPLETE_BATCH_SCRIPT,	1 },
+	{ REQUEST_COMPLETE_PROLOG,		4 },	/* job launch waits */
+	{ REQUEST_STEP_COMPLETE,		1 },
+	{ 0, 0 }
+};
+
 typedef struct {
 	uint16_t msg_index;
 	void (*resp_callback) (slurm_msg_t *msg);
@@ -80,6 +104,63 @@ typedef struct {
  */
 static msg_collection_type_t msg_collection;
 
+/* Return the aggregation settings of msg_type, NULL if not aggregated */
+static const msg_aggr_type_t *_find_msg_aggr_type(uint16_t msg_type)
+{
+	const msg_aggr_type_t *type;
+
+	for (type = msg_aggr_types; type->msg_type; type++) {
+		if (type->msg_type == msg_type)
+			return type;
+	}
+	return NULL;
+}
+
+/* Set ts to now plus msec milliseconds */
+static void _deadline_set(struct timespec *ts, uint64_t msec)
+{
+	struct timeval now;
+
+	gettimeofday(&now, NULL);
+	ts->tv_sec = now.tv_sec + (msec / MSEC_IN_SEC);
+	ts->tv_nsec = (now.tv_usec * NSEC_IN_USEC) +
+		(NSEC_IN_MSEC * (msec % MSEC_IN_SEC));
+	ts->tv_sec += ts->tv_nsec / NSEC_IN_SEC;
+	ts->tv_nsec %= NSEC_IN_SEC;
+}
+
+/* Return true if ts is earlier than the current time */
+static bool _deadline_passed(struct timespec *ts)
+{
+	struct timeval now;
+
+	gettimeofday(&now, NULL);
+	if (now.tv_sec != ts->tv_sec)
+		return (now.tv_sec > ts->tv_sec);
+	return ((now.tv_usec * NSEC_IN_USEC) >= ts->tv_nsec);
+}
+
+/*
+ * Pack the body of msg now so its size is known while it is collected and
+ * the packing is not done while the collection is suspended.
+ * _pack_composite_msg() copies already packed bodies as they are.
+ */
+static void _msg_aggr_pack(slurm_msg_t *msg)
+{
+	Buf buffer;
+
+	if (msg->data_size)
+		return;		/* forwarded composite part, already packed */
+
+	if (msg->protocol_version == NO_VAL16)
+		msg->protocol_version = SLURM_PROTOCOL_VERSION;
+	buffer = init_buf(BUF_SIZE);
+	pack_msg(msg, buffer);
+	slurm_free_msg_data(msg->msg_type, msg->data);
+	msg->data_size = get_buf_offset(buffer);
+	set_buf_offset(buffer, 0);
+	msg->data = buffer;
+}
 
 static void _msg_aggr_free(void *x)
 {
@@ -186,42 +267,37 @@ static int _send_to_next_collector(slurm_msg_t *msg)
  *
  *  Start and terminate message collection windows.
  *  Send collected msgs to next collector node or final destination
- *  at window expiration.
+ *  at window expiration. A window expires at the earliest deadline of the
+ *  msgs collected, or when WindowMsgs or WindowBytes is reached.
  */
 static void * _msg_aggregation_sender(void *arg)
 {
-	struct timeval now;
-	struct timespec timeout;
 	slurm_msg_t msg;
 	composite_msg_t cmp;
 
 	slurm_mutex_lock(&msg_collection.mutex);
 	msg_collection.running = 1;
-	slurm_cond_signal(&msg_collection.cond);
+	slurm_cond_broadcast(&msg_collection.cond);
 
 	while (msg_collection.running) {
 		/* Wait for a new msg to be collected */
-		slurm_cond_wait(&msg_collection.cond, &msg_collection.mutex);
+		while (msg_collection.running &&
+		       !list_count(msg_collection.msg_list))
+			slurm_cond_wait(&msg_collection.cond,
+					&msg_collection.mutex);
 
-		if (!msg_collection.running &&
-		    !list_count(msg_collection.msg_list))
+		if (!list_count(msg_collection.msg_list))
 			break;
 
-		/* A msg has been collected; start new window */
-		gettimeofday(&now, NULL);
-		timeout.tv_sec = now.tv_sec +
-			(msg_collection.window / MSEC_IN_SEC);
-		timeout.tv_nsec = (now.tv_usec * NSEC_IN_USEC) +
-			(NSEC_IN_MSEC * (msg_collection.window % MSEC_IN_SEC));
-		timeout.tv_sec += timeout.tv_nsec / NSEC_IN_SEC;
-		timeout.tv_nsec %= NSEC_IN_SEC;
-
-		slurm_cond_timedwait(&msg_collection.cond,
-				     &msg_collection.mutex, &timeout);
-
-		if (!msg_collection.running &&
-		    !list_count(msg_collection.msg_list))
-			break;
+		/*
+		 * A msg has been collected; wait for the window to expire.
+		 * The deadline moves up if a more urgent msg is added.
+		 */
+		while (msg_collection.running && !msg_collection.max_msgs &&
+		       !_deadline_passed(&msg_collection.deadline))
+			slurm_cond_timedwait(&msg_collection.cond,
+					     &msg_collection.mutex,
+					     &msg_collection.deadline);
 
 		msg_collection.max_msgs = true;
 
@@ -236,7 +312,7 @@ static void * _msg_aggregation_sender(void *arg)
 
 		msg_collection.msg_list =
 			list_create(slurm_free_comp_msg_list);
-		msg_collection.max_msgs = false;
+		msg_collection.msg_bytes = 0;
 
 		slurm_msg_t_init(&msg);
 		msg.msg_type = MESSAGE_COMPOSITE;
@@ -250,6 +326,7 @@ static void * _msg_aggregation_sender(void *arg)
 		FREE_NULL_LIST(cmp.msg_list);
 
 		/* Resume message collection */
+		msg_collection.max_msgs = false;
 		slurm_cond_broadcast(&msg_collection.cond);
 	}
 
@@ -258,7 +335,7 @@ static void * _msg_aggregation_sender(void *arg)
 }
 
 extern void msg_aggr_sender_init(char *host, uint16_t port, uint64_t window,
-				 uint64_t max_msg_cnt)
+				 uint64_t max_msg_cnt, uint64_t max_msg_bytes)
 {
 	if (msg_collection.running || (max_msg_cnt <= 1))
 		return;
@@ -275,6 +352,7 @@ extern void msg_aggr_sender_init(char *host, uint16_t port, uint64_t window,
 	slurm_set_addr(&msg_collection.node_addr, port, host);
 	msg_collection.window = window;
 	msg_collection.max_msg_cnt = max_msg_cnt;
+	msg_collection.max_msg_bytes = max_msg_bytes;
 	msg_collection.msg_aggr_list = list_create(_msg_aggr_free);
 	msg_collection.msg_list = list_create(slurm_free_comp_msg_list);
 	msg_collection.max_msgs = false;
@@ -290,12 +368,14 @@ extern void msg_aggr_sender_init(char *host, uint16_t port, uint64_t window,
 	slurm_mutex_unlock(&msg_collection.mutex);
 }
 
-extern void msg_aggr_sender_reconfig(uint64_t window, uint64_t max_msg_cnt)
+extern void msg_aggr_sender_reconfig(uint64_t window, uint64_t max_msg_cnt,
+				     uint64_t max_msg_bytes)
 {
 	if (msg_collection.running) {
 		slurm_mutex_lock(&msg_collection.mutex);
 		msg_collection.window = window;
 		msg_collection.max_msg_cnt = max_msg_cnt;
+		msg_collection.max_msg_bytes = max_msg_bytes;
 		msg_collection.debug_flags = slurm_get_debug_flags();
 		slurm_mutex_unlock(&msg_collection.mutex);
 	} else if (max_msg_cnt > 1) {
@@ -308,10 +388,9 @@ extern void msg_aggr_sender_fini(void)
 {
 	if (!msg_collection.running)
 		return;
-	msg_collection.running = 0;
 	slurm_mutex_lock(&msg_collection.mutex);
-
-	slurm_cond_signal(&msg_collection.cond);
+	msg_collection.running = 0;
+	slurm_cond_broadcast(&msg_collection.cond);
 	slurm_mutex_unlock(&msg_collection.mutex);
 
 	pthread_join(msg_collection.thread_id, NULL);
@@ -327,37 +406,59 @@ extern void msg_aggr_sender_fini(void)
 	slurm_mutex_destroy(&msg_collection.mutex);
 }
 
-extern void msg_aggr_add_msg(slurm_msg_t *msg, bool wait,
-			     void (*resp_callback) (slurm_msg_t *msg))
+extern bool msg_aggr_type_enabled(uint16_t msg_type)
+{
+	return (msg_collection.running && _find_msg_aggr_type(msg_type));
+}
+
+extern int msg_aggr_add_msg(slurm_msg_t *msg, bool wait,
+			    void (*resp_callback) (slurm_msg_t *msg))
 {
-	int count;
+	int count, rc = SLURM_SUCCESS;
+	const msg_aggr_type_t *type;
+	struct timespec deadline;
 	static uint16_t msg_index = 1;
 	static uint32_t wait_count = 0;
 
 	if (!msg_collection.running)
-		return;
+		return SLURM_ERROR;
+	if (!(type = _find_msg_aggr_type(msg->msg_type))) {
+		error("%s: %s can not be aggregated", __func__,
+		      rpc_num2string(msg->msg_type));
+		return SLURM_ERROR;
+	}
+
+	_msg_aggr_pack(msg);
+	_deadline_set(&deadline, msg_collection.window / type->window_div);
 
 	slurm_mutex_lock(&msg_collection.mutex);
-	if (msg_collection.max_msgs == true) {
+	/* Collection is suspended while a window is being sent */
+	while (msg_collection.max_msgs && msg_collection.running)
 		slurm_cond_wait(&msg_collection.cond, &msg_collection.mutex);
-	}
 
 	msg->msg_index = msg_index++;
 
 	/* Add msg to message collection */
 	list_append(msg_collection.msg_list, msg);
+	msg_collection.msg_bytes += msg->data_size;
 
 	count = list_count(msg_collection.msg_list);
 
+	/* First msg in collection or more urgent one; (re)set window */
+	if ((count == 1) ||
+	    (deadline.tv_sec < msg_collection.deadline.tv_sec) ||
+	    ((deadline.tv_sec == msg_collection.deadline.tv_sec) &&
+	     (deadline.tv_nsec < msg_collection.deadline.tv_nsec))) {
+		msg_collection.deadline = deadline;
+		slurm_cond_broadcast(&msg_collection.cond);
+	}
 
-	/* First msg in collection; initiate new window */
-	if (count == 1)
-		slurm_cond_signal(&msg_collection.cond);
-
-	/* Max msgs reached; terminate window */
-	if (count >= msg_collection.max_msg_cnt) {
+	/* Max msgs or bytes reached; terminate window */
+	if ((count >= msg_collection.max_msg_cnt) ||
+	    (msg_collection.max_msg_bytes &&
+	     (msg_collection.msg_bytes >= msg_collection.max_msg_bytes))) {
 		msg_collection.max_msgs = true;
-		slurm_cond_signal(&msg_collection.cond);
+		slurm_cond_broadcast(&msg_collection.cond);
 	}
 	slurm_mutex_unlock(&msg_collection.mutex);
 
@@ -383,8 +484,10 @@ extern void msg_aggr_add_msg(slurm_msg_t *msg, bool wait,
 
 		if (pthread_cond_timedwait(&msg_aggr->wait_cond,
 					   &msg_collection.aggr_mutex,
-					   &timeout) == ETIMEDOUT)
+					   &timeout) == ETIMEDOUT) {
 			_handle_msg_aggr_ret(msg_aggr->msg_index, 1);
+			rc = SLURM_ERROR;
+		}
 		wait_count--;
 		slurm_mutex_unlock(&msg_collection.aggr_mutex);
 
@@ -392,6 +495,8 @@ extern void msg_aggr_add_msg(slurm_msg_t *msg, bool wait,
 			slurm_mutex_destroy(&msg_collection.aggr_mutex);
 		_msg_aggr_free(msg_aggr);
 	}
+
+	return rc;
 }
 
 extern void msg_aggr_add_comp(Buf buffer, void *auth_cred, header_t *header)
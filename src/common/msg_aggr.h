@@ -45,17 +45,24 @@
 #include "src/common/slurm_protocol_defs.h"
 
 extern void msg_aggr_sender_init(char *host, uint16_t port, uint64_t window,
-				 uint64_t max_msg_cnt);
-extern void msg_aggr_sender_reconfig(uint64_t window, uint64_t max_msg_cnt);
+				 uint64_t max_msg_cnt, uint64_t max_msg_bytes);
+extern void msg_aggr_sender_reconfig(uint64_t window, uint64_t max_msg_cnt,
+				     uint64_t max_msg_bytes);
 extern void msg_aggr_sender_fini(void);
 
+/* return true if messages of type msg_type can be aggregated right now */
+extern bool msg_aggr_type_enabled(uint16_t msg_type);
+
 /* add a message that needs to be sent.
- * IN: msg - message to be sent
+ * IN: msg - message to be sent, ownership passes to the aggregator unless
+ *	     msg_aggr_type_enabled(msg->msg_type) is false
  * IN: wait - whether or not we need to wait for a response
  * IN: resp_callback - function to process response
+ * RET: SLURM_SUCCESS, or SLURM_ERROR if the message type can not be
+ *	aggregated or no response arrived within MessageTimeout when waiting
  */
-extern void msg_aggr_add_msg(slurm_msg_t *msg, bool wait,
-			     void (*resp_callback) (slurm_msg_t *msg));
+extern int msg_aggr_add_msg(slurm_msg_t *msg, bool wait,
+			    void (*resp_callback) (slurm_msg_t *msg));
 extern void msg_aggr_add_comp(Buf buffer, void *auth_cred, header_t *header);
 extern void msg_aggr_resp(slurm_msg_t *msg);
 
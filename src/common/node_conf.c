@@ -74,6 +74,23 @@
 
 #define _DEBUG 0
 
+/* Longest numeric node name suffix handled by the node range index */
+#define NODE_RANGE_MAX_WIDTH 9
+
+/*
+ * A run of nodes with consecutive node table indexes whose names share a
+ * prefix and have consecutive numeric suffixes of the same width
+ * (e.g. "tux[08-15]"). Nodes without a numeric suffix get a range of
+ * their own with a NULL prefix.
+ */
+typedef struct {
+	char *prefix;		/* name prefix, NULL if no numeric suffix */
+	unsigned long lo;	/* numeric suffix of first node in range */
+	unsigned long hi;	/* numeric suffix of last node in range */
+	int width;		/* digits in numeric suffix */
+	int node_inx;		/* node table index of first node in range */
+} node_range_t;
+
 /* Global variables */
 List config_list  = NULL;	/* list of config_record entries */
 List front_end_list = NULL;	/* list of slurm_conf_frontend_t entries */
@@ -84,6 +101,16 @@ int node_record_count = 0;		/* count in node_record_table_ptr */
 uint16_t *cr_node_num_cores = NULL;
 uint32_t *cr_node_cores_offset = NULL;
 
+/* Node range index, built on demand from the node table */
+static pthread_mutex_t node_range_mutex = PTHREAD_MUTEX_INITIALIZER;
+static bool node_range_valid = false;
+static node_range_t *node_range_table = NULL;	/* in node table order */
+static node_range_t **node_range_sorted = NULL;	/* by prefix and suffix */
+static int node_range_cnt = 0;
+static int node_range_sorted_cnt = 0;
+static node_record_t *node_range_table_ptr = NULL;
+static int node_range_node_cnt = 0;
+
 /* Local function definitions */
 static int	_delete_config_record (void);
 #if _DEBUG
@@ -92,6 +119,17 @@ static void	_dump_hash (void);
 static node_record_t *_find_node_record(char *name, bool test_alias,
 					bool log_missing);
 static void	_list_delete_config (void *config_entry);
+static void _node_name2bitmap_host(char *name, bool best_effort,
+				   bitstr_t *bitmap, int *rc,
+				   const char *caller);
+static int  _node_names2bitmap(hostlist_t hl, bool best_effort,
+			       bitstr_t *bitmap, const char *caller);
+static bool _node_range2bitmap(char *prefix, unsigned long lo,
+			       unsigned long hi, int width, bitstr_t *bitmap);
+static bool _node_range_build(void);
+static int  _node_range_cmp(const void *x, const void *y);
+static void _node_range_free(void);
+static void _node_range_invalidate(void);
 static void _node_record_hash_identity (void* item, const char** key,
 					uint32_t* key_len);
 
@@ -169,6 +207,277 @@ static void _node_record_hash_identity (void* item, const char** key,
 	*key_len = strlen(node_ptr->name);
 }
 
+/* Sort node ranges by name prefix, then by first numeric suffix */
+static int _node_range_cmp(const void *x, const void *y)
+{
+	node_range_t *range1 = *(node_range_t **) x;
+	node_range_t *range2 = *(node_range_t **) y;
+	int rc;
+
+	rc = xstrcmp(range1->prefix, range2->prefix);
+	if (rc)
+		return rc;
+	if (range1->lo < range2->lo)
+		return -1;
+	if (range1->lo > range2->lo)
+		return 1;
+	return 0;
+}
+
+static void _node_range_free(void)
+{
+	int i;
+
+	for (i = 0; i < node_range_cnt; i++)
+		xfree(node_range_table[i].prefix);
+	xfree(node_range_table);
+	xfree(node_range_sorted);
+	node_range_cnt = 0;
+	node_range_sorted_cnt = 0;
+	node_range_table_ptr = NULL;
+	node_range_node_cnt = 0;
+	node_range_valid = false;
+}
+
+/*
+ * Build the node range index from the node table if it is not current.
+ * Names are split the way hostlist_create() splits them, so a hostlist
+ * range can be mapped directly to node table indexes.
+ * RET true if the index can be used
+ */
+static bool _node_range_build(void)
+{
+	node_record_t *node_ptr;
+	node_range_t *range = NULL;
+	char *name, *suffix;
+	unsigned long num;
+	int i, width, len;
+
+	slurm_mutex_lock(&node_range_mutex);
+	if (node_range_valid &&
+	    (node_range_table_ptr == node_record_table_ptr) &&
+	    (node_range_node_cnt == node_record_count)) {
+		slurm_mutex_unlock(&node_range_mutex);
+		return true;
+	}
+
+	_node_range_free();
+	if (!node_hash_table || (slurmdb_setup_cluster_name_dims() > 1)) {
+		slurm_mutex_unlock(&node_range_mutex);
+		return false;
+	}
+
+	node_range_table = xcalloc(node_record_count + 1,
+				   sizeof(node_range_t));
+	for (i = 0, node_ptr = node_record_table_ptr; i < node_record_count;
+	     i++, node_ptr++) {
+		name = node_ptr->name;
+		if (!name || (name[0] == '\0')) {
+			/* vestigial record, never matched by name */
+			range = NULL;
+			continue;
+		}
+
+		len = strlen(name);
+		suffix = name + len;
+		while ((suffix > name) && isdigit((int) suffix[-1]))
+			suffix--;
+		width = len - (suffix - name);
+		num = 0;
+		if ((width > 0) && (width <= NODE_RANGE_MAX_WIDTH))
+			num = strtoul(suffix, NULL, 10);
+		else
+			width = 0;
+
+		if (range && range->prefix && width &&
+		    (range->width == width) && (range->hi + 1 == num) &&
+		    (range->node_inx + (range->hi - range->lo) + 1 == i) &&
+		    !strncmp(range->prefix, name, suffix - name) &&
+		    (range->prefix[suffix - name] == '\0')) {
+			range->hi = num;
+			continue;
+		}
+
+		range = &node_range_table[node_range_cnt++];
+		range->node_inx = i;
+		if (width) {
+			range->prefix = xstrndup(name, suffix - name);
+			range->lo = num;
+			range->hi = num;
+			range->width = width;
+		}
+	}
+
+	node_range_sorted = xcalloc(node_range_cnt + 1,
+				    sizeof(node_range_t *));
+	for (i = 0; i < node_range_cnt; i++) {
+		if (node_range_table[i].prefix)
+			node_range_sorted[node_range_sorted_cnt++] =
+				&node_range_table[i];
+	}
+	qsort(node_range_sorted, node_range_sorted_cnt, sizeof(node_range_t *),
+	      _node_range_cmp);
+
+	node_range_table_ptr = node_record_table_ptr;
+	node_range_node_cnt = node_record_count;
+	node_range_valid = true;
+	slurm_mutex_unlock(&node_range_mutex);
+
+	return true;
+}
+
+/* Discard the node range index, it is rebuilt when next needed */
+static void _node_range_invalidate(void)
+{
+	slurm_mutex_lock(&node_range_mutex);
+	_node_range_free();
+	slurm_mutex_unlock(&node_range_mutex);
+}
+
+/*
+ * Set the bits for all nodes named "prefix[lo-hi]" (suffixes zero padded to
+ * width) using the node range index.
+ * RET true if every name in the range mapped to a node, otherwise false and
+ *     no bits are set
+ */
+static bool _node_range2bitmap(char *prefix, unsigned long lo,
+			       unsigned long hi, int width, bitstr_t *bitmap)
+{
+	node_range_t *range;
+	unsigned long next, first, last, min_num;
+	int low = 0, high = node_range_sorted_cnt, mid, i, start;
+	bool pass, done;
+
+	/* Find the last range with this prefix starting at or below lo */
+	while (low < high) {
+		mid = (low + high) / 2;
+		range = node_range_sorted[mid];
+		i = xstrcmp(range->prefix, prefix);
+		if ((i < 0) || ((i == 0) && (range->lo <= lo)))
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	if ((low == 0) || xstrcmp(node_range_sorted[low - 1]->prefix, prefix))
+		return false;
+	start = low - 1;
+
+	/*
+	 * The first pass checks that the ranges cover lo through hi with
+	 * names which print identically, the second pass sets the bits.
+	 * A name printed with the hostlist width has max(width, digits)
+	 * digits, so a node range of greater width only matches where its
+	 * suffixes have no leading zeros.
+	 */
+	for (pass = false; ; pass = true) {
+		next = lo;
+		done = false;
+		for (i = start; (i < node_range_sorted_cnt) && !done; i++) {
+			range = node_range_sorted[i];
+			if (xstrcmp(range->prefix, prefix) ||
+			    (range->lo > next))
+				break;
+			if (range->hi < next)
+				continue;
+			first = next;
+			last = MIN(range->hi, hi);
+			if (range->width != width) {
+				if (range->width < width)
+					return false;
+				for (min_num = 1, mid = 1; mid < range->width;
+				     mid++)
+					min_num *= 10;
+				if (first < min_num)
+					return false;
+			}
+			if (pass) {
+				bit_nset(bitmap,
+					 range->node_inx + (first - range->lo),
+					 range->node_inx + (last - range->lo));
+			}
+			if (last == hi)
+				done = true;
+			else
+				next = last + 1;
+		}
+		if (!done)
+			return false;
+		if (pass)
+			break;
+	}
+
+	return true;
+}
+
+/*
+ * Look up one node name and set its bit in bitmap.
+ * Logs an error and sets rc to EINVAL (unless best_effort) if not found.
+ */
+static void _node_name2bitmap_host(char *name, bool best_effort,
+				   bitstr_t *bitmap, int *rc,
+				   const char *caller)
+{
+	node_record_t *node_ptr;
+
+	node_ptr = _find_node_record(name, best_effort, true);
+	if (node_ptr) {
+		bit_set(bitmap, (bitoff_t) (node_ptr - node_record_table_ptr));
+	} else {
+		error("%s: invalid node specified %s", caller, name);
+		if (!best_effort)
+			*rc = EINVAL;
+	}
+}
+
+/*
+ * Set the bits for all nodes in a hostlist. Numeric ranges are mapped
+ * through the node range index, anything else is looked up host by host.
+ */
+static int _node_names2bitmap(hostlist_t hl, bool best_effort,
+			      bitstr_t *bitmap, const char *caller)
+{
+	int rc = SLURM_SUCCESS;
+	char *prefix, *name;
+	unsigned long lo, hi, num;
+	int i, width, range_rc;
+	hostlist_iterator_t hi_iter;
+
+	if (!_node_range_build()) {
+		hi_iter = hostlist_iterator_create(hl);
+		while ((name = hostlist_next(hi_iter))) {
+			_node_name2bitmap_host(name, best_effort, bitmap, &rc,
+					       caller);
+			free(name);
+		}
+		hostlist_iterator_destroy(hi_iter);
+		return rc;
+	}
+
+	for (i = 0; ; i++) {
+		range_rc = hostlist_nth_range_values(hl, i, &prefix, &lo, &hi,
+						     &width);
+		if (range_rc < 0)
+			break;
+		if (range_rc == 0) {
+			_node_name2bitmap_host(prefix, best_effort, bitmap,
+					       &rc, caller);
+			continue;
+		}
+		if (_node_range2bitmap(prefix, lo, hi, width, bitmap))
+			continue;
+		for (num = lo; ; num++) {
+			name = xstrdup_printf("%s%0*lu", prefix, width, num);
+			_node_name2bitmap_host(name, best_effort, bitmap, &rc,
+					       caller);
+			xfree(name);
+			if (num == hi)
+				break;
+		}
+	}
+
+	return rc;
+}
+
 /*
  * bitmap2hostlist - given a bitmap, build a hostlist
  * IN bitmap - bitmap pointer
@@ -178,7 +487,8 @@ static void _node_record_hash_identity (void* item, const char** key,
  */
 hostlist_t bitmap2hostlist (bitstr_t *bitmap)
 {
-	int i, first, last;
+	int i, j, first, last, range_first, range_last;
+	node_range_t *range;
 	hostlist_t hl;
 
 	if (bitmap == NULL)
@@ -190,10 +500,44 @@ hostlist_t bitmap2hostlist (bitstr_t *bitmap)
 
 	last  = bit_fls(bitmap);
 	hl = hostlist_create(NULL);
-	for (i = first; i <= last; i++) {
-		if (bit_test(bitmap, i) == 0)
+	if (!_node_range_build()) {
+		for (i = first; i <= last; i++) {
+			if (bit_test(bitmap, i) == 0)
+				continue;
+			hostlist_push_host(hl, node_record_table_ptr[i].name);
+		}
+		return hl;
+	}
+
+	/*
+	 * Push each run of set bits within a node range as one hostlist
+	 * range rather than building and parsing every node name.
+	 */
+	for (i = 0; i < node_range_cnt; i++) {
+		range = &node_range_table[i];
+		range_first = range->node_inx;
+		range_last = range_first + (range->hi - range->lo);
+		if ((range_last < first) || (range_first > last))
 			continue;
-		hostlist_push_host(hl, node_record_table_ptr[i].name);
+		if (!range->prefix) {
+			if (bit_test(bitmap, range_first))
+				hostlist_push_host(hl, node_record_table_ptr
+						   [range_first].name);
+			continue;
+		}
+		range_first = MAX(range_first, first);
+		range_last = MIN(range_last, last);
+		for (j = range_first; j <= range_last; j++) {
+			if (!bit_test(bitmap, j))
+				continue;
+			range_first = j;
+			while ((j < range_last) && bit_test(bitmap, j + 1))
+				j++;
+			hostlist_push_range_values(hl, range->prefix,
+				range->lo + (range_first - range->node_inx),
+				range->lo + (j - range->node_inx),
+				range->width);
+		}
 	}
 	return hl;
 
@@ -661,6 +1005,7 @@ extern node_record_t *create_node_record(config_record_t *config_ptr,
 	}
 	node_ptr = node_record_table_ptr + (node_record_count++);
 	node_ptr->name = xstrdup(node_name);
+	_node_range_invalidate();
 	if (!node_hash_table)
 		node_hash_table = xhash_init(_node_record_hash_identity, NULL);
 	xhash_add(node_hash_table, node_ptr);
@@ -797,6 +1142,7 @@ extern int init_node_conf (void)
 	node_record_count = 0;
 	xfree(node_record_table_ptr);
 	xhash_free(node_hash_table);
+	_node_range_invalidate();
 
 	if (config_list)	/* delete defunct configuration entries */
 		(void) _delete_config_record ();
@@ -821,6 +1167,7 @@ extern void node_fini2 (void)
 	}
 
 	xhash_free(node_hash_table);
+	_node_range_invalidate();
 	node_ptr = node_record_table_ptr;
 	for (i = 0; i < node_record_count; i++, node_ptr++)
 		purge_node_rec(node_ptr);
@@ -843,7 +1190,6 @@ extern int node_name2bitmap (char *node_names, bool best_effort,
 			     bitstr_t **bitmap)
 {
 	int rc = SLURM_SUCCESS;
-	char *this_node_name;
 	bitstr_t *my_bitmap;
 	hostlist_t host_list;
 
@@ -863,20 +1209,7 @@ extern int node_name2bitmap (char *node_names, bool best_effort,
 		return rc;
 	}
 
-	while ( (this_node_name = hostlist_shift (host_list)) ) {
-		node_record_t *node_ptr;
-		node_ptr = _find_node_record(this_node_name, best_effort, true);
-		if (node_ptr) {
-			bit_set (my_bitmap, (bitoff_t) (node_ptr -
-							node_record_table_ptr));
-		} else {
-			error ("node_name2bitmap: invalid node specified %s",
-			       this_node_name);
-			if (!best_effort)
-				rc = EINVAL;
-		}
-		free (this_node_name);
-	}
+	rc = _node_names2bitmap(host_list, best_effort, my_bitmap, __func__);
 	hostlist_destroy (host_list);
 
 	return rc;
@@ -891,34 +1224,13 @@ extern int node_name2bitmap (char *node_names, bool best_effort,
  */
 extern int hostlist2bitmap (hostlist_t hl, bool best_effort, bitstr_t **bitmap)
 {
-	int rc = SLURM_SUCCESS;
 	bitstr_t *my_bitmap;
-	char *name;
-	hostlist_iterator_t hi;
 
 	FREE_NULL_BITMAP(*bitmap);
 	my_bitmap = (bitstr_t *) bit_alloc (node_record_count);
 	*bitmap = my_bitmap;
 
-	hi = hostlist_iterator_create(hl);
-	while ((name = hostlist_next(hi))) {
-		node_record_t *node_ptr;
-		node_ptr = _find_node_record(name, best_effort, true);
-		if (node_ptr) {
-			bit_set (my_bitmap, (bitoff_t) (node_ptr -
-							node_record_table_ptr));
-		} else {
-			error ("hostlist2bitmap: invalid node specified %s",
-			       name);
-			if (!best_effort)
-				rc = EINVAL;
-		}
-		free (name);
-	}
-
-	hostlist_iterator_destroy(hi);
-	return rc;
-
+	return _node_names2bitmap(hl, best_effort, my_bitmap, __func__);
 }
 
 /* Purge the contents of a node record */
@@ -957,6 +1269,7 @@ extern void rehash_node (void)
 	node_record_t *node_ptr = node_record_table_ptr;
 
 	xhash_free (node_hash_table);
+	_node_range_invalidate();
 	node_hash_table = xhash_init(_node_record_hash_identity, NULL);
 	for (i = 0; i < node_record_count; i++, node_ptr++) {
 		if ((node_ptr->name == NULL) ||
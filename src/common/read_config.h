@@ -126,6 +126,7 @@ extern uint16_t drop_priv_flag;
 #define DEFAULT_MPI_DEFAULT         "none"
 #define DEFAULT_MSG_AGGR_WINDOW_MSGS 1
 #define DEFAULT_MSG_AGGR_WINDOW_TIME 100
+#define DEFAULT_MSG_AGGR_WINDOW_BYTES 1048576
 #define DEFAULT_MSG_TIMEOUT         10
 #define DEFAULT_POWER_PLUGIN        ""
 #if defined WITH_CGROUP
@@ -104,6 +104,9 @@ static plugin_context_t **g_context = NULL;
 static int g_context_num = -1;
 static pthread_mutex_t context_lock = PTHREAD_MUTEX_INITIALIZER;
 
+static uint32_t auth_stats[AUTH_STAT_CNT];
+static pthread_mutex_t stats_lock = PTHREAD_MUTEX_INITIALIZER;
+
 extern int slurm_auth_init(char *auth_type)
 {
 	int retval = SLURM_SUCCESS;
@@ -223,6 +226,24 @@ int slurm_auth_index(void *cred)
 	return 0;
 }
 
+extern void slurm_auth_stat_inc(auth_stat_t stat)
+{
+	xassert(stat < AUTH_STAT_CNT);
+
+	slurm_mutex_lock(&stats_lock);
+	auth_stats[stat]++;
+	slurm_mutex_unlock(&stats_lock);
+}
+
+extern void slurm_auth_stats_get(uint32_t *stats, bool reset)
+{
+	slurm_mutex_lock(&stats_lock);
+	memcpy(stats, auth_stats, sizeof(auth_stats));
+	if (reset)
+		memset(auth_stats, 0, sizeof(auth_stats));
+	slurm_mutex_unlock(&stats_lock);
+}
+
 /*
  * Static bindings for the global authentication context.  The test
  * of the function pointers is omitted here because the global
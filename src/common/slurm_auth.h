@@ -68,6 +68,17 @@
  */
 #define AUTH_DEFAULT_INDEX 0
 
+/*
+ * Calls made by the auth plugins to their authentication service (e.g.
+ * munged), as reported by sdiag.
+ */
+typedef enum {
+	AUTH_STAT_ENCODE,	/* credential created by the service */
+	AUTH_STAT_DECODE,	/* credential verified by the service */
+	AUTH_STAT_DECODE_CACHED,/* credential verified from local cache */
+	AUTH_STAT_CNT
+} auth_stat_t;
+
 /*
  * Prepare the global context.
  * auth_type IN: authentication mechanism (e.g. "auth/munge") or
@@ -86,6 +97,19 @@ extern int slurm_auth_fini(void);
  */
 extern int slurm_auth_index(void *cred);
 
+/*
+ * Count a call made to the authentication service, used by the plugins.
+ */
+extern void slurm_auth_stat_inc(auth_stat_t stat);
+
+/*
+ * Get the counts of calls made to the authentication service since the last
+ * reset.
+ * OUT stats - array of AUTH_STAT_CNT counters indexed by auth_stat_t
+ * IN reset - clear the counters after reading them
+ */
+extern void slurm_auth_stats_get(uint32_t *stats, bool reset);
+
 /*
  * Static bindings for the global authentication context.
  */
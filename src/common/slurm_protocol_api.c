@@ -55,6 +55,13 @@
 #include <time.h>
 #include <unistd.h>
 
+#if HAVE_LIBZ
+#  include <zlib.h>
+#endif
+#if HAVE_LZ4
+#  include <lz4.h>
+#endif
+
 /* PROJECT INCLUDES */
 #include "src/common/assoc_mgr.h"
 #include "src/common/fd.h"
@@ -72,6 +79,7 @@
 #include "src/common/slurm_protocol_pack.h"
 #include "src/common/slurm_route.h"
 #include "src/common/strlcpy.h"
+#include "src/common/timers.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
 #include "src/slurmdbd/read_config.h"
@@ -87,14 +95,50 @@ strong_alias(get_unit_type, slurm_get_unit_type);
 /* #DEFINES */
 #define _DEBUG	0
 
+/* Default minimum message body size to compress (CompressMsgsMin) */
+#define DEFAULT_COMPRESS_MIN	(64 * 1024)
+
+#define MSG_COMPRESS_FLAGS	(SLURM_MSG_COMPRESSED | SLURM_MSG_ACCEPT_ZLIB | \
+				 SLURM_MSG_ACCEPT_LZ4)
+
+/* Connections to slurmd cached for reuse (PersistNodeConns) */
+#define CONN_CACHE_MAX		4096
+
+typedef struct {
+	slurm_addr_t addr;
+	int fd;
+	time_t last_used;
+} conn_cache_t;
+
 /* STATIC VARIABLES */
 static int message_timeout = -1;
+static pthread_mutex_t conn_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static conn_cache_t *conn_cache = NULL;
+static int conn_cache_cnt = 0;
+static int conn_cache_enabled = -1;
+static int conn_cache_idle = 0;
+static pthread_mutex_t compress_mutex = PTHREAD_MUTEX_INITIALIZER;
+static bool compress_inited = false;
+static uint16_t compress_type = COMPRESS_OFF;
+static uint32_t compress_min = DEFAULT_COMPRESS_MIN;
 
 /* STATIC FUNCTIONS */
+static bool  _compress_msg_body(header_t *hdr, uint16_t peer_flags,
+				Buf buffer, uint32_t body_offset,
+				char *body, uint32_t body_len);
+static uint16_t _compress_type(header_t *hdr, uint16_t peer_flags,
+			       uint32_t body_len);
+static bool  _conn_cache_enable(void);
+static int   _conn_cache_get(slurm_addr_t *addr);
+static void  _conn_cache_put(slurm_addr_t *addr, int fd);
 static char *_global_auth_key(void);
+static void  _pack_msg_header(header_t *hdr, uint32_t msglen, Buf buffer);
 static void  _remap_slurmctld_errno(void);
+static int   _uncompress_msg_body(header_t *hdr, Buf buffer);
 static int   _unpack_msg_uid(Buf buffer, uint16_t protocol_version);
 static bool  _is_port_ok(int, uint16_t, bool);
+static bool  _wait_for_reply(int fd, int timeout);
+static bool  _forwarder_alive(int fd, slurm_msg_t *req, int timeout);
 
 #if _DEBUG
 static void _print_data(char *data, int len);
@@ -586,6 +630,34 @@ uint16_t slurm_get_msg_timeout(void)
 	return msg_timeout;
 }
 
+/* slurm_get_ping_interval
+ * get how many seconds apart slurmctld pings each node, SlurmdTimeout/3 or
+ * 100 seconds without a SlurmdTimeout
+ */
+extern int slurm_get_ping_interval(void)
+{
+	slurm_ctl_conf_t *conf;
+	int ping_interval;
+
+	conf = slurm_conf_lock();
+	ping_interval = conf->slurmd_timeout ? (conf->slurmd_timeout / 3) : 100;
+	slurm_conf_unlock();
+
+	return ping_interval;
+}
+
+/* slurm_get_keep_conn_time
+ * get how many seconds a connection flagged with SLURM_MSG_KEEP_CONN may be
+ * idle and still be reused. slurmctld sends each node a ping or other
+ * periodic RPC at least every other ping interval, so this covers two and a
+ * half of them. slurmd keeps the connection open KEEP_CONN_SLACK seconds
+ * longer.
+ */
+extern int slurm_get_keep_conn_time(void)
+{
+	return (slurm_get_ping_interval() * 5) / 2;
+}
+
 /* slurm_get_plugin_dir
  * get plugin directory from slurmctld_conf object
  * RET char *   - plugin directory, MUST be xfreed by caller
@@ -3415,6 +3487,13 @@ extern int slurm_unpack_received_msg(slurm_msg_t *msg, int fd, Buf buffer)
 		goto total_return;
 	}
 
+	if ((header.flags & SLURM_MSG_COMPRESSED) &&
+	    (_uncompress_msg_body(&header, buffer) != SLURM_SUCCESS)) {
+		(void) g_slurm_auth_destroy(auth_cred);
+		rc = ESLURM_PROTOCOL_INCOMPLETE_PACKET;
+		goto total_return;
+	}
+
 	/*
 	 * Unpack message body
 	 */
@@ -3689,6 +3768,14 @@ List slurm_receive_msgs(int fd, int steps, int timeout)
 		goto total_return;
 	}
 
+	if ((header.flags & SLURM_MSG_COMPRESSED) &&
+	    (_uncompress_msg_body(&header, buffer) != SLURM_SUCCESS)) {
+		(void) g_slurm_auth_destroy(auth_cred);
+		free_buf(buffer);
+		rc = ESLURM_PROTOCOL_INCOMPLETE_PACKET;
+		goto total_return;
+	}
+
 	/*
 	 * Unpack message body
 	 */
@@ -3926,6 +4013,14 @@ int slurm_receive_msg_and_forward(int fd, slurm_addr_t *orig_addr,
 		goto total_return;
 	}
 
+	if ((header.flags & SLURM_MSG_COMPRESSED) &&
+	    (_uncompress_msg_body(&header, buffer) != SLURM_SUCCESS)) {
+		(void) g_slurm_auth_destroy(auth_cred);
+		free_buf(buffer);
+		rc = ESLURM_PROTOCOL_INCOMPLETE_PACKET;
+		goto total_return;
+	}
+
 	/*
 	 * Unpack message body
 	 */
@@ -3985,6 +4080,238 @@ _pack_msg(slurm_msg_t *msg, header_t *hdr, Buf buffer)
 	pack_msg(msg, buffer);
 	msglen = get_buf_offset(buffer) - tmplen;
 
+	if (!_compress_msg_body(hdr, msg->flags, buffer, tmplen,
+				&buffer->head[tmplen], msglen))
+		_pack_msg_header(hdr, msglen, buffer);
+}
+
+/*
+ *  Read the CompressMsgs and CompressMsgsMin CommunicationParameters once
+ */
+static void _compress_init(void)
+{
+	char *comm_params, *tmp_ptr;
+
+	slurm_mutex_lock(&compress_mutex);
+	if (compress_inited) {
+		slurm_mutex_unlock(&compress_mutex);
+		return;
+	}
+
+	comm_params = slurm_get_comm_parameters();
+	if ((tmp_ptr = xstrcasestr(comm_params, "CompressMsgs="))) {
+		tmp_ptr += strlen("CompressMsgs=");
+		if (!xstrncasecmp(tmp_ptr, "zlib", 4))
+			compress_type = COMPRESS_ZLIB;
+		else if (!xstrncasecmp(tmp_ptr, "lz4", 3))
+			compress_type = COMPRESS_LZ4;
+		else
+			error("Invalid CommunicationParameters CompressMsgs value: %s",
+			      tmp_ptr);
+	}
+	if ((tmp_ptr = xstrcasestr(comm_params, "CompressMsgsMin=")))
+		compress_min = strtoul(tmp_ptr + strlen("CompressMsgsMin="),
+				       NULL, 10);
+	xfree(comm_params);
+
+#if !HAVE_LZ4
+	if (compress_type == COMPRESS_LZ4) {
+		error("CompressMsgs=lz4 requested, but lz4 support not built, using zlib");
+		compress_type = COMPRESS_ZLIB;
+	}
+#endif
+#if !HAVE_LIBZ
+	if (compress_type == COMPRESS_ZLIB) {
+		error("CompressMsgs=zlib requested, but zlib support not built, messages will not be compressed");
+		compress_type = COMPRESS_OFF;
+	}
+#endif
+	compress_inited = true;
+	slurm_mutex_unlock(&compress_mutex);
+}
+
+/*
+ *  Pick the compression algorithm for a message body of body_len bytes.
+ *  peer_flags are the header flags of the message being replied to, a body
+ *  is only compressed with an algorithm the peer advertised there it can
+ *  decode. Nothing is advertised to the sender of a request, so requests
+ *  and replies to older or unknown peers are sent as is.
+ *  RET COMPRESS_OFF, COMPRESS_ZLIB or COMPRESS_LZ4
+ */
+static uint16_t _compress_type(header_t *hdr, uint16_t peer_flags,
+			       uint32_t body_len)
+{
+	uint16_t type;
+
+	if (!compress_inited)
+		_compress_init();
+
+	if ((compress_type == COMPRESS_OFF) || (body_len < compress_min) ||
+	    (hdr->msg_type == MESSAGE_COMPOSITE))
+		return COMPRESS_OFF;
+
+	type = compress_type;
+	if ((type == COMPRESS_LZ4) && !(peer_flags & SLURM_MSG_ACCEPT_LZ4))
+		type = COMPRESS_ZLIB;
+#if !HAVE_LIBZ
+	if (type == COMPRESS_ZLIB)
+		type = COMPRESS_OFF;
+#endif
+	if ((type == COMPRESS_ZLIB) && !(peer_flags & SLURM_MSG_ACCEPT_ZLIB))
+		type = COMPRESS_OFF;
+
+	return type;
+}
+
+/*
+ *  Compress a message body into buffer at body_offset, in the form
+ *  <uint8_t algorithm><uint32_t uncompressed size><compressed data>, and
+ *  repack the header with the SLURM_MSG_COMPRESSED flag and new body length.
+ *  The body may already reside in buffer at body_offset.
+ *  RET true if the body was compressed, false if it should be sent as is
+ */
+static bool _compress_msg_body(header_t *hdr, uint16_t peer_flags,
+			       Buf buffer, uint32_t body_offset,
+			       char *body, uint32_t body_len)
+{
+	uint16_t type = _compress_type(hdr, peer_flags, body_len);
+	char *out_buf = NULL;
+	uint32_t out_len = 0;
+	DEF_TIMERS;
+
+	if (type == COMPRESS_OFF)
+		return false;
+
+	START_TIMER;
+#if HAVE_LIBZ
+	if (type == COMPRESS_ZLIB) {
+		uLongf zlen = compressBound(body_len);
+		out_buf = xmalloc_nz(zlen);
+		if (compress2((Bytef *) out_buf, &zlen, (Bytef *) body,
+			      body_len, Z_BEST_SPEED) != Z_OK) {
+			error("%s: zlib compression error", __func__);
+			zlen = 0;
+		}
+		out_len = zlen;
+	}
+#endif
+#if HAVE_LZ4
+	if (type == COMPRESS_LZ4) {
+		int lz4_len = LZ4_compressBound(body_len);
+		out_buf = xmalloc_nz(lz4_len);
+		lz4_len = LZ4_compress_default(body, out_buf, body_len,
+					       lz4_len);
+		if (lz4_len <= 0) {
+			error("%s: lz4 compression error", __func__);
+			lz4_len = 0;
+		}
+		out_len = lz4_len;
+	}
+#endif
+	END_TIMER3(__func__, 1000000);
+
+	/* Not worth sending compressed */
+	if (!out_len || ((out_len + 5) >= body_len)) {
+		xfree(out_buf);
+		return false;
+	}
+
+	set_buf_offset(buffer, body_offset);
+	pack8((uint8_t) type, buffer);
+	pack32(body_len, buffer);
+	packmem_array(out_buf, out_len, buffer);
+	xfree(out_buf);
+
+	debug3("%s: %s compressed from %u to %u bytes in %s", __func__,
+	       rpc_num2string(hdr->msg_type), body_len, out_len + 5, TIME_STR);
+
+	hdr->flags |= SLURM_MSG_COMPRESSED;
+	_pack_msg_header(hdr, get_buf_offset(buffer) - body_offset, buffer);
+
+	return true;
+}
+
+/*
+ *  Replace a compressed message body (see _compress_msg_body()) which
+ *  starts at the current buffer offset with the uncompressed data, leaving
+ *  any preceding header and credential in place.
+ *  RET SLURM_SUCCESS or SLURM_ERROR
+ */
+static int _uncompress_msg_body(header_t *hdr, Buf buffer)
+{
+	uint8_t type;
+	uint32_t orig_len, in_len, body_offset = get_buf_offset(buffer);
+	char *in_buf, *new_head;
+	int rc = SLURM_ERROR;
+
+	safe_unpack8(&type, buffer);
+	safe_unpack32(&orig_len, buffer);
+	if (orig_len > MAX_BUF_SIZE - body_offset) {
+		error("%s: Invalid uncompressed size %u", __func__, orig_len);
+		return SLURM_ERROR;
+	}
+	in_buf = &buffer->head[get_buf_offset(buffer)];
+	in_len = remaining_buf(buffer);
+
+	new_head = xmalloc_nz(body_offset + orig_len);
+	memcpy(new_head, buffer->head, body_offset);
+
+	switch (type) {
+#if HAVE_LIBZ
+	case COMPRESS_ZLIB:
+	{
+		uLongf zlen = orig_len;
+		if ((uncompress((Bytef *) &new_head[body_offset], &zlen,
+				(Bytef *) in_buf, in_len) == Z_OK) &&
+		    (zlen == orig_len))
+			rc = SLURM_SUCCESS;
+		break;
+	}
+#endif
+#if HAVE_LZ4
+	case COMPRESS_LZ4:
+		if (LZ4_decompress_safe(in_buf, &new_head[body_offset], in_len,
+					orig_len) == orig_len)
+			rc = SLURM_SUCCESS;
+		break;
+#endif
+	default:
+		error("%s: Unsupported compression type %u", __func__, type);
+		xfree(new_head);
+		return SLURM_ERROR;
+	}
+
+	if (rc != SLURM_SUCCESS) {
+		error("%s: Failed to uncompress %s body", __func__,
+		      rpc_num2string(hdr->msg_type));
+		xfree(new_head);
+		return SLURM_ERROR;
+	}
+
+	xfree(buffer->head);
+	buffer->head = new_head;
+	buffer->size = body_offset + orig_len;
+	set_buf_offset(buffer, body_offset);
+
+	hdr->body_length = orig_len;
+	hdr->flags &= ~SLURM_MSG_COMPRESSED;
+
+	return SLURM_SUCCESS;
+
+unpack_error:
+	error("%s: Incomplete compressed message", __func__);
+	return SLURM_ERROR;
+}
+
+/*
+ *  Update the header with the message body length and repack it at the
+ *  start of buffer, which already holds the header and auth credential
+ */
+static void
+_pack_msg_header(header_t *hdr, uint32_t msglen, Buf buffer)
+{
+	unsigned int tmplen;
+
 	/* update header with correct cred and msg lengths */
 	update_header(hdr, msglen);
 
@@ -3995,6 +4322,28 @@ _pack_msg(slurm_msg_t *msg, header_t *hdr, Buf buffer)
 	set_buf_offset(buffer, tmplen);
 }
 
+/*
+ * slurm_msg_auth_create - create the authentication credential used to send
+ *	a message, honoring its auth_index and SLURM_GLOBAL_AUTH_KEY flag.
+ * IN msg		- message to be sent
+ * RET credential to be destroyed with g_slurm_auth_destroy() or NULL
+ */
+extern void *slurm_msg_auth_create(slurm_msg_t *msg)
+{
+	void *auth_cred;
+
+	if (msg->flags & SLURM_GLOBAL_AUTH_KEY) {
+		auth_cred = g_slurm_auth_create(msg->auth_index,
+						_global_auth_key());
+	} else {
+		char *auth_info = slurm_get_auth_info();
+		auth_cred = g_slurm_auth_create(msg->auth_index, auth_info);
+		xfree(auth_info);
+	}
+
+	return auth_cred;
+}
+
 /*
  *  Send a slurm message over an open file descriptor `fd'
  *    Returns the size of the message sent in bytes, or -1 on failure.
@@ -4004,7 +4353,7 @@ int slurm_send_node_msg(int fd, slurm_msg_t * msg)
 	header_t header;
 	Buf      buffer;
 	int      rc;
-	void *   auth_cred;
+	void *   auth_cred = NULL;
 	time_t   start_time = time(NULL);
 
 	if (msg->conn) {
@@ -4046,16 +4395,11 @@ int slurm_send_node_msg(int fd, slurm_msg_t * msg)
 	 * We get the credential now rather than later so the work can
 	 * can be done in parallel with waiting for message to forward,
 	 * but we may need to generate the credential again later if we
-	 * wait too long for the incoming message.
+	 * wait too long for the incoming message. A credential shared by a
+	 * fanout was already created by the caller.
 	 */
-	if (msg->flags & SLURM_GLOBAL_AUTH_KEY) {
-		auth_cred = g_slurm_auth_create(msg->auth_index,
-						_global_auth_key());
-	} else {
-		char *auth_info = slurm_get_auth_info();
-		auth_cred = g_slurm_auth_create(msg->auth_index, auth_info);
-		xfree(auth_info);
-	}
+	if (!msg->auth_cred_shared)
+		auth_cred = slurm_msg_auth_create(msg);
 
 	if (msg->forward.init != FORWARD_INIT) {
 		forward_init(&msg->forward);
@@ -4068,23 +4412,21 @@ int slurm_send_node_msg(int fd, slurm_msg_t * msg)
 	forward_wait(msg);
 
 	if (difftime(time(NULL), start_time) >= 60) {
-		(void) g_slurm_auth_destroy(auth_cred);
-		if (msg->flags & SLURM_GLOBAL_AUTH_KEY) {
-			auth_cred = g_slurm_auth_create(msg->auth_index,
-							_global_auth_key());
-		} else {
-			char *auth_info = slurm_get_auth_info();
-			auth_cred = g_slurm_auth_create(msg->auth_index,
-							auth_info);
-			xfree(auth_info);
-		}
-	}
+		if (auth_cred)
+			(void) g_slurm_auth_destroy(auth_cred);
+		auth_cred = slurm_msg_auth_create(msg);
+	} else if (msg->auth_cred_shared)
+		auth_cred = msg->auth_cred_shared;
 	if (auth_cred == NULL) {
 		error("authentication: %m");
 		slurm_seterrno_ret(SLURM_PROTOCOL_AUTHENTICATION_ERROR);
 	}
 
 	init_header(&header, msg, msg->flags);
+	/* Compression flags describe this message, not the one replied to */
+	header.flags &= ~MSG_COMPRESS_FLAGS;
+	if (header.version >= SLURM_20_02_PROTOCOL_VERSION)
+		header.flags |= SLURM_MSG_ACCEPT_BUILD;
 
 	/*
 	 * Pack header into buffer for transmission
@@ -4096,26 +4438,50 @@ int slurm_send_node_msg(int fd, slurm_msg_t * msg)
 	 * Pack auth credential
 	 */
 	rc = g_slurm_auth_pack(auth_cred, buffer, header.version);
-	(void) g_slurm_auth_destroy(auth_cred);
+	if (auth_cred != msg->auth_cred_shared)
+		(void) g_slurm_auth_destroy(auth_cred);
 	if (rc) {
 		error("authentication: %m");
 		free_buf(buffer);
 		slurm_seterrno_ret(SLURM_PROTOCOL_AUTHENTICATION_ERROR);
 	}
 
-	/*
-	 * Pack message into buffer
-	 */
-	_pack_msg(msg, &header, buffer);
+	if (pack_msg_is_prepacked(msg) &&
+	    _compress_msg_body(&header, msg->flags, buffer,
+			       get_buf_offset(buffer), msg->data,
+			       msg->data_size)) {
+		rc = slurm_msg_sendto(fd, get_buf_data(buffer),
+				      get_buf_offset(buffer));
+	} else if (pack_msg_is_prepacked(msg)) {
+		/*
+		 * The message body is already packed (e.g. job or node
+		 * information cached by slurmctld), so send it directly
+		 * after the header rather than copying it into the buffer.
+		 */
+		struct iovec iov[2];
+
+		_pack_msg_header(&header, msg->data_size, buffer);
+		iov[0].iov_base = get_buf_data(buffer);
+		iov[0].iov_len  = get_buf_offset(buffer);
+		iov[1].iov_base = msg->data;
+		iov[1].iov_len  = msg->data_size;
+		rc = slurm_msg_sendv_timeout(fd, iov, 2,
+					     (slurm_get_msg_timeout() * 1000));
+	} else {
+		/*
+		 * Pack message into buffer
+		 */
+		_pack_msg(msg, &header, buffer);
 
 #if	_DEBUG
-	_print_data (get_buf_data(buffer),get_buf_offset(buffer));
+		_print_data (get_buf_data(buffer),get_buf_offset(buffer));
 #endif
-	/*
-	 * Send message
-	 */
-	rc = slurm_msg_sendto(fd, get_buf_data(buffer),
-			      get_buf_offset(buffer));
+		/*
+		 * Send message
+		 */
+		rc = slurm_msg_sendto(fd, get_buf_data(buffer),
+				      get_buf_offset(buffer));
+	}
 
 	if ((rc < 0) && (errno == ENOTCONN)) {
 		debug3("slurm_msg_sendto: peer has disappeared for msg_type=%u",
@@ -4508,6 +4874,52 @@ _send_and_recv_msg(int fd, slurm_msg_t *req,
 	return rc;
 }
 
+/*
+ * Wait up to timeout msec for data to read on fd
+ * RET true if data is available (or the connection was closed)
+ */
+static bool _wait_for_reply(int fd, int timeout)
+{
+	struct pollfd pfd;
+	struct timeval tstart, tnow;
+	int rc, time_left = timeout;
+
+	pfd.fd = fd;
+	pfd.events = POLLIN;
+	gettimeofday(&tstart, NULL);
+	while ((rc = poll(&pfd, 1, time_left)) < 0) {
+		if ((errno != EINTR) && (errno != EAGAIN))
+			return true;	/* let the receive report the error */
+		gettimeofday(&tnow, NULL);
+		time_left = timeout - ((tnow.tv_sec - tstart.tv_sec) * 1000 +
+				       (tnow.tv_usec - tstart.tv_usec) / 1000);
+		if (time_left <= 0)
+			return false;
+	}
+
+	return (rc > 0);
+}
+
+/*
+ * Test if the node at the other end of fd, forwarding req and not yet done,
+ * still responds to a ping within timeout msec. A forwarder waiting on
+ * unresponsive children does, a hung one does not.
+ */
+static bool _forwarder_alive(int fd, slurm_msg_t *req, int timeout)
+{
+	slurm_msg_t ping_msg;
+	int rc;
+
+	slurm_msg_t_init(&ping_msg);
+	if (slurm_get_peer_addr(fd, &ping_msg.address))
+		return false;
+	ping_msg.msg_type = REQUEST_PING;
+	ping_msg.flags = req->flags & ~SLURM_MSG_KEEP_CONN;
+	ping_msg.protocol_version = req->protocol_version;
+
+	return (slurm_send_recv_rc_msg_only_one(&ping_msg, &rc, timeout) == 0);
+}
+
 /*
  * Send and recv a slurm request and response on the open slurm descriptor
  * with a list containing the responses of the children (if any) we
@@ -4515,14 +4927,17 @@ _send_and_recv_msg(int fd, slurm_msg_t *req,
  * IN fd	- file descriptor to receive msg on
  * IN req	- a slurm_msg struct to be sent by the function
  * IN timeout	- how long to wait in milliseconds
+ * IN/OUT keep_conn - if NULL or false the connection is closed, if true
+ *		  it is left open unless the exchange failed (then set false)
  * RET List	- List containing the responses of the children (if any) we
  *		  forwarded the message to. List containing type
  *		  (ret_data_info_t).
  */
 static List
-_send_and_recv_msgs(int fd, slurm_msg_t *req, int timeout)
+_send_and_recv_msgs(int fd, slurm_msg_t *req, int timeout, bool *keep_conn)
 {
 	List ret_list = NULL;
+	ret_data_info_t *ret_data_info;
 	int steps = 0;
 
 	if (!req->forward.timeout) {
@@ -4551,12 +4966,115 @@ _send_and_recv_msgs(int fd, slurm_msg_t *req, int timeout)
 
 			timeout += (req->forward.timeout*steps);
 		}
-		ret_list = slurm_receive_msgs(fd, steps, timeout);
+		if (req->forward.deadline && (req->forward.cnt > 0) &&
+		    (req->forward.deadline < timeout) &&
+		    !_wait_for_reply(fd, req->forward.deadline) &&
+		    !_forwarder_alive(fd, req, req->forward.deadline)) {
+			/* Caller will route around this forwarder */
+			req->forward.straggler = true;
+			slurm_seterrno(SLURM_PROTOCOL_SOCKET_IMPL_TIMEOUT);
+		} else
+			ret_list = slurm_receive_msgs(fd, steps, timeout);
+		/* A failed receive is pushed first, see slurm_receive_msgs() */
+		if (keep_conn &&
+		    (!ret_list || !(ret_data_info = list_peek(ret_list)) ||
+		     (ret_data_info->type == RESPONSE_FORWARD_FAILED)))
+			*keep_conn = false;
+	} else if (keep_conn)
+		*keep_conn = false;
+
+	if (!keep_conn || !*keep_conn)
+		(void) close(fd);
+
+	return ret_list;
+}
+
+/*
+ *  Test if connections to slurmd should be cached and reused for messages
+ *  flagged with SLURM_MSG_KEEP_CONN (CommunicationParameters=PersistNodeConns)
+ */
+static bool _conn_cache_enable(void)
+{
+	if (conn_cache_enabled == -1) {
+		char *comm_params = slurm_get_comm_parameters();
+
+		slurm_mutex_lock(&conn_cache_mutex);
+		if (xstrcasestr(comm_params, "PersistNodeConns")) {
+			conn_cache_idle = slurm_get_keep_conn_time();
+			conn_cache_enabled = 1;
+		} else
+			conn_cache_enabled = 0;
+		slurm_mutex_unlock(&conn_cache_mutex);
+		xfree(comm_params);
 	}
 
-	(void) close(fd);
+	return (conn_cache_enabled == 1);
+}
 
-	return ret_list;
+/*
+ *  Remove and return an idle cached connection to addr.
+ *  Connections idle too long or closed by the remote end are discarded.
+ *  RET open file descriptor or -1 if none available
+ */
+static int _conn_cache_get(slurm_addr_t *addr)
+{
+	time_t now = time(NULL);
+	struct pollfd pfd;
+	int i, fd = -1;
+
+	slurm_mutex_lock(&conn_cache_mutex);
+	for (i = 0; i < conn_cache_cnt; ) {
+		conn_cache_t *conn = &conn_cache[i];
+		bool match = ((conn->addr.sin_addr.s_addr ==
+			       addr->sin_addr.s_addr) &&
+			      (conn->addr.sin_port == addr->sin_port));
+
+		if (!match && ((now - conn->last_used) <= conn_cache_idle)) {
+			i++;
+			continue;
+		}
+
+		if (match && ((now - conn->last_used) <= conn_cache_idle))
+			fd = conn->fd;
+		else
+			(void) close(conn->fd);
+		conn_cache[i] = conn_cache[--conn_cache_cnt];
+
+		if (fd < 0)
+			continue;
+
+		/* Any pending data or EOF means slurmd is done with it */
+		pfd.fd = fd;
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+		if (poll(&pfd, 1, 0) == 0)
+			break;
+		(void) close(fd);
+		fd = -1;
+	}
+	slurm_mutex_unlock(&conn_cache_mutex);
+
+	return fd;
+}
+
+/*
+ *  Return a connection to addr to the cache for reuse
+ */
+static void _conn_cache_put(slurm_addr_t *addr, int fd)
+{
+	slurm_mutex_lock(&conn_cache_mutex);
+	if (conn_cache_cnt >= CONN_CACHE_MAX) {
+		slurm_mutex_unlock(&conn_cache_mutex);
+		(void) close(fd);
+		return;
+	}
+	if (!conn_cache)
+		conn_cache = xcalloc(CONN_CACHE_MAX, sizeof(conn_cache_t));
+	conn_cache[conn_cache_cnt].addr = *addr;
+	conn_cache[conn_cache_cnt].fd = fd;
+	conn_cache[conn_cache_cnt].last_used = time(NULL);
+	conn_cache_cnt++;
+	slurm_mutex_unlock(&conn_cache_mutex);
 }
 
 /*
@@ -4913,15 +5431,29 @@ List slurm_send_addr_recv_msgs(slurm_msg_t *msg, char *name, int timeout)
 	ret_data_info_t *ret_data_info = NULL;
 	ListIterator itr;
 	int i;
+	bool keep_conn = false, reused = false;
 
 	slurm_mutex_lock(&conn_lock);
 	if (conn_timeout == NO_VAL16)
 		conn_timeout = MIN(slurm_get_msg_timeout(), 10);
 	slurm_mutex_unlock(&conn_lock);
 
+	if (msg->flags & SLURM_MSG_KEEP_CONN) {
+		if (_conn_cache_enable() &&
+		    ((msg->protocol_version == NO_VAL16) ||
+		     (msg->protocol_version >= SLURM_20_02_PROTOCOL_VERSION)))
+			keep_conn = true;
+		else
+			msg->flags &= ~SLURM_MSG_KEEP_CONN;
+	}
+
+again:
+	if (keep_conn && ((fd = _conn_cache_get(&msg->address)) >= 0))
+		reused = true;
+
 	/* This connect retry logic permits Slurm hierarchical communications
 	 * to better survive slurmd restarts */
-	for (i = 0; i <= conn_timeout; i++) {
+	for (i = 0; (fd < 0) && (i <= conn_timeout); i++) {
 		if (i)
 			sleep(1);
 		fd = slurm_open_msg_conn(&msg->address);
@@ -4939,7 +5471,28 @@ List slurm_send_addr_recv_msgs(slurm_msg_t *msg, char *name, int timeout)
 
 	msg->ret_list = NULL;
 	msg->forward_struct = NULL;
-	if (!(ret_list = _send_and_recv_msgs(fd, msg, timeout))) {
+	ret_list = _send_and_recv_msgs(fd, msg, timeout,
+				       keep_conn ? &keep_conn : NULL);
+	if (keep_conn)
+		_conn_cache_put(&msg->address, fd);
+	else if (!ret_list && reused && !msg->forward.straggler) {
+		/*
+		 * The cached connection was closed by slurmd. Only messages
+		 * which are safe to repeat are sent on cached connections,
+		 * so retry once on a new connection.
+		 */
+		debug2("%s: cached connection to %s failed, reconnecting",
+		       __func__, name);
+		keep_conn = true;
+		reused = false;
+		fd = -1;
+		/* The peer may have seen a credential shared by a fanout */
+		msg->auth_cred_shared = NULL;
+		while ((fd = _conn_cache_get(&msg->address)) >= 0)
+			(void) close(fd);
+		goto again;
+	}
+	if (!ret_list) {
 		mark_as_failed_forward(&ret_list, name, errno);
 		errno = SLURM_COMMUNICATIONS_CONNECTION_ERROR;
 		return ret_list;
@@ -220,6 +220,18 @@ char *slurm_get_msg_aggr_params(void);
  */
 extern uint16_t slurm_get_msg_timeout(void);
 
+/* slurm_get_ping_interval
+ * get how many seconds apart slurmctld pings each node, from
+ * slurmctld_conf object
+ */
+extern int slurm_get_ping_interval(void);
+
+/* slurm_get_keep_conn_time
+ * get how long a connection flagged with SLURM_MSG_KEEP_CONN may be idle
+ * and still be reused, from slurmctld_conf object
+ */
+extern int slurm_get_keep_conn_time(void);
+
 /* slurm_get_reboot_program
  * RET char * - RebootProgram from slurm.conf, MUST be xfreed by caller
  */
@@ -1101,6 +1113,17 @@ int slurm_receive_msg_and_forward(int fd, slurm_addr_t *orig_addr,
  * send message functions
 \**********************************************************************/
 
+/*
+ * slurm_msg_auth_create - create the authentication credential used to send
+ *	a message, honoring its auth_index and SLURM_GLOBAL_AUTH_KEY flag.
+ *	A credential created once may be stored in msg->auth_cred_shared for
+ *	copies of the message sent to distinct hosts, since the receiving
+ *	hosts each accept it once. It must never be sent twice to one host.
+ * IN msg		- message to be sent
+ * RET credential to be destroyed with g_slurm_auth_destroy() or NULL
+ */
+extern void *slurm_msg_auth_create(slurm_msg_t *msg);
+
 /* sends a message to an arbitrary node
  *
  * IN open_fd		- file descriptor to send msg on
@@ -105,5 +105,34 @@
 #define SLURM_MSG_KEEP_BUFFER   0x0004
 #define SLURM_DROP_PRIV		0x0008
 #define USE_BCAST_NETWORK	0x0010
+#define SLURM_MSG_COMPRESSED	0x0020	/* message body is compressed */
+#define SLURM_MSG_ACCEPT_ZLIB	0x0040	/* sender can decode zlib bodies */
+#define SLURM_MSG_ACCEPT_LZ4	0x0080	/* sender can decode lz4 bodies */
+#define SLURM_MSG_KEEP_CONN	0x0100	/* sender will reuse the connection */
+#define SLURM_MSG_REG_REPLY	0x0200	/* slurmctld collects registrations
+					 * in replies to its requests */
+
+/* Compressed bodies this build can decode, advertised in every message */
+#if HAVE_LIBZ && HAVE_LZ4
+#  define SLURM_MSG_ACCEPT_BUILD (SLURM_MSG_ACCEPT_ZLIB | SLURM_MSG_ACCEPT_LZ4)
+#elif HAVE_LIBZ
+#  define SLURM_MSG_ACCEPT_BUILD SLURM_MSG_ACCEPT_ZLIB
+#elif HAVE_LZ4
+#  define SLURM_MSG_ACCEPT_BUILD SLURM_MSG_ACCEPT_LZ4
+#else
+#  define SLURM_MSG_ACCEPT_BUILD 0
+#endif
+
+/*
+ * Seconds past slurm_get_keep_conn_time() slurmd keeps a connection flagged
+ * with SLURM_MSG_KEEP_CONN open, so slurmctld doesn't reuse one being closed
+ */
+#define KEEP_CONN_SLACK		30
+
+/*
+ * Seconds for which an authentication credential created for a fanout
+ * (slurm_msg_t.auth_cred_shared) may be sent in place of a new one
+ */
+#define AUTH_SHARED_CRED_TTL	10
 
 #endif
@@ -5180,6 +5180,9 @@ extern uint32_t slurm_get_return_code(slurm_msg_type_t type, void *data)
 	case RESPONSE_ACCT_GATHER_UPDATE:
 		rc = SLURM_SUCCESS;
 		break;
+	case MESSAGE_NODE_REGISTRATION_STATUS:
+		rc = SLURM_SUCCESS;
+		break;
 	case RESPONSE_FORWARD_FAILED:
 		/* There may be other reasons for the failure, but
 		 * this may be a slurm_msg_t data type lacking the
@@ -446,6 +446,11 @@ typedef struct forward {
 				 * message to */
 	uint32_t   timeout;	/* original timeout increments */
 	uint16_t   tree_width;  /* what the treewidth should be */
+	uint32_t   deadline;	/* DON'T PACK: msec to wait for a forwarder's
+				 * reply before checking it still responds,
+				 * zero to wait for the full timeout */
+	bool       straggler;	/* DON'T PACK: set if the forwarder did not
+				 * reply by the deadline nor respond after */
 } forward_t;
 
 /*core api protocol message structures */
@@ -475,6 +480,8 @@ typedef struct forward_struct {
 typedef struct forward_message {
 	forward_struct_t *fwd_struct;
 	header_t header;
+	hostlist_t hl;		/* nodes to forward to, used in place of
+				 * header.forward.nodelist if set */
 	int timeout;
 } forward_msg_t;
 
@@ -488,6 +495,9 @@ typedef struct slurm_protocol_config {
 typedef struct slurm_msg {
 	slurm_addr_t address;
 	void *auth_cred;
+	void *auth_cred_shared;	/* DON'T PACK OR FREE! credential created once
+				 * for a fanout of this message to distinct
+				 * hosts, sent instead of a new credential */
 	int auth_index;		/* DON'T PACK: zero for normal communication.
 				 * index value copied from incoming connection,
 				 * so that we'll respond with the same auth
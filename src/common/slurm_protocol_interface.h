@@ -48,6 +48,7 @@
 #include <sys/socket.h>
 #include <sys/time.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include "src/common/macros.h"
@@ -94,6 +95,14 @@ extern ssize_t slurm_msg_sendto_timeout(int open_fd,
 					char *buffer,
 					size_t size,
 					int timeout);
+/* slurm_msg_sendv_timeout is identical to slurm_msg_sendto_timeout except
+ * that the message is gathered from several buffers, avoiding a copy into
+ * one contiguous buffer.
+ * IN iov - message segments, consumed as they are written
+ * IN iovcnt - count of segments in iov, at most 7
+ * RET number of message bytes written (excluding the length prefix) */
+extern ssize_t slurm_msg_sendv_timeout(int open_fd, struct iovec *iov,
+				       int iovcnt, int timeout);
 
 /********************/
 /* stream functions */
@@ -132,6 +141,8 @@ extern int slurm_get_stream_addr(int open_fd, slurm_addr_t *address);
 
 extern int slurm_send_timeout(int open_fd, char *buffer, size_t size,
 			      uint32_t flags, int timeout);
+extern int slurm_send_iov_timeout(int open_fd, struct iovec *iov, int iovcnt,
+				  uint32_t flags, int timeout);
 extern int slurm_recv_timeout(int open_fd, char *buffer, size_t size,
 			      uint32_t flags, int timeout);
 
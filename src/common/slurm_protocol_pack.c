@@ -11360,6 +11360,8 @@ static int  _unpack_stats_response_msg(stats_info_response_msg_t **msg_ptr,
 			safe_unpack32(&msg->jobs_pending,	buffer);
 			safe_unpack32(&msg->jobs_running,	buffer);
 			safe_unpack_time(&msg->job_states_ts,	buffer);
+			safe_unpack32(&msg->job_records_cnt,	buffer);
+			safe_unpack64(&msg->job_records_mem,	buffer);
 
 			safe_unpack32(&msg->schedule_cycle_max,	buffer);
 			safe_unpack32(&msg->schedule_cycle_last,buffer);
@@ -11367,6 +11369,8 @@ static int  _unpack_stats_response_msg(stats_info_response_msg_t **msg_ptr,
 			safe_unpack32(&msg->schedule_cycle_counter, buffer);
 			safe_unpack32(&msg->schedule_cycle_depth, buffer);
 			safe_unpack32(&msg->schedule_queue_len,	buffer);
+			safe_unpack32(&msg->schedule_array_tasks_last, buffer);
+			safe_unpack32(&msg->schedule_array_tasks_sum, buffer);
 
 			safe_unpack32(&msg->bf_backfilled_jobs,	buffer);
 			safe_unpack32(&msg->bf_last_backfilled_jobs, buffer);
@@ -11387,6 +11391,20 @@ static int  _unpack_stats_response_msg(stats_info_response_msg_t **msg_ptr,
 
 			safe_unpack32(&msg->bf_active,		buffer);
 			safe_unpack32(&msg->bf_backfilled_het_jobs, buffer);
+
+			safe_unpack32(&msg->auth_encode_cnt,	buffer);
+			safe_unpack32(&msg->auth_decode_cnt,	buffer);
+			safe_unpack32(&msg->auth_decode_cached_cnt, buffer);
+
+			safe_unpack32(&msg->route_split_cnt,	buffer);
+			safe_unpack64(&msg->route_split_usec,	buffer);
+			safe_unpack32(&msg->route_split_max_usec, buffer);
+			safe_unpack32(&msg->route_cache_hits,	buffer);
+
+			safe_unpack32(&msg->reg_batch_cnt,	buffer);
+			safe_unpack32(&msg->reg_node_cnt,	buffer);
+			safe_unpack64(&msg->reg_storm_last_usec, buffer);
+			safe_unpack64(&msg->reg_storm_max_usec,	buffer);
 		}
 
 		safe_unpack32(&msg->rpc_type_size,		buffer);
@@ -11978,6 +11996,30 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
+extern bool pack_msg_is_prepacked(slurm_msg_t const *msg)
+{
+	if (msg->protocol_version < SLURM_MIN_PROTOCOL_VERSION)
+		return false;
+
+	/* Must match the message types packed with _pack_buffer_msg() */
+	switch (msg->msg_type) {
+	case RESPONSE_JOB_INFO:
+	case RESPONSE_PARTITION_INFO:
+	case RESPONSE_NODE_INFO:
+	case RESPONSE_RESERVATION_INFO:
+	case RESPONSE_LAYOUT_INFO:
+	case RESPONSE_JOB_STEP_INFO:
+	case RESPONSE_BURST_BUFFER_INFO:
+	case RESPONSE_FRONT_END_INFO:
+	case RESPONSE_STATS_INFO:
+	case RESPONSE_ASSOC_MGR_INFO:
+	case RESPONSE_LICENSE_INFO:
+		return true;
+	default:
+		return false;
+	}
+}
+
 /* pack_msg
  * packs a generic slurm protocol message body
  * IN msg - the body structure to pack (note: includes message type)
@@ -80,6 +80,15 @@ extern int unpack_header(header_t *header, Buf buffer);
  */
 extern int pack_msg(slurm_msg_t const *msg, Buf buffer);
 
+/*
+ * Test if a message body is sent exactly as the pre-packed data buffer
+ * already held in msg->data (e.g. RESPONSE_JOB_INFO), in which case it can
+ * be written directly from msg->data instead of copied by pack_msg()
+ * IN msg - the message to test
+ * RET true if msg->data/data_size is the complete packed body
+ */
+extern bool pack_msg_is_prepacked(slurm_msg_t const *msg);
+
 /*
  * unpacks a generic slurm protocol message body
  * OUT msg - the body structure to unpack (note: includes message type)
@@ -51,6 +51,7 @@
 #include <sys/socket.h>
 #include <sys/time.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include "slurm/slurm_errno.h"
@@ -77,6 +78,12 @@
  */
 #define MAX_MSG_SIZE     (1024*1024*1024)
 
+/*
+ *  Maximum number of segments (including the length prefix) gathered into
+ *  a single message send.
+ */
+#define MAX_SEND_IOV     8
+
 
 /* Static functions */
 static int _slurm_connect(int __fd, struct sockaddr const * __addr,
@@ -170,26 +177,51 @@ extern ssize_t slurm_msg_sendto(int fd, char *buffer, size_t size)
 ssize_t slurm_msg_sendto_timeout(int fd, char *buffer,
 				 size_t size, int timeout)
 {
-	int   len;
+	struct iovec iov;
+
+	iov.iov_base = buffer;
+	iov.iov_len = size;
+
+	return slurm_msg_sendv_timeout(fd, &iov, 1, timeout);
+}
+
+extern ssize_t slurm_msg_sendv_timeout(int fd, struct iovec *iov, int iovcnt,
+				       int timeout)
+{
+	struct iovec msg_iov[MAX_SEND_IOV];
+	int   i, len;
+	size_t size = 0;
 	uint32_t usize;
 	SigFunc *ohandler;
 
+	if (iovcnt >= MAX_SEND_IOV) {
+		slurm_seterrno(EINVAL);
+		return SLURM_ERROR;
+	}
+
 	/*
 	 *  Ignore SIGPIPE so that send can return a error code if the
 	 *    other side closes the socket
 	 */
 	ohandler = xsignal(SIGPIPE, SIG_IGN);
 
+	/*
+	 *  Send the length prefix and all message segments in a single
+	 *    gathered write instead of one system call (and one TCP
+	 *    segment) per piece.
+	 */
+	for (i = 0; i < iovcnt; i++) {
+		msg_iov[i + 1] = iov[i];
+		size += iov[i].iov_len;
+	}
 	usize = htonl(size);
+	msg_iov[0].iov_base = &usize;
+	msg_iov[0].iov_len = sizeof(usize);
 
-	if ((len = slurm_send_timeout(
-				fd, (char *)&usize, sizeof(usize), 0,
-				timeout)) < 0)
+	if ((len = slurm_send_iov_timeout(fd, msg_iov, iovcnt + 1, 0,
+					  timeout)) < 0)
 		goto done;
-
-	if ((len = slurm_send_timeout(fd, buffer, size, 0, timeout)) < 0)
-		goto done;
-
+	len -= sizeof(usize);
 
      done:
 	xsignal(SIGPIPE, ohandler);
@@ -200,18 +232,39 @@ ssize_t slurm_msg_sendto_timeout(int fd, char *buffer,
  * RET message size (as specified in argument) or SLURM_ERROR on error */
 extern int slurm_send_timeout(int fd, char *buf, size_t size,
 			      uint32_t flags, int timeout)
+{
+	struct iovec iov;
+
+	iov.iov_base = buf;
+	iov.iov_len = size;
+
+	return slurm_send_iov_timeout(fd, &iov, 1, flags, timeout);
+}
+
+/* Send a gathered list of buffers with timeout. The iov array is consumed
+ * (advanced past the bytes written) as the data is sent.
+ * RET total size of all segments or SLURM_ERROR on error */
+extern int slurm_send_iov_timeout(int fd, struct iovec *iov, int iovcnt,
+				  uint32_t flags, int timeout)
 {
 	int rc;
 	int sent = 0;
-	int fd_flags;
+	size_t size = 0;
+	int fd_flags, i;
 	struct pollfd ufds;
 	struct timeval tstart;
+	struct msghdr msg;
 	int timeleft = timeout;
 	char temp[2];
 
+	for (i = 0; i < iovcnt; i++)
+		size += iov[i].iov_len;
+
 	ufds.fd     = fd;
 	ufds.events = POLLOUT;
 
+	memset(&msg, 0, sizeof(msg));
+
 	fd_flags = fcntl(fd, F_GETFL);
 	fd_set_nonblocking(fd);
 
@@ -265,7 +318,14 @@ extern int slurm_send_timeout(int fd, char *buf, size_t size,
 			      ufds.revents);
 		}
 
-		rc = send(fd, &buf[sent], (size - sent), flags);
+		/* Skip over any segments already fully written */
+		while ((iovcnt > 0) && (iov->iov_len == 0)) {
+			iov++;
+			iovcnt--;
+		}
+		msg.msg_iov = iov;
+		msg.msg_iovlen = iovcnt;
+		rc = sendmsg(fd, &msg, flags);
 		if (rc < 0) {
  			if (errno == EINTR)
 				continue;
@@ -289,6 +349,17 @@ extern int slurm_send_timeout(int fd, char *buf, size_t size,
 		}
 
 		sent += rc;
+		/* Advance past a partial write */
+		for (i = 0; (i < iovcnt) && (rc > 0); i++) {
+			if (rc >= iov[i].iov_len) {
+				rc -= iov[i].iov_len;
+				iov[i].iov_len = 0;
+			} else {
+				iov[i].iov_base = (char *) iov[i].iov_base + rc;
+				iov[i].iov_len -= rc;
+				rc = 0;
+			}
+		}
 	}
 
     done:
@@ -41,6 +41,7 @@
 #include <pthread.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <sys/param.h>		/* MAXPATHLEN */
 
 #include "slurm/slurm.h"
@@ -90,6 +91,8 @@ static slurm_addr_t *msg_collect_node = NULL; /* address of node to aggregate
 /* addresses of backup nodes to aggregate messages from this node */
 static uint32_t msg_backup_cnt = 0;
 static slurm_addr_t **msg_collect_backup  = NULL;
+static pthread_mutex_t stats_lock = PTHREAD_MUTEX_INITIALIZER;
+static route_stats_t route_stats;
 
 /* _get_all_nodes creates a hostlist containing all the nodes in the
  * node_record_table.
@@ -382,6 +385,7 @@ extern int route_g_split_hostlist(hostlist_t hl,
 	int rc;
 	int j, nnodes, nnodex;
 	char *buf;
+	DEF_TIMERS;
 
 	nnodes = nnodex = 0;
 	if (route_init(NULL) != SLURM_SUCCESS)
@@ -397,8 +401,17 @@ extern int route_g_split_hostlist(hostlist_t hl,
 		xfree(buf);
 	}
 
+	START_TIMER;
 	rc = (*(ops.split_hostlist))(hl, sp_hl, count,
 				     tree_width ? tree_width : g_tree_width);
+	END_TIMER;
+	slurm_mutex_lock(&stats_lock);
+	route_stats.split_cnt++;
+	route_stats.split_usec += DELTA_TIMER;
+	if (route_stats.split_max_usec < DELTA_TIMER)
+		route_stats.split_max_usec = DELTA_TIMER;
+	slurm_mutex_unlock(&stats_lock);
+
 	if (debug_flags & DEBUG_FLAG_ROUTE) {
 		/* Sanity check to make sure all nodes in msg list are in
 		 * a child list */
@@ -458,6 +471,21 @@ extern slurm_addr_t* route_g_next_collector_backup(void)
 	return (*(ops.next_collector_backup))();
 }
 
+/*
+ * route_stats_get - report hostlist split statistics
+ *
+ * OUT: stats - route_stats_t* - filled in with current counters
+ * IN: reset  - bool           - clear the counters after reading them
+ */
+extern void route_stats_get(route_stats_t *stats, bool reset)
+{
+	slurm_mutex_lock(&stats_lock);
+	if (stats)
+		memcpy(stats, &route_stats, sizeof(route_stats_t));
+	if (reset)
+		memset(&route_stats, 0, sizeof(route_stats_t));
+	slurm_mutex_unlock(&stats_lock);
+}
 
 /*
  * route_split_hostlist_treewidth - logic to split an input hostlist into
@@ -545,3 +573,13 @@ extern slurm_addr_t* route_next_collector_backup(int backup_inx)
 		return NULL;
 	return msg_collect_backup[backup_inx];
 }
+
+/*
+ * route_stats_cache_hit - note a split served from a plugin's cache
+ */
+extern void route_stats_cache_hit(void)
+{
+	slurm_mutex_lock(&stats_lock);
+	route_stats.cache_hits++;
+	slurm_mutex_unlock(&stats_lock);
+}
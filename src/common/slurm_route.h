@@ -39,6 +39,14 @@
 #ifndef __SLURM_ROUTE_PLUGIN_API_H__
 #define __SLURM_ROUTE_PLUGIN_API_H__
 
+/* Hostlist split statistics, reported by sdiag */
+typedef struct {
+	uint32_t split_cnt;		/* route_g_split_hostlist() calls */
+	uint64_t split_usec;		/* total time spent splitting */
+	uint32_t split_max_usec;	/* longest single split */
+	uint32_t cache_hits;		/* splits served from plugin cache */
+} route_stats_t;
+
 /*****************************************************************************\
  *  Functions required of all plugins
 \*****************************************************************************/
@@ -106,6 +114,14 @@ extern slurm_addr_t* route_g_next_collector ( bool *is_collector );
  */
 extern slurm_addr_t* route_g_next_collector_backup ( void );
 
+/*
+ * route_stats_get - report hostlist split statistics
+ *
+ * OUT: stats - route_stats_t* - filled in with current counters
+ * IN: reset  - bool           - clear the counters after reading them
+ */
+extern void route_stats_get(route_stats_t *stats, bool reset);
+
 
 /*****************************************************************************\
  *  Plugin Common Functions
@@ -152,4 +168,9 @@ extern slurm_addr_t* route_next_collector ( bool *is_collector );
  */
 extern slurm_addr_t* route_next_collector_backup(int backup_inx);
 
+/*
+ * route_stats_cache_hit - note a split served from a plugin's cache
+ */
+extern void route_stats_cache_hit(void);
+
 #endif /*___SLURM_ROUTE_PLUGIN_API_H__*/
@@ -300,8 +300,8 @@
 #define running_in_slurmstepd   slurm_running_in_slurmstepd
 
 /* slurm_auth.[ch] functions
- * None exported today.
- * The header file used only for #define values. */
+ * slurm_auth_stat_inc() already has the slurm_ prefix.
+ * The header file used otherwise only for #define values. */
 
 /* strlcpy.[ch] functions */
 #ifndef HAVE_STRLCPY
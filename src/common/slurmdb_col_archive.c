@@ -0,0 +1,1053 @@
+/*****************************************************************************\
+ *  slurmdb_col_archive.c - columnar job archive files
+ *****************************************************************************
+ *  Copyright (C) 2020 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+/*
+ * A columnar archive holds job records split into blocks of up to
+ * COL_BLOCK_ROWS jobs.  Inside a block each column is stored by itself,
+ * compressed when possible, after the smallest and largest value of the
+ * column in the block so a reader can skip blocks that can't match without
+ * uncompressing them.
+ *
+ * File layout:
+ *	uint32 COL_ARCHIVE_MAGIC, uint16 COL_ARCHIVE_VERSION,
+ *	time created, str cluster_name, uint32 COL_COUNT,
+ *	uint32 tres count, (uint32 id, str type, str name) per TRES,
+ *	uint32 qos count, (uint32 id, str name) per QOS,
+ *	uint32 job count, uint32 block count, blocks
+ * Block layout:
+ *	uint32 job count, then per column:
+ *	uint8 type, min, max (uint64 or str), uint8 compression,
+ *	uint32 uncompressed size, mem data
+ */
+
+#include "config.h"
+
+#include <stddef.h>
+
+#if HAVE_LIBZ
+#  include <zlib.h>
+#endif
+
+#include "src/common/hostlist.h"
+#include "src/common/list.h"
+#include "src/common/log.h"
+#include "src/common/slurmdb_col_archive.h"
+#include "src/common/slurmdb_defs.h"
+#include "src/common/uid.h"
+#include "src/common/xassert.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+
+#define COL_ARCHIVE_MAGIC	0x534c4341	/* "SLCA" */
+#define COL_ARCHIVE_VERSION	1
+#define COL_BLOCK_ROWS		4096
+
+enum {
+	COL_COMPRESS_NONE,
+	COL_COMPRESS_ZLIB
+};
+
+enum {
+	COL_TYPE_NUM,
+	COL_TYPE_STR
+};
+
+/* Must be kept in the same order as col_desc[] */
+enum {
+	COL_ACCOUNT,
+	COL_ALLOC_NODES,
+	COL_ARRAY_JOB_ID,
+	COL_ARRAY_TASK_ID,
+	COL_CONSTRAINTS,
+	COL_DERIVED_EC,
+	COL_ELIGIBLE,
+	COL_END,
+	COL_EXITCODE,
+	COL_FLAGS,
+	COL_GID,
+	COL_HET_JOB_ID,
+	COL_HET_JOB_OFFSET,
+	COL_JOBID,
+	COL_JOBNAME,
+	COL_NODES,
+	COL_PARTITION,
+	COL_PRIORITY,
+	COL_QOSID,
+	COL_REQ_CPUS,
+	COL_REQ_MEM,
+	COL_START,
+	COL_STATE,
+	COL_SUBMIT,
+	COL_SUSPENDED,
+	COL_TIMELIMIT,
+	COL_TRACK_STEPS,
+	COL_TRES_ALLOC,
+	COL_TRES_REQ,
+	COL_UID,
+	COL_WCKEY,
+	COL_WORK_DIR,
+	COL_COUNT
+};
+
+typedef struct {
+	uint8_t type;	/* COL_TYPE_* */
+	size_t offset;	/* of the field in slurmdb_job_rec_t */
+	size_t size;	/* of the field if it is a number */
+} col_desc_t;
+
+#define COL_NUM(field) { COL_TYPE_NUM, offsetof(slurmdb_job_rec_t, field), \
+			 sizeof(((slurmdb_job_rec_t *)0)->field) }
+#define COL_STR(field) { COL_TYPE_STR, offsetof(slurmdb_job_rec_t, field), 0 }
+
+static const col_desc_t col_desc[COL_COUNT] = {
+	COL_STR(account),
+	COL_NUM(alloc_nodes),
+	COL_NUM(array_job_id),
+	COL_NUM(array_task_id),
+	COL_STR(constraints),
+	COL_NUM(derived_ec),
+	COL_NUM(eligible),
+	COL_NUM(end),
+	COL_NUM(exitcode),
+	COL_NUM(flags),
+	COL_NUM(gid),
+	COL_NUM(het_job_id),
+	COL_NUM(het_job_offset),
+	COL_NUM(jobid),
+	COL_STR(jobname),
+	COL_STR(nodes),
+	COL_STR(partition),
+	COL_NUM(priority),
+	COL_NUM(qosid),
+	COL_NUM(req_cpus),
+	COL_NUM(req_mem),
+	COL_NUM(start),
+	COL_NUM(state),
+	COL_NUM(submit),
+	COL_NUM(suspended),
+	COL_NUM(timelimit),
+	COL_NUM(track_steps),
+	COL_STR(tres_alloc_str),
+	COL_STR(tres_req_str),
+	COL_NUM(uid),
+	COL_STR(wckey),
+	COL_STR(work_dir),
+};
+
+/* Smallest and largest value of a column in a block */
+typedef struct {
+	uint64_t num_max;
+	uint64_t num_min;
+	char *str_max;
+	char *str_min;
+} col_stats_t;
+
+struct slurmdb_col_writer {
+	uint32_t block_cnt;
+	uint32_t block_rows;
+	Buf body;			/* finished blocks */
+	char *cluster_name;
+	Buf col_buf[COL_COUNT];		/* columns of the current block */
+	col_stats_t col_stats[COL_COUNT];
+	Buf dict;			/* TRES and QOS of the archive */
+	uint32_t job_cnt;
+};
+
+static uint64_t _get_num(slurmdb_job_rec_t *job, const col_desc_t *desc)
+{
+	void *ptr = (char *)job + desc->offset;
+
+	switch (desc->size) {
+	case sizeof(uint16_t):
+		return *(uint16_t *)ptr;
+	case sizeof(uint32_t):
+		return *(uint32_t *)ptr;
+	case sizeof(uint64_t):
+		return *(uint64_t *)ptr;
+	}
+	return 0;
+}
+
+static void _set_num(slurmdb_job_rec_t *job, const col_desc_t *desc,
+		     uint64_t value)
+{
+	void *ptr = (char *)job + desc->offset;
+
+	switch (desc->size) {
+	case sizeof(uint16_t):
+		*(uint16_t *)ptr = value;
+		break;
+	case sizeof(uint32_t):
+		*(uint32_t *)ptr = value;
+		break;
+	case sizeof(uint64_t):
+		*(uint64_t *)ptr = value;
+		break;
+	}
+}
+
+static char **_str_ptr(slurmdb_job_rec_t *job, const col_desc_t *desc)
+{
+	return (char **)((char *)job + desc->offset);
+}
+
+static void _clear_stats(col_stats_t *stats)
+{
+	stats->num_max = 0;
+	stats->num_min = 0;
+	xfree(stats->str_max);
+	xfree(stats->str_min);
+}
+
+/* Pack the data of a column, compressing it if that makes it smaller */
+static void _pack_col_data(Buf col, Buf buffer)
+{
+	char *data = get_buf_data(col);
+	uint32_t len = get_buf_offset(col);
+
+#if HAVE_LIBZ
+	if (len) {
+		uLongf zlen = compressBound(len);
+		char *zbuf = xmalloc_nz(zlen);
+
+		if ((compress2((Bytef *) zbuf, &zlen, (Bytef *) data, len,
+			       Z_DEFAULT_COMPRESSION) == Z_OK) &&
+		    (zlen < len)) {
+			pack8(COL_COMPRESS_ZLIB, buffer);
+			pack32(len, buffer);
+			packmem(zbuf, zlen, buffer);
+			xfree(zbuf);
+			return;
+		}
+		xfree(zbuf);
+	}
+#endif
+	pack8(COL_COMPRESS_NONE, buffer);
+	pack32(len, buffer);
+	packmem(data, len, buffer);
+}
+
+static void _flush_block(slurmdb_col_writer_t *writer)
+{
+	int i;
+
+	if (!writer->block_rows)
+		return;
+
+	pack32(writer->block_rows, writer->body);
+	for (i = 0; i < COL_COUNT; i++) {
+		col_stats_t *stats = &writer->col_stats[i];
+
+		pack8(col_desc[i].type, writer->body);
+		if (col_desc[i].type == COL_TYPE_NUM) {
+			pack64(stats->num_min, writer->body);
+			pack64(stats->num_max, writer->body);
+		} else {
+			packstr(stats->str_min, writer->body);
+			packstr(stats->str_max, writer->body);
+		}
+		_pack_col_data(writer->col_buf[i], writer->body);
+
+		set_buf_offset(writer->col_buf[i], 0);
+		_clear_stats(stats);
+	}
+
+	writer->block_cnt++;
+	writer->block_rows = 0;
+}
+
+extern slurmdb_col_writer_t *slurmdb_col_writer_create(char *cluster_name,
+						       List tres_list,
+						       List qos_list)
+{
+	slurmdb_col_writer_t *writer = xmalloc(sizeof(*writer));
+	slurmdb_tres_rec_t *tres;
+	slurmdb_qos_rec_t *qos;
+	ListIterator itr;
+	int i;
+
+	writer->body = init_buf(BUF_SIZE);
+	writer->cluster_name = xstrdup(cluster_name);
+	for (i = 0; i < COL_COUNT; i++)
+		writer->col_buf[i] = init_buf(BUF_SIZE);
+
+	writer->dict = init_buf(BUF_SIZE);
+	pack32(tres_list ? list_count(tres_list) : 0, writer->dict);
+	if (tres_list) {
+		itr = list_iterator_create(tres_list);
+		while ((tres = list_next(itr))) {
+			pack32(tres->id, writer->dict);
+			packstr(tres->type, writer->dict);
+			packstr(tres->name, writer->dict);
+		}
+		list_iterator_destroy(itr);
+	}
+	pack32(qos_list ? list_count(qos_list) : 0, writer->dict);
+	if (qos_list) {
+		itr = list_iterator_create(qos_list);
+		while ((qos = list_next(itr))) {
+			pack32(qos->id, writer->dict);
+			packstr(qos->name, writer->dict);
+		}
+		list_iterator_destroy(itr);
+	}
+
+	return writer;
+}
+
+extern void slurmdb_col_writer_add_job(slurmdb_col_writer_t *writer,
+				       slurmdb_job_rec_t *job)
+{
+	int i;
+
+	xassert(writer);
+	xassert(job);
+
+	for (i = 0; i < COL_COUNT; i++) {
+		col_stats_t *stats = &writer->col_stats[i];
+
+		if (col_desc[i].type == COL_TYPE_NUM) {
+			uint64_t value = _get_num(job, &col_desc[i]);
+
+			if (!writer->block_rows || (value < stats->num_min))
+				stats->num_min = value;
+			if (!writer->block_rows || (value > stats->num_max))
+				stats->num_max = value;
+			pack64(value, writer->col_buf[i]);
+		} else {
+			char *value = *_str_ptr(job, &col_desc[i]);
+
+			if (!value)
+				value = "";
+			if (!writer->block_rows ||
+			    (xstrcmp(value, stats->str_min) < 0)) {
+				xfree(stats->str_min);
+				stats->str_min = xstrdup(value);
+			}
+			if (!writer->block_rows ||
+			    (xstrcmp(value, stats->str_max) > 0)) {
+				xfree(stats->str_max);
+				stats->str_max = xstrdup(value);
+			}
+			packstr(*_str_ptr(job, &col_desc[i]),
+				writer->col_buf[i]);
+		}
+	}
+
+	writer->job_cnt++;
+	if (++writer->block_rows >= COL_BLOCK_ROWS)
+		_flush_block(writer);
+}
+
+extern Buf slurmdb_col_writer_fini(slurmdb_col_writer_t *writer)
+{
+	Buf buffer;
+	int i;
+
+	xassert(writer);
+
+	_flush_block(writer);
+
+	buffer = init_buf(get_buf_offset(writer->body) +
+			  get_buf_offset(writer->dict) + BUF_SIZE);
+	pack32(COL_ARCHIVE_MAGIC, buffer);
+	pack16(COL_ARCHIVE_VERSION, buffer);
+	pack_time(time(NULL), buffer);
+	packstr(writer->cluster_name, buffer);
+	pack32(COL_COUNT, buffer);
+	packmem_array(get_buf_data(writer->dict),
+		      get_buf_offset(writer->dict), buffer);
+	pack32(writer->job_cnt, buffer);
+	pack32(writer->block_cnt, buffer);
+	packmem_array(get_buf_data(writer->body),
+		      get_buf_offset(writer->body), buffer);
+
+	for (i = 0; i < COL_COUNT; i++) {
+		free_buf(writer->col_buf[i]);
+		_clear_stats(&writer->col_stats[i]);
+	}
+	free_buf(writer->body);
+	free_buf(writer->dict);
+	xfree(writer->cluster_name);
+	xfree(writer);
+
+	return buffer;
+}
+
+static int _find_str(void *x, void *key)
+{
+	if (!xstrcmp((char *)x, (char *)key))
+		return 1;
+	return 0;
+}
+
+/* Does str_list have a string between min and max? */
+static bool _str_list_in_range(List str_list, char *min, char *max)
+{
+	ListIterator itr;
+	char *str;
+	bool found = false;
+
+	itr = list_iterator_create(str_list);
+	while ((str = list_next(itr))) {
+		if ((xstrcmp(str, min) >= 0) && (xstrcmp(str, max) <= 0)) {
+			found = true;
+			break;
+		}
+	}
+	list_iterator_destroy(itr);
+
+	return found;
+}
+
+/* Does uid_list (list of char *) have a uid between min and max? */
+static bool _uid_list_in_range(List uid_list, uint64_t min, uint64_t max)
+{
+	ListIterator itr;
+	char *str;
+	bool found = false;
+
+	itr = list_iterator_create(uid_list);
+	while ((str = list_next(itr))) {
+		uint64_t uid = slurm_atoul(str);
+		if ((uid >= min) && (uid <= max)) {
+			found = true;
+			break;
+		}
+	}
+	list_iterator_destroy(itr);
+
+	return found;
+}
+
+/* Is value in [min, max], or equal to min if there is no max? */
+static bool _in_range(uint64_t value, uint32_t min, uint32_t max)
+{
+	if (max)
+		return ((value >= min) && (value <= max));
+	return (value == min);
+}
+
+static bool _str_list_match(List str_list, char *str)
+{
+	return (list_find_first(str_list, _find_str, str ? str : "") != NULL);
+}
+
+static bool _id_list_match(List id_list, uint32_t id)
+{
+	char id_str[16];
+
+	snprintf(id_str, sizeof(id_str), "%u", id);
+	return (list_find_first(id_list, _find_str, id_str) != NULL);
+}
+
+/* Does a job match one of the job ids of step_list, like the database? */
+static bool _step_list_match(slurmdb_job_rec_t *job,
+			     slurmdb_job_cond_t *job_cond)
+{
+	ListIterator itr;
+	slurmdb_selected_step_t *selected_step;
+	bool found = false;
+
+	itr = list_iterator_create(job_cond->step_list);
+	while (!found && (selected_step = list_next(itr))) {
+		if (selected_step->array_task_id != NO_VAL) {
+			found = ((job->array_job_id == selected_step->jobid) &&
+				 (job->array_task_id ==
+				  selected_step->array_task_id));
+		} else if (selected_step->het_job_offset != NO_VAL) {
+			found = ((job->het_job_id == selected_step->jobid) &&
+				 ((job_cond->flags &
+				   JOBCOND_FLAG_WHOLE_HETJOB) ||
+				  (job->het_job_offset ==
+				   selected_step->het_job_offset)));
+		} else {
+			found = ((job->jobid == selected_step->jobid) ||
+				 (job->array_job_id == selected_step->jobid) ||
+				 (!(job_cond->flags &
+				    JOBCOND_FLAG_NO_WHOLE_HETJOB) &&
+				  (job->het_job_id == selected_step->jobid)));
+		}
+	}
+	list_iterator_destroy(itr);
+
+	return found;
+}
+
+/*
+ * Was a job in this state during the time window of job_cond? This mirrors
+ * the database, except that suspended jobs are those suspended at some point
+ * and running in the window, as archives have no suspend periods.
+ */
+static bool _state_match(slurmdb_job_rec_t *job, uint32_t state,
+			 slurmdb_job_cond_t *job_cond)
+{
+	time_t start = job_cond->usage_start, end = job_cond->usage_end;
+
+	if (!start && !end)
+		return (job->state == state);
+
+	switch (state) {
+	case JOB_PENDING:
+		return (job->eligible &&
+			((job->start && (start < job->start)) ||
+			 (!job->start && job->end && (start < job->end)) ||
+			 (!job->start && !job->end && (job->state == state))) &&
+			(end > job->eligible));
+	case JOB_SUSPENDED:
+		return (job->suspended && job->start &&
+			(job->start <= (end ? end : start)) &&
+			(!job->end || (job->end >= start)));
+	case JOB_RUNNING:
+		return (job->start &&
+			((start < job->end) ||
+			 (!job->end && (job->state == state))) &&
+			(end > job->start));
+	case JOB_COMPLETE:
+	case JOB_CANCELLED:
+	case JOB_FAILED:
+	case JOB_TIMEOUT:
+	case JOB_NODE_FAIL:
+	case JOB_PREEMPTED:
+	case JOB_BOOT_FAIL:
+	case JOB_DEADLINE:
+	case JOB_OOM:
+	case JOB_REQUEUE:
+	case JOB_RESIZING:
+	case JOB_REVOKED:
+		/* Job ending *in* the time window with the state */
+		return ((job->state == state) && job->end &&
+			(job->end >= start) && (job->end <= end));
+	default:
+		return (job->state == state);
+	}
+}
+
+static bool _state_list_match(slurmdb_job_rec_t *job,
+			      slurmdb_job_cond_t *job_cond)
+{
+	ListIterator itr;
+	char *state;
+	bool found = false;
+
+	itr = list_iterator_create(job_cond->state_list);
+	while (!found && (state = list_next(itr)))
+		found = _state_match(job, slurm_atoul(state), job_cond);
+	list_iterator_destroy(itr);
+
+	return found;
+}
+
+/* Did a job run on any of the nodes of used_hl? */
+static bool _used_nodes_match(slurmdb_job_rec_t *job, hostlist_t used_hl)
+{
+	hostlist_t hl;
+	char *host;
+	bool found = false;
+
+	if (!job->nodes || !(hl = hostlist_create(job->nodes)))
+		return false;
+	while (!found && (host = hostlist_shift(hl))) {
+		found = (hostlist_find(used_hl, host) >= 0);
+		free(host);
+	}
+	hostlist_destroy(hl);
+
+	return found;
+}
+
+/*
+ * Apply the time window of job_cond like the database does when neither
+ * states nor job ids are requested, which also means blocks can be skipped
+ * on their eligible and end times.
+ */
+static bool _default_time_window(slurmdb_job_cond_t *job_cond)
+{
+	return ((!job_cond->state_list || !list_count(job_cond->state_list)) &&
+		(!job_cond->step_list || !list_count(job_cond->step_list)));
+}
+
+static bool _job_time_match(slurmdb_job_rec_t *job,
+			    slurmdb_job_cond_t *job_cond)
+{
+	if (job_cond->state_list && list_count(job_cond->state_list))
+		return _state_list_match(job, job_cond);
+
+	if (job_cond->step_list && list_count(job_cond->step_list)) {
+		/* Explicit jobs are shown even if not eligible */
+		if (job_cond->flags & JOBCOND_FLAG_NO_DEFAULT_USAGE)
+			return true;
+		if (job_cond->usage_end && (job->submit > job_cond->usage_end))
+			return false;
+		return (!job->end || (job->end >= job_cond->usage_start));
+	}
+
+	if (job_cond->usage_end &&
+	    (!job->eligible || (job->eligible >= job_cond->usage_end)))
+		return false;
+	if (job_cond->usage_start && job->end &&
+	    (job->end < job_cond->usage_start))
+		return false;
+
+	return true;
+}
+
+/*
+ * Can a block with these stats have a job matching job_cond?  The time
+ * checks mirror what the database does for -S/-E.
+ */
+static bool _block_match(col_stats_t *stats, slurmdb_job_cond_t *job_cond)
+{
+	if (!job_cond)
+		return true;
+
+	if (_default_time_window(job_cond)) {
+		if (job_cond->usage_end &&
+		    (stats[COL_ELIGIBLE].num_min >= job_cond->usage_end))
+			return false;
+		if (job_cond->usage_start && stats[COL_END].num_min &&
+		    (stats[COL_END].num_max < job_cond->usage_start))
+			return false;
+	}
+
+	if (job_cond->userid_list && list_count(job_cond->userid_list) &&
+	    !_uid_list_in_range(job_cond->userid_list,
+				stats[COL_UID].num_min,
+				stats[COL_UID].num_max))
+		return false;
+	if (job_cond->acct_list && list_count(job_cond->acct_list) &&
+	    !_str_list_in_range(job_cond->acct_list,
+				stats[COL_ACCOUNT].str_min,
+				stats[COL_ACCOUNT].str_max))
+		return false;
+	if (job_cond->partition_list && list_count(job_cond->partition_list) &&
+	    !_str_list_in_range(job_cond->partition_list,
+				stats[COL_PARTITION].str_min,
+				stats[COL_PARTITION].str_max))
+		return false;
+
+	return true;
+}
+
+/*
+ * Does a job match job_cond? Every filter sacct can send to the database
+ * except associations and reasons, which archives don't store, is applied.
+ */
+static bool _job_match(slurmdb_job_rec_t *job, slurmdb_job_cond_t *job_cond,
+		       hostlist_t used_hl)
+{
+	if (!job_cond)
+		return true;
+
+	if (!(job_cond->flags & JOBCOND_FLAG_DUP) &&
+	    (job->state == JOB_REVOKED))
+		return false;
+
+	if (job_cond->step_list && list_count(job_cond->step_list) &&
+	    !_step_list_match(job, job_cond))
+		return false;
+
+	if (!_job_time_match(job, job_cond))
+		return false;
+
+	if (job_cond->userid_list && list_count(job_cond->userid_list) &&
+	    !_id_list_match(job_cond->userid_list, job->uid))
+		return false;
+	if (job_cond->groupid_list && list_count(job_cond->groupid_list) &&
+	    !_id_list_match(job_cond->groupid_list, job->gid))
+		return false;
+	if (job_cond->qos_list && list_count(job_cond->qos_list) &&
+	    !_id_list_match(job_cond->qos_list, job->qosid))
+		return false;
+	if (job_cond->acct_list && list_count(job_cond->acct_list) &&
+	    !_str_list_match(job_cond->acct_list, job->account))
+		return false;
+	if (job_cond->partition_list && list_count(job_cond->partition_list) &&
+	    !_str_list_match(job_cond->partition_list, job->partition))
+		return false;
+	if (job_cond->jobname_list && list_count(job_cond->jobname_list) &&
+	    !_str_list_match(job_cond->jobname_list, job->jobname))
+		return false;
+	if (job_cond->wckey_list && list_count(job_cond->wckey_list) &&
+	    !_str_list_match(job_cond->wckey_list, job->wckey))
+		return false;
+
+	if (job_cond->constraint_list &&
+	    list_count(job_cond->constraint_list)) {
+		ListIterator itr;
+		char *constraint;
+		bool found = true;
+
+		/* All of them are needed, like the database */
+		itr = list_iterator_create(job_cond->constraint_list);
+		while (found && (constraint = list_next(itr))) {
+			if (constraint[0])
+				found = (xstrstr(job->constraints,
+						 constraint) != NULL);
+			else
+				found = (!job->constraints ||
+					 !job->constraints[0]);
+		}
+		list_iterator_destroy(itr);
+		if (!found)
+			return false;
+	}
+
+	if (job_cond->db_flags != SLURMDB_JOB_FLAG_NOTSET) {
+		if (job_cond->db_flags == SLURMDB_JOB_FLAG_NONE) {
+			if (job->flags != job_cond->db_flags)
+				return false;
+		} else if (!(job->flags & job_cond->db_flags))
+			return false;
+	}
+
+	if (job_cond->cpus_min &&
+	    !_in_range(slurmdb_find_tres_count_in_string(job->tres_alloc_str,
+							 TRES_CPU),
+		       job_cond->cpus_min, job_cond->cpus_max))
+		return false;
+	if (job_cond->nodes_min &&
+	    !_in_range(job->alloc_nodes, job_cond->nodes_min,
+		       job_cond->nodes_max))
+		return false;
+	if (job_cond->timelimit_min &&
+	    !_in_range(job->timelimit, job_cond->timelimit_min,
+		       job_cond->timelimit_max))
+		return false;
+
+	if (used_hl && !_used_nodes_match(job, used_hl))
+		return false;
+
+	return true;
+}
+
+/* Return a buffer with the uncompressed data of a column */
+static Buf _unpack_col_data(uint8_t compress, uint32_t len,
+			    char *data, uint32_t data_len)
+{
+	char *out;
+
+	switch (compress) {
+	case COL_COMPRESS_NONE:
+		if (data_len != len)
+			return NULL;
+		out = xmalloc_nz(len + 1);
+		memcpy(out, data, len);
+		return create_buf(out, len);
+#if HAVE_LIBZ
+	case COL_COMPRESS_ZLIB:
+	{
+		uLongf zlen = len;
+
+		out = xmalloc_nz(len + 1);
+		if ((uncompress((Bytef *) out, &zlen, (Bytef *) data,
+				data_len) != Z_OK) || (zlen != len)) {
+			xfree(out);
+			return NULL;
+		}
+		return create_buf(out, len);
+	}
+#endif
+	default:
+		error("%s: Unsupported compression type %u",
+		      __func__, compress);
+		return NULL;
+	}
+}
+
+static int _unpack_dict(Buf buffer, List *tres_list, List *qos_list)
+{
+	uint32_t count, id, uint32_tmp;
+	char *type = NULL, *name = NULL;
+	int i;
+
+	safe_unpack32(&count, buffer);
+	for (i = 0; i < count; i++) {
+		safe_unpack32(&id, buffer);
+		safe_unpackstr_xmalloc(&type, &uint32_tmp, buffer);
+		safe_unpackstr_xmalloc(&name, &uint32_tmp, buffer);
+		if (tres_list && !(*tres_list &&
+				   list_find_first(*tres_list,
+						   slurmdb_find_tres_in_list,
+						   &id))) {
+			slurmdb_tres_rec_t *tres = xmalloc(sizeof(*tres));
+			tres->id = id;
+			tres->type = type;
+			tres->name = name;
+			type = name = NULL;
+			if (!*tres_list)
+				*tres_list = list_create(
+					slurmdb_destroy_tres_rec);
+			list_append(*tres_list, tres);
+		}
+		xfree(type);
+		xfree(name);
+	}
+
+	safe_unpack32(&count, buffer);
+	for (i = 0; i < count; i++) {
+		safe_unpack32(&id, buffer);
+		safe_unpackstr_xmalloc(&name, &uint32_tmp, buffer);
+		if (qos_list && !(*qos_list &&
+				  list_find_first(*qos_list,
+						  slurmdb_find_qos_in_list,
+						  &id))) {
+			slurmdb_qos_rec_t *qos = xmalloc(sizeof(*qos));
+			slurmdb_init_qos_rec(qos, 0, NO_VAL);
+			qos->id = id;
+			qos->name = name;
+			name = NULL;
+			if (!*qos_list)
+				*qos_list = list_create(
+					slurmdb_destroy_qos_rec);
+			list_append(*qos_list, qos);
+		}
+		xfree(name);
+	}
+	return SLURM_SUCCESS;
+
+unpack_error:
+	xfree(type);
+	xfree(name);
+	return SLURM_ERROR;
+}
+
+/* Unpack the jobs of one block into job_list, RET SLURM_SUCCESS or error */
+static int _unpack_block(Buf buffer, char *cluster_name,
+			 slurmdb_job_cond_t *job_cond, hostlist_t used_hl,
+			 List job_list)
+{
+	col_stats_t stats[COL_COUNT];
+	uint8_t compress[COL_COUNT], type;
+	uint32_t col_len[COL_COUNT], data_len[COL_COUNT];
+	char *data[COL_COUNT];
+	Buf col_buf[COL_COUNT];
+	uint32_t rows, uint32_tmp;
+	slurmdb_job_rec_t *job = NULL;
+	int i, r, rc = SLURM_ERROR;
+
+	memset(stats, 0, sizeof(stats));
+	memset(col_buf, 0, sizeof(col_buf));
+
+	safe_unpack32(&rows, buffer);
+	for (i = 0; i < COL_COUNT; i++) {
+		safe_unpack8(&type, buffer);
+		if (type != col_desc[i].type)
+			goto unpack_error;
+		if (type == COL_TYPE_NUM) {
+			safe_unpack64(&stats[i].num_min, buffer);
+			safe_unpack64(&stats[i].num_max, buffer);
+		} else {
+			safe_unpackstr_xmalloc(&stats[i].str_min,
+					       &uint32_tmp, buffer);
+			safe_unpackstr_xmalloc(&stats[i].str_max,
+					       &uint32_tmp, buffer);
+		}
+		safe_unpack8(&compress[i], buffer);
+		safe_unpack32(&col_len[i], buffer);
+		safe_unpackmem_ptr(&data[i], &data_len[i], buffer);
+	}
+
+	rc = SLURM_SUCCESS;
+	if (!_block_match(stats, job_cond))
+		goto end_it;
+
+	for (i = 0; i < COL_COUNT; i++) {
+		if (!(col_buf[i] = _unpack_col_data(compress[i], col_len[i],
+						    data[i], data_len[i]))) {
+			rc = SLURM_ERROR;
+			goto end_it;
+		}
+	}
+
+	for (r = 0; r < rows; r++) {
+		job = slurmdb_create_job_rec();
+		for (i = 0; i < COL_COUNT; i++) {
+			if (col_desc[i].type == COL_TYPE_NUM) {
+				uint64_t value;
+				safe_unpack64(&value, col_buf[i]);
+				_set_num(job, &col_desc[i], value);
+			} else {
+				safe_unpackstr_xmalloc(
+					_str_ptr(job, &col_desc[i]),
+					&uint32_tmp, col_buf[i]);
+			}
+		}
+
+		if (!_job_match(job, job_cond, used_hl)) {
+			slurmdb_destroy_job_rec(job);
+			job = NULL;
+			continue;
+		}
+
+		job->cluster = xstrdup(cluster_name);
+		if (!(job->user = uid_to_string_or_null(job->uid)))
+			job->user = xstrdup_printf("%u", job->uid);
+		if (job->start && (job->end > job->start)) {
+			job->elapsed = job->end - job->start;
+			if (job->elapsed > job->suspended)
+				job->elapsed -= job->suspended;
+			else
+				job->elapsed = 0;
+		}
+		job->show_full = 1;
+		list_append(job_list, job);
+		job = NULL;
+	}
+	goto end_it;
+
+unpack_error:
+	rc = SLURM_ERROR;
+	if (job)
+		slurmdb_destroy_job_rec(job);
+end_it:
+	for (i = 0; i < COL_COUNT; i++) {
+		free_buf(col_buf[i]);
+		_clear_stats(&stats[i]);
+	}
+	return rc;
+}
+
+/*
+ * Open an archive file and unpack its header
+ * RET buffer positioned at the dictionary or NULL on error
+ */
+static Buf _open_archive(char *file_name, char **cluster_name)
+{
+	Buf buffer;
+	uint32_t magic, col_cnt, uint32_tmp;
+	uint16_t version;
+	time_t created;
+
+	if (!(buffer = create_mmap_buf(file_name))) {
+		error("%s: Unable to read archive file %s: %m",
+		      __func__, file_name);
+		return NULL;
+	}
+
+	safe_unpack32(&magic, buffer);
+	safe_unpack16(&version, buffer);
+	if ((magic != COL_ARCHIVE_MAGIC) || (version != COL_ARCHIVE_VERSION)) {
+		error("%s: %s is not a columnar job archive",
+		      __func__, file_name);
+		free_buf(buffer);
+		return NULL;
+	}
+	safe_unpack_time(&created, buffer);
+	safe_unpackstr_xmalloc(cluster_name, &uint32_tmp, buffer);
+	safe_unpack32(&col_cnt, buffer);
+	if (col_cnt != COL_COUNT)
+		goto unpack_error;
+
+	return buffer;
+
+unpack_error:
+	error("%s: Archive file %s is corrupted", __func__, file_name);
+	xfree(*cluster_name);
+	free_buf(buffer);
+	return NULL;
+}
+
+extern int slurmdb_col_archive_read_dict(char *file_name, List *tres_list,
+					 List *qos_list)
+{
+	Buf buffer;
+	char *cluster_name = NULL;
+	int rc;
+
+	if (!(buffer = _open_archive(file_name, &cluster_name)))
+		return SLURM_ERROR;
+
+	if ((rc = _unpack_dict(buffer, tres_list, qos_list)) != SLURM_SUCCESS)
+		error("%s: Archive file %s is corrupted", __func__, file_name);
+
+	xfree(cluster_name);
+	free_buf(buffer);
+	return rc;
+}
+
+extern List slurmdb_col_archive_read_jobs(char *file_name,
+					  slurmdb_job_cond_t *job_cond,
+					  List *tres_list, List *qos_list)
+{
+	Buf buffer;
+	List job_list = NULL;
+	char *cluster_name = NULL;
+	hostlist_t used_hl = NULL;
+	uint32_t job_cnt, block_cnt;
+	int i;
+
+	if (!(buffer = _open_archive(file_name, &cluster_name)))
+		return NULL;
+
+	job_list = list_create(slurmdb_destroy_job_rec);
+
+	/* Skip the whole file if it is for a cluster we don't want */
+	if (job_cond && job_cond->cluster_list &&
+	    list_count(job_cond->cluster_list) &&
+	    !list_find_first(job_cond->cluster_list, _find_str,
+			     cluster_name))
+		goto end_it;
+
+	if (_unpack_dict(buffer, tres_list, qos_list) != SLURM_SUCCESS)
+		goto unpack_error;
+
+	if (job_cond && job_cond->used_nodes)
+		used_hl = hostlist_create(job_cond->used_nodes);
+
+	safe_unpack32(&job_cnt, buffer);
+	safe_unpack32(&block_cnt, buffer);
+	for (i = 0; i < block_cnt; i++) {
+		if (_unpack_block(buffer, cluster_name, job_cond, used_hl,
+				  job_list) != SLURM_SUCCESS)
+			goto unpack_error;
+	}
+
+	debug("%s: %d of %u jobs from %s matched",
+	      __func__, list_count(job_list), job_cnt, file_name);
+end_it:
+	FREE_NULL_HOSTLIST(used_hl);
+	xfree(cluster_name);
+	free_buf(buffer);
+	return job_list;
+
+unpack_error:
+	error("%s: Archive file %s is corrupted", __func__, file_name);
+	FREE_NULL_HOSTLIST(used_hl);
+	FREE_NULL_LIST(job_list);
+	xfree(cluster_name);
+	free_buf(buffer);
+	return NULL;
+}
@@ -0,0 +1,96 @@
+/*****************************************************************************\
+ *  slurmdb_col_archive.h - columnar job archive files
+ *****************************************************************************
+ *  Copyright (C) 2020 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _SLURMDB_COL_ARCHIVE_H
+#define _SLURMDB_COL_ARCHIVE_H
+
+#include "slurm/slurmdb.h"
+#include "src/common/pack.h"
+
+typedef struct slurmdb_col_writer slurmdb_col_writer_t;
+
+/*
+ * Start a columnar archive of the jobs of cluster_name.
+ *
+ * IN tres_list - list of slurmdb_tres_rec_t's stored in the archive so it
+ *	can be read without the database, may be NULL
+ * IN qos_list - list of slurmdb_qos_rec_t's, same as tres_list
+ * RET writer to pass to slurmdb_col_writer_add_job()
+ */
+extern slurmdb_col_writer_t *slurmdb_col_writer_create(char *cluster_name,
+						       List tres_list,
+						       List qos_list);
+
+/* Add a job to the archive, the job is copied and can be freed after. */
+extern void slurmdb_col_writer_add_job(slurmdb_col_writer_t *writer,
+				       slurmdb_job_rec_t *job);
+
+/*
+ * Finish the archive and free writer.
+ * RET buffer with the contents of the archive file, free with free_buf()
+ */
+extern Buf slurmdb_col_writer_fini(slurmdb_col_writer_t *writer);
+
+/*
+ * Read the TRES and QOS stored in a columnar archive file.
+ *
+ * IN file_name - archive file to read
+ * IN/OUT tres_list - if not NULL the TRES stored in the archive are added to
+ *	the list, which is created if needed
+ * IN/OUT qos_list - same as tres_list for the QOS stored in the archive
+ * RET SLURM_SUCCESS or SLURM_ERROR
+ */
+extern int slurmdb_col_archive_read_dict(char *file_name, List *tres_list,
+					 List *qos_list);
+
+/*
+ * Read the jobs from a columnar archive file matching job_cond, as the
+ * database would.  Associations and reasons are not stored in archives and
+ * their filters are ignored.  Blocks of the file which can't have a job
+ * matching the time, user, account or partition are skipped without
+ * uncompressing them.
+ *
+ * IN file_name - archive file to read
+ * IN job_cond - jobs to return, may be NULL for all of them
+ * IN/OUT tres_list - if not NULL the TRES stored in the archive are added to
+ *	the list, which is created if needed
+ * IN/OUT qos_list - same as tres_list for the QOS stored in the archive
+ * RET list of slurmdb_job_rec_t's or NULL on error
+ */
+extern List slurmdb_col_archive_read_jobs(char *file_name,
+					  slurmdb_job_cond_t *job_cond,
+					  List *tres_list, List *qos_list);
+
+#endif
@@ -399,6 +399,90 @@ extern void slurmdb_job_cond_def_start_end(slurmdb_job_cond_t *job_cond)
 		job_cond->usage_end = time(NULL);
 }
 
+extern void slurmdb_job_chunk_get(slurmdb_job_cond_t *job_cond,
+				  List cluster_list,
+				  slurmdb_cluster_jobs_f get_jobs, void *arg,
+				  List job_list)
+{
+	ListIterator itr;
+	char *cluster_name;
+	bool exhausted, found_cursor = true;
+	uint32_t after_jobid, chunk_size = 0;
+	int job_cnt;
+
+	/*
+	 * When the caller asks for a chunk of jobs start after the cursor
+	 * and stop once we have chunk_size of them.  The clusters are always
+	 * walked in the same order so the cursor stays valid between calls.
+	 */
+	if (job_cond && job_cond->chunk_size) {
+		chunk_size = job_cond->chunk_size;
+		if (job_cond->cursor_cluster)
+			found_cursor = false;
+	}
+
+	itr = list_iterator_create(cluster_list);
+	while ((cluster_name = list_next(itr))) {
+		after_jobid = 0;
+		if (!found_cursor) {
+			if (xstrcmp(cluster_name, job_cond->cursor_cluster))
+				continue;
+			found_cursor = true;
+			after_jobid = job_cond->cursor_jobid;
+		}
+
+		/*
+		 * Keep going until at least one job is found or the cluster
+		 * has nothing more, the caller takes an empty chunk to mean
+		 * there are no more jobs.
+		 */
+		do {
+			job_cnt = list_count(job_list);
+			if ((*get_jobs)(cluster_name,
+					chunk_size ? (chunk_size - job_cnt) : 0,
+					&after_jobid, &exhausted, job_list, arg)
+			    != SLURM_SUCCESS)
+				break;
+		} while (!exhausted && (job_cnt == list_count(job_list)));
+
+		if (chunk_size && (!exhausted ||
+				   (list_count(job_list) >= chunk_size)))
+			break;
+	}
+	list_iterator_destroy(itr);
+}
+
+/*
+ * The jobs come back grouped by cluster in the order the clusters were
+ * looked at, so the cursor is the highest job id of the last cluster.
+ */
+extern void slurmdb_job_chunk_set_cursor(slurmdb_job_cond_t *job_cond,
+					 List job_list)
+{
+	ListIterator itr;
+	slurmdb_job_rec_t *job;
+	char *cluster = NULL;
+	uint32_t jobid = 0;
+
+	itr = list_iterator_create(job_list);
+	while ((job = list_next(itr))) {
+		if (xstrcmp(job->cluster, cluster)) {
+			cluster = job->cluster;
+			jobid = 0;
+		}
+		if (job->jobid > jobid)
+			jobid = job->jobid;
+	}
+	list_iterator_destroy(itr);
+
+	if (!cluster)
+		return;
+
+	xfree(job_cond->cursor_cluster);
+	job_cond->cursor_cluster = xstrdup(cluster);
+	job_cond->cursor_jobid = jobid;
+}
+
 static uint32_t _str_2_qos_flags(char *flags)
 {
 	if (xstrcasestr(flags, "DenyOnLimit"))
@@ -1222,6 +1306,7 @@ extern void slurmdb_destroy_job_cond(void *object)
 		FREE_NULL_LIST(job_cond->associd_list);
 		FREE_NULL_LIST(job_cond->cluster_list);
 		FREE_NULL_LIST(job_cond->constraint_list);
+		xfree(job_cond->cursor_cluster);
 		FREE_NULL_LIST(job_cond->groupid_list);
 		FREE_NULL_LIST(job_cond->jobname_list);
 		FREE_NULL_LIST(job_cond->partition_list);
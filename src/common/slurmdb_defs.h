@@ -296,6 +296,34 @@ extern char *slurmdb_ave_tres_usage(char *tres_string, int tasks);
 extern int slurmdb_setup_cluster_rec(slurmdb_cluster_rec_t *cluster_rec);
 
 extern void slurmdb_job_cond_def_start_end(slurmdb_job_cond_t *job_cond);
+
+/*
+ * Get the jobs of cluster_name for slurmdb_job_chunk_get().
+ *
+ * IN limit - if not 0, stop at the job id of the limit'th matching record
+ * IN/OUT after_jobid - only look at job ids above it, set to the last job
+ *	id looked at when limit is set
+ * OUT exhausted - true if the cluster has no more jobs to look at
+ * IN/OUT job_list - jobs found are appended to it
+ * RET SLURM_SUCCESS or error
+ */
+typedef int (*slurmdb_cluster_jobs_f)(char *cluster_name, uint32_t limit,
+				      uint32_t *after_jobid, bool *exhausted,
+				      List job_list, void *arg);
+
+/*
+ * Walk cluster_list getting jobs with get_jobs() into job_list.  With
+ * job_cond->chunk_size only the next chunk of jobs after the cursor of
+ * job_cond is fetched, an empty job_list means there are no more jobs.
+ */
+extern void slurmdb_job_chunk_get(slurmdb_job_cond_t *job_cond,
+				  List cluster_list,
+				  slurmdb_cluster_jobs_f get_jobs, void *arg,
+				  List job_list);
+
+/* Move the cursor of job_cond after the chunk of jobs in job_list */
+extern void slurmdb_job_chunk_set_cursor(slurmdb_job_cond_t *job_cond,
+					 List job_list);
 extern int slurmdb_job_sort_by_submit_time(void *v1, void *v2);
 
 #endif
@@ -40,6 +40,8 @@
 
 #include "config.h"
 
+#include <ctype.h>
+
 #include "mysql_common.h"
 #include "src/common/log.h"
 #include "src/common/xstring.h"
@@ -48,6 +50,13 @@
 #include "src/common/slurm_protocol_api.h"
 #include "src/common/read_config.h"
 
+/*
+ * Deferred writes are sent once this many rows or bytes are pending, to
+ * stay well below the server's max_allowed_packet
+ */
+#define MYSQL_BATCH_MAX_ROWS	500
+#define MYSQL_BATCH_MAX_SIZE	(512 * 1024)
+
 static char *table_defs_table = "table_defs_table";
 
 typedef struct {
@@ -55,6 +64,18 @@ typedef struct {
 	char *columns;
 } db_key_t;
 
+static void _destroy_batch_query(void *arg)
+{
+	mysql_batch_query_t *batch_query = (mysql_batch_query_t *)arg;
+
+	if (batch_query) {
+		xfree(batch_query->head);
+		xfree(batch_query->query);
+		xfree(batch_query->tail);
+		xfree(batch_query);
+	}
+}
+
 static void _destroy_db_key(void *arg)
 {
 	db_key_t *db_key = (db_key_t *)arg;
@@ -181,6 +202,89 @@ end_it:
 	return rc;
 }
 
+/* NOTE: Ensure that mysql_conn->lock is set on function entry */
+static void _reset_pending(mysql_conn_t *mysql_conn)
+{
+	list_flush(mysql_conn->pending_list);
+	mysql_conn->pending_last = NULL;
+	mysql_conn->pending_rows = 0;
+	mysql_conn->pending_size = 0;
+}
+
+/* NOTE: Ensure that mysql_conn->lock is set on function entry */
+static void _append_batch_query(mysql_batch_query_t *batch_query, char **query)
+{
+	xstrcat(*query, batch_query->query);
+	if (batch_query->tail)
+		xstrfmtcat(*query, " %s", batch_query->tail);
+	xstrcat(*query, ";");
+}
+
+/*
+ * Send the deferred statements of the connection in one round trip.
+ * A failure is remembered in pending_failed, as the caller that deferred
+ * the statement has already been told it succeeded and the transaction may
+ * have been rolled back by the server (deadlock or lock wait timeout),
+ * taking statements made earlier in it along. The next commit then rolls
+ * the transaction back and fails instead, so the sender resends it all.
+ * The statements are run again one at a time only to report which failed.
+ * NOTE: Ensure that mysql_conn->lock is set on function entry
+ */
+static int _flush_pending(mysql_conn_t *mysql_conn)
+{
+	mysql_batch_query_t *batch_query;
+	ListIterator itr;
+	char *query = NULL;
+	int rc = SLURM_SUCCESS, errnum;
+	DEF_TIMERS;
+
+	if (!mysql_conn->pending_list || !list_count(mysql_conn->pending_list))
+		return SLURM_SUCCESS;
+
+	START_TIMER;
+	itr = list_iterator_create(mysql_conn->pending_list);
+	while ((batch_query = list_next(itr)))
+		_append_batch_query(batch_query, &query);
+
+	if ((_mysql_query_internal(mysql_conn->db_conn, query) != SLURM_SUCCESS)
+	    || (_clear_results(mysql_conn->db_conn) != SLURM_SUCCESS)) {
+		rc = SLURM_ERROR;
+		errnum = mysql_errno(mysql_conn->db_conn);
+		if ((errnum == ER_LOCK_DEADLOCK) ||
+		    (errnum == ER_LOCK_WAIT_TIMEOUT)) {
+			error("%s: %d batched statements failed, transaction rolled back",
+			      __func__, list_count(mysql_conn->pending_list));
+		} else {
+			error("%s: %d batched statements failed, running them one at a time",
+			      __func__, list_count(mysql_conn->pending_list));
+			list_iterator_reset(itr);
+			while ((batch_query = list_next(itr))) {
+				xfree(query);
+				_append_batch_query(batch_query, &query);
+				if ((_mysql_query_internal(
+					     mysql_conn->db_conn, query) !=
+				     SLURM_SUCCESS) ||
+				    (_clear_results(mysql_conn->db_conn) !=
+				     SLURM_SUCCESS))
+					error("%s: failed statement: %.512s",
+					      __func__, query);
+			}
+		}
+	}
+	list_iterator_destroy(itr);
+	if (rc != SLURM_SUCCESS)
+		mysql_conn->pending_failed = true;
+	xfree(query);
+	END_TIMER;
+
+	debug3("%s: %u rows in %d statements took %s", __func__,
+	       mysql_conn->pending_rows, list_count(mysql_conn->pending_list),
+	       TIME_STR);
+	_reset_pending(mysql_conn);
+
+	return rc;
+}
+
 /* NOTE: Ensure that mysql_conn->lock is NOT set on function entry */
 static int _mysql_make_table_current(mysql_conn_t *mysql_conn, char *table_name,
 				     storage_field_t *fields, char *ending)
@@ -633,6 +737,7 @@ extern mysql_conn_t *create_mysql_conn(int conn_num, bool rollback,
 	mysql_conn->conn = conn_num;
 	mysql_conn->cluster_name = xstrdup(cluster_name);
 	slurm_mutex_init(&mysql_conn->lock);
+	mysql_conn->pending_list = list_create(_destroy_batch_query);
 	mysql_conn->update_list = list_create(slurmdb_destroy_update_object);
 
 	return mysql_conn;
@@ -645,6 +750,7 @@ extern int destroy_mysql_conn(mysql_conn_t *mysql_conn)
 		xfree(mysql_conn->pre_commit_query);
 		xfree(mysql_conn->cluster_name);
 		slurm_mutex_destroy(&mysql_conn->lock);
+		FREE_NULL_LIST(mysql_conn->pending_list);
 		FREE_NULL_LIST(mysql_conn->update_list);
 		xfree(mysql_conn);
 	}
@@ -777,15 +883,18 @@ extern int mysql_db_get_db_connection(mysql_conn_t *mysql_conn, char *db_name,
 
 extern int mysql_db_close_db_connection(mysql_conn_t *mysql_conn)
 {
+	int rc = SLURM_SUCCESS;
+
 	slurm_mutex_lock(&mysql_conn->lock);
 	if (mysql_conn && mysql_conn->db_conn) {
+		rc = _flush_pending(mysql_conn);
 		if (mysql_thread_safe())
 			mysql_thread_end();
 		mysql_close(mysql_conn->db_conn);
 		mysql_conn->db_conn = NULL;
 	}
 	slurm_mutex_unlock(&mysql_conn->lock);
-	return SLURM_SUCCESS;
+	return rc;
 }
 
 extern int mysql_db_cleanup()
@@ -810,7 +919,87 @@ extern int mysql_db_query(mysql_conn_t *mysql_conn, char *query)
 		return 0;	/* For CLANG false positive */
 	}
 	slurm_mutex_lock(&mysql_conn->lock);
-	rc = _mysql_query_internal(mysql_conn->db_conn, query);
+	if ((rc = _flush_pending(mysql_conn)) == SLURM_SUCCESS)
+		rc = _mysql_query_internal(mysql_conn->db_conn, query);
+	slurm_mutex_unlock(&mysql_conn->lock);
+	return rc;
+}
+
+extern int mysql_db_query_batch(mysql_conn_t *mysql_conn, char *query)
+{
+	mysql_batch_query_t *batch_query;
+	int rc = SLURM_SUCCESS, len;
+
+	if (!mysql_conn || !mysql_conn->db_conn) {
+		fatal("You haven't inited this storage yet.");
+		return 0;	/* For CLANG false positive */
+	}
+	batch_query = xmalloc(sizeof(mysql_batch_query_t));
+	batch_query->query = xstrdup(query);
+	/* statements are separated when sent, avoid empty ones */
+	len = strlen(batch_query->query);
+	while (len && ((batch_query->query[len - 1] == ';') ||
+		       isspace((unsigned char) batch_query->query[len - 1])))
+		batch_query->query[--len] = '\0';
+
+	slurm_mutex_lock(&mysql_conn->lock);
+	list_append(mysql_conn->pending_list, batch_query);
+	mysql_conn->pending_last = batch_query;
+	mysql_conn->pending_rows++;
+	mysql_conn->pending_size += strlen(query);
+	if ((mysql_conn->pending_rows >= MYSQL_BATCH_MAX_ROWS) ||
+	    (mysql_conn->pending_size >= MYSQL_BATCH_MAX_SIZE))
+		rc = _flush_pending(mysql_conn);
+	slurm_mutex_unlock(&mysql_conn->lock);
+	return rc;
+}
+
+extern int mysql_db_insert_batch(mysql_conn_t *mysql_conn, char *head,
+				 char *row, char *tail)
+{
+	mysql_batch_query_t *batch_query;
+	int rc = SLURM_SUCCESS;
+
+	if (!mysql_conn || !mysql_conn->db_conn) {
+		fatal("You haven't inited this storage yet.");
+		return 0;	/* For CLANG false positive */
+	}
+
+	slurm_mutex_lock(&mysql_conn->lock);
+	batch_query = mysql_conn->pending_last;
+	if (batch_query && batch_query->head && !xstrcmp(batch_query->head, head) &&
+	    !xstrcmp(batch_query->tail, tail)) {
+		xstrfmtcat(batch_query->query, ", %s", row);
+	} else {
+		batch_query = xmalloc(sizeof(mysql_batch_query_t));
+		batch_query->head = xstrdup(head);
+		batch_query->query = xstrdup_printf("%s %s", head, row);
+		batch_query->tail = xstrdup(tail);
+		list_append(mysql_conn->pending_list, batch_query);
+		mysql_conn->pending_last = batch_query;
+		mysql_conn->pending_size += strlen(head) + strlen(tail);
+	}
+	mysql_conn->pending_rows++;
+	mysql_conn->pending_size += strlen(row);
+	if ((mysql_conn->pending_rows >= MYSQL_BATCH_MAX_ROWS) ||
+	    (mysql_conn->pending_size >= MYSQL_BATCH_MAX_SIZE))
+		rc = _flush_pending(mysql_conn);
+	slurm_mutex_unlock(&mysql_conn->lock);
+	return rc;
+}
+
+extern int mysql_db_flush(mysql_conn_t *mysql_conn)
+{
+	int rc;
+
+	if (!mysql_conn->db_conn)
+		return SLURM_ERROR;
+
+	slurm_mutex_lock(&mysql_conn->lock);
+	rc = _flush_pending(mysql_conn);
+	if (mysql_conn->pending_failed)
+		rc = SLURM_ERROR;
+	mysql_conn->pending_failed = false;
 	slurm_mutex_unlock(&mysql_conn->lock);
 	return rc;
 }
@@ -828,7 +1017,9 @@ extern int mysql_db_delete_affected_rows(mysql_conn_t *mysql_conn, char *query)
 		return 0;	/* For CLANG false positive */
 	}
 	slurm_mutex_lock(&mysql_conn->lock);
-	if (!(rc = _mysql_query_internal(mysql_conn->db_conn, query)))
+	if ((rc = _flush_pending(mysql_conn)) != SLURM_SUCCESS)
+		rc = -1;
+	else if (!(rc = _mysql_query_internal(mysql_conn->db_conn, query)))
 		rc = mysql_affected_rows(mysql_conn->db_conn);
 	slurm_mutex_unlock(&mysql_conn->lock);
 	return rc;
@@ -863,9 +1054,23 @@ extern int mysql_db_commit(mysql_conn_t *mysql_conn)
 		return SLURM_ERROR;
 
 	slurm_mutex_lock(&mysql_conn->lock);
+	(void) _flush_pending(mysql_conn);
 	/* clear out the old results so we don't get a 2014 error */
 	_clear_results(mysql_conn->db_conn);
-	if (mysql_commit(mysql_conn->db_conn)) {
+	if (mysql_conn->pending_failed) {
+		/*
+		 * Some deferred writes could not be made, fail the whole
+		 * transaction so the sender keeps and resends its records
+		 */
+		error("%s: deferred statements failed, rolling back",
+		      __func__);
+		mysql_conn->pending_failed = false;
+		if (mysql_rollback(mysql_conn->db_conn))
+			error("mysql_rollback failed: %d %s",
+			      mysql_errno(mysql_conn->db_conn),
+			      mysql_error(mysql_conn->db_conn));
+		rc = SLURM_ERROR;
+	} else if (mysql_commit(mysql_conn->db_conn)) {
 		error("mysql_commit failed: %d %s",
 		      mysql_errno(mysql_conn->db_conn),
 		      mysql_error(mysql_conn->db_conn));
@@ -884,6 +1089,9 @@ extern int mysql_db_rollback(mysql_conn_t *mysql_conn)
 		return SLURM_ERROR;
 
 	slurm_mutex_lock(&mysql_conn->lock);
+	/* deferred statements are part of what is rolled back */
+	_reset_pending(mysql_conn);
+	mysql_conn->pending_failed = false;
 	/* clear out the old results so we don't get a 2014 error */
 	_clear_results(mysql_conn->db_conn);
 	if (mysql_rollback(mysql_conn->db_conn)) {
@@ -910,6 +1118,8 @@ extern MYSQL_RES *mysql_db_query_ret(mysql_conn_t *mysql_conn,
 	MYSQL_RES *result = NULL;
 
 	slurm_mutex_lock(&mysql_conn->lock);
+	if (_flush_pending(mysql_conn) != SLURM_SUCCESS)
+		goto fini;
 	if (_mysql_query_internal(mysql_conn->db_conn, query) != SLURM_ERROR)  {
 		if (mysql_errno(mysql_conn->db_conn) == ER_NO_SUCH_TABLE)
 			goto fini;
@@ -939,8 +1149,9 @@ extern int mysql_db_query_check_after(mysql_conn_t *mysql_conn, char *query)
 	int rc = SLURM_SUCCESS;
 
 	slurm_mutex_lock(&mysql_conn->lock);
-	if ((rc = _mysql_query_internal(
-		     mysql_conn->db_conn, query)) != SLURM_ERROR)
+	if (((rc = _flush_pending(mysql_conn)) == SLURM_SUCCESS) &&
+	    ((rc = _mysql_query_internal(
+		      mysql_conn->db_conn, query)) != SLURM_ERROR))
 		rc = _clear_results(mysql_conn->db_conn);
 	slurm_mutex_unlock(&mysql_conn->lock);
 	return rc;
@@ -951,7 +1162,8 @@ extern uint64_t mysql_db_insert_ret_id(mysql_conn_t *mysql_conn, char *query)
 	uint64_t new_id = 0;
 
 	slurm_mutex_lock(&mysql_conn->lock);
-	if (_mysql_query_internal(mysql_conn->db_conn, query) != SLURM_ERROR)  {
+	if ((_flush_pending(mysql_conn) == SLURM_SUCCESS) &&
+	    (_mysql_query_internal(mysql_conn->db_conn, query) != SLURM_ERROR)) {
 		new_id = mysql_insert_id(mysql_conn->db_conn);
 		if (!new_id) {
 			/* should have new id */
@@ -58,11 +58,24 @@ typedef enum {
 	SLURM_MYSQL_PLUGIN_JC, /* jobcomp */
 } slurm_mysql_plugin_type_t;
 
+typedef struct {
+	char *head;	/* for inserts, statement up to the values */
+	char *query;	/* statement, with all rows for inserts */
+	char *tail;	/* for inserts, appended when the statement is sent */
+} mysql_batch_query_t;
+
 typedef struct {
 	bool cluster_deleted;
 	char *cluster_name;
 	MYSQL *db_conn;
 	pthread_mutex_t lock;
+	List pending_list;	/* statements deferred by mysql_db_query_batch()
+				 * and mysql_db_insert_batch() */
+	mysql_batch_query_t *pending_last; /* last entry of pending_list */
+	uint32_t pending_rows;	/* rows and statements in pending_list */
+	uint32_t pending_size;	/* bytes in pending_list */
+	bool pending_failed;	/* deferred statements failed since the last
+				 * commit or rollback */
 	char *pre_commit_query;
 	bool rollback;
 	List update_list;
@@ -93,6 +106,36 @@ extern int mysql_db_get_db_connection(mysql_conn_t *mysql_conn, char *db_name,
 extern int mysql_db_close_db_connection(mysql_conn_t *mysql_conn);
 extern int mysql_db_cleanup();
 extern int mysql_db_query(mysql_conn_t *mysql_conn, char *query);
+
+/*
+ * Defer a write statement, to be sent to the database together with the
+ * other deferred statements of the connection in a single round trip.
+ * Deferred statements are run before any other statement of the connection,
+ * and before it commits or closes, so they keep their place in the
+ * transaction. Only use this for statements whose result is not needed and
+ * which can safely be run again.
+ * Should a deferred statement fail, the statement that sent it fails and
+ * mysql_db_commit() rolls the transaction back and returns SLURM_ERROR.
+ */
+extern int mysql_db_query_batch(mysql_conn_t *mysql_conn, char *query);
+
+/*
+ * Defer one row of an insert. Consecutive rows deferred with the same head
+ * and tail are sent as a single multi-row insert statement.
+ * IN head - statement up to "values" (e.g. "insert into t (a, b) values")
+ * IN row - row of values including the parentheses (e.g. "(1, 2)")
+ * IN tail - rest of the statement (e.g. "on duplicate key update ...")
+ *	which must not refer to the values directly, but use VALUES(col)
+ */
+extern int mysql_db_insert_batch(mysql_conn_t *mysql_conn, char *head,
+				 char *row, char *tail);
+
+/*
+ * Send all statements deferred on the connection to the database now.
+ * Returns SLURM_ERROR if any deferred statement failed since the last flush,
+ * commit or rollback.
+ */
+extern int mysql_db_flush(mysql_conn_t *mysql_conn);
 extern int mysql_db_delete_affected_rows(mysql_conn_t *mysql_conn, char *query);
 extern int mysql_db_ping(mysql_conn_t *mysql_conn);
 extern int mysql_db_commit(mysql_conn_t *mysql_conn);
@@ -1127,6 +1127,23 @@ extern int check_connection(mysql_conn_t *mysql_conn)
 	return SLURM_SUCCESS;
 }
 
+/*
+ * Return a copy of as_mysql_cluster_list for queries over all clusters, so
+ * they don't hold as_mysql_cluster_list_lock, and with it other queries and
+ * cluster changes, while they run.
+ */
+extern List as_mysql_copy_cluster_list(void)
+{
+	List cluster_list;
+
+	slurm_mutex_lock(&as_mysql_cluster_list_lock);
+	if (!(cluster_list = slurm_copy_char_list(as_mysql_cluster_list)))
+		cluster_list = list_create(xfree_ptr);
+	slurm_mutex_unlock(&as_mysql_cluster_list_lock);
+
+	return cluster_list;
+}
+
 /* Let me know if the last statement had rows that were affected.
  * This only gets called by a non-threaded connection, so there is no
  * need to worry about locks.
@@ -2763,12 +2780,17 @@ extern int acct_storage_p_commit(mysql_conn_t *mysql_conn, bool commit)
 
 	debug4("got %d commits", list_count(mysql_conn->update_list));
 
+	rc = SLURM_SUCCESS;
+
+	/* Send the deferred job and step writes of autocommit connections */
+	if (!mysql_conn->rollback)
+		rc = mysql_db_flush(mysql_conn);
+
 	if (mysql_conn->rollback) {
 		if (!commit) {
 			if (mysql_db_rollback(mysql_conn))
 				error("rollback failed");
 		} else {
-			int rc = SLURM_SUCCESS;
 			/*
 			 * Handle anything here we were unable to do
 			 * because of rollback issues.
@@ -2785,9 +2807,8 @@ extern int acct_storage_p_commit(mysql_conn_t *mysql_conn, bool commit)
 			if (rc != SLURM_SUCCESS) {
 				if (mysql_db_rollback(mysql_conn))
 					error("rollback failed");
-			} else {
-				if (mysql_db_commit(mysql_conn))
-					error("commit failed");
+			} else if ((rc = mysql_db_commit(mysql_conn))) {
+				error("commit failed");
 			}
 		}
 	}
@@ -2852,7 +2873,7 @@ extern int acct_storage_p_commit(mysql_conn_t *mysql_conn, bool commit)
 	xfree(mysql_conn->pre_commit_query);
 	list_flush(mysql_conn->update_list);
 
-	return SLURM_SUCCESS;
+	return rc;
 }
 
 extern int acct_storage_p_add_users(mysql_conn_t *mysql_conn, uint32_t uid,
@@ -130,6 +130,7 @@ typedef enum {
 extern int check_connection(mysql_conn_t *mysql_conn);
 extern char *fix_double_quotes(char *str);
 extern int last_affected_rows(mysql_conn_t *mysql_conn);
+extern List as_mysql_copy_cluster_list(void);
 extern void reset_mysql_conn(mysql_conn_t *mysql_conn);
 extern int create_cluster_assoc_table(
 	mysql_conn_t *mysql_conn, char *cluster_name);
@@ -45,6 +45,7 @@
 #include "as_mysql_archive.h"
 #include "src/common/env.h"
 #include "src/common/slurm_time.h"
+#include "src/common/slurmdb_col_archive.h"
 #include "src/common/slurmdbd_defs.h"
 
 #define SLURM_17_11_PROTOCOL_VERSION ((32 << 8) | 0)
@@ -2889,6 +2890,66 @@ static Buf _pack_archive_jobs(MYSQL_RES *result, char *cluster_name,
 	return buffer;
 }
 
+/*
+ * Same jobs as _pack_archive_jobs() in the columnar format read by
+ * sacct --archive-file.
+ */
+static Buf _pack_archive_jobs_col(MYSQL_RES *result, char *cluster_name)
+{
+	MYSQL_ROW row;
+	slurmdb_col_writer_t *writer;
+	slurmdb_job_rec_t job;
+	assoc_mgr_lock_t locks = { NO_LOCK, NO_LOCK, READ_LOCK, NO_LOCK,
+				   READ_LOCK, NO_LOCK, NO_LOCK };
+
+	assoc_mgr_lock(&locks);
+	writer = slurmdb_col_writer_create(cluster_name, assoc_mgr_tres_list,
+					   assoc_mgr_qos_list);
+	assoc_mgr_unlock(&locks);
+
+	while ((row = mysql_fetch_row(result))) {
+		/* The strings are only borrowed from the row */
+		memset(&job, 0, sizeof(slurmdb_job_rec_t));
+
+		job.account = row[JOB_REQ_ACCOUNT];
+		job.alloc_nodes = slurm_atoul(row[JOB_REQ_ALLOC_NODES]);
+		job.array_job_id = slurm_atoul(row[JOB_REQ_ARRAYJOBID]);
+		job.array_task_id = slurm_atoul(row[JOB_REQ_ARRAYTASKID]);
+		job.constraints = row[JOB_REQ_CONSTRAINTS];
+		job.derived_ec = slurm_atoul(row[JOB_REQ_DERIVED_EC]);
+		job.eligible = slurm_atoul(row[JOB_REQ_ELIGIBLE]);
+		job.end = slurm_atoul(row[JOB_REQ_END]);
+		job.exitcode = slurm_atoul(row[JOB_REQ_EXIT_CODE]);
+		job.flags = slurm_atoul(row[JOB_REQ_FLAGS]);
+		job.gid = slurm_atoul(row[JOB_REQ_GID]);
+		job.het_job_id = slurm_atoul(row[JOB_REQ_HET_JOB_ID]);
+		job.het_job_offset = slurm_atoul(row[JOB_REQ_HET_JOB_OFFSET]);
+		job.jobid = slurm_atoul(row[JOB_REQ_JOBID]);
+		job.jobname = row[JOB_REQ_NAME];
+		job.nodes = row[JOB_REQ_NODELIST];
+		job.partition = row[JOB_REQ_PARTITION];
+		job.priority = slurm_atoul(row[JOB_REQ_PRIORITY]);
+		job.qosid = slurm_atoul(row[JOB_REQ_QOS]);
+		job.req_cpus = slurm_atoul(row[JOB_REQ_REQ_CPUS]);
+		job.req_mem = slurm_atoull(row[JOB_REQ_REQ_MEM]);
+		job.start = slurm_atoul(row[JOB_REQ_START]);
+		job.state = slurm_atoul(row[JOB_REQ_STATE]);
+		job.submit = slurm_atoul(row[JOB_REQ_SUBMIT]);
+		job.suspended = slurm_atoul(row[JOB_REQ_SUSPENDED]);
+		job.timelimit = slurm_atoul(row[JOB_REQ_TIMELIMIT]);
+		job.track_steps = slurm_atoul(row[JOB_REQ_TRACKSTEPS]);
+		job.tres_alloc_str = row[JOB_REQ_TRESA];
+		job.tres_req_str = row[JOB_REQ_TRESR];
+		job.uid = slurm_atoul(row[JOB_REQ_UID]);
+		job.wckey = row[JOB_REQ_WCKEY];
+		job.work_dir = row[JOB_REQ_WORK_DIR];
+
+		slurmdb_col_writer_add_job(writer, &job);
+	}
+
+	return slurmdb_col_writer_fini(writer);
+}
+
 /* returns sql statement from archived data or NULL on error */
 static char *_load_jobs(uint16_t rpc_version, Buf buffer,
 			char *cluster_name, uint32_t rec_cnt)
@@ -3850,7 +3911,6 @@ static uint32_t _archive_table(purge_type_t type, mysql_conn_t *mysql_conn,
 
 	buffer = (*pack_func)(result, cluster_name, cnt, usage_info,
 			      &period_start);
-	mysql_free_result(result);
 
 	error_code = archive_write_file(buffer, cluster_name,
 					period_start, period_end,
@@ -3858,6 +3918,18 @@ static uint32_t _archive_table(purge_type_t type, mysql_conn_t *mysql_conn,
 					archive_period);
 	free_buf(buffer);
 
+	if ((error_code == SLURM_SUCCESS) && (type == PURGE_JOB) &&
+	    slurmdbd_conf && slurmdbd_conf->archive_columnar) {
+		mysql_data_seek(result, 0);
+		buffer = _pack_archive_jobs_col(result, cluster_name);
+		error_code = archive_write_file(buffer, cluster_name,
+						period_start, period_end,
+						arch_dir, "job_col",
+						archive_period);
+		free_buf(buffer);
+	}
+	mysql_free_result(result);
+
 	if (error_code != SLURM_SUCCESS)
 		return error_code;
 
@@ -3410,6 +3410,7 @@ extern List as_mysql_get_assocs(mysql_conn_t *mysql_conn, uid_t uid,
 	slurmdb_user_rec_t user;
 	char *prefix = "t1";
 	List use_cluster_list = as_mysql_cluster_list;
+	bool free_cluster_list = false;
 	char *cluster_name = NULL;
 
 	if (!assoc_cond) {
@@ -3457,8 +3458,10 @@ empty:
 	}
 	assoc_list = list_create(slurmdb_destroy_assoc_rec);
 
-	if (use_cluster_list == as_mysql_cluster_list)
-		slurm_mutex_lock(&as_mysql_cluster_list_lock);
+	if (use_cluster_list == as_mysql_cluster_list) {
+		use_cluster_list = as_mysql_copy_cluster_list();
+		free_cluster_list = true;
+	}
 	itr = list_iterator_create(use_cluster_list);
 	while ((cluster_name = list_next(itr))) {
 		int rc;
@@ -3472,8 +3475,8 @@ empty:
 		}
 	}
 	list_iterator_destroy(itr);
-	if (use_cluster_list == as_mysql_cluster_list)
-		slurm_mutex_unlock(&as_mysql_cluster_list_lock);
+	if (free_cluster_list)
+		FREE_NULL_LIST(use_cluster_list);
 	xfree(tmp);
 	xfree(extra);
 
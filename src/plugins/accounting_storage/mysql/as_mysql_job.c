@@ -724,7 +724,7 @@ no_rollup_change:
 
 		if (debug_flags & DEBUG_FLAG_DB_JOB)
 			DB_DEBUG(mysql_conn->conn, "query\n%s", query);
-		rc = mysql_db_query(mysql_conn, query);
+		rc = mysql_db_query_batch(mysql_conn, query);
 	}
 
 	/* now we will reset all the steps */
@@ -1128,7 +1128,7 @@ extern int as_mysql_job_complete(mysql_conn_t *mysql_conn,
 
 	if (debug_flags & DEBUG_FLAG_DB_JOB)
 		DB_DEBUG(mysql_conn->conn, "query\n%s", query);
-	rc = mysql_db_query(mysql_conn, query);
+	rc = mysql_db_query_batch(mysql_conn, query);
 	xfree(query);
 
 	xfree(tres_alloc_str);
@@ -1144,7 +1144,7 @@ extern int as_mysql_step_start(mysql_conn_t *mysql_conn,
 	char node_list[BUFFER_SIZE];
 	char *node_inx = NULL;
 	time_t start_time, submit_time;
-	char *query = NULL;
+	char *head = NULL, *query = NULL;
 
 	if (!step_ptr->job_ptr->db_index
 	    && ((!step_ptr->job_ptr->details
@@ -1248,35 +1248,45 @@ extern int as_mysql_step_start(mysql_conn_t *mysql_conn,
 		}
 	}
 
-	/* we want to print a -1 for the requid so leave it a
-	   %d */
-	/* The stepid could be -2 so use %d not %u */
-	query = xstrdup_printf(
+	/*
+	 * Steps are inserted as rows of a single statement until something
+	 * else is sent to the database, so the update on a duplicate key
+	 * takes the values from the row.
+	 */
+	head = xstrdup_printf(
 		"insert into \"%s_%s\" (job_db_inx, id_step, time_start, "
 		"step_name, state, tres_alloc, "
 		"nodes_alloc, task_cnt, nodelist, node_inx, "
 		"task_dist, req_cpufreq, req_cpufreq_min, req_cpufreq_gov) "
-		"values (%"PRIu64", %d, %d, '%s', %d, '%s', %d, %d, "
-		"'%s', '%s', %d, %u, %u, %u) "
-		"on duplicate key update "
-		"nodes_alloc=%d, task_cnt=%d, time_end=0, state=%d, "
-		"nodelist='%s', node_inx='%s', task_dist=%d, "
-		"req_cpufreq=%u, req_cpufreq_min=%u, req_cpufreq_gov=%u,"
-		"tres_alloc='%s';",
-		mysql_conn->cluster_name, step_table,
+		"values",
+		mysql_conn->cluster_name, step_table);
+	/* we want to print a -1 for the requid so leave it a
+	   %d */
+	/* The stepid could be -2 so use %d not %u */
+	query = xstrdup_printf(
+		"(%"PRIu64", %d, %d, '%s', %d, '%s', %d, %d, "
+		"'%s', '%s', %d, %u, %u, %u)",
 		step_ptr->job_ptr->db_index,
 		step_ptr->step_id,
 		(int)start_time, step_ptr->name,
 		JOB_RUNNING, step_ptr->tres_alloc_str,
 		nodes, tasks, node_list, node_inx, task_dist,
 		step_ptr->cpu_freq_max, step_ptr->cpu_freq_min,
-		step_ptr->cpu_freq_gov, nodes, tasks, JOB_RUNNING,
-		node_list, node_inx, task_dist, step_ptr->cpu_freq_max,
-		step_ptr->cpu_freq_min, step_ptr->cpu_freq_gov,
-		step_ptr->tres_alloc_str);
+		step_ptr->cpu_freq_gov);
 	if (debug_flags & DEBUG_FLAG_DB_STEP)
-		DB_DEBUG(mysql_conn->conn, "query\n%s", query);
-	rc = mysql_db_query(mysql_conn, query);
+		DB_DEBUG(mysql_conn->conn, "query\n%s %s", head, query);
+	rc = mysql_db_insert_batch(
+		mysql_conn, head, query,
+		"on duplicate key update "
+		"nodes_alloc=VALUES(nodes_alloc), task_cnt=VALUES(task_cnt), "
+		"time_end=0, state=VALUES(state), "
+		"nodelist=VALUES(nodelist), node_inx=VALUES(node_inx), "
+		"task_dist=VALUES(task_dist), "
+		"req_cpufreq=VALUES(req_cpufreq), "
+		"req_cpufreq_min=VALUES(req_cpufreq_min), "
+		"req_cpufreq_gov=VALUES(req_cpufreq_gov), "
+		"tres_alloc=VALUES(tres_alloc)");
+	xfree(head);
 	xfree(query);
 
 	return rc;
@@ -1525,7 +1535,7 @@ extern int as_mysql_step_complete(mysql_conn_t *mysql_conn,
 		   step_ptr->job_ptr->db_index, step_ptr->step_id);
 	if (debug_flags & DEBUG_FLAG_DB_STEP)
 		DB_DEBUG(mysql_conn->conn, "query\n%s", query);
-	rc = mysql_db_query(mysql_conn, query);
+	rc = mysql_db_query_batch(mysql_conn, query);
 	xfree(query);
 
 	/* set the energy for the entire job. */
@@ -1538,7 +1548,7 @@ extern int as_mysql_step_complete(mysql_conn_t *mysql_conn,
 			step_ptr->job_ptr->db_index);
 		if (debug_flags & DEBUG_FLAG_DB_STEP)
 			DB_DEBUG(mysql_conn->conn, "query\n%s", query);
-		rc = mysql_db_query(mysql_conn, query);
+		rc = mysql_db_query_batch(mysql_conn, query);
 		xfree(query);
 	}
 
@@ -51,6 +51,19 @@ typedef struct {
 	bitstr_t *asked_bitmap;
 } local_cluster_t;
 
+/* Arguments of _get_cluster_jobs() for slurmdb_job_chunk_get() */
+typedef struct {
+	char *cluster_name;	/* cluster extra was last set up for */
+	char **extra;
+	bool is_admin;
+	slurmdb_job_cond_t *job_cond;
+	char *job_fields;
+	mysql_conn_t *mysql_conn;
+	int only_pending;
+	char *step_fields;
+	slurmdb_user_rec_t *user;
+} get_jobs_args_t;
+
 /* if this changes you will need to edit the corresponding
  * enum below also t1 is job_table */
 char *job_req_inx[] = {
@@ -455,15 +468,27 @@ static void _destroy_local_cluster(void *object)
 	}
 }
 
+/*
+ * Get the jobs of cluster_name matching job_cond into sent_list.
+ *
+ * If limit is set only the jobs with an id_job after *after_jobid are looked
+ * at, stopping at the id_job of the limit'th matching record so all records
+ * of a given job id are always returned together.  On return *after_jobid is
+ * set to the last id_job looked at and *exhausted tells if there were no
+ * more records to look at in this cluster.
+ */
 static int _cluster_get_jobs(mysql_conn_t *mysql_conn,
 			     slurmdb_user_rec_t *user,
 			     slurmdb_job_cond_t *job_cond,
 			     char *cluster_name,
 			     char *job_fields, char *step_fields,
 			     char *sent_extra,
-			     bool is_admin, int only_pending, List sent_list)
+			     bool is_admin, int only_pending,
+			     uint32_t limit, uint32_t *after_jobid,
+			     bool *exhausted, List sent_list)
 {
 	char *query = NULL;
+	char *tables = NULL;
 	char *extra = xstrdup(sent_extra);
 	uint16_t private_data = slurm_get_private_data();
 	slurmdb_selected_step_t *selected_step = NULL;
@@ -479,8 +504,11 @@ static int _cluster_get_jobs(mysql_conn_t *mysql_conn,
 	char *prefix="t2";
 	int rc = SLURM_SUCCESS;
 	int last_id = -1, curr_id = -1;
+	uint32_t end_jobid = 0;
 	local_cluster_t *curr_cluster = NULL;
 
+	*exhausted = true;
+
 	/* This is here to make sure we are looking at only this user
 	 * if this flag is set.  We also include any accounts they may be
 	 * coordinator of.
@@ -548,7 +576,7 @@ static int _cluster_get_jobs(mysql_conn_t *mysql_conn,
 	setup_job_cluster_cond_limits(mysql_conn, job_cond,
 				      cluster_name, &extra);
 
-	query = xstrdup_printf("select %s from \"%s_%s\" as t1 "
+	tables = xstrdup_printf("\"%s_%s\" as t1 "
 			       "left join \"%s_%s\" as t2 "
 			       "on t1.id_assoc=t2.id_assoc "
 			       "left join \"%s_%s\" as t3 "
@@ -561,7 +589,7 @@ static int _cluster_get_jobs(mysql_conn_t *mysql_conn,
 			       "(t3.time_end >= t1.time_submit || "
 			       "t3.time_end = 0)) || "
 			       "(t3.time_start > t1.time_submit)))",
-			       job_fields, cluster_name, job_table,
+			       cluster_name, job_table,
 			       cluster_name, assoc_table,
 			       cluster_name, resv_table);
 
@@ -572,6 +600,49 @@ static int _cluster_get_jobs(mysql_conn_t *mysql_conn,
 			xstrcat(extra, " where (t1.time_end=0)");
 	}
 
+	if (*after_jobid) {
+		if (extra)
+			xstrfmtcat(extra, " && (t1.id_job>%u)", *after_jobid);
+		else
+			xstrfmtcat(extra, " where (t1.id_job>%u)",
+				   *after_jobid);
+	}
+
+	/*
+	 * Find the id_job of the limit'th record, the records after it with
+	 * the same id_job are returned too so duplicates and resized jobs are
+	 * handled the same as when everything is returned at once.
+	 */
+	if (limit) {
+		query = xstrdup_printf("select t1.id_job from %s%s "
+				       "order by t1.id_job limit %u, 1",
+				       tables, extra ? extra : "", limit - 1);
+		if (debug_flags & DEBUG_FLAG_DB_JOB)
+			DB_DEBUG(mysql_conn->conn, "query\n%s", query);
+		if (!(result = mysql_db_query_ret(mysql_conn, query, 0))) {
+			xfree(extra);
+			xfree(query);
+			xfree(tables);
+			rc = SLURM_ERROR;
+			goto end_it;
+		}
+		xfree(query);
+		if ((row = mysql_fetch_row(result))) {
+			end_jobid = slurm_atoul(row[0]);
+			*exhausted = false;
+			if (extra)
+				xstrfmtcat(extra, " && (t1.id_job<=%u)",
+					   end_jobid);
+			else
+				xstrfmtcat(extra, " where (t1.id_job<=%u)",
+					   end_jobid);
+		}
+		mysql_free_result(result);
+	}
+
+	query = xstrdup_printf("select %s from %s", job_fields, tables);
+	xfree(tables);
+
 	if (extra) {
 		xstrcat(query, extra);
 		xfree(extra);
@@ -615,6 +686,8 @@ static int _cluster_get_jobs(mysql_conn_t *mysql_conn,
 		int start = slurm_atoul(row[JOB_REQ_START]);
 
 		curr_id = slurm_atoul(row[JOB_REQ_JOBID]);
+		if (limit)
+			*after_jobid = curr_id;
 
 		if (job_cond && !(job_cond->flags & JOBCOND_FLAG_DUP)
 		    && (curr_id == last_id)
@@ -1682,13 +1755,36 @@ extern int setup_job_cond_limits(slurmdb_job_cond_t *job_cond,
 	return set;
 }
 
+static int _get_cluster_jobs(char *cluster_name, uint32_t limit,
+			     uint32_t *after_jobid, bool *exhausted,
+			     List job_list, void *arg)
+{
+	get_jobs_args_t *args = (get_jobs_args_t *)arg;
+	int rc;
+
+	if (args->cluster_name != cluster_name) {
+		args->cluster_name = cluster_name;
+		_setup_job_cond_selected_steps(args->job_cond, cluster_name,
+					       args->extra);
+	}
+
+	if ((rc = _cluster_get_jobs(args->mysql_conn, args->user,
+				    args->job_cond, cluster_name,
+				    args->job_fields, args->step_fields,
+				    *args->extra, args->is_admin,
+				    args->only_pending, limit, after_jobid,
+				    exhausted, job_list)) != SLURM_SUCCESS)
+		error("Problem getting jobs for cluster %s", cluster_name);
+
+	return rc;
+}
+
 extern List as_mysql_jobacct_process_get_jobs(mysql_conn_t *mysql_conn,
 					      uid_t uid,
 					      slurmdb_job_cond_t *job_cond)
 {
 	char *extra = NULL;
 	char *tmp = NULL, *tmp2 = NULL;
-	ListIterator itr = NULL;
 	int is_admin=1;
 	int i;
 	List job_list = NULL;
@@ -1696,7 +1792,8 @@ extern List as_mysql_jobacct_process_get_jobs(mysql_conn_t *mysql_conn,
 	slurmdb_user_rec_t user;
 	int only_pending = 0;
 	List use_cluster_list = as_mysql_cluster_list;
-	char *cluster_name;
+	bool free_cluster_list = false;
+	get_jobs_args_t args;
 	assoc_mgr_lock_t locks = { NO_LOCK, NO_LOCK, NO_LOCK, NO_LOCK,
 				   READ_LOCK, NO_LOCK, NO_LOCK };
 
@@ -1742,29 +1839,31 @@ extern List as_mysql_jobacct_process_get_jobs(mysql_conn_t *mysql_conn,
 	if (job_cond
 	    && job_cond->cluster_list && list_count(job_cond->cluster_list))
 		use_cluster_list = job_cond->cluster_list;
-	else
-		slurm_mutex_lock(&as_mysql_cluster_list_lock);
+	else {
+		use_cluster_list = as_mysql_copy_cluster_list();
+		free_cluster_list = true;
+	}
+
+	memset(&args, 0, sizeof(args));
+	args.extra = &extra;
+	args.is_admin = is_admin;
+	args.job_cond = job_cond;
+	args.job_fields = tmp;
+	args.mysql_conn = mysql_conn;
+	args.only_pending = only_pending;
+	args.step_fields = tmp2;
+	args.user = &user;
 
 	assoc_mgr_lock(&locks);
 
 	job_list = list_create(slurmdb_destroy_job_rec);
-	itr = list_iterator_create(use_cluster_list);
-	while ((cluster_name = list_next(itr))) {
-		int rc;
-		_setup_job_cond_selected_steps(job_cond, cluster_name, &extra);
-		if ((rc = _cluster_get_jobs(mysql_conn, &user, job_cond,
-					    cluster_name, tmp, tmp2, extra,
-					    is_admin, only_pending, job_list))
-		    != SLURM_SUCCESS)
-			error("Problem getting jobs for cluster %s",
-			      cluster_name);
-	}
-	list_iterator_destroy(itr);
+	slurmdb_job_chunk_get(job_cond, use_cluster_list, _get_cluster_jobs,
+			      &args, job_list);
 
 	assoc_mgr_unlock(&locks);
 
-	if (use_cluster_list == as_mysql_cluster_list)
-		slurm_mutex_unlock(&as_mysql_cluster_list_lock);
+	if (free_cluster_list)
+		FREE_NULL_LIST(use_cluster_list);
 
 	xfree(tmp);
 	xfree(tmp2);
@@ -42,6 +42,14 @@
 #include "as_mysql_archive.h"
 #include "src/common/parse_time.h"
 #include "src/common/slurm_time.h"
+#include "src/common/xhash.h"
+
+/*
+ * Number of hours of job records read from the database at once by the
+ * hourly rollup.  Each record is then reused for every hour it overlaps
+ * instead of being fetched again for each hour.
+ */
+#define ROLLUP_JOB_WINDOW_HOURS 24
 
 enum {
 	TIME_ALLOC,
@@ -72,6 +80,20 @@ typedef struct {
 	List loc_tres;
 } local_id_usage_t;
 
+typedef struct {
+	uint32_t array_pending;
+	uint32_t assoc_id;
+	uint64_t db_inx;
+	time_t eligible;
+	time_t end;
+	uint32_t rcpu;
+	uint32_t resv_id;
+	time_t start;
+	bool suspended;
+	char *tres;
+	uint32_t wckey_id;
+} local_job_usage_t;
+
 typedef struct {
 	time_t end;
 	int id; /*only needed for reservations */
@@ -107,6 +129,15 @@ static void _destroy_local_id_usage(void *object)
 	}
 }
 
+static void _destroy_local_job_usage(void *object)
+{
+	local_job_usage_t *j_usage = (local_job_usage_t *)object;
+	if (j_usage) {
+		xfree(j_usage->tres);
+		xfree(j_usage);
+	}
+}
+
 static void _destroy_local_cluster_usage(void *object)
 {
 	local_cluster_usage_t *c_usage = (local_cluster_usage_t *)object;
@@ -136,14 +167,36 @@ static int _find_loc_tres(void *x, void *key)
 	return 0;
 }
 
-static int _find_id_usage(void *x, void *key)
+/* Fetch key from xhash_t item. Called from function ptr */
+static void _id_usage_key(void *item, const char **key, uint32_t *key_len)
 {
-	local_id_usage_t *loc = (local_id_usage_t *)x;
-	uint32_t id = *(uint32_t *)key;
+	local_id_usage_t *usage = (local_id_usage_t *)item;
 
-	if (loc->id == id)
-		return 1;
-	return 0;
+	xassert(usage);
+
+	*key = (char *)&usage->id;
+	*key_len = sizeof(int);
+}
+
+/*
+ * Find the usage record for id in usage_hash, adding a new one to both
+ * usage_list and usage_hash if it isn't there yet.  usage_list owns the
+ * records, usage_hash is only an index into it.
+ */
+static local_id_usage_t *_find_add_id_usage(List usage_list,
+					    xhash_t *usage_hash, int id)
+{
+	local_id_usage_t *usage;
+
+	if ((usage = xhash_get(usage_hash, (char *)&id, sizeof(int))))
+		return usage;
+
+	usage = xmalloc(sizeof(local_id_usage_t));
+	usage->id = id;
+	list_append(usage_list, usage);
+	xhash_add(usage_hash, usage);
+
+	return usage;
 }
 
 static void _remove_job_tres_time_from_cluster(List c_tres, List j_tres,
@@ -959,20 +1012,26 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 	char *query = NULL;
 	MYSQL_RES *result = NULL;
 	MYSQL_ROW row;
+	time_t job_window_end = 0;
 	ListIterator a_itr = NULL;
 	ListIterator c_itr = NULL;
+	ListIterator j_itr = NULL;
 	ListIterator w_itr = NULL;
 	ListIterator r_itr = NULL;
 	List assoc_usage_list = list_create(_destroy_local_id_usage);
 	List cluster_down_list = list_create(_destroy_local_cluster_usage);
+	List job_usage_list = list_create(_destroy_local_job_usage);
 	List wckey_usage_list = list_create(_destroy_local_id_usage);
 	List resv_usage_list = list_create(_destroy_local_resv_usage);
+	xhash_t *assoc_usage_hash = xhash_init(_id_usage_key, NULL);
+	xhash_t *wckey_usage_hash = xhash_init(_id_usage_key, NULL);
 	uint16_t track_wckey = slurm_get_track_wckey();
 	local_cluster_usage_t *loc_c_usage = NULL;
 	local_cluster_usage_t *c_usage = NULL;
 	local_resv_usage_t *r_usage = NULL;
 	local_id_usage_t *a_usage = NULL;
 	local_id_usage_t *w_usage = NULL;
+	local_job_usage_t *j_usage = NULL;
 	/* char start_char[20], end_char[20]; */
 
 	char *job_req_inx[] = {
@@ -1060,6 +1119,7 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 /* 	info("begin end %s", slurm_ctime2(&curr_end)); */
 	a_itr = list_iterator_create(assoc_usage_list);
 	c_itr = list_iterator_create(cluster_down_list);
+	j_itr = list_iterator_create(job_usage_list);
 	w_itr = list_iterator_create(wckey_usage_list);
 	r_itr = list_iterator_create(resv_usage_list);
 	while (curr_start < end) {
@@ -1206,42 +1266,84 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 		}
 		mysql_free_result(result);
 
-		/* now get the jobs during this time only  */
-		query = xstrdup_printf("select %s from \"%s_%s\" as job "
-				       "where (job.time_eligible && "
-				       "job.time_eligible < %ld && "
-				       "(job.time_end >= %ld || "
-				       "job.time_end = 0)) "
-				       "group by job.job_db_inx "
-				       "order by job.id_assoc, "
-				       "job.time_eligible",
-				       job_str, cluster_name, job_table,
-				       curr_end, curr_start);
+		/*
+		 * Get the jobs for the next ROLLUP_JOB_WINDOW_HOURS hours in
+		 * one query and reuse them for each hour they overlap rather
+		 * than asking the database for them again every hour.
+		 */
+		if (curr_start >= job_window_end) {
+			job_window_end = curr_start +
+				(ROLLUP_JOB_WINDOW_HOURS * add_sec);
+			list_flush(job_usage_list);
+
+			query = xstrdup_printf(
+				"select %s from \"%s_%s\" as job "
+				"where (job.time_eligible && "
+				"job.time_eligible < %ld && "
+				"(job.time_end >= %ld || "
+				"job.time_end = 0)) "
+				"group by job.job_db_inx "
+				"order by job.id_assoc, "
+				"job.time_eligible",
+				job_str, cluster_name, job_table,
+				job_window_end, curr_start);
 
-		if (debug_flags & DEBUG_FLAG_DB_USAGE)
-			DB_DEBUG(mysql_conn->conn, "query\n%s", query);
-		if (!(result = mysql_db_query_ret(
-			      mysql_conn, query, 0))) {
-			rc = SLURM_ERROR;
-			goto end_it;
+			if (debug_flags & DEBUG_FLAG_DB_USAGE)
+				DB_DEBUG(mysql_conn->conn, "query\n%s", query);
+			if (!(result = mysql_db_query_ret(
+				      mysql_conn, query, 0))) {
+				rc = SLURM_ERROR;
+				goto end_it;
+			}
+			xfree(query);
+
+			while ((row = mysql_fetch_row(result))) {
+				j_usage = xmalloc(sizeof(local_job_usage_t));
+				j_usage->db_inx = slurm_atoull(
+					row[JOB_REQ_DB_INX]);
+				j_usage->assoc_id =
+					slurm_atoul(row[JOB_REQ_ASSOCID]);
+				j_usage->wckey_id =
+					slurm_atoul(row[JOB_REQ_WCKEYID]);
+				j_usage->array_pending =
+					slurm_atoul(row[JOB_REQ_ARRAY_PENDING]);
+				j_usage->eligible =
+					slurm_atoul(row[JOB_REQ_ELG]);
+				j_usage->start =
+					slurm_atoul(row[JOB_REQ_START]);
+				j_usage->end = slurm_atoul(row[JOB_REQ_END]);
+				j_usage->suspended =
+					slurm_atoul(row[JOB_REQ_SUSPENDED]);
+				j_usage->rcpu = slurm_atoul(row[JOB_REQ_RCPU]);
+				j_usage->resv_id =
+					slurm_atoul(row[JOB_REQ_RESVID]);
+				j_usage->tres = xstrdup(row[JOB_REQ_TRES]);
+				list_append(job_usage_list, j_usage);
+			}
+			mysql_free_result(result);
+			result = NULL;
+			j_usage = NULL;
 		}
-		xfree(query);
 
-		while ((row = mysql_fetch_row(result))) {
-			//uint32_t job_id = slurm_atoul(row[JOB_REQ_JOBID]);
-			uint32_t assoc_id = slurm_atoul(row[JOB_REQ_ASSOCID]);
-			uint32_t wckey_id = slurm_atoul(row[JOB_REQ_WCKEYID]);
-			uint32_t array_pending =
-				slurm_atoul(row[JOB_REQ_ARRAY_PENDING]);
-			uint32_t resv_id = slurm_atoul(row[JOB_REQ_RESVID]);
-			time_t row_eligible = slurm_atoul(row[JOB_REQ_ELG]);
-			time_t row_start = slurm_atoul(row[JOB_REQ_START]);
-			time_t row_end = slurm_atoul(row[JOB_REQ_END]);
-			uint32_t row_rcpu = slurm_atoul(row[JOB_REQ_RCPU]);
+		/* now go through the jobs during this time only */
+		list_iterator_reset(j_itr);
+		while ((j_usage = list_next(j_itr))) {
+			uint32_t assoc_id = j_usage->assoc_id;
+			uint32_t wckey_id = j_usage->wckey_id;
+			uint32_t array_pending = j_usage->array_pending;
+			uint32_t resv_id = j_usage->resv_id;
+			time_t row_eligible = j_usage->eligible;
+			time_t row_start = j_usage->start;
+			time_t row_end = j_usage->end;
+			uint32_t row_rcpu = j_usage->rcpu;
 			List loc_tres = NULL;
 			int loc_seconds = 0;
 			int seconds = 0, suspend_seconds = 0;
 
+			if ((row_eligible >= curr_end) ||
+			    (row_end && (row_end < curr_start)))
+				continue;
+
 			if (row_start && (row_start < curr_start))
 				row_start = curr_start;
 
@@ -1256,19 +1358,20 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 
 			seconds = (row_end - row_start);
 
-			if (slurm_atoul(row[JOB_REQ_SUSPENDED])) {
+			if (j_usage->suspended) {
 				MYSQL_RES *result2 = NULL;
 				MYSQL_ROW row2;
 				/* get the suspended time for this job */
 				query = xstrdup_printf(
 					"select %s from \"%s_%s\" where "
 					"(time_start < %ld && (time_end >= %ld "
-					"|| time_end = 0)) && job_db_inx=%s "
+					"|| time_end = 0)) && "
+					"job_db_inx=%"PRIu64" "
 					"order by time_start",
 					suspend_str, cluster_name,
 					suspend_table,
 					curr_end, curr_start,
-					row[JOB_REQ_DB_INX]);
+					j_usage->db_inx);
 
 				debug4("%d(%s:%d) query\n%s",
 				       mysql_conn->conn, THIS_FILE,
@@ -1277,7 +1380,6 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 					      mysql_conn,
 					      query, 0))) {
 					rc = SLURM_ERROR;
-					mysql_free_result(result);
 					goto end_it;
 				}
 				xfree(query);
@@ -1304,9 +1406,9 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 			}
 
 			if (last_id != assoc_id) {
-				a_usage = xmalloc(sizeof(local_id_usage_t));
-				a_usage->id = assoc_id;
-				list_append(assoc_usage_list, a_usage);
+				a_usage = _find_add_id_usage(assoc_usage_list,
+							     assoc_usage_hash,
+							     assoc_id);
 				last_id = assoc_id;
 				/* a_usage->loc_tres is made later,
 				   don't do it here.
@@ -1319,20 +1421,12 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 
 			/* do the wckey calculation */
 			if (last_wckeyid != wckey_id) {
-				list_iterator_reset(w_itr);
-				while ((w_usage = list_next(w_itr)))
-					if (w_usage->id == wckey_id)
-						break;
-
-				if (!w_usage) {
-					w_usage = xmalloc(
-						sizeof(local_id_usage_t));
-					w_usage->id = wckey_id;
-					list_append(wckey_usage_list,
-						    w_usage);
+				w_usage = _find_add_id_usage(wckey_usage_list,
+							     wckey_usage_hash,
+							     wckey_id);
+				if (!w_usage->loc_tres)
 					w_usage->loc_tres = list_create(
 						_destroy_local_tres_usage);
-				}
 				last_wckeyid = wckey_id;
 			}
 
@@ -1345,12 +1439,12 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 			 */
 			loc_tres = list_create(_destroy_local_tres_usage);
 
-			_add_tres_time_2_list(loc_tres, row[JOB_REQ_TRES],
+			_add_tres_time_2_list(loc_tres, j_usage->tres,
 					      TIME_ALLOC, seconds,
 					      suspend_seconds, 0);
 			if (w_usage)
 				_add_tres_time_2_list(w_usage->loc_tres,
-						      row[JOB_REQ_TRES],
+						      j_usage->tres,
 						      TIME_ALLOC, seconds,
 						      suspend_seconds, 0);
 
@@ -1512,7 +1606,6 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 				}
 			}
 		}
-		mysql_free_result(result);
 
 		/* now figure out how much more to add to the
 		   associations that could had run in the reservation
@@ -1560,20 +1653,16 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 					r_usage->local_assocs);
 				while ((assoc = list_next(tmp_itr))) {
 					uint32_t associd = slurm_atoul(assoc);
-					if ((last_id != associd) &&
-					    !(a_usage = list_find_first(
-						      assoc_usage_list,
-						      _find_id_usage,
-						      &associd))) {
-						a_usage = xmalloc(
-							sizeof(local_id_usage_t));
-						a_usage->id = associd;
-						list_append(assoc_usage_list,
-							    a_usage);
+					if (last_id != associd) {
+						a_usage = _find_add_id_usage(
+							assoc_usage_list,
+							assoc_usage_hash,
+							associd);
 						last_id = associd;
+					}
+					if (!a_usage->loc_tres)
 						a_usage->loc_tres = list_create(
 							_destroy_local_tres_usage);
-					}
 
 					_add_time_tres(a_usage->loc_tres,
 						       TIME_ALLOC, loc_tres->id,
@@ -1662,6 +1751,8 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 		a_usage     = NULL;
 		w_usage     = NULL;
 
+		xhash_clear(assoc_usage_hash);
+		xhash_clear(wckey_usage_hash);
 		list_flush(assoc_usage_list);
 		list_flush(cluster_down_list);
 		list_flush(wckey_usage_list);
@@ -1680,6 +1771,8 @@ end_it:
 		list_iterator_destroy(a_itr);
 	if (c_itr)
 		list_iterator_destroy(c_itr);
+	if (j_itr)
+		list_iterator_destroy(j_itr);
 	if (w_itr)
 		list_iterator_destroy(w_itr);
 	if (r_itr)
@@ -1687,8 +1780,11 @@ end_it:
 
 	FREE_NULL_LIST(assoc_usage_list);
 	FREE_NULL_LIST(cluster_down_list);
+	FREE_NULL_LIST(job_usage_list);
 	FREE_NULL_LIST(wckey_usage_list);
 	FREE_NULL_LIST(resv_usage_list);
+	xhash_free(assoc_usage_hash);
+	xhash_free(wckey_usage_hash);
 
 /* 	info("stop start %s", slurm_ctime2(&curr_start)); */
 /* 	info("stop end %s", slurm_ctime2(&curr_end)); */
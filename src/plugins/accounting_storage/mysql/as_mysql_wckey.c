@@ -797,6 +797,7 @@ extern List as_mysql_get_wckeys(mysql_conn_t *mysql_conn, uid_t uid,
 	uint16_t private_data = 0;
 	slurmdb_user_rec_t user;
 	List use_cluster_list = as_mysql_cluster_list;
+	bool free_cluster_list = false;
 	ListIterator itr;
 
 	if (!wckey_cond) {
@@ -844,8 +845,10 @@ empty:
 
 	wckey_list = list_create(slurmdb_destroy_wckey_rec);
 
-	if (use_cluster_list == as_mysql_cluster_list)
-		slurm_mutex_lock(&as_mysql_cluster_list_lock);
+	if (use_cluster_list == as_mysql_cluster_list) {
+		use_cluster_list = as_mysql_copy_cluster_list();
+		free_cluster_list = true;
+	}
 	//START_TIMER;
 	itr = list_iterator_create(use_cluster_list);
 	while ((cluster_name = list_next(itr))) {
@@ -859,8 +862,8 @@ empty:
 	}
 	list_iterator_destroy(itr);
 
-	if (use_cluster_list == as_mysql_cluster_list)
-		slurm_mutex_unlock(&as_mysql_cluster_list_lock);
+	if (free_cluster_list)
+		FREE_NULL_LIST(use_cluster_list);
 
 	xfree(tmp);
 	xfree(extra);
@@ -37,6 +37,9 @@
  *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
 \*****************************************************************************/
 
+#include <dirent.h>
+#include <sys/stat.h>
+
 #include "src/common/slurm_xlator.h"
 
 #include "src/common/fd.h"
@@ -48,13 +51,17 @@
 
 enum {
 	MAX_DBD_ACTION_DISCARD,
-	MAX_DBD_ACTION_EXIT
+	MAX_DBD_ACTION_EXIT,
+	MAX_DBD_ACTION_SPOOL
 };
 
 #define DBD_MAGIC		0xDEAD3219
 #define SLURMDBD_TIMEOUT	900	/* Seconds SlurmDBD for response */
 #define DEBUG_PRINT_MAX_MSG_TYPES 10
 #define MAX_DBD_DEFAULT_ACTION MAX_DBD_ACTION_DISCARD
+#define DBD_SPOOL_SEG_SIZE	(64 * 1024 * 1024) /* Bytes per spool file */
+#define DBD_SPOOL_SYNC_SECS	1	/* Seconds between spool syncs */
+#define DBD_REC_OVERHEAD	(2 * sizeof(uint32_t)) /* size and magic */
 
 static pthread_mutex_t agent_lock = PTHREAD_MUTEX_INITIALIZER;
 static pthread_cond_t  agent_cond = PTHREAD_COND_INITIALIZER;
@@ -71,6 +78,36 @@ static pthread_cond_t  slurmdbd_cond = PTHREAD_COND_INITIALIZER;
 
 static int max_dbd_msg_action = MAX_DBD_DEFAULT_ACTION;
 
+/*
+ * Messages past MaxDBDMsgs are appended to StateSaveLocation/dbd.spool.<seg>
+ * files when max_dbd_msg_action=spool and read back into agent_list as it
+ * drains, oldest file first. Once anything is spooled every new message is
+ * spooled too so they reach the slurmdbd in order. How far the oldest file
+ * has been read is kept in dbd.spool.head so a restart doesn't replay what
+ * was already moved to agent_list; a file is only removed once the head
+ * file has moved past it. Protected by agent_lock.
+ */
+typedef struct {
+	uint32_t head;		/* oldest spool file, read from */
+	int head_fd;
+	uint32_t head_off;	/* offset read up to in head file */
+	uint16_t head_ver;	/* protocol version of head file */
+	uint32_t tail;		/* newest spool file, appended to */
+	int tail_fd;
+	uint32_t tail_size;	/* bytes in tail file */
+	int roll_fd;		/* previous tail file, still to sync */
+	uint32_t cnt;		/* messages spooled */
+	uint64_t bytes;		/* bytes spooled */
+	bool dirty;		/* tail written since last sync */
+	bool failed;		/* last append failed */
+	time_t sync_time;
+	uint32_t agent_hwm;	/* high water marks */
+	uint32_t cnt_hwm;
+	uint64_t bytes_hwm;
+} dbd_spool_t;
+
+static dbd_spool_t spool = { .head_fd = -1, .tail_fd = -1, .roll_fd = -1 };
+
 static int _send_fini_msg(void)
 {
 	int rc;
@@ -317,6 +354,27 @@ static Buf _load_dbd_rec(int fd)
 	return buffer;
 }
 
+/*
+ * Unpack and repack a message saved with an older rpc_version with the
+ * current SLURM_PROTOCOL_VERSION just so we keep things up to date.
+ * RET the message to send, NULL if it could not be unpacked
+ */
+static Buf _repack_dbd_rec(Buf buffer, uint16_t rpc_version)
+{
+	persist_msg_t msg = {0};
+	int rc;
+
+	if (rpc_version == SLURM_PROTOCOL_VERSION)
+		return buffer;
+
+	set_buf_offset(buffer, 0);
+	rc = unpack_slurmdbd_msg(&msg, rpc_version, buffer);
+	free_buf(buffer);
+	if (rc != SLURM_SUCCESS)
+		return NULL;
+	return pack_slurmdbd_msg(&msg, SLURM_PROTOCOL_VERSION);
+}
+
 static void _load_dbd_state(void)
 {
 	char *dbd_fname;
@@ -365,23 +423,7 @@ static void _load_dbd_state(void)
 				buffer = _load_dbd_rec(fd);
 			if (buffer == NULL)
 				break;
-			if (rpc_version != SLURM_PROTOCOL_VERSION) {
-				/* unpack and repack with new
-				 * PROTOCOL_VERSION just so we keep
-				 * things up to date.
-				 */
-				persist_msg_t msg = {0};
-				int rc;
-				set_buf_offset(buffer, 0);
-				rc = unpack_slurmdbd_msg(
-					&msg, rpc_version, buffer);
-				free_buf(buffer);
-				if (rc == SLURM_SUCCESS)
-					buffer = pack_slurmdbd_msg(
-						&msg, SLURM_PROTOCOL_VERSION);
-				else
-					buffer = NULL;
-			}
+			buffer = _repack_dbd_rec(buffer, rpc_version);
 			if (!buffer) {
 				error("no buffer given");
 				continue;
@@ -498,6 +540,500 @@ end_it:
 	xfree(dbd_fname);
 }
 
+static char *_spool_fname(uint32_t seg)
+{
+	char *fname = slurm_get_state_save_location();
+
+	xstrfmtcat(fname, "/dbd.spool.%u", seg);
+	return fname;
+}
+
+static char *_spool_head_fname(void)
+{
+	char *fname = slurm_get_state_save_location();
+
+	xstrcat(fname, "/dbd.spool.head");
+	return fname;
+}
+
+/*
+ * Record which spool file and offset the next message is read from.
+ * Written to a new file and renamed over the old one so a crash leaves
+ * either record intact. Without sync the new record may be lost in a
+ * crash, which only replays messages; it is needed before a spool file is
+ * removed or created.
+ */
+static int _spool_save_head(bool sync)
+{
+	char *fname = _spool_head_fname(), *new_fname = NULL;
+	uint32_t head[2] = { spool.head, spool.head_off };
+	int fd, rc = SLURM_ERROR;
+
+	xstrfmtcat(new_fname, "%s.new", fname);
+	fd = open(new_fname, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+	if (fd < 0) {
+		error("slurmdbd: Creating spool head file %s: %m", new_fname);
+		goto fini;
+	}
+	if (write(fd, head, sizeof(head)) != sizeof(head)) {
+		error("slurmdbd: spool head save error: %m");
+		(void) close(fd);
+		goto fini;
+	}
+	if (sync) {
+		if (fsync_and_close(fd, "dbd.spool.head"))
+			goto fini;
+	} else
+		(void) close(fd);
+	if (rename(new_fname, fname)) {
+		error("slurmdbd: rename(%s, %s): %m", new_fname, fname);
+		goto fini;
+	}
+	rc = SLURM_SUCCESS;
+
+fini:
+	if (rc != SLURM_SUCCESS)
+		(void) unlink(new_fname);
+	xfree(new_fname);
+	xfree(fname);
+	return rc;
+}
+
+/* Read the protocol version record at the start of a spool file */
+static int _spool_read_ver(int fd, uint16_t *rpc_version)
+{
+	Buf buffer;
+	char *ver_str = NULL;
+	uint32_t ver_str_len;
+
+	if (!(buffer = _load_dbd_rec(fd)))
+		return SLURM_ERROR;
+	set_buf_offset(buffer, 0);
+	safe_unpackstr_xmalloc(&ver_str, &ver_str_len, buffer);
+	if (!ver_str || xstrncmp(ver_str, "VER", 3))
+		goto unpack_error;
+	*rpc_version = slurm_atoul(ver_str + 3);
+	xfree(ver_str);
+	free_buf(buffer);
+	return SLURM_SUCCESS;
+
+unpack_error:
+	error("slurmdbd: spool file has no version record");
+	xfree(ver_str);
+	free_buf(buffer);
+	return SLURM_ERROR;
+}
+
+static void _spool_log_hwm(const char *when)
+{
+	info("slurmdbd: %s, high water marks agent_count=%u spool_count=%u spool_bytes=%"PRIu64,
+	     when, spool.agent_hwm, spool.cnt_hwm, spool.bytes_hwm);
+}
+
+/* Remove all spool files once everything in them is in agent_list */
+static void _spool_reset(void)
+{
+	char *fname;
+	uint32_t seg;
+
+	if (spool.head_fd >= 0)
+		(void) close(spool.head_fd);
+	if (spool.tail_fd >= 0)
+		(void) close(spool.tail_fd);
+	if (spool.roll_fd >= 0)
+		(void) close(spool.roll_fd);
+	for (seg = spool.head; seg <= spool.tail; seg++) {
+		fname = _spool_fname(seg);
+		(void) unlink(fname);
+		xfree(fname);
+	}
+	/* Last so a crash in between finds the head file missing */
+	fname = _spool_head_fname();
+	(void) unlink(fname);
+	xfree(fname);
+
+	spool.head = spool.tail = 0;
+	spool.head_fd = spool.tail_fd = spool.roll_fd = -1;
+	spool.head_off = spool.tail_size = 0;
+	spool.cnt = 0;
+	spool.bytes = 0;
+	spool.dirty = false;
+}
+
+/* Open the tail spool file for appending, creating it if needed */
+static int _spool_open_tail(void)
+{
+	char *fname = _spool_fname(spool.tail);
+	char curr_ver_str[10];
+	Buf buffer;
+	int rc;
+
+	if (spool.tail_size) {
+		spool.tail_fd = open(fname, O_WRONLY | O_APPEND);
+		if (spool.tail_fd < 0)
+			error("slurmdbd: Opening spool file %s: %m", fname);
+		xfree(fname);
+		return (spool.tail_fd < 0) ? SLURM_ERROR : SLURM_SUCCESS;
+	}
+
+	spool.tail_fd = open(fname, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND,
+			     0600);
+	if (spool.tail_fd < 0) {
+		error("slurmdbd: Creating spool file %s: %m", fname);
+		xfree(fname);
+		return SLURM_ERROR;
+	}
+	xfree(fname);
+
+	snprintf(curr_ver_str, sizeof(curr_ver_str),
+		 "VER%d", SLURM_PROTOCOL_VERSION);
+	buffer = init_buf(strlen(curr_ver_str));
+	packstr(curr_ver_str, buffer);
+	rc = _save_dbd_rec(spool.tail_fd, buffer);
+	spool.tail_size = get_buf_offset(buffer) + DBD_REC_OVERHEAD;
+	free_buf(buffer);
+	if (rc != SLURM_SUCCESS) {
+		(void) close(spool.tail_fd);
+		spool.tail_fd = -1;
+		spool.tail_size = 0;
+	}
+	return rc;
+}
+
+/* Append a message to the spool, the caller still owns buffer */
+static int _spool_append(Buf buffer)
+{
+	uint32_t size = get_buf_offset(buffer) + DBD_REC_OVERHEAD;
+
+	if ((spool.tail_fd >= 0) &&
+	    (spool.tail_size + size > DBD_SPOOL_SEG_SIZE)) {
+		/* Leave the sync to _spool_sync() unless it fell behind */
+		if (spool.roll_fd >= 0)
+			(void) fsync_and_close(spool.roll_fd, "dbd.spool");
+		spool.roll_fd = spool.tail_fd;
+		spool.tail_fd = -1;
+		spool.tail++;
+		spool.tail_size = 0;
+		spool.dirty = false;
+	}
+	/* A stale head file must not point into the new spool files */
+	if (!spool.cnt && (spool.tail_fd < 0) &&
+	    (_spool_save_head(true) != SLURM_SUCCESS))
+		return SLURM_ERROR;
+	if ((spool.tail_fd < 0) && (_spool_open_tail() != SLURM_SUCCESS))
+		return SLURM_ERROR;
+
+	if (_save_dbd_rec(spool.tail_fd, buffer) != SLURM_SUCCESS) {
+		/* Drop any partial record so later appends stay readable */
+		if (ftruncate(spool.tail_fd, spool.tail_size))
+			error("slurmdbd: spool truncate error: %m");
+		return SLURM_ERROR;
+	}
+
+	if (!spool.cnt)
+		info("slurmdbd: agent queue is full (%u), spooling messages to StateSaveLocation",
+		     list_count(agent_list));
+	spool.tail_size += size;
+	spool.cnt++;
+	spool.bytes += size;
+	spool.dirty = true;
+	spool.cnt_hwm = MAX(spool.cnt_hwm, spool.cnt);
+	spool.bytes_hwm = MAX(spool.bytes_hwm, spool.bytes);
+	return SLURM_SUCCESS;
+}
+
+static int _spool_open_head(void)
+{
+	char *fname = _spool_fname(spool.head);
+	off_t pos;
+
+	spool.head_fd = open(fname, O_RDONLY);
+	if (spool.head_fd < 0) {
+		error("slurmdbd: Opening spool file %s: %m", fname);
+		xfree(fname);
+		return SLURM_ERROR;
+	}
+	xfree(fname);
+
+	if ((_spool_read_ver(spool.head_fd, &spool.head_ver) !=
+	     SLURM_SUCCESS) ||
+	    ((pos = lseek(spool.head_fd, 0, SEEK_CUR)) < 0) ||
+	    ((spool.head_off > pos) &&
+	     (lseek(spool.head_fd, spool.head_off, SEEK_SET) < 0))) {
+		(void) close(spool.head_fd);
+		spool.head_fd = -1;
+		return SLURM_ERROR;
+	}
+	if (spool.head_off < pos)
+		spool.head_off = pos;
+	return SLURM_SUCCESS;
+}
+
+/*
+ * Move spooled messages back into agent_list once it is half empty, up to
+ * MaxDBDMsgs of them.
+ */
+static void _spool_refill(void)
+{
+	Buf buffer;
+	char *fname;
+	int moved = 0;
+	uint32_t done = spool.head;
+
+	if (!spool.cnt ||
+	    (list_count(agent_list) >= (slurmctld_conf.max_dbd_msgs / 2)))
+		return;
+
+	while (spool.cnt &&
+	       (list_count(agent_list) < slurmctld_conf.max_dbd_msgs)) {
+		if ((spool.head_fd < 0) &&
+		    (_spool_open_head() != SLURM_SUCCESS)) {
+			if (spool.head >= spool.tail)
+				break;
+			/* Not counted by _spool_recover(), skip it */
+			spool.head++;
+			spool.head_off = 0;
+			continue;
+		}
+		if (!(buffer = _load_dbd_rec(spool.head_fd))) {
+			if (spool.head >= spool.tail) {
+				error("slurmdbd: spool file %u ends early, discarding %u spooled messages",
+				      spool.head, spool.cnt);
+				spool.cnt = 0;
+				break;
+			}
+			/* Done with this file, go to the next one */
+			(void) close(spool.head_fd);
+			spool.head_fd = -1;
+			spool.head++;
+			spool.head_off = 0;
+			continue;
+		}
+		spool.head_off += get_buf_offset(buffer) + DBD_REC_OVERHEAD;
+		spool.bytes -= get_buf_offset(buffer) + DBD_REC_OVERHEAD;
+		spool.cnt--;
+		if (!(buffer = _repack_dbd_rec(buffer, spool.head_ver))) {
+			error("slurmdbd: unable to unpack spooled message");
+			continue;
+		}
+		if (!list_enqueue(agent_list, buffer))
+			fatal("slurmdbd: list_enqueue, no memory");
+		moved++;
+	}
+
+	if (spool.cnt && (spool.head_fd < 0)) {
+		error("slurmdbd: unable to read spool, discarding %u spooled messages",
+		      spool.cnt);
+		spool.cnt = 0;
+	}
+
+	if (slurmctld_conf.debug_flags & DEBUG_FLAG_AGENT)
+		info("%s: moved %d spooled messages to agent queue, %u left",
+		     __func__, moved, spool.cnt);
+
+	if (!spool.cnt) {
+		_spool_reset();
+		_spool_log_hwm("spool drained");
+		return;
+	}
+	/* Finished files go only once the head file is past them */
+	if (_spool_save_head(done != spool.head) != SLURM_SUCCESS)
+		return;
+	for ( ; done < spool.head; done++) {
+		fname = _spool_fname(done);
+		(void) unlink(fname);
+		xfree(fname);
+	}
+}
+
+/*
+ * Flush appended messages to disk at most every DBD_SPOOL_SYNC_SECS.
+ * Called without agent_lock, which is only held to pick up the files to
+ * sync so send_slurmdbd_msg() isn't stalled behind the disk.
+ */
+static void _spool_sync(void)
+{
+	int roll_fd, tail_fd = -1;
+	time_t now = time(NULL);
+
+	slurm_mutex_lock(&agent_lock);
+	roll_fd = spool.roll_fd;
+	spool.roll_fd = -1;
+	if (spool.dirty && (spool.tail_fd >= 0) &&
+	    (difftime(now, spool.sync_time) >= DBD_SPOOL_SYNC_SECS)) {
+		if ((tail_fd = dup(spool.tail_fd)) < 0)
+			error("slurmdbd: spool dup error: %m");
+		spool.dirty = false;
+		spool.sync_time = now;
+	}
+	slurm_mutex_unlock(&agent_lock);
+
+	if (roll_fd >= 0)
+		(void) fsync_and_close(roll_fd, "dbd.spool");
+	if (tail_fd >= 0)
+		(void) fsync_and_close(tail_fd, "dbd.spool");
+}
+
+/* Count the messages in a spool file starting at the current offset
+ * RET offset after the last complete message */
+static off_t _spool_scan(int fd, uint32_t *cnt, uint64_t *bytes)
+{
+	uint32_t msg_size, magic;
+	off_t pos = lseek(fd, 0, SEEK_CUR);
+
+	while ((read(fd, &msg_size, sizeof(msg_size)) == sizeof(msg_size)) &&
+	       (msg_size <= MAX_DBD_MSG_LEN) &&
+	       (lseek(fd, msg_size, SEEK_CUR) >= 0) &&
+	       (read(fd, &magic, sizeof(magic)) == sizeof(magic)) &&
+	       (magic == DBD_MAGIC)) {
+		pos += msg_size + DBD_REC_OVERHEAD;
+		(*cnt)++;
+		*bytes += msg_size + DBD_REC_OVERHEAD;
+	}
+	return pos;
+}
+
+/* Close the spool leaving its files to be recovered on the next start */
+static void _spool_close(void)
+{
+	if (spool.roll_fd >= 0)
+		(void) fsync_and_close(spool.roll_fd, "dbd.spool");
+	if (spool.tail_fd >= 0) {
+		if (spool.cnt && spool.dirty)
+			(void) fsync_and_close(spool.tail_fd, "dbd.spool");
+		else
+			(void) close(spool.tail_fd);
+	}
+	if (spool.cnt) {
+		(void) _spool_save_head(true);
+		_spool_log_hwm("agent ending with messages spooled");
+	}
+	if (spool.head_fd >= 0)
+		(void) close(spool.head_fd);
+
+	spool.head = spool.tail = 0;
+	spool.head_fd = spool.tail_fd = spool.roll_fd = -1;
+	spool.head_off = spool.tail_size = 0;
+	spool.cnt = 0;
+	spool.bytes = 0;
+	spool.dirty = false;
+}
+
+/*
+ * Find the range of dbd.spool.<seg> files in StateSaveLocation
+ * RET false if there are none
+ */
+static bool _spool_find_segs(uint32_t *first, uint32_t *last)
+{
+	char *dir = slurm_get_state_save_location();
+	struct dirent *ent;
+	DIR *dirp;
+	uint32_t seg;
+	bool found = false;
+	int len;
+
+	if (!(dirp = opendir(dir))) {
+		error("slurmdbd: opendir(%s): %m", dir);
+		xfree(dir);
+		return false;
+	}
+	while ((ent = readdir(dirp))) {
+		if ((sscanf(ent->d_name, "dbd.spool.%u%n", &seg, &len) != 1) ||
+		    ent->d_name[len])
+			continue;
+		if (!found || (seg < *first))
+			*first = seg;
+		if (!found || (seg > *last))
+			*last = seg;
+		found = true;
+	}
+	closedir(dirp);
+	xfree(dir);
+	return found;
+}
+
+/* Find the messages still spooled from before a restart or crash */
+static void _spool_recover(void)
+{
+	char *fname;
+	uint32_t head[2] = { 0, 0 }, first = 0, last = 0, seg;
+	uint16_t rpc_version;
+	struct stat stat_buf;
+	off_t end, good;
+	int fd;
+
+	if (!_spool_find_segs(&first, &last)) {
+		_spool_reset();
+		return;
+	}
+
+	fname = _spool_head_fname();
+	fd = open(fname, O_RDONLY);
+	xfree(fname);
+	if ((fd < 0) || (read(fd, head, sizeof(head)) != sizeof(head)) ||
+	    (head[0] < first) || (head[0] > last)) {
+		error("slurmdbd: spool head file missing or stale, reading spool files %u-%u from the start",
+		      first, last);
+		head[0] = first;
+		head[1] = 0;
+	}
+	if (fd >= 0)
+		(void) close(fd);
+
+	/* Files before the head were read before the restart */
+	for (seg = first; seg < head[0]; seg++) {
+		fname = _spool_fname(seg);
+		(void) unlink(fname);
+		xfree(fname);
+	}
+
+	fname = _spool_fname(head[0]);
+	if (stat(fname, &stat_buf))
+		head[1] = 0;
+	xfree(fname);
+
+	spool.head = spool.tail = head[0];
+	spool.head_off = head[1];
+	for (seg = spool.head; seg <= last; seg++) {
+		fname = _spool_fname(seg);
+		fd = open(fname, O_RDWR);
+		if (fd < 0) {
+			error("slurmdbd: Opening spool file %s: %m", fname);
+			xfree(fname);
+			continue;
+		}
+		xfree(fname);
+		spool.tail = seg;
+		spool.tail_size = 0;
+		if (_spool_read_ver(fd, &rpc_version) != SLURM_SUCCESS) {
+			(void) close(fd);
+			continue;
+		}
+		if ((seg == spool.head) &&
+		    (spool.head_off > lseek(fd, 0, SEEK_CUR)))
+			(void) lseek(fd, spool.head_off, SEEK_SET);
+		good = _spool_scan(fd, &spool.cnt, &spool.bytes);
+		end = lseek(fd, 0, SEEK_END);
+		if (end > good) {
+			/* Partial message from a crash while appending */
+			error("slurmdbd: discarding %"PRIu64" bytes at end of spool file %u",
+			      (uint64_t) (end - good), seg);
+			if (ftruncate(fd, good))
+				error("slurmdbd: spool truncate error: %m");
+		}
+		spool.tail_size = good;
+		(void) close(fd);
+	}
+
+	if (!spool.cnt) {
+		_spool_reset();
+		return;
+	}
+	spool.cnt_hwm = spool.cnt;
+	spool.bytes_hwm = spool.bytes;
+	verbose("slurmdbd: recovered %u spooled RPCs", spool.cnt);
+}
+
 /* Purge queued step records from the agent queue
  * RET number of records purged */
 static int _purge_step_req(void)
@@ -557,6 +1093,10 @@ static int _purge_job_start_req(void)
 
 static void _max_dbd_msg_action(uint32_t *msg_cnt)
 {
+	/* Nothing is purged unless the spool can't be written */
+	if ((max_dbd_msg_action == MAX_DBD_ACTION_SPOOL) && !spool.failed)
+		return;
+
 	if (max_dbd_msg_action == MAX_DBD_ACTION_EXIT) {
 		if (*msg_cnt < slurmctld_conf.max_dbd_msgs)
 			return;
@@ -566,7 +1106,7 @@ static void _max_dbd_msg_action(uint32_t *msg_cnt)
 		      *msg_cnt);
 	}
 
-	/* MAX_DBD_ACTION_DISCARD */
+	/* MAX_DBD_ACTION_DISCARD or failed MAX_DBD_ACTION_SPOOL */
 	if (*msg_cnt >= (slurmctld_conf.max_dbd_msgs - 1))
 		*msg_cnt -= _purge_step_req();
 	if (*msg_cnt >= (slurmctld_conf.max_dbd_msgs - 1))
@@ -769,7 +1309,9 @@ static void *_agent(void *x)
 			}
 		}
 
+		_spool_sync();
 		slurm_mutex_lock(&agent_lock);
+		_spool_refill();
 		cnt = list_count(agent_list);
 		if ((cnt == 0) || (slurmdbd_conn->fd < 0) ||
 		    (fail_time && (difftime(time(NULL), fail_time) < 10))) {
@@ -777,8 +1319,9 @@ static void *_agent(void *x)
 			_max_dbd_msg_action(&cnt);
 			END_TIMER2("slurmdbd agent: sleep");
 			if (slurmctld_conf.debug_flags & DEBUG_FLAG_AGENT)
-				info("%s: slurmdbd agent sleeping with agent_count=%d",
-				     __func__, list_count(agent_list));
+				info("%s: slurmdbd agent sleeping with agent_count=%d spool_count=%u",
+				     __func__, list_count(agent_list),
+				     spool.cnt);
 			abs_time.tv_sec  = time(NULL) + 10;
 			abs_time.tv_nsec = 0;
 			slurm_cond_timedwait(&agent_cond, &agent_lock,
@@ -896,6 +1439,7 @@ static void *_agent(void *x)
 
 	slurm_mutex_lock(&agent_lock);
 	_save_dbd_state();
+	_spool_close();
 
 	if (slurmctld_conf.debug_flags & DEBUG_FLAG_AGENT)
 		info("%s: slurmdbd agent ending with agent_count=%d",
@@ -915,6 +1459,7 @@ static void _create_agent(void)
 	if (agent_list == NULL) {
 		agent_list = list_create(slurmdbd_free_buffer);
 		_load_dbd_state();
+		_spool_recover();
 	}
 
 	if (agent_tid == 0) {
@@ -1214,12 +1759,28 @@ extern int send_slurmdbd_msg(uint16_t rpc_version, persist_msg_t *req)
 			(slurmdbd_conn->trigger_callbacks.dbd_fail)();
 	}
 
+	/* Keep spooling until the spool drains so messages stay in order */
+	if (spool.cnt || ((max_dbd_msg_action == MAX_DBD_ACTION_SPOOL) &&
+			  (cnt >= slurmctld_conf.max_dbd_msgs))) {
+		if (_spool_append(buffer) == SLURM_SUCCESS) {
+			spool.failed = false;
+			free_buf(buffer);
+			goto end_it;
+		}
+		if (!spool.failed)
+			error("slurmdbd: unable to spool %s:%u request, purging agent queue instead",
+			      slurmdbd_msg_type_2_str(req->msg_type, 1),
+			      req->msg_type);
+		spool.failed = true;
+	}
+
 	/* Handle action */
 	_max_dbd_msg_action(&cnt);
 
 	if (cnt < slurmctld_conf.max_dbd_msgs) {
 		if (list_enqueue(agent_list, buffer) == NULL)
 			fatal("list_enqueue: memory allocation failure");
+		spool.agent_hwm = MAX(spool.agent_hwm, cnt + 1);
 	} else {
 		error("slurmdbd: agent queue is full (%u), discarding %s:%u request",
 		      cnt,
@@ -1231,6 +1792,7 @@ extern int send_slurmdbd_msg(uint16_t rpc_version, persist_msg_t *req)
 		rc = SLURM_ERROR;
 	}
 
+end_it:
 	slurm_cond_broadcast(&agent_cond);
 	slurm_mutex_unlock(&agent_lock);
 	return rc;
@@ -1247,7 +1809,13 @@ extern bool slurmdbd_conn_active(void)
 
 extern int slurmdbd_agent_queue_count(void)
 {
-	return list_count(agent_list);
+	int cnt;
+
+	slurm_mutex_lock(&agent_lock);
+	cnt = list_count(agent_list) + spool.cnt;
+	slurm_mutex_unlock(&agent_lock);
+
+	return cnt;
 }
 
 extern void slurmdbd_agent_config_setup(void)
@@ -1273,10 +1841,12 @@ extern void slurmdbd_agent_config_setup(void)
 			max_dbd_msg_action = MAX_DBD_ACTION_DISCARD;
 		else if (!xstrcasecmp(type, "exit"))
 			max_dbd_msg_action = MAX_DBD_ACTION_EXIT;
+		else if (!xstrcasecmp(type, "spool"))
+			max_dbd_msg_action = MAX_DBD_ACTION_SPOOL;
 		else
 			fatal("Unknown SlurmctldParameters option for max_dbd_msg_action '%s'",
 			      type);
-		xfree(tmp_ptr);
+		xfree(type);
 	} else
 		max_dbd_msg_action = MAX_DBD_DEFAULT_ACTION;
 }
@@ -45,6 +45,10 @@
  *  Copyright (C) 2002 The Regents of the University of California.
  \*****************************************************************************/
 
+#include "config.h"
+
+#include <dirent.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/types.h>
@@ -56,9 +60,13 @@
 #include <unistd.h>
 #include <math.h>
 #include <curl/curl.h>
+#if HAVE_LIBZ
+#  include <zlib.h>
+#endif
 
 #include "src/common/slurm_xlator.h"
 #include "src/common/fd.h"
+#include "src/common/list.h"
 #include "src/common/slurm_acct_gather_profile.h"
 #include "src/common/slurm_protocol_api.h"
 #include "src/common/slurm_protocol_defs.h"
@@ -96,6 +104,17 @@ const char plugin_name[] = "AcctGatherProfile influxdb plugin";
 const char plugin_type[] = "acct_gather_profile/influxdb";
 const uint32_t plugin_version = SLURM_VERSION_NUMBER;
 
+/* Seconds a partially filled batch may wait before being sent */
+#define INFLUXDB_FLUSH_INTERVAL 10
+/* Batches kept in memory before new ones go to the spool file */
+#define INFLUXDB_MAX_BATCHES 64
+/* Seconds to wait after a failed send before trying again */
+#define INFLUXDB_RETRY_INTERVAL 30
+/* Seconds a single send may take */
+#define INFLUXDB_SEND_TIMEOUT 10
+/* Larger records in a spool file mean it is corrupt */
+#define INFLUXDB_SPOOL_MAX_REC (BUF_SIZE * 64)
+
 typedef struct {
 	char *host;
 	char *database;
@@ -127,8 +146,23 @@ static slurm_influxdb_conf_t influxdb_conf;
 static uint32_t g_profile_running = ACCT_GATHER_PROFILE_NOT_SET;
 static stepd_step_rec_t *g_job = NULL;
 
+/* Batch being filled, send_list and the sender are protected by send_lock */
 static char *datastr = NULL;
 static int datastrlen = 0;
+static time_t batch_start = 0;
+static List send_list = NULL;
+static pthread_mutex_t send_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t send_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t send_tid = 0;
+static bool send_shutdown = false;
+static CURL *curl_handle = NULL;
+
+/* Batches which could not be sent yet, protected by spool_lock */
+static pthread_mutex_t spool_lock = PTHREAD_MUTEX_INITIALIZER;
+static char *spool_file = NULL;
+static int spool_fd = -1;
+static off_t spool_offset = 0;
+static uint32_t spool_cnt = 0;
 
 static table_t *tables = NULL;
 static size_t tables_max_len = 0;
@@ -186,51 +220,66 @@ static size_t _write_callback(void *contents, size_t size, size_t nmemb,
 	return realsize;
 }
 
-/* Try to send data to influxdb */
-static int _send_data(const char *data)
+#if HAVE_LIBZ
+/* Compress data with gzip, which the InfluxDB write API accepts
+ * RET compressed data to xfree or NULL on error */
+static char *_gzip(const char *data, size_t len, size_t *out_len)
+{
+	z_stream strm;
+	char *out;
+
+	memset(&strm, 0, sizeof(strm));
+	/* 16 added to the window bits asks for a gzip header */
+	if (deflateInit2(&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16,
+			 8, Z_DEFAULT_STRATEGY) != Z_OK)
+		return NULL;
+
+	*out_len = deflateBound(&strm, len);
+	out = xmalloc_nz(*out_len);
+	strm.next_in = (Bytef *) data;
+	strm.avail_in = len;
+	strm.next_out = (Bytef *) out;
+	strm.avail_out = *out_len;
+	if (deflate(&strm, Z_FINISH) != Z_STREAM_END) {
+		(void) deflateEnd(&strm);
+		xfree(out);
+		return NULL;
+	}
+	*out_len = strm.total_out;
+	(void) deflateEnd(&strm);
+
+	return out;
+}
+#endif
+
+/* Try to send a batch of data to influxdb */
+static int _send_data(const char *data, size_t len)
 {
-	CURL *curl_handle = NULL;
 	CURLcode res;
 	struct http_response chunk;
+	struct curl_slist *slist = NULL;
 	int rc = SLURM_SUCCESS;
 	long response_code;
 	static int error_cnt = 0;
-	char *url = NULL;
-	size_t length;
+	char *url = NULL, *zdata = NULL;
+	size_t zlen = 0;
 
 	debug3("%s %s called", plugin_type, __func__);
 
-	/*
-	 * Every compute node which is sampling data will try to establish a
-	 * different connection to the influxdb server. In order to reduce the
-	 * number of connections, every time a new sampled data comes in, it
-	 * is saved in the 'datastr' buffer. Once this buffer is full, then we
-	 * try to open the connection and send this buffer, instead of opening
-	 * one per sample.
-	 */
-	if (data && ((datastrlen + strlen(data)) <= BUF_SIZE)) {
-		xstrcat(datastr, data);
-		length = strlen(data);
-		datastrlen += length;
-		if (slurm_get_debug_flags() & DEBUG_FLAG_PROFILE)
-			info("%s %s: %zu bytes of data added to buffer. New buffer size: %d",
-			     plugin_type, __func__, length, datastrlen);
-		return rc;
-	}
-
 	DEF_TIMERS;
 	START_TIMER;
 
-	if (curl_global_init(CURL_GLOBAL_ALL) != 0) {
-		error("%s %s: curl_global_init: %m", plugin_type, __func__);
-		rc = SLURM_ERROR;
-		goto cleanup_global_init;
-	} else if ((curl_handle = curl_easy_init()) == NULL) {
+	/* Keep the handle so the connection is reused between batches */
+	if (!curl_handle && !(curl_handle = curl_easy_init())) {
 		error("%s %s: curl_easy_init: %m", plugin_type, __func__);
-		rc = SLURM_ERROR;
-		goto cleanup_easy_init;
+		return SLURM_ERROR;
 	}
 
+#if HAVE_LIBZ
+	if ((zdata = _gzip(data, len, &zlen)))
+		slist = curl_slist_append(slist, "Content-Encoding: gzip");
+#endif
+
 	xstrfmtcat(url, "%s/write?db=%s&rp=%s&precision=s", influxdb_conf.host,
 		   influxdb_conf.database, influxdb_conf.rt_policy);
 
@@ -241,9 +290,19 @@ static int _send_data(const char *data)
 	if (influxdb_conf.password)
 		curl_easy_setopt(curl_handle, CURLOPT_PASSWORD,
 				 influxdb_conf.password);
-	curl_easy_setopt(curl_handle, CURLOPT_POST, 1);
-	curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDS, datastr);
-	curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDSIZE, strlen(datastr));
+	curl_easy_setopt(curl_handle, CURLOPT_POST, 1L);
+	if (zdata) {
+		curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDS, zdata);
+		curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDSIZE,
+				 (long) zlen);
+	} else {
+		curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDS, data);
+		curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDSIZE,
+				 (long) len);
+	}
+	curl_easy_setopt(curl_handle, CURLOPT_HTTPHEADER, slist);
+	curl_easy_setopt(curl_handle, CURLOPT_TIMEOUT,
+			 (long) INFLUXDB_SEND_TIMEOUT);
 	if (influxdb_conf.username)
 		curl_easy_setopt(curl_handle, CURLOPT_USERNAME,
 				 influxdb_conf.username);
@@ -252,7 +311,7 @@ static int _send_data(const char *data)
 
 	if ((res = curl_easy_perform(curl_handle)) != CURLE_OK) {
 		if ((error_cnt++ % 100) == 0)
-			error("%s %s: curl_easy_perform failed to send data (discarded). Reason: %s",
+			error("%s %s: curl_easy_perform failed to send data (spooled). Reason: %s",
 			      plugin_type, __func__, curl_easy_strerror(res));
 		rc = SLURM_ERROR;
 		goto cleanup;
@@ -276,43 +335,347 @@ static int _send_data(const char *data)
 		debug2("%s %s: data write success", plugin_type, __func__);
 		if (error_cnt > 0)
 			error_cnt = 0;
-	} else {
-		rc = SLURM_ERROR;
-		debug2("%s %s: data write failed, response code: %ld",
+	} else if (response_code < 500) {
+		/* Sending it again won't help, don't spool it */
+		debug2("%s %s: data write failed (discarded), response code: %ld",
 		       plugin_type, __func__, response_code);
 		if (slurm_get_debug_flags() & DEBUG_FLAG_PROFILE) {
 			/* Strip any trailing newlines. */
-			while (chunk.message[strlen(chunk.message) - 1] == '\n')
-				chunk.message[strlen(chunk.message) - 1] = '\0';
+			while (chunk.size &&
+			       (chunk.message[chunk.size - 1] == '\n'))
+				chunk.message[--chunk.size] = '\0';
 			info("%s %s: JSON response body: %s", plugin_type,
 			     __func__, chunk.message);
 		}
+	} else {
+		rc = SLURM_ERROR;
+		debug2("%s %s: data write failed, response code: %ld",
+		       plugin_type, __func__, response_code);
 	}
 
 cleanup:
+	curl_slist_free_all(slist);
 	xfree(chunk.message);
 	xfree(url);
-cleanup_easy_init:
-	curl_easy_cleanup(curl_handle);
-cleanup_global_init:
-	curl_global_cleanup();
+	xfree(zdata);
 
 	END_TIMER;
 	if (slurm_get_debug_flags() & DEBUG_FLAG_PROFILE)
-		debug("%s %s: took %s to send data", plugin_type, __func__,
-		      TIME_STR);
+		debug("%s %s: took %s to send %zu bytes (%zu compressed)",
+		      plugin_type, __func__, TIME_STR, len, zlen);
+
+	return rc;
+}
+
+/* Append a batch to the spool file, spool_lock must be held */
+static int _spool_append(const char *data, uint32_t len)
+{
+	if (spool_fd < 0)
+		return SLURM_ERROR;
+
+	if (lseek(spool_fd, 0, SEEK_END) < 0)
+		goto rwfail;
+	safe_write(spool_fd, &len, sizeof(len));
+	safe_write(spool_fd, data, len);
+	spool_cnt++;
+	return SLURM_SUCCESS;
+
+rwfail:
+	error("%s %s: unable to write %s, %u bytes of data discarded: %m",
+	      plugin_type, __func__, spool_file, len);
+	return SLURM_ERROR;
+}
+
+/* Read the batch at offset of fd
+ * RET the batch to xfree, NULL at the end of the file or on error */
+static char *_spool_read(int fd, off_t offset, uint32_t *len)
+{
+	char *data = NULL;
+
+	if ((lseek(fd, offset, SEEK_SET) < 0) ||
+	    (read(fd, len, sizeof(*len)) != sizeof(*len)) ||
+	    (*len > INFLUXDB_SPOOL_MAX_REC))
+		return NULL;
+	data = xmalloc_nz(*len + 1);
+	safe_read(fd, data, *len);
+	data[*len] = '\0';
+	return data;
+
+rwfail:
+	xfree(data);
+	return NULL;
+}
+
+/*
+ * Take over the spool files left behind by steps which ended before their
+ * data could be sent. The owning slurmstepd holds a lock on its file as
+ * long as it runs, from before the file gets its ".spool" name.
+ */
+static void _spool_adopt(char *spool_dir)
+{
+	DIR *dir;
+	struct dirent *ent;
+	struct stat stat_buf;
+	char *path, *data;
+	uint32_t len;
+	off_t offset;
+	int fd, adopted;
+
+	if (!(dir = opendir(spool_dir)))
+		return;
+	while ((ent = readdir(dir))) {
+		if (xstrncmp(ent->d_name, "influxdb.", 9) ||
+		    !xstrstr(ent->d_name, ".spool"))
+			continue;
+		path = xstrdup_printf("%s/%s", spool_dir, ent->d_name);
+		if ((fd = open(path, O_RDWR | O_CLOEXEC)) < 0) {
+			xfree(path);
+			continue;
+		}
+		/* Skip live files and those another step just adopted */
+		if ((fd_get_write_lock(fd) < 0) || fstat(fd, &stat_buf) ||
+		    (stat_buf.st_nlink == 0)) {
+			(void) close(fd);
+			xfree(path);
+			continue;
+		}
+		offset = 0;
+		adopted = 0;
+		while ((data = _spool_read(fd, offset, &len))) {
+			offset += sizeof(len) + len;
+			if (_spool_append(data, len) == SLURM_SUCCESS)
+				adopted++;
+			xfree(data);
+		}
+		(void) unlink(path);
+		(void) close(fd);
+		if (adopted)
+			debug("%s %s: adopted %d batches from %s",
+			      plugin_type, __func__, adopted, path);
+		xfree(path);
+	}
+	closedir(dir);
+}
 
-	if (data) {
-		datastr = xstrdup(data);
-		datastrlen = strlen(data);
+/*
+ * Create the spool file under a name _spool_adopt() ignores and rename it
+ * only once locked, so no other step can take it over while this one runs.
+ */
+static void _spool_open(void)
+{
+	char *spool_dir = slurm_get_slurmd_spooldir(g_job->node_name);
+	char *data, *path;
+	uint32_t len;
+	off_t offset = 0;
+
+	spool_file = xstrdup_printf("%s/influxdb.%u.%u.new", spool_dir,
+				    g_job->jobid, g_job->stepid);
+	spool_fd = open(spool_file, O_RDWR | O_CREAT | O_CLOEXEC,
+			S_IRUSR | S_IWUSR);
+	if (spool_fd < 0) {
+		error("%s %s: unable to open %s, data which can't be sent will be discarded: %m",
+		      plugin_type, __func__, spool_file);
+		xfree(spool_dir);
+		return;
+	}
+	if (fd_get_write_lock(spool_fd) < 0)
+		error("%s %s: unable to lock %s: %m",
+		      plugin_type, __func__, spool_file);
+
+	slurm_mutex_lock(&spool_lock);
+	/* Left by an earlier run of the step which failed to rename it */
+	while ((data = _spool_read(spool_fd, offset, &len))) {
+		offset += sizeof(len) + len;
+		spool_cnt++;
+		xfree(data);
+	}
+	if (ftruncate(spool_fd, offset))
+		error("%s %s: unable to truncate %s: %m",
+		      plugin_type, __func__, spool_file);
+	/* Includes the file a requeued job left under the same step */
+	_spool_adopt(spool_dir);
+
+	path = xstrdup_printf("%s/influxdb.%u.%u.spool", spool_dir,
+			      g_job->jobid, g_job->stepid);
+	if (rename(spool_file, path) < 0) {
+		error("%s %s: unable to rename %s to %s: %m",
+		      plugin_type, __func__, spool_file, path);
+		xfree(path);
 	} else {
-		datastr[0] = '\0';
-		datastrlen = 0;
+		xfree(spool_file);
+		spool_file = path;
+	}
+	slurm_mutex_unlock(&spool_lock);
+	xfree(spool_dir);
+}
+
+/* Remove the spool file if everything in it was sent */
+static void _spool_close(void)
+{
+	slurm_mutex_lock(&spool_lock);
+	if (spool_fd >= 0) {
+		if (!spool_cnt)
+			(void) unlink(spool_file);
+		else
+			info("%s %s: %u batches of data left in %s to be sent by a later step",
+			     plugin_type, __func__, spool_cnt, spool_file);
+		(void) close(spool_fd);
+		spool_fd = -1;
+	}
+	xfree(spool_file);
+	slurm_mutex_unlock(&spool_lock);
+}
+
+/* Send the spooled batches, oldest first, until one fails */
+static int _spool_send(void)
+{
+	char *data;
+	uint32_t len;
+	int rc = SLURM_SUCCESS;
+
+	slurm_mutex_lock(&spool_lock);
+	while (spool_cnt &&
+	       (data = _spool_read(spool_fd, spool_offset, &len))) {
+		slurm_mutex_unlock(&spool_lock);
+		rc = _send_data(data, len);
+		xfree(data);
+		slurm_mutex_lock(&spool_lock);
+		if (rc != SLURM_SUCCESS)
+			break;
+		spool_offset += sizeof(len) + len;
+		spool_cnt--;
 	}
+	if (!spool_cnt && spool_offset) {
+		/* All sent, start over */
+		if (ftruncate(spool_fd, 0))
+			error("%s %s: unable to truncate %s: %m",
+			      plugin_type, __func__, spool_file);
+		spool_offset = 0;
+	}
+	slurm_mutex_unlock(&spool_lock);
 
 	return rc;
 }
 
+/* Send a batch now or spool it if influxdb isn't reachable */
+static void _send_batch(char *data, time_t *retry_time)
+{
+	uint32_t len = strlen(data);
+
+	if ((time(NULL) >= *retry_time) &&
+	    (_send_data(data, len) == SLURM_SUCCESS))
+		return;
+
+	*retry_time = time(NULL) + INFLUXDB_RETRY_INTERVAL;
+	slurm_mutex_lock(&spool_lock);
+	(void) _spool_append(data, len);
+	slurm_mutex_unlock(&spool_lock);
+}
+
+/* Move the batch being filled to send_list, send_lock must be held */
+static void _queue_batch(void)
+{
+	if (!datastrlen)
+		return;
+
+	if (list_count(send_list) >= INFLUXDB_MAX_BATCHES) {
+		/* Bound the memory used if the sender falls behind */
+		slurm_mutex_lock(&spool_lock);
+		(void) _spool_append(datastr, datastrlen);
+		slurm_mutex_unlock(&spool_lock);
+		xfree(datastr);
+	} else
+		list_enqueue(send_list, datastr);
+	datastr = NULL;
+	datastrlen = 0;
+	slurm_cond_signal(&send_cond);
+}
+
+/*
+ * Send the batches queued by the sampling threads so they never wait on
+ * the network. Partial batches are sent every INFLUXDB_FLUSH_INTERVAL
+ * seconds, failed ones are spooled and retried every
+ * INFLUXDB_RETRY_INTERVAL seconds.
+ */
+static void *_sender(void *arg)
+{
+	struct timespec ts = {0, 0};
+	time_t retry_time = 0, now;
+	char *data;
+	bool stop;
+
+	_spool_open();
+
+	while (1) {
+		slurm_mutex_lock(&send_lock);
+		now = time(NULL);
+		if (!send_shutdown && !list_count(send_list) &&
+		    (!datastrlen ||
+		     (now - batch_start < INFLUXDB_FLUSH_INTERVAL)) &&
+		    (!spool_cnt || (now < retry_time))) {
+			ts.tv_sec = now + 1;
+			slurm_cond_timedwait(&send_cond, &send_lock, &ts);
+			now = time(NULL);
+		}
+		if (datastrlen && (send_shutdown ||
+				   (now - batch_start >=
+				    INFLUXDB_FLUSH_INTERVAL)))
+			_queue_batch();
+		data = list_dequeue(send_list);
+		stop = send_shutdown && !data;
+		slurm_mutex_unlock(&send_lock);
+
+		if (data) {
+			_send_batch(data, &retry_time);
+			xfree(data);
+		}
+		if (spool_cnt && (time(NULL) >= retry_time) &&
+		    (_spool_send() != SLURM_SUCCESS))
+			retry_time = time(NULL) + INFLUXDB_RETRY_INTERVAL;
+		if (stop)
+			break;
+	}
+
+	_spool_close();
+	if (curl_handle) {
+		curl_easy_cleanup(curl_handle);
+		curl_handle = NULL;
+	}
+	return NULL;
+}
+
+/* Add data to the batch being filled */
+static void _add_data(const char *data)
+{
+	size_t length = strlen(data);
+
+	slurm_mutex_lock(&send_lock);
+	if (datastrlen && ((datastrlen + length) > BUF_SIZE))
+		_queue_batch();
+	if (!datastrlen)
+		batch_start = time(NULL);
+	xstrcat(datastr, data);
+	datastrlen += length;
+	if (slurm_get_debug_flags() & DEBUG_FLAG_PROFILE)
+		info("%s %s: %zu bytes of data added to buffer. New buffer size: %d",
+		     plugin_type, __func__, length, datastrlen);
+	slurm_mutex_unlock(&send_lock);
+}
+
+/* Stop the sender once everything queued was sent or spooled */
+static void _stop_sender(void)
+{
+	if (!send_tid)
+		return;
+
+	slurm_mutex_lock(&send_lock);
+	send_shutdown = true;
+	slurm_cond_signal(&send_cond);
+	slurm_mutex_unlock(&send_lock);
+	pthread_join(send_tid, NULL);
+	send_tid = 0;
+}
+
 /*
  * init() is called when the plugin is loaded, before any other functions
  * are called. Put global initialization here.
@@ -324,7 +687,11 @@ extern int init(void)
 	if (!running_in_slurmstepd())
 		return SLURM_SUCCESS;
 
-	datastr = xmalloc(BUF_SIZE);
+	if (curl_global_init(CURL_GLOBAL_ALL) != 0) {
+		error("%s %s: curl_global_init: %m", plugin_type, __func__);
+		return SLURM_ERROR;
+	}
+	send_list = list_create(xfree_ptr);
 	return SLURM_SUCCESS;
 }
 
@@ -332,6 +699,11 @@ extern int fini(void)
 {
 	debug3("%s %s called", plugin_type, __func__);
 
+	if (running_in_slurmstepd()) {
+		_stop_sender();
+		FREE_NULL_LIST(send_list);
+		curl_global_cleanup();
+	}
 	_free_tables();
 	xfree(datastr);
 	xfree(influxdb_conf.host);
@@ -444,6 +816,9 @@ extern int acct_gather_profile_p_node_step_start(stepd_step_rec_t* job)
 	debug2("%s %s: option --profile=%s", plugin_type, __func__,
 	       profile_str);
 	g_profile_running = _determine_profile();
+
+	if ((g_profile_running > ACCT_GATHER_PROFILE_NONE) && !send_tid)
+		slurm_thread_create(&send_tid, _sender, NULL);
 	return rc;
 }
 
@@ -460,6 +835,7 @@ extern int acct_gather_profile_p_node_step_end(void)
 
 	xassert(running_in_slurmstepd());
 
+	_stop_sender();
 	return rc;
 }
 
@@ -485,7 +861,11 @@ extern int acct_gather_profile_p_task_end(pid_t taskpid)
 {
 	debug3("%s %s called", plugin_type, __func__);
 
-	_send_data(NULL);
+	/* Let the sender flush the partial batch without waiting on it */
+	slurm_mutex_lock(&send_lock);
+	if (send_tid)
+		_queue_batch();
+	slurm_mutex_unlock(&send_lock);
 	return SLURM_SUCCESS;
 }
 
@@ -580,7 +960,7 @@ extern int acct_gather_profile_p_add_sample_data(int table_id, void *data,
 		}
 	}
 
-	_send_data(str);
+	_add_data(str);
 	xfree(str);
 
 	return SLURM_SUCCESS;
@@ -55,6 +55,7 @@
 
 #define RETRY_COUNT		20
 #define RETRY_USEC		100000
+#define DECODE_CACHE_SIZE	1024	/* slots in decoded credential cache */
 
 /*
  * These variables are required by the generic plugin interface.  If they
@@ -104,8 +105,29 @@ typedef struct _slurm_auth_credential {
 	gid_t   gid;       /* GID. valid only if verified == true            */
 } slurm_auth_credential_t;
 
+/*
+ * Recently decoded credentials. Munge accepts each credential only once per
+ * host, so seeing one again means it was replayed. That is expected only
+ * when several slurmd share a munged (MULTIPLE_SLURMD), where the cached
+ * result is used. Otherwise the replay is rejected without asking munged.
+ */
+typedef struct {
+	uint32_t hash;		/* hash of m_str, zero if slot is unused */
+	char    *m_str;		/* munged string */
+	time_t   expires;	/* credential expiration time */
+	struct in_addr addr;
+	uid_t    uid;
+	gid_t    gid;
+} decode_cache_t;
+
+static decode_cache_t *decode_cache = NULL;
+static pthread_mutex_t decode_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
 /* Static prototypes */
 
+static int _decode_cache_find(slurm_auth_credential_t *c);
+static void _decode_cache_add(slurm_auth_credential_t *c, munge_ctx_t ctx);
+static uint32_t _decode_cache_hash(const char *m_str);
 static int _decode_cred(slurm_auth_credential_t *c, char *socket);
 static void _print_cred(munge_ctx_t ctx);
 
@@ -124,6 +146,21 @@ int init(void)
 	return SLURM_SUCCESS;
 }
 
+int fini(void)
+{
+	int i;
+
+	slurm_mutex_lock(&decode_cache_lock);
+	if (decode_cache) {
+		for (i = 0; i < DECODE_CACHE_SIZE; i++)
+			xfree(decode_cache[i].m_str);
+		xfree(decode_cache);
+	}
+	slurm_mutex_unlock(&decode_cache_lock);
+
+	return SLURM_SUCCESS;
+}
+
 
 /*
  * Allocate a credential.  This function should return NULL if it cannot
@@ -174,6 +211,7 @@ slurm_auth_credential_t *slurm_auth_create(char *opts)
 	ohandler = xsignal(SIGALRM, (SigFunc *)SIG_BLOCK);
 
 again:
+	slurm_auth_stat_inc(AUTH_STAT_ENCODE);
 	err = munge_encode(&cred->m_str, ctx, NULL, 0);
 	if (err != EMUNGE_SUCCESS) {
 		if ((err == EMUNGE_SOCKET) && retry--) {
@@ -415,6 +453,11 @@ static int _decode_cred(slurm_auth_credential_t *c, char *socket)
 	if (c->verified)
 		return SLURM_SUCCESS;
 
+	if (_decode_cache_find(c) != SLURM_ERROR) {
+		slurm_auth_stat_inc(AUTH_STAT_DECODE_CACHED);
+		return c->verified ? SLURM_SUCCESS : SLURM_ERROR;
+	}
+
 	if ((ctx = munge_ctx_create()) == NULL) {
 		error("munge_ctx_create failure");
 		return SLURM_ERROR;
@@ -427,6 +470,7 @@ static int _decode_cred(slurm_auth_credential_t *c, char *socket)
 	}
 
 again:
+	slurm_auth_stat_inc(AUTH_STAT_DECODE);
 	err = munge_decode(c->m_str, ctx, NULL, NULL, &c->uid, &c->gid);
 	if (err != EMUNGE_SUCCESS) {
 		if ((err == EMUNGE_SOCKET) && retry--) {
@@ -473,12 +517,101 @@ again:
 		      munge_ctx_strerror(ctx));
 
 	c->verified = true;
+	_decode_cache_add(c, ctx);
 
 done:
 	munge_ctx_destroy(ctx);
 	return err ? SLURM_ERROR : SLURM_SUCCESS;
 }
 
+/* FNV-1a hash of a munged string, never zero */
+static uint32_t _decode_cache_hash(const char *m_str)
+{
+	uint32_t hash = 2166136261U;
+
+	for (; *m_str; m_str++) {
+		hash ^= (uint8_t) *m_str;
+		hash *= 16777619;
+	}
+
+	return hash ? hash : 1;
+}
+
+/*
+ * Look for credential `c' in the decode cache. If found, it is either
+ * verified from the cache or rejected as a replay.
+ * RET SLURM_SUCCESS if found, SLURM_ERROR if munged must decode it
+ */
+static int _decode_cache_find(slurm_auth_credential_t *c)
+{
+	uint32_t hash;
+	decode_cache_t *entry;
+	int rc = SLURM_ERROR;
+
+	if (!c->m_str)
+		return SLURM_ERROR;
+
+	hash = _decode_cache_hash(c->m_str);
+	slurm_mutex_lock(&decode_cache_lock);
+	if (!decode_cache)
+		goto fini;
+	entry = &decode_cache[hash % DECODE_CACHE_SIZE];
+	if ((entry->hash != hash) || xstrcmp(entry->m_str, c->m_str))
+		goto fini;
+	if (entry->expires < time(NULL)) {
+		/* Let munged report the expired credential */
+		entry->hash = 0;
+		xfree(entry->m_str);
+		goto fini;
+	}
+
+#ifdef MULTIPLE_SLURMD
+	debug2("We had a replayed cred, but this is expected in multiple slurmd mode.");
+	c->addr = entry->addr;
+	c->uid = entry->uid;
+	c->gid = entry->gid;
+	c->verified = true;
+#else
+	error("Munge decode failed: Replayed credential");
+	slurm_seterrno(ESLURM_AUTH_CRED_INVALID);
+#endif
+	rc = SLURM_SUCCESS;
+
+fini:
+	slurm_mutex_unlock(&decode_cache_lock);
+	return rc;
+}
+
+/* Remember credential `c' just verified by munged until it expires */
+static void _decode_cache_add(slurm_auth_credential_t *c, munge_ctx_t ctx)
+{
+	time_t encoded;
+	int ttl;
+	uint32_t hash;
+	decode_cache_t *entry;
+
+	if (!c->m_str ||
+	    (munge_ctx_get(ctx, MUNGE_OPT_ENCODE_TIME, &encoded) !=
+	     EMUNGE_SUCCESS) ||
+	    (munge_ctx_get(ctx, MUNGE_OPT_TTL, &ttl) != EMUNGE_SUCCESS))
+		return;
+
+	hash = _decode_cache_hash(c->m_str);
+	slurm_mutex_lock(&decode_cache_lock);
+	if (!decode_cache)
+		decode_cache = xcalloc(DECODE_CACHE_SIZE,
+				       sizeof(decode_cache_t));
+	entry = &decode_cache[hash % DECODE_CACHE_SIZE];
+	xfree(entry->m_str);
+	entry->hash = hash;
+	entry->m_str = xstrdup(c->m_str);
+	entry->expires = encoded + ttl;
+	entry->addr = c->addr;
+	entry->uid = c->uid;
+	entry->gid = c->gid;
+	slurm_mutex_unlock(&decode_cache_lock);
+}
+
 /*
  *  Print credential information.
  */
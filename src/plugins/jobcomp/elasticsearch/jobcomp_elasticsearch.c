@@ -99,6 +99,11 @@ const char plugin_type[] = "jobcomp/elasticsearch";
 const uint32_t plugin_version = SLURM_VERSION_NUMBER;
 
 #define INDEX_RETRY_INTERVAL 30
+#define BULK_MAX_JOBS_DEFAULT 1000	/* jobs per _bulk request */
+#define BULK_FLUSH_MSEC_DEFAULT 1000	/* max wait before a _bulk request */
+#define PEND_LOG_COMPACT_SIZE (64 * 1024 * 1024)
+#define PEND_REC_ADD 1		/* job to index */
+#define PEND_REC_DONE 2		/* job indexed or rejected */
 #define JOBCOMP_DATA_FORMAT "{\"jobid\":%u,\"username\":\"%s\","	\
 	"\"user_id\":%u,\"groupname\":\"%s\",\"group_id\":%u,"		\
 	"\"@start\":\"%s\",\"@end\":\"%s\",\"elapsed\":%ld,"		\
@@ -126,21 +131,45 @@ struct http_response {
 };
 
 struct job_node {
+	uint32_t id;
+	bool indexed;
 	time_t last_index_retry;
 	char * serialized_job;
 };
 
+/*
+ * Jobs waiting to be indexed are appended to pend_log_file as they
+ * complete and a record is appended once they are indexed, so a restart
+ * or crash doesn't lose or re-index them. The log is rewritten with just
+ * the pending jobs by _save_state() when it grows too big.
+ * save_state_file is the old format, only read on upgrade.
+ */
 char *save_state_file = "elasticsearch_state";
+char *pend_log_file = "elasticsearch_pending";
 char *index_type = "/slurm/jobcomp";
 char *log_url = NULL;
+char *bulk_url = NULL;
 
 static pthread_cond_t location_cond = PTHREAD_COND_INITIALIZER;
 static pthread_mutex_t location_mutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_mutex_t save_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t compact_lock = PTHREAD_MUTEX_INITIALIZER;
 static pthread_mutex_t pend_jobs_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pend_jobs_cond = PTHREAD_COND_INITIALIZER;
 static pthread_t job_handler_thread;
 static List jobslist = NULL;
 static bool thread_shutdown = false;
+static uint32_t bulk_max_jobs = BULK_MAX_JOBS_DEFAULT;
+static uint32_t bulk_flush_msec = BULK_FLUSH_MSEC_DEFAULT;
+static CURL *bulk_handle = NULL;
+
+/* Protected by save_lock */
+static int pend_log_fd = -1;
+static uint64_t pend_log_size = 0;
+static uint64_t compact_size = 0;	/* pend_log_size after compaction */
+static Buf compact_buf = NULL;		/* records logged while compacting */
+static uint32_t next_job_id = 1;
+static uint32_t new_job_cnt = 0;
 
 /* Get the user name for the give user_id */
 static void _get_user_name(uint32_t user_id, char *user_name, int buf_size)
@@ -221,41 +250,130 @@ static uint32_t _read_file(const char *file, char **data)
 	return data_size;
 }
 
-/* Load jobcomp data from save state file */
-static int _load_pending_jobs(void)
+/* Return the path to name in StateSaveLocation, NULL if not configured */
+static char *_state_file(const char *name)
 {
-	int i, rc = SLURM_SUCCESS;
-	char *saved_data = NULL, *state_file = NULL, *job_data = NULL;
-	uint32_t data_size, job_cnt = 0, tmp32 = 0;
-	Buf buffer;
-	struct job_node *jnode;
+	char *state_file = slurm_get_state_save_location();
 
-	state_file = slurm_get_state_save_location();
-	if (state_file == NULL) {
+	if ((state_file == NULL) || (state_file[0] == '\0')) {
 		error("%s: Could not retrieve StateSaveLocation from conf",
 		      plugin_type);
-		return SLURM_ERROR;
+		xfree(state_file);
+		return NULL;
 	}
 
 	if (state_file[strlen(state_file) - 1] != '/')
 		xstrcat(state_file, "/");
-	xstrcat(state_file, save_state_file);
+	xstrcat(state_file, name);
+
+	return state_file;
+}
+
+static int _find_job_id(void *x, void *key)
+{
+	struct job_node *jnode = (struct job_node *) x;
+
+	return (jnode->id == *(uint32_t *) key);
+}
+
+static int _find_indexed(void *x, void *key)
+{
+	struct job_node *jnode = (struct job_node *) x;
+
+	return jnode->indexed;
+}
+
+/* Pack a pending log record, prefixed by its size */
+static void _pack_pend_rec(uint16_t type, struct job_node *jnode, Buf buffer)
+{
+	uint32_t start = get_buf_offset(buffer), end;
+
+	pack32(0, buffer);	/* record size, set below */
+	pack16(type, buffer);
+	pack32(jnode->id, buffer);
+	if (type == PEND_REC_ADD)
+		packstr(jnode->serialized_job, buffer);
+
+	end = get_buf_offset(buffer);
+	set_buf_offset(buffer, start);
+	pack32(end - start - sizeof(uint32_t), buffer);
+	set_buf_offset(buffer, end);
+}
+
+static int _write_buf(int fd, Buf buffer, const char *file)
+{
+	int pos = 0, nwrite, amount;
+	char *data = (char *) get_buf_data(buffer);
+
+	nwrite = get_buf_offset(buffer);
+	while (nwrite > 0) {
+		amount = write(fd, &data[pos], nwrite);
+		if (amount < 0) {
+			if (errno == EINTR)
+				continue;
+			error("%s: Error writing file %s, %m",
+			      plugin_type, file);
+			return SLURM_ERROR;
+		}
+		nwrite -= amount;
+		pos += amount;
+	}
+
+	return SLURM_SUCCESS;
+}
+
+/* Append the records in buffer to the pending log, save_lock must be held */
+static void _append_pend_log(Buf buffer)
+{
+	char *log_file;
+
+	if (pend_log_fd < 0) {
+		if (!(log_file = _state_file(pend_log_file)))
+			return;
+		pend_log_fd = open(log_file, O_CREAT | O_WRONLY | O_APPEND,
+				   S_IRUSR | S_IWUSR);
+		if (pend_log_fd < 0) {
+			error("%s: Can't open pending job log %s: %m",
+			      plugin_type, log_file);
+			xfree(log_file);
+			return;
+		}
+		fd_set_close_on_exec(pend_log_fd);
+		xfree(log_file);
+	}
+
+	if (_write_buf(pend_log_fd, buffer, pend_log_file) == SLURM_SUCCESS) {
+		pend_log_size += get_buf_offset(buffer);
+		/* Also goes to the log _save_state() is writing */
+		if (compact_buf)
+			packmem_array(get_buf_data(buffer),
+				      get_buf_offset(buffer), compact_buf);
+	} else if (ftruncate(pend_log_fd, pend_log_size))
+		/* Drop any partial record so later ones stay readable */
+		error("%s: Can't truncate %s: %m", plugin_type, pend_log_file);
+}
+
+/* Load jobcomp data saved in the old state file format */
+static int _load_state_file(char *state_file)
+{
+	int i;
+	char *saved_data = NULL, *job_data = NULL;
+	uint32_t data_size, job_cnt = 0, tmp32 = 0;
+	Buf buffer;
+	struct job_node *jnode;
 
-	slurm_mutex_lock(&save_lock);
 	data_size = _read_file(state_file, &saved_data);
 	if ((data_size <= 0) || (saved_data == NULL)) {
-		slurm_mutex_unlock(&save_lock);
 		xfree(saved_data);
-		xfree(state_file);
-		return rc;
+		return SLURM_SUCCESS;
 	}
-	slurm_mutex_unlock(&save_lock);
 
 	buffer = create_buf(saved_data, data_size);
 	safe_unpack32(&job_cnt, buffer);
 	for (i = 0; i < job_cnt; i++) {
 		safe_unpackstr_xmalloc(&job_data, &tmp32, buffer);
 		jnode = xmalloc(sizeof(struct job_node));
+		jnode->id = next_job_id++;
 		jnode->serialized_job = job_data;
 		list_enqueue(jobslist, jnode);
 	}
@@ -265,17 +383,192 @@ static int _load_pending_jobs(void)
 			     job_cnt);
 	}
 	free_buf(buffer);
-	xfree(state_file);
 
-	return rc;
+	return SLURM_SUCCESS;
 
 unpack_error:
 	error("%s: Error unpacking file %s", plugin_type, state_file);
 	free_buf(buffer);
-	xfree(state_file);
 	return SLURM_ERROR;
 }
 
+/* Replay the pending job log */
+static int _load_pend_log(char *log_file)
+{
+	char *saved_data = NULL, *job_data = NULL;
+	uint32_t data_size, rec_size, rec_end, id, tmp32 = 0;
+	uint16_t type;
+	Buf buffer;
+	struct job_node *jnode;
+
+	data_size = _read_file(log_file, &saved_data);
+	if ((data_size <= 0) || (saved_data == NULL)) {
+		xfree(saved_data);
+		return SLURM_SUCCESS;
+	}
+
+	buffer = create_buf(saved_data, data_size);
+	while (remaining_buf(buffer) >= sizeof(uint32_t)) {
+		safe_unpack32(&rec_size, buffer);
+		if (rec_size > remaining_buf(buffer)) {
+			/* Partial record from a crash while appending */
+			error("%s: Ignoring partial record at end of %s",
+			      plugin_type, log_file);
+			break;
+		}
+		rec_end = get_buf_offset(buffer) + rec_size;
+		safe_unpack16(&type, buffer);
+		safe_unpack32(&id, buffer);
+		if (type == PEND_REC_ADD) {
+			safe_unpackstr_xmalloc(&job_data, &tmp32, buffer);
+			jnode = xmalloc(sizeof(struct job_node));
+			jnode->id = id;
+			jnode->serialized_job = job_data;
+			job_data = NULL;
+			list_enqueue(jobslist, jnode);
+		} else if (type == PEND_REC_DONE)
+			list_delete_all(jobslist, _find_job_id, &id);
+		next_job_id = MAX(next_job_id, id + 1);
+		set_buf_offset(buffer, rec_end);
+	}
+	if (slurm_get_debug_flags() & DEBUG_FLAG_ESEARCH)
+		info("%s: Loaded %d pending jobs from %s", plugin_type,
+		     list_count(jobslist), log_file);
+	free_buf(buffer);
+
+	return SLURM_SUCCESS;
+
+unpack_error:
+	error("%s: Error unpacking file %s", plugin_type, log_file);
+	free_buf(buffer);
+	return SLURM_ERROR;
+}
+
+/*
+ * Rewrite the pending job log with just the jobs not yet indexed, for
+ * further indexing retries. save_lock is not held while the new log is
+ * written, records logged meanwhile are collected in compact_buf and
+ * added to it before it replaces the old one.
+ */
+static int _save_state(void)
+{
+	int fd, rc = SLURM_SUCCESS, rc2;
+	char *state_file, *new_file, *old_file;
+	ListIterator iter;
+	static int high_buffer_size = (1024 * 1024);
+	Buf buffer;
+	struct job_node *jnode;
+
+	if (!(state_file = _state_file(pend_log_file)))
+		return SLURM_ERROR;
+	old_file = xstrdup_printf("%s.old", state_file);
+	new_file = xstrdup_printf("%s.new", state_file);
+
+	slurm_mutex_lock(&compact_lock);
+	slurm_mutex_lock(&save_lock);
+	buffer = init_buf(high_buffer_size);
+	iter = list_iterator_create(jobslist);
+	while ((jnode = (struct job_node *)list_next(iter))) {
+		if (!jnode->indexed)
+			_pack_pend_rec(PEND_REC_ADD, jnode, buffer);
+	}
+	list_iterator_destroy(iter);
+	high_buffer_size = MAX(get_buf_offset(buffer), high_buffer_size);
+	compact_buf = init_buf(BUF_SIZE);
+	slurm_mutex_unlock(&save_lock);
+
+	fd = open(new_file, O_CREAT | O_WRONLY | O_TRUNC, S_IRUSR | S_IWUSR);
+	if (fd < 0) {
+		error("%s: Can't save jobcomp state, open file %s error %m",
+		      plugin_type, new_file);
+		rc = SLURM_ERROR;
+	} else {
+		fd_set_close_on_exec(fd);
+		rc = _write_buf(fd, buffer, new_file);
+		if ((rc2 = fsync_and_close(fd, pend_log_file)))
+			rc = rc2;
+	}
+
+	slurm_mutex_lock(&save_lock);
+	if ((rc == SLURM_SUCCESS) && get_buf_offset(compact_buf)) {
+		fd = open(new_file, O_WRONLY | O_APPEND);
+		if (fd < 0) {
+			error("%s: Can't save jobcomp state, open file %s error %m",
+			      plugin_type, new_file);
+			rc = SLURM_ERROR;
+		} else {
+			rc = _write_buf(fd, compact_buf, new_file);
+			(void) close(fd);
+		}
+	}
+
+	if (rc == SLURM_ERROR)
+		(void) unlink(new_file);
+	else {
+		(void) unlink(old_file);
+		if (link(state_file, old_file) && (errno != ENOENT)) {
+			error("%s: Unable to create link for %s -> %s: %m",
+			      plugin_type, state_file, old_file);
+			rc = SLURM_ERROR;
+		}
+		(void) unlink(state_file);
+		if (link(new_file, state_file)) {
+			error("%s: Unable to create link for %s -> %s: %m",
+			      plugin_type, new_file, state_file);
+			rc = SLURM_ERROR;
+		}
+		(void) unlink(new_file);
+
+		/* Append to the new log from now on */
+		if (pend_log_fd >= 0) {
+			(void) close(pend_log_fd);
+			pend_log_fd = -1;
+		}
+		pend_log_size = get_buf_offset(buffer) +
+				get_buf_offset(compact_buf);
+		compact_size = pend_log_size;
+	}
+	FREE_NULL_BUFFER(compact_buf);
+
+	xfree(old_file);
+	xfree(state_file);
+	xfree(new_file);
+	slurm_mutex_unlock(&save_lock);
+	slurm_mutex_unlock(&compact_lock);
+
+	free_buf(buffer);
+
+	return rc;
+}
+
+/* Load jobcomp data not indexed before the last shutdown */
+static int _load_pending_jobs(void)
+{
+	int rc;
+	char *state_file = NULL, *log_file = NULL;
+
+	if (!(state_file = _state_file(save_state_file)) ||
+	    !(log_file = _state_file(pend_log_file))) {
+		xfree(state_file);
+		return SLURM_ERROR;
+	}
+
+	slurm_mutex_lock(&save_lock);
+	rc = _load_state_file(state_file);
+	if (_load_pend_log(log_file) != SLURM_SUCCESS)
+		rc = SLURM_ERROR;
+	slurm_mutex_unlock(&save_lock);
+
+	/* Start over with a log of just the pending jobs */
+	if ((_save_state() == SLURM_SUCCESS) && (rc == SLURM_SUCCESS))
+		(void) unlink(state_file);
+
+	xfree(state_file);
+	xfree(log_file);
+
+	return rc;
+}
+
 /* Callback to handle the HTTP response */
 static size_t _write_callback(void *contents, size_t size, size_t nmemb,
 			      void *userp)
@@ -292,102 +585,105 @@ static size_t _write_callback(void *contents, size_t size, size_t nmemb,
 	return realsize;
 }
 
-/* Try to index job into elasticsearch */
-static int _index_job(const char *jobcomp)
+/*
+ * Get the status of each item from a _bulk response, in the order the
+ * jobs were sent.
+ * RET SLURM_SUCCESS if there was a status for each of the cnt jobs
+ */
+static int _parse_bulk_response(char *resp, int cnt, long *status)
+{
+	char *p;
+	int i;
+
+	if (strstr(resp, "\"errors\":false")) {
+		for (i = 0; i < cnt; i++)
+			status[i] = 201;
+		return SLURM_SUCCESS;
+	}
+
+	if (!(p = strstr(resp, "\"items\"")))
+		return SLURM_ERROR;
+	for (i = 0; i < cnt; i++) {
+		if (!(p = strstr(p, "\"status\"")))
+			return SLURM_ERROR;
+		p += strlen("\"status\"");
+		while ((*p == ' ') || (*p == ':'))
+			p++;
+		status[i] = strtol(p, &p, 10);
+	}
+
+	return SLURM_SUCCESS;
+}
+
+/*
+ * Send cnt jobs in one _bulk request to elasticsearch
+ * OUT status - HTTP status of each job
+ * RET SLURM_SUCCESS if each job got a status
+ */
+static int _index_bulk(const char *body, int cnt, long *status)
 {
-	CURL *curl_handle = NULL;
 	CURLcode res;
 	struct http_response chunk;
 	struct curl_slist *slist = NULL;
+	long http_code = 0;
 	int rc = SLURM_SUCCESS;
-	char *token = NULL;
 
-	if (log_url == NULL) {
+	if (bulk_url == NULL) {
 		error("%s: JobCompLoc parameter not configured", plugin_type);
 		return SLURM_ERROR;
 	}
 
-	if (curl_global_init(CURL_GLOBAL_ALL) != 0) {
-		error("%s: curl_global_init: %m", plugin_type);
-		rc = SLURM_ERROR;
-		goto cleanup_global_init;
-	} else if ((curl_handle = curl_easy_init()) == NULL) {
+	/* Keep the handle so the connection is reused between requests */
+	if (!bulk_handle && !(bulk_handle = curl_easy_init())) {
 		error("%s: curl_easy_init: %m", plugin_type);
-		rc = SLURM_ERROR;
-		goto cleanup_easy_init;
+		return SLURM_ERROR;
 	}
 
-	slist = curl_slist_append(slist, "Content-Type: application/json");
-
+	/* The _bulk API requires newline delimited JSON */
+	slist = curl_slist_append(slist, "Content-Type: application/x-ndjson");
 	if (slist == NULL) {
 		error("%s: curl_slist_append: %m", plugin_type);
-		rc = SLURM_ERROR;
-		goto cleanup_easy_init;
+		return SLURM_ERROR;
 	}
 
 	chunk.message = xmalloc(1);
 	chunk.size = 0;
 
-	curl_easy_setopt(curl_handle, CURLOPT_URL, log_url);
-	curl_easy_setopt(curl_handle, CURLOPT_POST, 1);
-	curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDS, jobcomp);
-	curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDSIZE, strlen(jobcomp));
-	curl_easy_setopt(curl_handle, CURLOPT_HTTPHEADER, slist);
-	curl_easy_setopt(curl_handle, CURLOPT_HEADER, 1);
-	curl_easy_setopt(curl_handle, CURLOPT_WRITEFUNCTION, _write_callback);
-	curl_easy_setopt(curl_handle, CURLOPT_WRITEDATA, (void *) &chunk);
+	curl_easy_setopt(bulk_handle, CURLOPT_URL, bulk_url);
+	curl_easy_setopt(bulk_handle, CURLOPT_POST, 1L);
+	curl_easy_setopt(bulk_handle, CURLOPT_POSTFIELDS, body);
+	curl_easy_setopt(bulk_handle, CURLOPT_POSTFIELDSIZE, (long) strlen(body));
+	curl_easy_setopt(bulk_handle, CURLOPT_HTTPHEADER, slist);
+	curl_easy_setopt(bulk_handle, CURLOPT_WRITEFUNCTION, _write_callback);
+	curl_easy_setopt(bulk_handle, CURLOPT_WRITEDATA, (void *) &chunk);
 
-	if ((res = curl_easy_perform(curl_handle)) != CURLE_OK) {
+	if ((res = curl_easy_perform(bulk_handle)) != CURLE_OK) {
 		if (slurm_get_debug_flags() & DEBUG_FLAG_ESEARCH)
-			info("%s: Could not connect to: %s , reason: %s"
-			     ,plugin_type, log_url, curl_easy_strerror(res));
+			info("%s: Could not connect to: %s , reason: %s",
+			     plugin_type, bulk_url, curl_easy_strerror(res));
 		rc = SLURM_ERROR;
 		goto cleanup;
 	}
 
-	token = strtok(chunk.message, " ");
-	if (token == NULL) {
-		error("%s: Could not receive the HTTP response status code from %s",
-		      plugin_type, log_url);
-		rc = SLURM_ERROR;
-		goto cleanup;
-	}
-	token = strtok(NULL, " ");
-
-	/* HTTP 100 (Continue). */
-	if ((xstrcmp(token, "100") == 0)) {
-		(void)  strtok(NULL, " ");
-		token = strtok(NULL, " ");
-	}
-
-	/*
-	 * HTTP 200 (OK)	- request succeed.
-	 * HTTP 201 (Created)	- request succeed and resource created.
-	 */
-	if ((xstrcmp(token, "200") != 0) && (xstrcmp(token, "201") != 0)) {
+	curl_easy_getinfo(bulk_handle, CURLINFO_RESPONSE_CODE, &http_code);
+	if (http_code != 200) {
 		if (slurm_get_debug_flags() & DEBUG_FLAG_ESEARCH) {
-			info("%s: HTTP status code %s received from %s",
-			     plugin_type, token, log_url);
+			info("%s: HTTP status code %ld received from %s",
+			     plugin_type, http_code, bulk_url);
 			info("%s: HTTP response:\n%s", plugin_type,
 			     chunk.message);
 		}
 		rc = SLURM_ERROR;
-	} else {
-		token = strtok((char *)jobcomp, ",");
-		(void)  strtok(token, ":");
-		token = strtok(NULL, ":");
-		if (slurm_get_debug_flags() & DEBUG_FLAG_ESEARCH)
-			info("%s: Job with jobid %s indexed into elasticsearch",
-			     plugin_type, token);
+	} else if (_parse_bulk_response(chunk.message, cnt, status) !=
+		   SLURM_SUCCESS) {
+		error("%s: Could not get the status of %d jobs from the response of %s",
+		      plugin_type, cnt, bulk_url);
+		rc = SLURM_ERROR;
 	}
 
 cleanup:
 	curl_slist_free_all(slist);
 	xfree(chunk.message);
-cleanup_easy_init:
-	curl_easy_cleanup(curl_handle);
-cleanup_global_init:
-	curl_global_cleanup();
 	return rc;
 }
 
@@ -468,97 +764,6 @@ static char *_json_escape(const char *str)
 	return ret;
 }
 
-/* Saves the state of all jobcomp data for further indexing retries */
-static int _save_state(void)
-{
-	int fd, rc = SLURM_SUCCESS;
-	char *state_file, *new_file, *old_file;
-	ListIterator iter;
-	static int high_buffer_size = (1024 * 1024);
-	Buf buffer = init_buf(high_buffer_size);
-	uint32_t job_cnt;
-	struct job_node *jnode;
-
-	job_cnt = list_count(jobslist);
-	pack32(job_cnt, buffer);
-	iter = list_iterator_create(jobslist);
-	while ((jnode = (struct job_node *)list_next(iter))) {
-		packstr(jnode->serialized_job, buffer);
-	}
-	list_iterator_destroy(iter);
-
-	state_file = slurm_get_state_save_location();
-	if (state_file == NULL || state_file[0] == '\0') {
-		error("%s: Could not retrieve StateSaveLocation from conf",
-		      plugin_type);
-		return SLURM_ERROR;
-	}
-
-	if (state_file[strlen(state_file) - 1] != '/')
-		xstrcat(state_file, "/");
-
-	xstrcat(state_file, save_state_file);
-	old_file = xstrdup(state_file);
-	new_file = xstrdup(state_file);
-	xstrcat(new_file, ".new");
-	xstrcat(old_file, ".old");
-
-	slurm_mutex_lock(&save_lock);
-	fd = open(new_file, O_CREAT | O_WRONLY | O_TRUNC, S_IRUSR | S_IWUSR);
-	if (fd < 0) {
-		error("%s: Can't save jobcomp state, open file %s error %m",
-		      plugin_type, new_file);
-		rc = SLURM_ERROR;
-	} else {
-		int pos = 0, nwrite, amount, rc2;
-		char *data;
-		fd_set_close_on_exec(fd);
-		nwrite = get_buf_offset(buffer);
-		data = (char *) get_buf_data(buffer);
-		high_buffer_size = MAX(nwrite, high_buffer_size);
-		while (nwrite > 0) {
-			amount = write(fd, &data[pos], nwrite);
-			if ((amount < 0) && (errno != EINTR)) {
-				error("%s: Error writing file %s, %m",
-				      plugin_type, new_file);
-				rc = SLURM_ERROR;
-				break;
-			}
-			nwrite -= amount;
-			pos += amount;
-		}
-		if ((rc2 = fsync_and_close(fd, save_state_file)))
-			rc = rc2;
-	}
-
-	if (rc == SLURM_ERROR)
-		(void) unlink(new_file);
-	else {
-		(void) unlink(old_file);
-		if (link(state_file, old_file)) {
-			error("%s: Unable to create link for %s -> %s: %m",
-			      plugin_type, state_file, old_file);
-			rc = SLURM_ERROR;
-		}
-		(void) unlink(state_file);
-		if (link(new_file, state_file)) {
-			error("%s: Unable to create link for %s -> %s: %m",
-			      plugin_type, new_file, state_file);
-			rc = SLURM_ERROR;
-		}
-		(void) unlink(new_file);
-	}
-
-	xfree(old_file);
-	xfree(state_file);
-	xfree(new_file);
-	slurm_mutex_unlock(&save_lock);
-
-	free_buf(buffer);
-
-	return rc;
-}
-
 /* This is a variation of slurm_make_time_str() in src/common/parse_time.h
  * This version uses ISO8601 format by default. */
 static void _make_time_str(time_t * time, char *string, int size)
@@ -579,13 +784,14 @@ extern int slurm_jobcomp_log_record(job_record_t *job_ptr)
 	char usr_str[32], grp_str[32], start_str[32], end_str[32], time_str[32];
 	char *json_str = NULL, *state_string = NULL;
 	char *exit_code_str = NULL, *derived_ec_str = NULL;
-	Buf script;
+	Buf script, buffer;
 	enum job_states job_state;
 	int i, tmp_int, tmp_int2;
 	time_t elapsed_time;
 	uint32_t time_limit;
 	uint16_t ntasks_per_node;
 	struct job_node *jnode;
+	bool wake;
 
 	if (list_count(jobslist) > MAX_JOBS) {
 		error("%s: Limit of %d enqueued jobs in memory waiting to be indexed reached. Job %lu discarded",
@@ -875,18 +1081,116 @@ extern int slurm_jobcomp_log_record(job_record_t *job_ptr)
 	xstrcat(json_str, "}");
 	jnode = xmalloc(sizeof(struct job_node));
 	jnode->serialized_job = json_str;
-	list_enqueue(jobslist, jnode);
 	json_str = NULL;
 
+	slurm_mutex_lock(&save_lock);
+	jnode->id = next_job_id++;
+	buffer = init_buf(strlen(jnode->serialized_job) + 64);
+	_pack_pend_rec(PEND_REC_ADD, jnode, buffer);
+	_append_pend_log(buffer);
+	free_buf(buffer);
+	list_enqueue(jobslist, jnode);
+	wake = (++new_job_cnt >= bulk_max_jobs);
+	slurm_mutex_unlock(&save_lock);
+
+	if (wake) {
+		slurm_mutex_lock(&pend_jobs_lock);
+		slurm_cond_signal(&pend_jobs_cond);
+		slurm_mutex_unlock(&pend_jobs_lock);
+	}
+
 	return SLURM_SUCCESS;
 }
 
-extern void *_process_jobs(void *x)
+/* Send up to bulk_max_jobs of the jobs due for indexing in one request
+ * RET number of jobs sent */
+static int _index_jobs(void)
 {
 	ListIterator iter;
-	struct job_node *jnode = NULL;
+	struct job_node *jnode, **batch;
+	char *body = NULL, *pos = NULL;
+	long *status;
+	int i, cnt = 0, success_cnt = 0, fail_cnt = 0, reject_cnt = 0;
+	int wait_retry_cnt = 0;
+	time_t now = time(NULL);
+	Buf buffer;
+
+	batch = xcalloc(bulk_max_jobs, sizeof(struct job_node *));
+	slurm_mutex_lock(&save_lock);
+	new_job_cnt = 0;
+	slurm_mutex_unlock(&save_lock);
+	iter = list_iterator_create(jobslist);
+	while ((jnode = (struct job_node *)list_next(iter)) &&
+	       (cnt < bulk_max_jobs)) {
+		if (jnode->last_index_retry &&
+		    (difftime(now, jnode->last_index_retry) <
+		     INDEX_RETRY_INTERVAL)) {
+			wait_retry_cnt++;
+			continue;
+		}
+		xstrfmtcatat(body, &pos, "{\"index\":{}}\n%s\n",
+			     jnode->serialized_job);
+		batch[cnt++] = jnode;
+	}
+	list_iterator_destroy(iter);
+
+	if (!cnt) {
+		xfree(batch);
+		return 0;
+	}
+
+	status = xcalloc(cnt, sizeof(long));
+	if (_index_bulk(body, cnt, status) != SLURM_SUCCESS) {
+		for (i = 0; i < cnt; i++)
+			batch[i]->last_index_retry = now;
+		fail_cnt = cnt;
+		goto end_it;
+	}
+
+	buffer = init_buf(cnt * 16);
+	for (i = 0; i < cnt; i++) {
+		if ((status[i] == 200) || (status[i] == 201)) {
+			success_cnt++;
+		} else if ((status[i] == 429) || (status[i] >= 500)) {
+			/* Too many requests or server error, try again */
+			batch[i]->last_index_retry = now;
+			fail_cnt++;
+			continue;
+		} else {
+			/* Retrying a rejected document won't help */
+			error("%s: HTTP status code %ld indexing %s, discarding it",
+			      plugin_type, status[i], batch[i]->serialized_job);
+			reject_cnt++;
+		}
+		batch[i]->indexed = true;
+		_pack_pend_rec(PEND_REC_DONE, batch[i], buffer);
+	}
+
+	slurm_mutex_lock(&save_lock);
+	if (get_buf_offset(buffer))
+		_append_pend_log(buffer);
+	list_delete_all(jobslist, _find_indexed, NULL);
+	slurm_mutex_unlock(&save_lock);
+	free_buf(buffer);
+
+end_it:
+	if (slurm_get_debug_flags() & DEBUG_FLAG_ESEARCH) {
+		info("%s: index success:%d fail:%d rejected:%d wait_retry:%d",
+		     plugin_type, success_cnt, fail_cnt, reject_cnt,
+		     wait_retry_cnt);
+	}
+	xfree(status);
+	xfree(body);
+	xfree(batch);
+
+	return cnt;
+}
+
+extern void *_process_jobs(void *x)
+{
 	struct timespec ts = {0, 0};
-	time_t now;
+	struct timeval now;
+	bool compact;
 
 	/* Wait for slurm_jobcomp_set_location log_url setup. */
 	slurm_mutex_lock(&location_mutex);
@@ -895,33 +1199,42 @@ extern void *_process_jobs(void *x)
 	slurm_mutex_unlock(&location_mutex);
 
 	while (!thread_shutdown) {
-		int success_cnt = 0, fail_cnt = 0, wait_retry_cnt = 0;
-		sleep(1);
-		iter = list_iterator_create(jobslist);
-		while ((jnode = (struct job_node *)list_next(iter)) &&
-		       !thread_shutdown) {
-			now = time(NULL);
-			if ((jnode->last_index_retry == 0) ||
-			    (difftime(now, jnode->last_index_retry) >=
-					INDEX_RETRY_INTERVAL)) {
-				if ((_index_job(jnode->serialized_job) ==
-				     SLURM_SUCCESS)) {
-					list_delete_item(iter);
-					success_cnt++;
-				} else {
-					jnode->last_index_retry = now;
-					fail_cnt++;
-				}
-			} else
-				wait_retry_cnt++;
-		}
-		list_iterator_destroy(iter);
-		if ((success_cnt || fail_cnt) &&
-		    (slurm_get_debug_flags() & DEBUG_FLAG_ESEARCH)) {
-			info("%s: index success:%d fail:%d wait_retry:%d",
-			     plugin_type, success_cnt, fail_cnt,
-			     wait_retry_cnt);
+		/* Wait for bulk_max_jobs new jobs or bulk_flush_msec */
+		gettimeofday(&now, NULL);
+		ts.tv_sec = now.tv_sec + (bulk_flush_msec / 1000);
+		ts.tv_nsec = (now.tv_usec * 1000) +
+			     ((bulk_flush_msec % 1000) * 1000000);
+		if (ts.tv_nsec >= 1000000000) {
+			ts.tv_sec++;
+			ts.tv_nsec -= 1000000000;
 		}
+		slurm_mutex_lock(&pend_jobs_lock);
+		if (!thread_shutdown)
+			slurm_cond_timedwait(&pend_jobs_cond, &pend_jobs_lock,
+					     &ts);
+		slurm_mutex_unlock(&pend_jobs_lock);
+
+		/* Keep going while there are full batches to send */
+		while (!thread_shutdown &&
+		       (_index_jobs() >= bulk_max_jobs))
+			;
+
+		/*
+		 * Rewrite the log once it has doubled since the last rewrite,
+		 * so a large backlog is not rewritten on every pass
+		 */
+		slurm_mutex_lock(&save_lock);
+		compact = ((pend_log_size > PEND_LOG_COMPACT_SIZE) &&
+			   (pend_log_size > (2 * compact_size))) ||
+			  (pend_log_size && !list_count(jobslist));
+		slurm_mutex_unlock(&save_lock);
+		if (compact)
+			(void) _save_state();
+	}
+
+	if (bulk_handle) {
+		curl_easy_cleanup(bulk_handle);
+		bulk_handle = NULL;
 	}
 	return NULL;
 }
@@ -933,12 +1246,42 @@ static void _jobslist_del(void *x)
 	xfree(jnode);
 }
 
+/* Read bulk_max_jobs and bulk_flush_msec from JobCompParams */
+static void _read_params(void)
+{
+	char *params = slurm_get_jobcomp_params(), *tmp_ptr;
+	int tmp_int;
+
+	bulk_max_jobs = BULK_MAX_JOBS_DEFAULT;
+	bulk_flush_msec = BULK_FLUSH_MSEC_DEFAULT;
+
+	if ((tmp_ptr = xstrcasestr(params, "bulk_max_jobs="))) {
+		tmp_int = atoi(tmp_ptr + 14);
+		if (tmp_int > 0)
+			bulk_max_jobs = tmp_int;
+		else
+			error("%s: Invalid JobCompParams bulk_max_jobs",
+			      plugin_type);
+	}
+	if ((tmp_ptr = xstrcasestr(params, "bulk_flush_msec="))) {
+		tmp_int = atoi(tmp_ptr + 16);
+		if (tmp_int > 0)
+			bulk_flush_msec = tmp_int;
+		else
+			error("%s: Invalid JobCompParams bulk_flush_msec",
+			      plugin_type);
+	}
+	xfree(params);
+}
+
 /*
  * init() is called when the plugin is loaded, before any other functions
  * are called. Put global initialization here.
  */
 extern int init(void)
 {
+	_read_params();
+	curl_global_init(CURL_GLOBAL_ALL);
 	jobslist = list_create(_jobslist_del);
 	slurm_thread_create(&job_handler_thread, _process_jobs, NULL);
 	slurm_mutex_lock(&pend_jobs_lock);
@@ -950,12 +1293,21 @@ extern int init(void)
 
 extern int fini(void)
 {
+	slurm_mutex_lock(&pend_jobs_lock);
 	thread_shutdown = true;
+	slurm_cond_broadcast(&pend_jobs_cond);
+	slurm_mutex_unlock(&pend_jobs_lock);
 	pthread_join(job_handler_thread, NULL);
 
 	_save_state();
+	if (pend_log_fd >= 0) {
+		(void) close(pend_log_fd);
+		pend_log_fd = -1;
+	}
 	list_destroy(jobslist);
 	xfree(log_url);
+	xfree(bulk_url);
+	curl_global_cleanup();
 	return SLURM_SUCCESS;
 }
 
@@ -979,12 +1331,12 @@ extern int slurm_jobcomp_set_location(char *location)
 		location[strlen(location) - 1] = '\0';
 
 	log_url = xstrdup_printf("%s%s", location, index_type);
+	bulk_url = xstrdup_printf("%s/_bulk", log_url);
 
-	curl_global_init(CURL_GLOBAL_ALL);
 	curl_handle = curl_easy_init();
 	if (curl_handle) {
 		curl_easy_setopt(curl_handle, CURLOPT_URL, log_url);
-		curl_easy_setopt(curl_handle, CURLOPT_NOBODY, 1);
+		curl_easy_setopt(curl_handle, CURLOPT_NOBODY, 1L);
 		res = curl_easy_perform(curl_handle);
 		if (res != CURLE_OK) {
 			error("%s: Could not connect to: %s", plugin_type,
@@ -993,7 +1345,6 @@ extern int slurm_jobcomp_set_location(char *location)
 		}
 		curl_easy_cleanup(curl_handle);
 	}
-	curl_global_cleanup();
 
 	slurm_mutex_lock(&location_mutex);
 	slurm_cond_broadcast(&location_cond);
@@ -39,12 +39,14 @@
 #include <signal.h>
 #include <stdlib.h>
 #include <sys/types.h>
+#include <time.h>
 
 #include "slurm/slurm_errno.h"
 #include "src/common/slurm_xlator.h"
 #include "src/common/forward.h"
 #include "src/common/node_conf.h"
 #include "src/common/slurm_protocol_defs.h"
+#include "src/common/slurm_route.h"
 #include "src/common/slurm_topology.h"
 #include "src/slurmctld/locks.h"
 
@@ -91,10 +93,46 @@ const char plugin_name[]        = "route topology plugin";
 const char plugin_type[]        = "route/topology";
 const uint32_t plugin_version   = SLURM_VERSION_NUMBER;
 
+#define ROUTE_CACHE_SIZE	8	/* split results remembered */
+#define ROUTE_CACHE_TTL		60	/* seconds a split result may be reused */
+#define ROUTE_STALE_RESPONSE	300	/* seconds without node response */
+
+/* Forwarder penalties, lower score is a better forwarder */
+#define ROUTE_SCORE_DOWN	20000	/* unreachable or powered off */
+#define ROUTE_SCORE_STALE	10000	/* not heard from recently */
+#define ROUTE_SCORE_LOAD_MAX	9999	/* cap on per-CPU load percentage */
+
+typedef struct {
+	char *hl_str;		/* input hostlist, NULL if slot unused */
+	uint16_t tree_width;	/* tree_width of the split */
+	time_t node_update;	/* last_node_update at time of split */
+	uint32_t generation;	/* route_generation at time of split */
+	time_t split_time;	/* when the split was made */
+	int count;		/* elements in sp_str */
+	char **sp_str;		/* ranged string of each child hostlist */
+} route_cache_t;
+
 /* Global data */
 static uint64_t debug_flags = 0;
 static pthread_mutex_t route_lock = PTHREAD_MUTEX_INITIALIZER;
 static bool run_in_slurmctld = false;
+static bool route_health = false;	/* TopologyParam=RouteHealth */
+static pthread_mutex_t cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static route_cache_t route_cache[ROUTE_CACHE_SIZE];
+static int route_cache_next = 0;
+static uint32_t route_generation = 0;
+
+static int  _cache_get(char *hl_str, uint16_t tree_width,
+		       hostlist_t **sp_hl, int *count);
+static void _cache_purge(void);
+static void _cache_put(char *hl_str, uint16_t tree_width,
+		       hostlist_t *sp_hl, int count);
+static void _empty_hostlist(hostlist_t hl);
+static uint32_t _node_score(node_record_t *node_ptr, time_t now);
+static void _order_forwarder(hostlist_t *hl_ptr, time_t now);
+static void _order_forwarders(hostlist_t *sp_hl, int count);
+static int  _split_hostlist(hostlist_t hl, hostlist_t **sp_hl,
+			    int *count, uint16_t tree_width);
 
 /*****************************************************************************\
  *  Functions required of all plugins
@@ -105,12 +143,16 @@ static bool run_in_slurmctld = false;
  */
 extern int init(void)
 {
-	char *topotype;
+	char *topotype, *topo_param;
 	topotype = slurm_get_topology_plugin();
 	if (xstrcasecmp(topotype,"topology/tree") != 0) {
 		fatal("ROUTE: route/topology requires topology/tree");
 	}
 	xfree(topotype);
+	topo_param = slurm_get_topology_param();
+	if (xstrcasestr(topo_param, "RouteHealth"))
+		route_health = true;
+	xfree(topo_param);
 	debug_flags = slurm_get_debug_flags();
 	run_in_slurmctld = running_in_slurmctld();
 	verbose("%s loaded", plugin_name);
@@ -122,9 +164,183 @@ extern int init(void)
  */
 extern int fini(void)
 {
+	_cache_purge();
 	return SLURM_SUCCESS;
 }
 
+/* Release every cached split result. Caller must hold cache_lock or be the
+ * only thread left running. */
+static void _cache_purge(void)
+{
+	int i, j;
+
+	for (i = 0; i < ROUTE_CACHE_SIZE; i++) {
+		for (j = 0; j < route_cache[i].count; j++)
+			xfree(route_cache[i].sp_str[j]);
+		xfree(route_cache[i].sp_str);
+		xfree(route_cache[i].hl_str);
+		route_cache[i].count = 0;
+	}
+	route_cache_next = 0;
+}
+
+/*
+ * Rebuild the split of hl_str from the cache if a result made since the
+ * last node state change is available.
+ * RET SLURM_SUCCESS if sp_hl and count were filled from the cache
+ */
+static int _cache_get(char *hl_str, uint16_t tree_width,
+		      hostlist_t **sp_hl, int *count)
+{
+	route_cache_t *cache;
+	time_t now = time(NULL);
+	int i, j, rc = SLURM_ERROR;
+
+	slurm_mutex_lock(&cache_lock);
+	for (i = 0; i < ROUTE_CACHE_SIZE; i++) {
+		cache = &route_cache[i];
+		if (!cache->hl_str || (cache->tree_width != tree_width) ||
+		    (cache->node_update != last_node_update) ||
+		    (cache->generation != route_generation) ||
+		    (difftime(now, cache->split_time) > ROUTE_CACHE_TTL) ||
+		    xstrcmp(cache->hl_str, hl_str))
+			continue;
+		*sp_hl = xmalloc(sizeof(hostlist_t) * cache->count);
+		for (j = 0; j < cache->count; j++)
+			(*sp_hl)[j] = hostlist_create(cache->sp_str[j]);
+		*count = cache->count;
+		rc = SLURM_SUCCESS;
+		break;
+	}
+	slurm_mutex_unlock(&cache_lock);
+
+	return rc;
+}
+
+/*
+ * Remember the split of hl_str. hostlist_create() keeps the order of the
+ * ranged strings, so the forwarder chosen for each child list stays first
+ * when the result is rebuilt.
+ */
+static void _cache_put(char *hl_str, uint16_t tree_width,
+		       hostlist_t *sp_hl, int count)
+{
+	route_cache_t *cache;
+	int j;
+
+	slurm_mutex_lock(&cache_lock);
+	cache = &route_cache[route_cache_next];
+	route_cache_next = (route_cache_next + 1) % ROUTE_CACHE_SIZE;
+	for (j = 0; j < cache->count; j++)
+		xfree(cache->sp_str[j]);
+	xfree(cache->hl_str);
+	cache->hl_str = xstrdup(hl_str);
+	cache->tree_width = tree_width;
+	cache->node_update = last_node_update;
+	cache->generation = route_generation;
+	cache->split_time = time(NULL);
+	cache->count = count;
+	xrealloc(cache->sp_str, sizeof(char *) * count);
+	for (j = 0; j < count; j++)
+		cache->sp_str[j] = hostlist_ranged_string_xmalloc(sp_hl[j]);
+	slurm_mutex_unlock(&cache_lock);
+}
+
+/*
+ * Rate a node as a message forwarder using its last known state, lower is
+ * better. Reachability comes first, then per-CPU load breaks ties. A
+ * draining node still forwards messages and is not penalized. Nodes not in
+ * the node table are treated as unreachable.
+ */
+static uint32_t _node_score(node_record_t *node_ptr, time_t now)
+{
+	uint32_t score = 0, load;
+
+	if (!node_ptr)
+		return ROUTE_SCORE_DOWN;
+	if (IS_NODE_DOWN(node_ptr) || IS_NODE_NO_RESPOND(node_ptr) ||
+	    IS_NODE_FAIL(node_ptr) || IS_NODE_POWER_SAVE(node_ptr) ||
+	    IS_NODE_POWER_UP(node_ptr))
+		return ROUTE_SCORE_DOWN;
+	if (node_ptr->last_response &&
+	    (difftime(now, node_ptr->last_response) > ROUTE_STALE_RESPONSE))
+		score += ROUTE_SCORE_STALE;
+	if (node_ptr->cpus) {
+		load = node_ptr->cpu_load / node_ptr->cpus;
+		score += MIN(load, ROUTE_SCORE_LOAD_MAX);
+	}
+
+	return score;
+}
+
+/* Remove every host from hl */
+static void _empty_hostlist(hostlist_t hl)
+{
+	char *range;
+
+	while ((range = hostlist_shift_range(hl)))
+		free(range);
+}
+
+/*
+ * Move the best forwarder of a child hostlist to its front. The first host
+ * is kept unless another is strictly better, so the order is unchanged
+ * when no node state is known (e.g. in slurmd).
+ */
+static void _order_forwarder(hostlist_t *hl_ptr, time_t now)
+{
+	hostlist_iterator_t itr;
+	hostlist_t new_hl;
+	char *name;
+	uint32_t score, best_score = 0;
+	int inx = 0, best_inx = 0;
+
+	if (hostlist_count(*hl_ptr) < 2)
+		return;
+
+	itr = hostlist_iterator_create(*hl_ptr);
+	while ((name = hostlist_next(itr))) {
+		score = _node_score(find_node_record2(name), now);
+		free(name);
+		if ((inx == 0) || (score < best_score)) {
+			best_score = score;
+			best_inx = inx;
+		}
+		if (best_score == 0)
+			break;	/* can not do better */
+		inx++;
+	}
+	hostlist_iterator_destroy(itr);
+	if (best_inx == 0)
+		return;
+
+	name = hostlist_nth(*hl_ptr, best_inx);
+	hostlist_delete_nth(*hl_ptr, best_inx);
+	new_hl = hostlist_create(name);
+	hostlist_push_list(new_hl, *hl_ptr);
+	hostlist_destroy(*hl_ptr);
+	*hl_ptr = new_hl;
+	if (debug_flags & DEBUG_FLAG_ROUTE)
+		debug("ROUTE: forwarder %s chosen, score %u", name, best_score);
+	free(name);
+}
+
+/* Pick the forwarder of each child hostlist from current node health */
+static void _order_forwarders(hostlist_t *sp_hl, int count)
+{
+	slurmctld_lock_t node_read_lock = { .node = READ_LOCK };
+	time_t now = time(NULL);
+	int i;
+
+	/* Only acquire the slurmctld lock if running as the slurmctld. */
+	if (run_in_slurmctld)
+		lock_slurmctld(node_read_lock);
+	for (i = 0; i < count; i++)
+		_order_forwarder(&sp_hl[i], now);
+	if (run_in_slurmctld)
+		unlock_slurmctld(node_read_lock);
+}
+
 /*****************************************************************************\
  *  API Implementations
 \*****************************************************************************/
@@ -141,10 +357,44 @@ extern int fini(void)
  * Note: created hostlist will have to be freed independently using
  *       hostlist_destroy by the caller.
  * Note: the hostlist_t array will have to be xfree.
+ * Note: with TopologyParam=RouteHealth the first host of each created
+ *       hostlist is the most reachable and least loaded one, and results
+ *       are cached until node state changes.
  */
 extern int route_p_split_hostlist(hostlist_t hl,
 				  hostlist_t** sp_hl,
 				  int* count, uint16_t tree_width)
+{
+	char *hl_str = NULL;
+	int rc;
+
+	if (route_health) {
+		hl_str = hostlist_ranged_string_xmalloc(hl);
+		if (_cache_get(hl_str, tree_width, sp_hl, count) ==
+		    SLURM_SUCCESS) {
+			route_stats_cache_hit();
+			rc = SLURM_SUCCESS;
+			goto fini;
+		}
+	}
+	rc = _split_hostlist(hl, sp_hl, count, tree_width);
+	if ((rc == SLURM_SUCCESS) && route_health) {
+		_order_forwarders(*sp_hl, *count);
+		_cache_put(hl_str, tree_width, *sp_hl, *count);
+	}
+
+fini:
+	/* The per-switch split does not consume hl, callers expect it to */
+	if (rc == SLURM_SUCCESS)
+		_empty_hostlist(hl);
+	xfree(hl_str);
+
+	return rc;
+}
+
+/* Split hl by the child switches of the lowest switch reaching all of it */
+static int _split_hostlist(hostlist_t hl, hostlist_t **sp_hl,
+			   int *count, uint16_t tree_width)
 {
 	int i, j, k, hl_ndx, msg_count, sw_count, lst_count;
 	char  *buf;
@@ -268,7 +518,15 @@ extern int route_p_split_hostlist(hostlist_t hl,
  */
 extern int route_p_reconfigure (void)
 {
+	char *topo_param;
+
 	debug_flags = slurm_get_debug_flags();
+	topo_param = slurm_get_topology_param();
+	route_health = (xstrcasestr(topo_param, "RouteHealth") != NULL);
+	xfree(topo_param);
+	slurm_mutex_lock(&cache_lock);
+	route_generation++;	/* switch table may have been rebuilt */
+	slurm_mutex_unlock(&cache_lock);
 	return SLURM_SUCCESS;
 }
 
@@ -42,6 +42,7 @@
 #include "src/common/proc_args.h"
 #include "src/common/read_config.h"
 #include "src/common/slurm_time.h"
+#include "src/common/slurmdb_col_archive.h"
 #include "src/common/xstring.h"
 #include "sacct.h"
 #include <time.h>
@@ -54,6 +55,7 @@
 #define OPT_LONG_UNITS     0x104
 #define OPT_LONG_FEDR      0x105
 #define OPT_LONG_WHETJOB   0x106
+#define OPT_LONG_ARCHIVE   0x107
 
 #define JOB_HASH_SIZE 1000
 
@@ -327,6 +329,9 @@ sacct [<OPTION>]                                                            \n \
      -A, --accounts:                                                        \n\
 	           Use this comma separated list of accounts to select jobs \n\
                    to display.  By default, all accounts are selected.      \n\
+         --archive-file=file_list:                                          \n\
+	           Read jobs from this comma separated list of columnar     \n\
+                   archive files instead of the database.                   \n\
      -b, --brief:                                                           \n\
 	           Equivalent to '--format=jobstep,state,error'.            \n\
      -c, --completion: Use job completion instead of accounting data.       \n\
@@ -601,13 +606,38 @@ extern int get_data(void)
 	if (params.opt_completion) {
 		jobs = slurmdb_jobcomp_jobs_get(job_cond);
 		return SLURM_SUCCESS;
+	} else if (params.opt_archive_list) {
+		char *file_name;
+		List file_jobs;
+
+		FREE_NULL_LIST(jobs);
+		jobs = list_create(slurmdb_destroy_job_rec);
+		itr = list_iterator_create(params.opt_archive_list);
+		while ((file_name = list_next(itr))) {
+			if (!(file_jobs = slurmdb_col_archive_read_jobs(
+				      file_name, job_cond,
+				      &g_tres_list, &g_qos_list))) {
+				error("Problem reading archive file %s",
+				      file_name);
+				continue;
+			}
+			list_transfer(jobs, file_jobs);
+			FREE_NULL_LIST(file_jobs);
+		}
+		list_iterator_destroy(itr);
+		itr = NULL;
 	} else {
+		FREE_NULL_LIST(jobs);
 		jobs = slurmdb_jobs_get(acct_db_conn, job_cond);
 	}
 
 	if (!jobs)
 		return SLURM_ERROR;
 
+	/* Remember where this chunk ended so the next one starts after it */
+	if (job_cond->chunk_size)
+		slurmdb_job_chunk_set_cursor(job_cond, jobs);
+
 	/*
 	 * Remove duplicate federated jobs. The db will remove duplicates for
 	 * one cluster but not when jobs for multiple clusters are requested.
@@ -681,6 +711,7 @@ extern void parse_command_line(int argc, char **argv)
 	struct stat stat_buf;
 	char *dot = NULL;
 	char *env_val = NULL;
+	char *qos_names = NULL;
 	bool brief_output = false, long_output = false;
 	bool all_users = false;
 	bool all_clusters = false;
@@ -693,6 +724,7 @@ extern void parse_command_line(int argc, char **argv)
                 {"allusers",       no_argument,       0,    'a'},
                 {"accounts",       required_argument, 0,    'A'},
                 {"allocations",    no_argument,       0,    'X'},
+                {"archive-file",   required_argument, 0,    OPT_LONG_ARCHIVE},
                 {"brief",          no_argument,       0,    'b'},
                 {"completion",     no_argument,       0,    'c'},
                 {"constraints",    required_argument, 0,    'C'},
@@ -884,6 +916,12 @@ extern void parse_command_line(int argc, char **argv)
 		case 'l':
 			long_output = true;
 			break;
+		case OPT_LONG_ARCHIVE:
+			if (!params.opt_archive_list)
+				params.opt_archive_list =
+					list_create(xfree_ptr);
+			slurm_addto_char_list(params.opt_archive_list, optarg);
+			break;
 		case OPT_LONG_FEDR:
 			params.opt_federation = true;
 			all_clusters = false;
@@ -931,21 +969,9 @@ extern void parse_command_line(int argc, char **argv)
 				PRINT_FIELDS_PARSABLE_NO_ENDING;
 			break;
 		case 'q':
-			if (!g_qos_list) {
-				slurmdb_qos_cond_t qos_cond;
-				memset(&qos_cond, 0,
-				       sizeof(slurmdb_qos_cond_t));
-				qos_cond.with_deleted = 1;
-				g_qos_list = slurmdb_qos_get(
-					acct_db_conn, &qos_cond);
-			}
-
-			if (!job_cond->qos_list)
-				job_cond->qos_list = list_create(xfree_ptr);
-
-			if (!slurmdb_addto_qos_char_list(job_cond->qos_list,
-							g_qos_list, optarg, 0))
-				fatal("problem processing qos list");
+			/* Resolved once we know where the QOS come from */
+			xstrfmtcat(qos_names, "%s%s", qos_names ? "," : "",
+				   optarg);
 			break;
 		case 'r':
 			if (!job_cond->partition_list)
@@ -1115,6 +1141,13 @@ extern void parse_command_line(int argc, char **argv)
 			exit(1);
 		}
 		xfree(acct_type);
+	} else if (params.opt_archive_list) {
+		/* Archive files are read directly, no database needed */
+		debug2("Reading jobs from archive files");
+		if (job_cond->associd_list || job_cond->reason_list) {
+			error("--associations and --reason can't be used with --archive-file, archives don't store them");
+			exit(1);
+		}
 	} else {
 		if (slurm_acct_storage_init(params.opt_filein) !=
 		    SLURM_SUCCESS) {
@@ -1128,6 +1161,10 @@ extern void parse_command_line(int argc, char **argv)
 				"Slurm accounting storage is disabled\n");
 			exit(1);
 		}
+		/* Only the database backed plugins know about chunks */
+		if (!xstrcmp(acct_type, "accounting_storage/slurmdbd") ||
+		    !xstrcmp(acct_type, "accounting_storage/mysql"))
+			job_cond->chunk_size = SACCT_JOB_CHUNK;
 		xfree(acct_type);
 		acct_db_conn = slurmdb_connection_get();
 		if (errno != SLURM_SUCCESS) {
@@ -1136,9 +1173,33 @@ extern void parse_command_line(int argc, char **argv)
 		}
 	}
 
+	if (qos_names) {
+		if (params.opt_archive_list) {
+			/* Use the QOS stored in the archives */
+			itr = list_iterator_create(params.opt_archive_list);
+			while ((start = list_next(itr)))
+				(void) slurmdb_col_archive_read_dict(
+					start, &g_tres_list, &g_qos_list);
+			list_iterator_destroy(itr);
+		} else if (!g_qos_list) {
+			slurmdb_qos_cond_t qos_cond;
+			memset(&qos_cond, 0, sizeof(slurmdb_qos_cond_t));
+			qos_cond.with_deleted = 1;
+			g_qos_list = slurmdb_qos_get(acct_db_conn, &qos_cond);
+		}
+
+		if (!job_cond->qos_list)
+			job_cond->qos_list = list_create(xfree_ptr);
+
+		if (!slurmdb_addto_qos_char_list(job_cond->qos_list,
+						 g_qos_list, qos_names, 0))
+			fatal("problem processing qos list");
+		xfree(qos_names);
+	}
+
 	/* specific clusters requested? */
 	if (params.opt_federation && !all_clusters && !job_cond->cluster_list &&
-	    !params.opt_local) {
+	    !params.opt_local && !params.opt_archive_list) {
 		/* Test if in federated cluster and if so, get information from
 		 * all clusters in that federation */
 		slurmdb_federation_rec_t *fed = NULL;
@@ -1164,6 +1225,12 @@ extern void parse_command_line(int argc, char **argv)
 		FREE_NULL_LIST(cluster_list);
 		FREE_NULL_LIST(fed_list);
 	}
+	/*
+	 * Duplicate federated jobs can be on any of the clusters so they can
+	 * only be removed with all the jobs in hand.
+	 */
+	if (params.cluster_name && !(job_cond->flags & JOBCOND_FLAG_DUP))
+		job_cond->chunk_size = 0;
 	if (all_clusters) {
 		if (job_cond->cluster_list
 		   && list_count(job_cond->cluster_list)) {
@@ -1177,6 +1244,9 @@ extern void parse_command_line(int argc, char **argv)
 		while ((start = list_next(itr)))
 			debug2("\t: %s", start);
 		list_iterator_destroy(itr);
+	} else if (params.opt_archive_list) {
+		/* Archive files hold the cluster they came from */
+		debug2("Clusters requested:\tall in archive");
 	} else if (!job_cond->cluster_list
 		  || !list_count(job_cond->cluster_list)) {
 		if (!job_cond->cluster_list)
@@ -1495,11 +1565,12 @@ extern void sacct_fini(void)
 
 	if (params.opt_completion)
 		slurmdb_jobcomp_fini();
-	else {
+	else if (!params.opt_archive_list) {
 		slurmdb_connection_close(&acct_db_conn);
 		slurm_acct_storage_fini();
 	}
 	xfree(params.opt_field_list);
 	xfree(params.opt_filein);
+	FREE_NULL_LIST(params.opt_archive_list);
 	slurmdb_destroy_job_cond(params.job_cond);
 }
@@ -182,12 +182,21 @@ int main(int argc, char **argv)
 	switch (op) {
 	case SACCT_LIST:
 		print_fields_header(print_fields_list);
-		if (get_data() == SLURM_ERROR)
-			exit(errno);
-		if (params.opt_completion)
+		if (params.opt_completion) {
+			if (get_data() == SLURM_ERROR)
+				exit(errno);
 			do_list_completion();
-		else
+			break;
+		}
+		/*
+		 * When asking for jobs in chunks get_data() gets the next
+		 * chunk each time, print each one as soon as it is here.
+		 */
+		do {
+			if (get_data() == SLURM_ERROR)
+				exit(errno);
 			do_list();
+		} while (params.job_cond->chunk_size && list_count(jobs));
 		break;
 	case SACCT_HELP:
 		do_help();
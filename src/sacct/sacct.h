@@ -71,6 +71,10 @@
 #define LONG_COMP_FIELDS "jobid,uid,jobname,partition,nnodes,nodelist,state,start,end,timelimit"
 
 #define MAX_PRINTFIELDS 100
+
+/* Number of jobs asked for at a time from the database */
+#define SACCT_JOB_CHUNK 1000
+
 #define FORMAT_STRING_SIZE 34
 
 #define SECONDS_IN_MINUTE 60
@@ -200,6 +204,7 @@ typedef struct {
 	char *cluster_name;	/* Set if in federated cluster */
 	uint32_t convert_flags;	/* --noconvert */
 	slurmdb_job_cond_t *job_cond;
+	List opt_archive_list;	/* --archive-file= */
 	int opt_completion;	/* --completion */
 	bool opt_federation;	/* --federation */
 	char *opt_field_list;	/* --fields= */
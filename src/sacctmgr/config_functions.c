@@ -317,6 +317,19 @@ extern int sacctmgr_list_stats(int argc, char **argv)
 		list_iterator_destroy(itr);
 	}
 
+	if (stats_rec->batch_cnt) {
+		printf("\nBatched messages (DBD_SEND_MULT_MSG)\n");
+		printf("\tBatches:      %u\n", stats_rec->batch_cnt);
+		printf("\tMessages:     %"PRIu64"\n", stats_rec->batch_msg_cnt);
+		printf("\tMean size:    %"PRIu64"\n",
+		       stats_rec->batch_msg_cnt / stats_rec->batch_cnt);
+		printf("\tMax time:     %"PRIu64"\n",
+		       stats_rec->batch_time_max);
+		printf("\tTotal time:   %"PRIu64"\n", stats_rec->batch_time);
+		printf("\tMean time:    %"PRIu64"\n",
+		       stats_rec->batch_time / stats_rec->batch_cnt);
+	}
+
 	if (argc) {
 		if (!xstrncasecmp(argv[0], "ave_time", 2))
 			sort_by_ave_time = true;
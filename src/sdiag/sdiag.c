@@ -130,6 +130,8 @@ static int _print_stats(void)
 	       slurm_ctime2(&buf->job_states_ts), buf->job_states_ts);
 	printf("Jobs pending:   %d\n", buf->jobs_pending);
 	printf("Jobs running:   %d\n", buf->jobs_running);
+	printf("Job records:    %u (%"PRIu64" KB estimated)\n",
+	       buf->job_records_cnt, buf->job_records_mem / 1024);
 
 	printf("\nMain schedule statistics (microseconds):\n");
 	printf("\tLast cycle:   %u\n", buf->schedule_cycle_last);
@@ -147,6 +149,13 @@ static int _print_stats(void)
 		       ((buf->req_time - buf->req_time_start) / 60)));
 	}
 	printf("\tLast queue length: %u\n", buf->schedule_queue_len);
+	printf("\tLast array tasks started: %u\n",
+	       buf->schedule_array_tasks_last);
+	if (buf->schedule_cycle_counter > 0) {
+		printf("\tMean array tasks started: %u\n",
+		       buf->schedule_array_tasks_sum /
+		       buf->schedule_cycle_counter);
+	}
 
 	if (buf->bf_active) {
 		printf("\nBackfilling stats (WARNING: data obtained"
@@ -191,6 +200,34 @@ static int _print_stats(void)
 	printf("\nLatency for 1000 calls to gettimeofday(): %d microseconds\n",
 	       buf->gettimeofday_latency);
 
+	printf("\nAuthentication service calls\n");
+	printf("\tCredentials encoded: %u\n", buf->auth_encode_cnt);
+	printf("\tCredentials decoded: %u\n", buf->auth_decode_cnt);
+	printf("\tDecodes from cache:  %u\n", buf->auth_decode_cached_cnt);
+	if ((buf->req_time - buf->req_time_start) > 0) {
+		printf("\tCalls per second:    %.2f\n",
+		       (double) (buf->auth_encode_cnt + buf->auth_decode_cnt) /
+		       (buf->req_time - buf->req_time_start));
+	}
+
+	printf("\nMessage forwarding route\n");
+	printf("\tHostlist splits:     %u\n", buf->route_split_cnt);
+	if (buf->route_split_cnt > 0) {
+		printf("\tMean split time:     %"PRIu64" microseconds\n",
+		       buf->route_split_usec / buf->route_split_cnt);
+	}
+	printf("\tMax split time:      %u microseconds\n",
+	       buf->route_split_max_usec);
+	printf("\tSplits from cache:   %u\n", buf->route_cache_hits);
+
+	printf("\nNode registration through forwarding tree\n");
+	printf("\tBatches validated:   %u\n", buf->reg_batch_cnt);
+	printf("\tNodes validated:     %u\n", buf->reg_node_cnt);
+	printf("\tLast storm time:     %"PRIu64" microseconds\n",
+	       buf->reg_storm_last_usec);
+	printf("\tMax storm time:      %"PRIu64" microseconds\n",
+	       buf->reg_storm_max_usec);
+
 	printf("\nRemote Procedure Call statistics by message type\n");
 	for (i = 0; i < buf->rpc_type_size; i++) {
 		printf("\t%-40s(%5u) count:%-6u "
@@ -84,6 +84,7 @@
 #include "src/common/macros.h"
 #include "src/common/node_select.h"
 #include "src/common/parse_time.h"
+#include "src/common/slurm_auth.h"
 #include "src/common/slurm_protocol_api.h"
 #include "src/common/slurm_protocol_interface.h"
 #include "src/common/uid.h"
@@ -147,6 +148,10 @@ typedef struct agent_info {
 	slurm_msg_type_t msg_type;	/* RPC to be issued */
 	void **msg_args_pptr;		/* RPC data to be used */
 	uint16_t protocol_version;	/* if set, use this version */
+	uint16_t msg_flags;		/* additional message header flags */
+	void *auth_cred;		/* credential shared by threads */
+	time_t auth_cred_time;		/* when auth_cred was created */
+	struct timeval start_tv;	/* when the agent started */
 } agent_info_t;
 
 typedef struct task_info {
@@ -160,6 +165,8 @@ typedef struct task_info {
 	slurm_msg_type_t msg_type;	/* RPC to be issued */
 	void *msg_args_ptr;		/* ptr to RPC data to be used */
 	uint16_t protocol_version;	/* if set, use this version */
+	uint16_t msg_flags;		/* additional message header flags */
+	void *auth_cred;		/* credential shared by threads */
 } task_info_t;
 
 typedef struct queued_request {
@@ -192,6 +199,7 @@ static int  _setup_requeue(agent_arg_t *agent_arg_ptr, thd_t *thread_ptr,
 			   int *count, int *spot);
 static void _sig_handler(int dummy);
 static void *_thread_per_group_rpc(void *args);
+static void _validate_reg_batch(List reg_list);
 static int   _valid_agent_arg(agent_arg_t *agent_arg_ptr);
 static void *_wdog(void *args);
 
@@ -311,6 +319,21 @@ void *agent(void *args)
 	agent_info_ptr = _make_agent_info(agent_arg_ptr);
 	thread_ptr = agent_info_ptr->thread_struct;
 
+#ifndef HAVE_FRONT_END
+	/*
+	 * Every thread sends to distinct nodes, so they can share one
+	 * credential rather than each calling into the auth plugin. Messages
+	 * to a specific address (srun) may reach one host repeatedly.
+	 */
+	if (!agent_arg_ptr->addr && (agent_info_ptr->thread_count > 1)) {
+		slurm_msg_t msg;
+
+		slurm_msg_t_init(&msg);
+		agent_info_ptr->auth_cred = slurm_msg_auth_create(&msg);
+		agent_info_ptr->auth_cred_time = time(NULL);
+	}
+#endif
+
 	/* start the watchdog thread */
 	slurm_thread_create(&thread_wdog, _wdog, agent_info_ptr);
 
@@ -374,6 +397,8 @@ cleanup:
 	_purge_agent_args(agent_arg_ptr);
 
 	if (agent_info_ptr) {
+		if (agent_info_ptr->auth_cred)
+			(void) g_slurm_auth_destroy(agent_info_ptr->auth_cred);
 		xfree(agent_info_ptr->thread_struct);
 		xfree(agent_info_ptr);
 	}
@@ -445,6 +470,8 @@ static agent_info_t *_make_agent_info(agent_arg_t *agent_arg_ptr)
 	agent_info_ptr->msg_type       = agent_arg_ptr->msg_type;
 	agent_info_ptr->msg_args_pptr  = &agent_arg_ptr->msg_args;
 	agent_info_ptr->protocol_version = agent_arg_ptr->protocol_version;
+	agent_info_ptr->msg_flags      = agent_arg_ptr->msg_flags;
+	gettimeofday(&agent_info_ptr->start_tv, NULL);
 
 	if ((agent_arg_ptr->msg_type != REQUEST_JOB_NOTIFY)	&&
 	    (agent_arg_ptr->msg_type != REQUEST_REBOOT_NODES)	&&
@@ -531,6 +558,11 @@ static task_info_t *_make_task_data(agent_info_t *agent_info_ptr, int inx)
 	task_info_ptr->msg_type          = agent_info_ptr->msg_type;
 	task_info_ptr->msg_args_ptr      = *agent_info_ptr->msg_args_pptr;
 	task_info_ptr->protocol_version  = agent_info_ptr->protocol_version;
+	task_info_ptr->msg_flags         = agent_info_ptr->msg_flags;
+	/* Threads started later use their own credential */
+	if (difftime(time(NULL), agent_info_ptr->auth_cred_time) <
+	    AUTH_SHARED_CRED_TTL)
+		task_info_ptr->auth_cred = agent_info_ptr->auth_cred;
 
 	return task_info_ptr;
 }
@@ -748,6 +780,21 @@ static void _notify_slurmctld_nodes(agent_info_t *agent_ptr,
 
 	/* Update last_response on responding nodes */
 	lock_slurmctld(node_write_lock);
+	if ((agent_ptr->msg_type == REQUEST_NODE_REGISTRATION_STATUS) &&
+	    (agent_ptr->msg_flags & SLURM_MSG_REG_REPLY)) {
+		/* All registrations gathered and validated, end of storm */
+		struct timeval now;
+		uint64_t storm_usec;
+
+		gettimeofday(&now, NULL);
+		storm_usec = ((uint64_t) (now.tv_sec -
+					  agent_ptr->start_tv.tv_sec) *
+			      USEC_IN_SEC) +
+			     now.tv_usec - agent_ptr->start_tv.tv_usec;
+		slurmctld_diag_stats.reg_storm_last_usec = storm_usec;
+		if (slurmctld_diag_stats.reg_storm_max_usec < storm_usec)
+			slurmctld_diag_stats.reg_storm_max_usec = storm_usec;
+	}
 	for (i = 0; i < agent_ptr->thread_count; i++) {
 		char *down_msg, *node_names;
 		slurm_msg_type_t resp_type = RESPONSE_SLURM_RC;
@@ -884,7 +931,7 @@ static void *_thread_per_group_rpc(void *args)
 	state_t thread_state = DSH_NO_RESP;
 	slurm_msg_type_t msg_type = task_ptr->msg_type;
 	bool is_kill_msg, srun_agent;
-	List ret_list = NULL;
+	List ret_list = NULL, reg_list = NULL;
 	ListIterator itr;
 	ret_data_info_t *ret_data_info = NULL;
 	int sig_array[2] = {SIGUSR1, 0};
@@ -930,6 +977,19 @@ static void *_thread_per_group_rpc(void *args)
 
 	msg.msg_type = msg_type;
 	msg.data     = task_ptr->msg_args_ptr;
+	msg.auth_cred_shared = task_ptr->auth_cred;
+	msg.flags |= task_ptr->msg_flags;
+
+	/*
+	 * Periodic node RPCs are the bulk of our connections and are safe to
+	 * resend, so they may reuse a connection to slurmd if configured
+	 * with CommunicationParameters=PersistNodeConns.
+	 */
+	if ((msg_type == REQUEST_PING) ||
+	    (msg_type == REQUEST_NODE_REGISTRATION_STATUS) ||
+	    (msg_type == REQUEST_HEALTH_CHECK) ||
+	    (msg_type == REQUEST_ACCT_GATHER_UPDATE))
+		msg.flags |= SLURM_MSG_KEEP_CONN;
 
 	if (slurmctld_conf.debug_flags & DEBUG_FLAG_AGENT) {
 		info("%s: sending %s to %s", __func__, rpc_num2string(msg_type),
@@ -1025,6 +1085,16 @@ static void *_thread_per_group_rpc(void *args)
 			unlock_slurmctld(job_write_lock);
 		}
 
+		/* SPECIAL CASE: Registration returned through the tree */
+		if (ret_data_info->type == MESSAGE_NODE_REGISTRATION_STATUS) {
+			if (!reg_list) {
+				reg_list = list_create((ListDelF)
+					slurm_free_node_registration_status_msg);
+			}
+			list_append(reg_list, ret_data_info->data);
+			ret_data_info->data = NULL;
+		}
+
 		/* SPECIAL CASE: Record node's CPU load */
 		if (ret_data_info->type == RESPONSE_ACCT_GATHER_UPDATE) {
 			lock_slurmctld(node_write_lock);
@@ -1191,6 +1261,11 @@ static void *_thread_per_group_rpc(void *args)
 	}
 	list_iterator_destroy(itr);
 
+	if (reg_list) {
+		_validate_reg_batch(reg_list);
+		FREE_NULL_LIST(reg_list);
+	}
+
 cleanup:
 	xfree(args);
 	if (!ret_list && (msg_type == REQUEST_SIGNAL_TASKS)) {
@@ -1221,6 +1296,63 @@ cleanup:
 	return (void *) NULL;
 }
 
+/*
+ * Validate node registrations returned through the forwarding tree
+ * (SlurmctldParameters=tree_registration), taking the slurmctld locks once
+ * for the whole batch rather than once per node.
+ */
+static void _validate_reg_batch(List reg_list)
+{
+	/* Locks: Read config, write job, write node, read federation */
+	slurmctld_lock_t job_write_lock = {
+		READ_LOCK, WRITE_LOCK, WRITE_LOCK, NO_LOCK, READ_LOCK };
+	slurm_node_registration_status_msg_t *reg_msg;
+	ListIterator itr;
+	bool newly_up = false, node_up;
+	int rc;
+	DEF_TIMERS;
+
+	START_TIMER;
+	lock_slurmctld(job_write_lock);
+	itr = list_iterator_create(reg_list);
+	while ((reg_msg = list_next(itr))) {
+		if (!(slurmctld_conf.debug_flags & DEBUG_FLAG_NO_CONF_HASH) &&
+		    (reg_msg->hash_val != NO_VAL) &&
+		    (reg_msg->hash_val != slurm_get_hash_val())) {
+			error("Node %s appears to have a different slurm.conf than the slurmctld.",
+			      reg_msg->node_name);
+		}
+		node_up = false;
+#ifdef HAVE_FRONT_END		/* Operates only on front-end */
+		rc = validate_nodes_via_front_end(reg_msg,
+						  SLURM_PROTOCOL_VERSION,
+						  &node_up);
+#else
+		validate_jobs_on_node(reg_msg);
+		rc = validate_node_specs(reg_msg, SLURM_PROTOCOL_VERSION,
+					 &node_up);
+#endif
+		if (rc) {
+			error("%s: node=%s: %s", __func__, reg_msg->node_name,
+			      slurm_strerror(rc));
+		}
+		if (node_up)
+			newly_up = true;
+	}
+	list_iterator_destroy(itr);
+	slurmctld_diag_stats.reg_batch_cnt++;
+	slurmctld_diag_stats.reg_node_cnt += list_count(reg_list);
+	unlock_slurmctld(job_write_lock);
+	END_TIMER2("_validate_reg_batch");
+
+	if (slurmctld_conf.debug_flags & DEBUG_FLAG_AGENT) {
+		info("%s: validated %d node registrations %s",
+		     __func__, list_count(reg_list), TIME_STR);
+	}
+	if (newly_up)
+		queue_job_scheduler();
+}
+
 /*
  * Signal handler.  We are really interested in interrupting hung communictions
  * and causing them to return EINTR. Multiple interrupts might be required.
@@ -1300,6 +1432,7 @@ static void _queue_agent_retry(agent_info_t * agent_info_ptr, int count)
 	agent_arg_ptr->retry = 1;
 	agent_arg_ptr->hostlist = hostlist_create(NULL);
 	agent_arg_ptr->msg_type = agent_info_ptr->msg_type;
+	agent_arg_ptr->msg_flags = agent_info_ptr->msg_flags;
 	agent_arg_ptr->msg_args = *(agent_info_ptr->msg_args_pptr);
 	*(agent_info_ptr->msg_args_pptr) = NULL;
 
@@ -60,6 +60,7 @@ typedef struct agent_arg {
 					 * nodes we are sending to */
 	uint16_t        protocol_version; /* protocol version to use */
 	slurm_msg_type_t msg_type;	/* RPC to be issued */
+	uint16_t	msg_flags;	/* additional message header flags */
 	void		*msg_args;	/* RPC data to be transmitted */
 } agent_arg_t;
 
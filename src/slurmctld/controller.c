@@ -3427,6 +3427,8 @@ static int _foreach_job_running(void *object, void *arg)
 	}
 	if (IS_JOB_RUNNING(job_ptr))
 		slurmctld_diag_stats.jobs_running++;
+	slurmctld_diag_stats.job_records_cnt++;
+	slurmctld_diag_stats.job_records_mem += job_record_mem_size(job_ptr);
 
 	return SLURM_SUCCESS;
 }
@@ -3435,8 +3437,11 @@ static void _update_diag_job_state_counts(void)
 {
 	slurmctld_diag_stats.jobs_running = 0;
 	slurmctld_diag_stats.jobs_pending = 0;
+	slurmctld_diag_stats.job_records_cnt = 0;
+	slurmctld_diag_stats.job_records_mem = 0;
 	slurmctld_diag_stats.job_states_ts = time(NULL);
 	list_for_each(job_list, _foreach_job_running, NULL);
+	slurmctld_diag_stats.job_records_mem += job_str_mem_size();
 }
 
 static void *_wait_primary_prog(void *arg)
@@ -84,6 +84,7 @@
 #include "src/common/tres_frequency.h"
 #include "src/common/uid.h"
 #include "src/common/xassert.h"
+#include "src/common/xhash.h"
 #include "src/common/xstring.h"
 
 #include "src/slurmctld/acct_policy.h"
@@ -149,6 +150,13 @@ typedef struct {
 	int rc;
 } job_overlap_args_t;
 
+/* Entry of job_str_hash, see _job_str_get() */
+typedef struct {
+	char *str;
+	uint32_t len;
+	uint32_t ref_cnt;
+} job_str_t;
+
 /* Global variables */
 List   job_list = NULL;		/* job_record list */
 time_t last_job_update;		/* time of last update to job records */
@@ -173,6 +181,10 @@ static bitstr_t *requeue_exit = NULL;
 static bitstr_t *requeue_exit_hold = NULL;
 static bool     validate_cfgd_licenses = true;
 
+static xhash_t *job_str_hash = NULL;
+static uint64_t job_str_mem = 0;
+static pthread_mutex_t job_str_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 /* Local functions */
 static void _add_job_hash(job_record_t *job_ptr);
 static void _add_job_array_hash(job_record_t *job_ptr);
@@ -244,6 +256,8 @@ static void _set_job_requeue_exit_value(job_record_t *job_ptr);
 static void _signal_batch_job(job_record_t *job_ptr, uint16_t signal,
 			      uint16_t flags);
 static void _signal_job(job_record_t *job_ptr, int signal, uint16_t flags);
+static uint64_t _str_array_size(char **str_array, uint32_t cnt);
+static uint64_t _str_size(const char *str);
 static void _suspend_job(job_record_t *job_ptr, uint16_t op, bool indf_susp);
 static int  _suspend_job_nodes(job_record_t *job_ptr, bool indf_susp);
 static bool _top_priority(job_record_t *job_ptr, uint32_t het_job_offset);
@@ -267,6 +281,82 @@ static int  _write_data_array_to_file(char *file_name, char **data,
 static void _xmit_new_end_time(job_record_t *job_ptr);
 
 
+static void _job_str_id(void *item, const char **key, uint32_t *key_len)
+{
+	job_str_t *job_str = (job_str_t *) item;
+
+	*key = job_str->str;
+	*key_len = job_str->len;
+}
+
+static void _job_str_free(void *item)
+{
+	job_str_t *job_str = (job_str_t *) item;
+
+	xfree(job_str->str);
+	xfree(job_str);
+}
+
+/*
+ * Account, wckey and working directory are usually the same for many jobs,
+ * so job records share one copy of each through a reference counted table.
+ * Those fields must be set with _job_str_get() and released with
+ * _job_str_put(), never with xstrdup() or xfree().
+ * RET shared copy of str
+ */
+static char *_job_str_get(const char *str)
+{
+	job_str_t *job_str;
+	uint32_t len;
+
+	if (!str)
+		return NULL;
+	if (!(len = strlen(str)))
+		return xstrdup(str);	/* xhash can not key on "" */
+
+	slurm_mutex_lock(&job_str_mutex);
+	if (!job_str_hash)
+		job_str_hash = xhash_init(_job_str_id, _job_str_free);
+	if ((job_str = xhash_get(job_str_hash, str, len))) {
+		job_str->ref_cnt++;
+	} else {
+		job_str = xmalloc(sizeof(job_str_t));
+		job_str->str = xstrdup(str);
+		job_str->len = len;
+		job_str->ref_cnt = 1;
+		xhash_add(job_str_hash, job_str);
+		job_str_mem += sizeof(job_str_t) + len + 1;
+	}
+	slurm_mutex_unlock(&job_str_mutex);
+
+	return job_str->str;
+}
+
+/* Release a string returned by _job_str_get() and clear the pointer */
+static void _job_str_put(char **str)
+{
+	job_str_t *job_str;
+
+	if (!*str || !(*str)[0]) {
+		xfree(*str);
+		return;
+	}
+
+	slurm_mutex_lock(&job_str_mutex);
+	job_str = xhash_get_str(job_str_hash, *str);
+	if (job_str && (job_str->str == *str)) {
+		*str = NULL;
+		if (!--job_str->ref_cnt) {
+			job_str_mem -= sizeof(job_str_t) + job_str->len + 1;
+			xhash_delete(job_str_hash, job_str->str, job_str->len);
+		}
+	}
+	slurm_mutex_unlock(&job_str_mutex);
+
+	/* Not from the table (e.g. set by a plugin), owned by the record */
+	xfree(*str);
+}
+
 static char *_get_mail_user(const char *user_name, uid_t user_id)
 {
 	char *mail_user = NULL;
@@ -669,6 +759,7 @@ static void _delete_job_details(job_record_t *job_entry)
 	FREE_NULL_BITMAP(job_entry->details->exc_node_bitmap);
 	xfree(job_entry->details->exc_nodes);
 	xfree(job_entry->details->extra);
+	feature_cache_free(&job_entry->details->feature_cache);
 	FREE_NULL_LIST(job_entry->details->feature_list);
 	xfree(job_entry->details->features);
 	xfree(job_entry->details->cluster_features);
@@ -678,7 +769,7 @@ static void _delete_job_details(job_record_t *job_entry)
 	xfree(job_entry->details->std_out);
 	FREE_NULL_BITMAP(job_entry->details->req_node_bitmap);
 	xfree(job_entry->details->req_nodes);
-	xfree(job_entry->details->work_dir);
+	_job_str_put(&job_entry->details->work_dir);
 	xfree(job_entry->details->x11_magic_cookie);
 	xfree(job_entry->details->x11_target);
 	xfree(job_entry->details);	/* Must be last */
@@ -2238,10 +2329,10 @@ static int _load_job_state(Buf buffer, uint16_t protocol_version)
 	job_ptr->tres_fmt_req_str = tres_fmt_req_str;
 	tres_fmt_req_str = NULL;
 
-	xfree(job_ptr->account);
-	job_ptr->account = account;
-	xstrtolower(job_ptr->account);
-	account          = NULL;  /* reused, nothing left to free */
+	_job_str_put(&job_ptr->account);
+	xstrtolower(account);
+	job_ptr->account = _job_str_get(account);
+	xfree(account);
 	xfree(job_ptr->alloc_node);
 	job_ptr->alloc_node   = alloc_node;
 	alloc_node             = NULL;	/* reused, nothing left to free */
@@ -2311,10 +2402,10 @@ static int _load_job_state(Buf buffer, uint16_t protocol_version)
 	xfree(job_ptr->user_name);
 	job_ptr->user_name    = user_name;
 	user_name             = NULL;   /* reused, nothing left to free */
-	xfree(job_ptr->wckey);		/* in case duplicate record */
-	job_ptr->wckey        = wckey;
-	xstrtolower(job_ptr->wckey);
-	wckey                 = NULL;	/* reused, nothing left to free */
+	_job_str_put(&job_ptr->wckey);	/* in case duplicate record */
+	xstrtolower(wckey);
+	job_ptr->wckey = _job_str_get(wckey);
+	xfree(wckey);
 	xfree(job_ptr->network);
 	job_ptr->network      = network;
 	network               = NULL;  /* reused, nothing left to free */
@@ -2838,7 +2929,7 @@ static int _load_job_details(job_record_t *job_ptr, Buf buffer,
 	xfree(job_ptr->details->mem_bind);
 	xfree(job_ptr->details->std_out);
 	xfree(job_ptr->details->req_nodes);
-	xfree(job_ptr->details->work_dir);
+	_job_str_put(&job_ptr->details->work_dir);
 
 	/* now put the details into the job record */
 	job_ptr->details->acctg_freq = acctg_freq;
@@ -2892,7 +2983,8 @@ static int _load_job_details(job_record_t *job_ptr, Buf buffer,
 	job_ptr->details->submit_time = submit_time;
 	job_ptr->details->task_dist = task_dist;
 	job_ptr->details->whole_node = whole_node;
-	job_ptr->details->work_dir = work_dir;
+	job_ptr->details->work_dir = _job_str_get(work_dir);
+	xfree(work_dir);
 
 	return SLURM_SUCCESS;
 
@@ -4443,7 +4535,7 @@ extern job_record_t *job_array_split(job_record_t *job_ptr)
 	slurm_copy_priority_factors_object(job_ptr_pend->prio_factors,
 					   job_ptr->prio_factors);
 
-	job_ptr_pend->account = xstrdup(job_ptr->account);
+	job_ptr_pend->account = _job_str_get(job_ptr->account);
 	job_ptr_pend->admin_comment = xstrdup(job_ptr->admin_comment);
 	job_ptr_pend->alias_list = xstrdup(job_ptr->alias_list);
 	job_ptr_pend->alloc_node = xstrdup(job_ptr->alloc_node);
@@ -4555,7 +4647,7 @@ extern job_record_t *job_array_split(job_record_t *job_ptr)
 	job_ptr_pend->tres_per_task = xstrdup(job_ptr->tres_per_task);
 
 	job_ptr_pend->user_name = xstrdup(job_ptr->user_name);
-	job_ptr_pend->wckey = xstrdup(job_ptr->wckey);
+	job_ptr_pend->wckey = _job_str_get(job_ptr->wckey);
 	job_ptr_pend->deadline = job_ptr->deadline;
 
 	job_details = job_ptr->details;
@@ -4597,6 +4689,7 @@ extern job_record_t *job_array_split(job_record_t *job_ptr)
 			bit_copy(job_details->exc_node_bitmap);
 	}
 	details_new->exc_nodes = xstrdup(job_details->exc_nodes);
+	details_new->feature_cache = NULL;
 	details_new->feature_list =
 		feature_list_copy(job_details->feature_list);
 	details_new->features = xstrdup(job_details->features);
@@ -4616,7 +4709,7 @@ extern job_record_t *job_array_split(job_record_t *job_ptr)
 	details_new->std_err = xstrdup(job_details->std_err);
 	details_new->std_in = xstrdup(job_details->std_in);
 	details_new->std_out = xstrdup(job_details->std_out);
-	details_new->work_dir = xstrdup(job_details->work_dir);
+	details_new->work_dir = _job_str_get(job_details->work_dir);
 	details_new->x11_magic_cookie = xstrdup(job_details->x11_magic_cookie);
 
 	if (job_ptr->fed_details) {
@@ -8030,7 +8123,7 @@ static int _copy_job_desc_to_job_record(job_desc_msg_t *job_desc,
 	}
 
 	job_ptr->name = xstrdup(job_desc->name);
-	job_ptr->wckey = xstrdup(job_desc->wckey);
+	job_ptr->wckey = _job_str_get(job_desc->wckey);
 
 	/* Since this is only used in the slurmctld, copy it now. */
 	job_ptr->tres_req_cnt = job_desc->tres_req_cnt;
@@ -8051,7 +8144,7 @@ static int _copy_job_desc_to_job_record(job_desc_msg_t *job_desc,
 		job_ptr->time_min = job_desc->time_min;
 	job_ptr->alloc_sid  = job_desc->alloc_sid;
 	job_ptr->alloc_node = xstrdup(job_desc->alloc_node);
-	job_ptr->account    = xstrdup(job_desc->account);
+	job_ptr->account    = _job_str_get(job_desc->account);
 	job_ptr->batch_features = xstrdup(job_desc->batch_features);
 	job_ptr->burst_buffer = xstrdup(job_desc->burst_buffer);
 	job_ptr->network    = xstrdup(job_desc->network);
@@ -8218,7 +8311,7 @@ static int _copy_job_desc_to_job_record(job_desc_msg_t *job_desc,
 	detail_ptr->std_err = xstrdup(job_desc->std_err);
 	detail_ptr->std_in = xstrdup(job_desc->std_in);
 	detail_ptr->std_out = xstrdup(job_desc->std_out);
-	detail_ptr->work_dir = xstrdup(job_desc->work_dir);
+	detail_ptr->work_dir = _job_str_get(job_desc->work_dir);
 	if (job_desc->begin_time > time(NULL))
 		detail_ptr->begin_time = job_desc->begin_time;
 	job_ptr->select_jobinfo =
@@ -9294,7 +9387,7 @@ static void _list_delete_job(void *job_entry)
 	}
 
 	_delete_job_details(job_ptr);
-	xfree(job_ptr->account);
+	_job_str_put(&job_ptr->account);
 	xfree(job_ptr->admin_comment);
 	xfree(job_ptr->alias_list);
 	xfree(job_ptr->alloc_node);
@@ -9367,7 +9460,7 @@ static void _list_delete_job(void *job_entry)
 	step_list_purge(job_ptr);
 	select_g_select_jobinfo_free(job_ptr->select_jobinfo);
 	xfree(job_ptr->user_name);
-	xfree(job_ptr->wckey);
+	_job_str_put(&job_ptr->wckey);
 	if (job_array_size > job_count) {
 		error("job_count underflow");
 		job_count = 0;
@@ -12420,8 +12513,8 @@ static int _update_job(job_record_t *job_ptr, job_desc_msg_t *job_specs,
 
 	if (new_assoc_ptr) {
 		/* Change account/association */
-		xfree(job_ptr->account);
-		job_ptr->account = xstrdup(new_assoc_ptr->acct);
+		_job_str_put(&job_ptr->account);
+		job_ptr->account = _job_str_get(new_assoc_ptr->acct);
 		job_ptr->assoc_id = new_assoc_ptr->id;
 		job_ptr->assoc_ptr = new_assoc_ptr;
 
@@ -13120,12 +13213,14 @@ static int _update_job(job_record_t *job_ptr, job_desc_msg_t *job_specs,
 					   job_ptr);
 				xfree(old_features);
 				FREE_NULL_LIST(old_list);
+				feature_cache_free(&detail_ptr->feature_cache);
 			}
 		} else {
 			sched_info("%s: cleared features for %pJ", __func__,
 				   job_ptr);
 			xfree(detail_ptr->features);
 			FREE_NULL_LIST(detail_ptr->feature_list);
+			feature_cache_free(&detail_ptr->feature_cache);
 		}
 	}
 	if (error_code != SLURM_SUCCESS)
@@ -13222,8 +13317,8 @@ static int _update_job(job_record_t *job_ptr, job_desc_msg_t *job_specs,
 			error_code = ESLURM_JOB_NOT_PENDING;
 			goto fini;
 		} else if (detail_ptr) {
-			xfree(detail_ptr->work_dir);
-			detail_ptr->work_dir = xstrdup(job_specs->work_dir);
+			_job_str_put(&detail_ptr->work_dir);
+			detail_ptr->work_dir = _job_str_get(job_specs->work_dir);
 			sched_info("%s: setting work_dir to %s for %pJ",
 				   __func__, detail_ptr->work_dir, job_ptr);
 			update_accounting = true;
@@ -15387,6 +15482,8 @@ void job_fini (void)
 	FREE_NULL_LIST(purge_files_list);
 	FREE_NULL_BITMAP(requeue_exit);
 	FREE_NULL_BITMAP(requeue_exit_hold);
+	xhash_free(job_str_hash);
+	job_str_mem = 0;
 }
 
 /* Record the start of one job array task */
@@ -15426,6 +15523,133 @@ extern bool job_array_start_test(job_record_t *job_ptr)
 	return true;
 }
 
+static uint64_t _str_size(const char *str)
+{
+	if (!str)
+		return 0;
+	return strlen(str) + 1;
+}
+
+static uint64_t _str_array_size(char **str_array, uint32_t cnt)
+{
+	uint64_t size = 0;
+	int i;
+
+	if (!str_array)
+		return 0;
+	for (i = 0; i < cnt; i++)
+		size += _str_size(str_array[i]);
+	size += sizeof(char *) * (cnt + 1);
+
+	return size;
+}
+
+/*
+ * Return an estimate of the memory held by a job record: the record, its
+ * details and array structures, the strings they reference and the step
+ * records. Lists, bitmaps and plugin specific data are not included, nor
+ * are the strings shared with other records (see job_str_mem_size()).
+ */
+extern uint64_t job_record_mem_size(job_record_t *job_ptr)
+{
+	struct job_details *details = job_ptr->details;
+	uint64_t size = sizeof(job_record_t);
+
+	size += _str_size(job_ptr->admin_comment);
+	size += _str_size(job_ptr->alias_list);
+	size += _str_size(job_ptr->alloc_node);
+	size += _str_size(job_ptr->batch_features);
+	size += _str_size(job_ptr->batch_host);
+	size += _str_size(job_ptr->burst_buffer);
+	size += _str_size(job_ptr->burst_buffer_state);
+	size += _str_size(job_ptr->clusters);
+	size += _str_size(job_ptr->comment);
+	size += _str_size(job_ptr->cpus_per_tres);
+	size += _str_size(job_ptr->gres_alloc);
+	size += _str_size(job_ptr->gres_req);
+	size += _str_size(job_ptr->gres_used);
+	size += _str_size(job_ptr->het_job_id_set);
+	size += _str_size(job_ptr->licenses);
+	size += _str_size(job_ptr->mail_user);
+	size += _str_size(job_ptr->mem_per_tres);
+	size += _str_size(job_ptr->mcs_label);
+	size += _str_size(job_ptr->name);
+	size += _str_size(job_ptr->network);
+	size += _str_size(job_ptr->nodes);
+	size += _str_size(job_ptr->nodes_completing);
+	size += _str_size(job_ptr->origin_cluster);
+	size += _str_size(job_ptr->partition);
+	size += _str_size(job_ptr->resv_name);
+	size += _str_size(job_ptr->resp_host);
+	size += _str_size(job_ptr->sched_nodes);
+	size += _str_size(job_ptr->state_desc);
+	size += _str_size(job_ptr->system_comment);
+	size += _str_size(job_ptr->tres_alloc_str);
+	size += _str_size(job_ptr->tres_bind);
+	size += _str_size(job_ptr->tres_fmt_alloc_str);
+	size += _str_size(job_ptr->tres_fmt_req_str);
+	size += _str_size(job_ptr->tres_freq);
+	size += _str_size(job_ptr->tres_per_job);
+	size += _str_size(job_ptr->tres_per_node);
+	size += _str_size(job_ptr->tres_per_socket);
+	size += _str_size(job_ptr->tres_per_task);
+	size += _str_size(job_ptr->tres_req_str);
+	size += _str_size(job_ptr->user_name);
+	size += _str_array_size(job_ptr->gres_detail_str,
+				job_ptr->gres_detail_cnt);
+	size += _str_array_size(job_ptr->spank_job_env,
+				job_ptr->spank_job_env_size);
+	if (job_ptr->tres_req_cnt)
+		size += sizeof(uint64_t) * slurmctld_tres_cnt;
+	if (job_ptr->tres_alloc_cnt)
+		size += sizeof(uint64_t) * slurmctld_tres_cnt;
+
+	if (job_ptr->array_recs) {
+		size += sizeof(job_array_struct_t);
+		size += _str_size(job_ptr->array_recs->task_id_str);
+	}
+	if (job_ptr->step_list) {
+		size += sizeof(step_record_t) *
+			list_count(job_ptr->step_list);
+	}
+
+	if (details) {
+		size += sizeof(struct job_details);
+		size += _str_size(details->acctg_freq);
+		size += _str_size(details->cluster_features);
+		size += _str_size(details->cpu_bind);
+		size += _str_size(details->dependency);
+		size += _str_size(details->exc_nodes);
+		size += _str_size(details->features);
+		size += _str_size(details->mem_bind);
+		size += _str_size(details->orig_dependency);
+		size += _str_size(details->req_nodes);
+		size += _str_size(details->std_err);
+		size += _str_size(details->std_in);
+		size += _str_size(details->std_out);
+		size += _str_size(details->x11_magic_cookie);
+		size += _str_size(details->x11_target);
+		size += _str_array_size(details->argv, details->argc);
+		size += _str_array_size(details->env_sup, details->env_cnt);
+		if (details->mc_ptr)
+			size += sizeof(multi_core_data_t);
+	}
+
+	return size;
+}
+
+/* Return the memory held by the strings job records share, in bytes */
+extern uint64_t job_str_mem_size(void)
+{
+	uint64_t size;
+
+	slurm_mutex_lock(&job_str_mutex);
+	size = job_str_mem;
+	slurm_mutex_unlock(&job_str_mutex);
+
+	return size;
+}
+
 static void _job_array_comp(job_record_t *job_ptr, bool was_running,
 			    bool requeue)
 {
@@ -17310,9 +17534,9 @@ extern int update_job_wckey(char *module, job_record_t *job_ptr,
 		}
 	}
 
-	xfree(job_ptr->wckey);
+	_job_str_put(&job_ptr->wckey);
 	if (wckey_rec.name && wckey_rec.name[0] != '\0') {
-		job_ptr->wckey = xstrdup(wckey_rec.name);
+		job_ptr->wckey = _job_str_get(wckey_rec.name);
 		info("%s: setting wckey to %s for %pJ",
 		     module, wckey_rec.name, job_ptr);
 	} else {
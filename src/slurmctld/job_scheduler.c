@@ -716,7 +716,7 @@ static bool _failed_partition(part_record_t *part_ptr,
 	return false;
 }
 
-static void _do_diag_stats(long delta_t)
+static void _do_diag_stats(long delta_t, uint32_t array_task_cnt)
 {
 	if (delta_t > slurmctld_diag_stats.schedule_cycle_max)
 		slurmctld_diag_stats.schedule_cycle_max = delta_t;
@@ -724,6 +724,8 @@ static void _do_diag_stats(long delta_t)
 	slurmctld_diag_stats.schedule_cycle_sum += delta_t;
 	slurmctld_diag_stats.schedule_cycle_last = delta_t;
 	slurmctld_diag_stats.schedule_cycle_counter++;
+	slurmctld_diag_stats.schedule_array_tasks_last = array_task_cnt;
+	slurmctld_diag_stats.schedule_array_tasks_sum += array_task_cnt;
 }
 
 /* Return true of all partitions have the same priority, otherwise false. */
@@ -982,7 +984,7 @@ static int _schedule(uint32_t job_limit)
 	List job_queue = NULL;
 	int failed_part_cnt = 0, failed_resv_cnt = 0, job_cnt = 0;
 	int error_code, i, j, part_cnt, time_limit, pend_time;
-	uint32_t job_depth = 0, array_task_id;
+	uint32_t job_depth = 0, array_task_id, array_task_cnt = 0;
 	job_queue_rec_t *job_queue_rec;
 	job_record_t *job_ptr = NULL;
 	part_record_t *part_ptr, **failed_parts = NULL, *skip_part_ptr = NULL;
@@ -993,7 +995,7 @@ static int _schedule(uint32_t job_limit)
 	/* Locks: Read config, write job, write node, read partition */
 	slurmctld_lock_t job_write_lock =
 		{ READ_LOCK, WRITE_LOCK, WRITE_LOCK, READ_LOCK, READ_LOCK };
-	bool is_job_array_head;
+	bool is_job_array_head, array_task_next = false;
 	static time_t sched_update = 0;
 	static bool fifo_sched = false;
 	static bool assoc_limit_stop = false;
@@ -1446,6 +1448,7 @@ next_part:
 			is_job_array_head = true;
 		else
 			is_job_array_head = false;
+		array_task_next = false;
 
 next_task:
 		if ((time(NULL) - sched_start) >= sched_timeout) {
@@ -1471,7 +1474,13 @@ next_task:
 			if (!job_array_start_test(job_ptr))
 				continue;
 		}
-		if (max_jobs_per_part) {
+		/*
+		 * Further tasks of a job array which just started a task are
+		 * not charged against the queue depth limits, so that a large
+		 * array can fill idle resources in a single pass. They remain
+		 * bounded by max_sched_time and sched_max_job_start.
+		 */
+		if (max_jobs_per_part && !array_task_next) {
 			bool skip_job = false;
 			for (j = 0; j < part_cnt; j++) {
 				if (sched_part_ptr[j] != job_ptr->part_ptr)
@@ -1494,7 +1503,7 @@ next_task:
 				continue;
 			}
 		}
-		if (job_depth++ > job_limit) {
+		if (!array_task_next && (job_depth++ > job_limit)) {
 			sched_debug("already tested %u jobs, breaking out",
 				    job_depth);
 			break;
@@ -1812,13 +1821,17 @@ skip_start:
 				launch_job(job_ptr);
 			rebuild_job_part_list(job_ptr);
 			job_cnt++;
+			if (job_ptr->array_task_id != NO_VAL)
+				array_task_cnt++;
 			if (is_job_array_head &&
 			    (job_ptr->array_task_id != NO_VAL)) {
 				/* Try starting another task of the job array */
 				job_ptr = find_job_record(job_ptr->array_job_id);
 				if (job_ptr && IS_JOB_PENDING(job_ptr) &&
-				    (bb_g_job_test_stage_in(job_ptr,false) ==1))
+				    (bb_g_job_test_stage_in(job_ptr,false) ==1)) {
+					array_task_next = true;
 					goto next_task;
+				}
 			}
 			continue;
 		} else if ((error_code ==
@@ -1938,7 +1951,7 @@ fail_this_part:	if (fail_by_part) {
 	unlock_slurmctld(job_write_lock);
 	END_TIMER2("schedule");
 
-	_do_diag_stats(DELTA_TIMER);
+	_do_diag_stats(DELTA_TIMER, array_task_cnt);
 
 out:
 #if HAVE_SYS_PRCTL_H
@@ -5139,6 +5152,21 @@ extern void feature_list_delete(void *x)
 	xfree(feature_ptr);
 }
 
+/*
+ * Free a job's cached feature expression evaluation
+ */
+extern void feature_cache_free(job_feature_cache_t **cache_pptr)
+{
+	job_feature_cache_t *cache = *cache_pptr;
+
+	if (!cache)
+		return;
+	FREE_NULL_BITMAP(cache->active_bitmap);
+	FREE_NULL_BITMAP(cache->avail_bitmap);
+	xfree(cache);
+	*cache_pptr = NULL;
+}
+
 static int _match_job_feature(void *x, void *key)
 {
 	job_feature_t *feat = (job_feature_t *) x;
@@ -3534,6 +3534,20 @@ void msg_to_slurmd (slurm_msg_type_t msg_type)
 	}
 #endif
 
+	/*
+	 * With tree_registration, slurmd does not register by itself after
+	 * reconfiguring; the next ping cycle gathers all registrations through
+	 * the forwarding tree instead. slurmd holds its reply until the
+	 * reconfigure is applied, and registers by itself should no request
+	 * come (e.g. the node was not responding).
+	 */
+	if ((msg_type == REQUEST_RECONFIGURE) && kill_agent_args->node_count &&
+	    (kill_agent_args->protocol_version == SLURM_PROTOCOL_VERSION) &&
+	    ping_nodes_tree_reg()) {
+		kill_agent_args->msg_flags |= SLURM_MSG_REG_REPLY;
+		ping_nodes_register_all();
+	}
+
 	if (kill_agent_args->node_count == 0) {
 		hostlist_destroy(kill_agent_args->hostlist);
 		xfree (kill_agent_args);
@@ -3594,6 +3608,12 @@ void push_reconfig_to_slurmd(void)
 		}
 	}
 
+	/* See msg_to_slurmd() */
+	if (new_args->node_count && ping_nodes_tree_reg()) {
+		new_args->msg_flags |= SLURM_MSG_REG_REPLY;
+		ping_nodes_register_all();
+	}
+
 	if (new_args->node_count == 0) {
 		hostlist_destroy(new_args->hostlist);
 		slurm_free_config_response_msg(config);
@@ -637,6 +637,7 @@ extern void deallocate_nodes(job_record_t *job_ptr, bool timeout,
  * For every element in the feature_list, identify the nodes with that feature
  * either active or available and set the feature_list's node_bitmap_active and
  * node_bitmap_avail fields accordingly.
+ * Bitmaps built since the last change to the node feature lists are reused.
  */
 extern void find_feature_nodes(List feature_list, bool can_reboot)
 {
@@ -648,6 +649,13 @@ extern void find_feature_nodes(List feature_list, bool can_reboot)
 		return;
 	feat_iter = list_iterator_create(feature_list);
 	while ((job_feat_ptr = list_next(feat_iter))) {
+		if ((job_feat_ptr->feature_gen == node_features_gen) &&
+		    (job_feat_ptr->can_reboot == can_reboot) &&
+		    job_feat_ptr->node_bitmap_active &&
+		    job_feat_ptr->node_bitmap_avail)
+			continue;	/* Bitmaps still current */
+		job_feat_ptr->feature_gen = node_features_gen;
+		job_feat_ptr->can_reboot = can_reboot;
 		FREE_NULL_BITMAP(job_feat_ptr->node_bitmap_active);
 		FREE_NULL_BITMAP(job_feat_ptr->node_bitmap_avail);
 		node_feat_ptr = list_find_first(active_feature_list,
@@ -3426,17 +3434,19 @@ extern int list_find_feature(void *feature_entry, void *key)
 }
 
 /*
- * valid_feature_counts - validate a job's features can be satisfied
- *	by the selected nodes (NOTE: does not process XOR or XAND operators)
+ * _eval_feature_expr - evaluate a job's AND/OR feature expression against
+ *	all nodes (NOTE: does not process XOR or XAND operators)
  * IN job_ptr - job to operate on
  * IN use_active - if set, then only consider nodes with the identified features
  *	active, otherwise use available features
- * IN/OUT node_bitmap - nodes available for use, clear if unusable
+ * IN/OUT result_bitmap - set to nodes satisfying the expression
  * OUT has_xor - set if XOR/XAND found in feature expression
- * RET true if valid, false otherwise
+ * OUT have_count - set if any feature has a node count
+ * NOTE: find_feature_nodes() must be called first
  */
-extern bool valid_feature_counts(job_record_t *job_ptr, bool use_active,
-				 bitstr_t *node_bitmap, bool *has_xor)
+static void _eval_feature_expr(job_record_t *job_ptr, bool use_active,
+			       bitstr_t *result_bitmap, bool *has_xor,
+			       bool *have_count)
 {
 	struct job_details *detail_ptr = job_ptr->details;
 	ListIterator job_feat_iter;
@@ -3445,19 +3455,11 @@ extern bool valid_feature_counts(job_record_t *job_ptr, bool use_active,
 	int last_paren_cnt = 0;
 	bitstr_t *feature_bitmap, *paren_bitmap = NULL;
 	bitstr_t *tmp_bitmap, *work_bitmap;
-	bool have_count = false, rc = true, user_update;
-
-	xassert(detail_ptr);
-	xassert(node_bitmap);
-	xassert(has_xor);
 
 	*has_xor = false;
-	if (detail_ptr->feature_list == NULL)	/* no constraints */
-		return rc;
-
-	user_update = node_features_g_user_update(job_ptr->user_id);
-	find_feature_nodes(detail_ptr->feature_list, user_update);
-	feature_bitmap = bit_copy(node_bitmap);
+	*have_count = false;
+	feature_bitmap = result_bitmap;
+	bit_set_all(feature_bitmap);
 	work_bitmap = feature_bitmap;
 	job_feat_iter = list_iterator_create(detail_ptr->feature_list);
 	while ((job_feat_ptr = list_next(job_feat_iter))) {
@@ -3476,7 +3478,8 @@ extern bool valid_feature_counts(job_record_t *job_ptr, bool use_active,
 				}
 				bit_free(paren_bitmap);
 			}
-			paren_bitmap = bit_copy(node_bitmap);
+			paren_bitmap = bit_alloc(bit_size(result_bitmap));
+			bit_set_all(paren_bitmap);
 			work_bitmap = paren_bitmap;
 		}
 
@@ -3507,7 +3510,7 @@ extern bool valid_feature_counts(job_record_t *job_ptr, bool use_active,
 				bit_clear_all(work_bitmap);
 		}
 		if (job_feat_ptr->count)
-			have_count = true;
+			*have_count = true;
 
 		if (last_paren_cnt > job_feat_ptr->paren) {
 			/* End of expression in parenthesis */
@@ -3539,10 +3542,86 @@ extern bool valid_feature_counts(job_record_t *job_ptr, bool use_active,
 
 	}
 	list_iterator_destroy(job_feat_iter);
-	if (!have_count)
-		bit_and(node_bitmap, work_bitmap);
-	FREE_NULL_BITMAP(feature_bitmap);
+	if (work_bitmap != feature_bitmap)	/* unbalanced parenthesis */
+		bit_copybits(feature_bitmap, work_bitmap);
 	FREE_NULL_BITMAP(paren_bitmap);
+}
+
+/*
+ * _get_feature_cache - return a job's evaluated feature expression, building
+ *	it if the node feature lists changed since it was last evaluated
+ * IN job_ptr - job to operate on
+ * IN can_reboot - if set, the user can change node features
+ * RET the job's feature cache, owned by the job details
+ */
+static job_feature_cache_t *_get_feature_cache(job_record_t *job_ptr,
+					       bool can_reboot)
+{
+	struct job_details *detail_ptr = job_ptr->details;
+	job_feature_cache_t *cache = detail_ptr->feature_cache;
+
+	if (cache && (cache->feature_gen == node_features_gen) &&
+	    (cache->can_reboot == can_reboot) &&
+	    (bit_size(cache->active_bitmap) == node_record_count))
+		return cache;
+
+	if (!cache) {
+		cache = xmalloc(sizeof(job_feature_cache_t));
+		detail_ptr->feature_cache = cache;
+	}
+	if (!cache->active_bitmap ||
+	    (bit_size(cache->active_bitmap) != node_record_count)) {
+		FREE_NULL_BITMAP(cache->active_bitmap);
+		FREE_NULL_BITMAP(cache->avail_bitmap);
+		cache->active_bitmap = bit_alloc(node_record_count);
+		cache->avail_bitmap = bit_alloc(node_record_count);
+	}
+
+	find_feature_nodes(detail_ptr->feature_list, can_reboot);
+	_eval_feature_expr(job_ptr, true, cache->active_bitmap,
+			   &cache->has_xor, &cache->has_count);
+	_eval_feature_expr(job_ptr, false, cache->avail_bitmap,
+			   &cache->has_xor, &cache->has_count);
+	cache->can_reboot = can_reboot;
+	cache->feature_gen = node_features_gen;
+
+	return cache;
+}
+
+/*
+ * valid_feature_counts - validate a job's features can be satisfied
+ *	by the selected nodes (NOTE: does not process XOR or XAND operators)
+ * IN job_ptr - job to operate on
+ * IN use_active - if set, then only consider nodes with the identified features
+ *	active, otherwise use available features
+ * IN/OUT node_bitmap - nodes available for use, clear if unusable
+ * OUT has_xor - set if XOR/XAND found in feature expression
+ * RET true if valid, false otherwise
+ */
+extern bool valid_feature_counts(job_record_t *job_ptr, bool use_active,
+				 bitstr_t *node_bitmap, bool *has_xor)
+{
+	struct job_details *detail_ptr = job_ptr->details;
+	job_feature_cache_t *cache;
+	bool rc = true, user_update;
+
+	xassert(detail_ptr);
+	xassert(node_bitmap);
+	xassert(has_xor);
+
+	*has_xor = false;
+	if (detail_ptr->feature_list == NULL)	/* no constraints */
+		return rc;
+
+	user_update = node_features_g_user_update(job_ptr->user_id);
+	cache = _get_feature_cache(job_ptr, user_update);
+	*has_xor = cache->has_xor;
+	if (!cache->has_count) {
+		if (use_active)
+			bit_and(node_bitmap, cache->active_bitmap);
+		else
+			bit_and(node_bitmap, cache->avail_bitmap);
+	}
 #if _DEBUG
 {
 	char * tmp;
@@ -46,6 +46,7 @@
 #include "src/common/hostlist.h"
 #include "src/common/node_select.h"
 #include "src/common/read_config.h"
+#include "src/common/xstring.h"
 #include "src/slurmctld/agent.h"
 #include "src/slurmctld/front_end.h"
 #include "src/slurmctld/ping_nodes.h"
@@ -60,6 +61,7 @@
 static pthread_mutex_t lock_mutex = PTHREAD_MUTEX_INITIALIZER;
 static int ping_count = 0;
 static time_t ping_start = 0;
+static bool reg_all_nodes = false;	/* mutex via node table write lock */
 
 /*
  * is_ping_done - test if the last node ping cycle has completed.
@@ -310,6 +312,7 @@ void ping_nodes (void)
 		 * once in a while). We limit these requests since they
 		 * can generate a flood of incoming RPCs. */
 		if (IS_NODE_UNKNOWN(node_ptr) || (node_ptr->boot_time == 0) ||
+		    (reg_all_nodes && !IS_NODE_NO_RESPOND(node_ptr)) ||
 		    ((i >= offset) && (i < (offset + max_reg_threads)))) {
 			if (reg_agent_args->protocol_version >
 			    node_ptr->protocol_version)
@@ -342,6 +345,7 @@ void ping_nodes (void)
 #endif
 
 	restart_flag = false;
+	reg_all_nodes = false;
 	if (ping_agent_args->node_count == 0) {
 		hostlist_destroy(ping_agent_args->hostlist);
 		xfree (ping_agent_args);
@@ -365,6 +369,8 @@ void ping_nodes (void)
 		debug("Spawning registration agent for %s %d hosts",
 		      host_str, reg_agent_args->node_count);
 		xfree(host_str);
+		if (ping_nodes_tree_reg())
+			reg_agent_args->msg_flags |= SLURM_MSG_REG_REPLY;
 		ping_begin();
 		agent_queue_request(reg_agent_args);
 	}
@@ -378,6 +384,41 @@ void ping_nodes (void)
 	}
 }
 
+/*
+ * ping_nodes_register_all - request a registration from every responding
+ *	node on the next ping cycle, which is started right away
+ */
+extern void ping_nodes_register_all(void)
+{
+	reg_all_nodes = true;
+	ping_nodes_now = true;
+}
+
+/*
+ * ping_nodes_tree_reg - test if SlurmctldParameters=tree_registration is
+ *	configured, so nodes return their registration in the reply to
+ *	REQUEST_NODE_REGISTRATION_STATUS through the forwarding tree
+ */
+extern bool ping_nodes_tree_reg(void)
+{
+#ifdef HAVE_FRONT_END
+	return false;
+#else
+	static time_t conf_update = 0;
+	static bool tree_reg = false;
+
+	if (conf_update != slurmctld_conf.last_update) {
+		char *ctld_params = slurm_get_slurmctld_params();
+
+		tree_reg = (xstrcasestr(ctld_params, "tree_registration") !=
+			    NULL);
+		xfree(ctld_params);
+		conf_update = slurmctld_conf.last_update;
+	}
+	return tree_reg;
+#endif
+}
+
 /* Spawn health check function for every node that is not DOWN */
 extern void run_health_check(void)
 {
@@ -71,4 +71,17 @@ extern void ping_end (void);
  */
 extern void ping_nodes (void);
 
+/*
+ * ping_nodes_register_all - request a registration from every responding
+ *	node on the next ping cycle, which is started right away
+ */
+extern void ping_nodes_register_all(void);
+
+/*
+ * ping_nodes_tree_reg - test if SlurmctldParameters=tree_registration is
+ *	configured, so nodes return their registration in the reply to
+ *	REQUEST_NODE_REGISTRATION_STATUS through the forwarding tree
+ */
+extern bool ping_nodes_tree_reg(void);
+
 #endif /* !_HAVE_PING_NODES_H */
@@ -149,7 +149,8 @@ inline static void  _slurm_rpc_complete_job_allocation(slurm_msg_t * msg);
 inline static void  _slurm_rpc_complete_batch_script(slurm_msg_t * msg,
 						     bool *run_scheduler,
 						     bool running_composite);
-inline static void  _slurm_rpc_complete_prolog(slurm_msg_t * msg);
+inline static void  _slurm_rpc_complete_prolog(slurm_msg_t * msg,
+					       bool running_composite);
 inline static void  _slurm_rpc_dump_batch_script(slurm_msg_t *msg);
 inline static void  _slurm_rpc_dump_conf(slurm_msg_t * msg);
 inline static void  _slurm_rpc_dump_front_end(slurm_msg_t * msg);
@@ -383,7 +384,7 @@ void slurmctld_req(slurm_msg_t *msg, connection_arg_t *arg)
 		_slurm_rpc_complete_job_allocation(msg);
 		break;
 	case REQUEST_COMPLETE_PROLOG:
-		_slurm_rpc_complete_prolog(msg);
+		_slurm_rpc_complete_prolog(msg, 0);
 		break;
 	case REQUEST_COMPLETE_BATCH_SCRIPT:
 		i = 0;
@@ -2487,7 +2488,8 @@ static void _slurm_rpc_complete_job_allocation(slurm_msg_t * msg)
 
 /* _slurm_rpc_complete_prolog - process RPC to note the
  *	completion of a prolog */
-static void _slurm_rpc_complete_prolog(slurm_msg_t * msg)
+static void _slurm_rpc_complete_prolog(slurm_msg_t * msg,
+				       bool running_composite)
 {
 	int error_code = SLURM_SUCCESS;
 	DEF_TIMERS;
@@ -2502,9 +2504,12 @@ static void _slurm_rpc_complete_prolog(slurm_msg_t * msg)
 	debug2("Processing RPC: REQUEST_COMPLETE_PROLOG from JobId=%u",
 	       comp_msg->job_id);
 
-	lock_slurmctld(job_write_lock);
+	/* Composite messages already hold the lock */
+	if (!running_composite)
+		lock_slurmctld(job_write_lock);
 	error_code = prolog_complete(comp_msg->job_id, comp_msg->prolog_rc);
-	unlock_slurmctld(job_write_lock);
+	if (!running_composite)
+		unlock_slurmctld(job_write_lock);
 
 	END_TIMER2("_slurm_rpc_complete_prolog");
 
@@ -6509,6 +6514,9 @@ static void  _slurm_rpc_comp_msg_list(composite_msg_t * comp_msg,
 		case MESSAGE_EPILOG_COMPLETE:
 			_slurm_rpc_epilog_complete(next_msg, run_scheduler, 1);
 			break;
+		case REQUEST_COMPLETE_PROLOG:
+			_slurm_rpc_complete_prolog(next_msg, 1);
+			break;
 		case MESSAGE_NODE_REGISTRATION_STATUS:
 			_slurm_rpc_node_registration(next_msg, 1);
 			break;
@@ -97,6 +97,7 @@
 /* Global variables */
 List active_feature_list;	/* list of currently active features_records */
 List avail_feature_list;	/* list of available features_records */
+uint32_t node_features_gen = 1;	/* bumped when either feature list changes */
 bool node_features_updated = true;
 bool slurmctld_init_db = true;
 
@@ -1625,6 +1626,7 @@ extern void build_feature_list_eq(void)
 		list_append(active_feature_list, active_feature_ptr);
 	}
 	list_iterator_destroy(feature_iter);
+	node_features_gen++;
 }
 
 /*
@@ -1696,6 +1698,7 @@ extern void build_feature_list_ne(void)
 			xfree(tmp_str);
 		}
 	}
+	node_features_gen++;
 }
 
 /*
@@ -1731,6 +1734,7 @@ extern void update_feature_list(List feature_list, char *new_features,
 		xfree(tmp_str);
 	}
 	node_features_updated = true;
+	node_features_gen++;
 }
 
 static void _gres_reconfig(bool reconfig)
@@ -101,6 +101,28 @@ List      resv_list = (List) NULL;
 static List prom_resv_list = NULL;
 uint32_t  top_suffix = 0;
 
+/*
+ * Reservations ordered by start time so that job_test_resv() only examines
+ * those reservations which can overlap a job rather than walking all of
+ * resv_list for every job test. Reservations with RESERVE_FLAG_TIME_FLOAT
+ * move with the current time, so they are kept first and always examined.
+ * Rebuilt when last_resv_update changes or a reservation's end time passes.
+ */
+typedef struct resv_timeline {
+	bool valid;		/* set false to force a rebuild */
+	time_t build_time;	/* when built, compare with last_resv_update */
+	time_t next_end_time;	/* first reservation end after build_time */
+	uint32_t max_boot_time;	/* largest boot_time of any reservation */
+	int float_cnt;		/* count of RESERVE_FLAG_TIME_FLOAT records */
+	int resv_cnt;		/* total count of records */
+	int resv_size;		/* size of resv and start_time arrays */
+	slurmctld_resv_t **resv; /* float records, then by start_time_first */
+	time_t *start_time;	/* start_time_first of resv[i] */
+} resv_timeline_t;
+
+static resv_timeline_t resv_timeline = { .valid = false };
+static pthread_mutex_t resv_timeline_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 /*
  * the two following structs enable to build a
  * planning of a constraint evolution over time
@@ -130,6 +152,7 @@ static uint32_t _max_constraint_planning(constraint_planning_t* sched,
 
 static void _advance_resv_time(slurmctld_resv_t *resv_ptr);
 static void _advance_time(time_t *res_time, int day_cnt);
+static int  _resv_timeline_get(time_t end_time, time_t now);
 static int  _build_account_list(char *accounts, int *account_cnt,
 				char ***account_list, bool *account_not);
 static int  _build_uid_list(char *users, int *user_cnt, uid_t **user_list,
@@ -431,6 +454,8 @@ static void _restore_resv(slurmctld_resv_t *dest_resv,
 
 	if (dest_resv->flags & RESERVE_FLAG_PROM)
 		list_append(prom_resv_list, dest_resv);
+
+	resv_timeline.valid = false;
 }
 
 static void _del_resv_rec(void *x)
@@ -439,6 +464,7 @@ static void _del_resv_rec(void *x)
 	slurmctld_resv_t *resv_ptr = (slurmctld_resv_t *) x;
 
 	if (resv_ptr) {
+		resv_timeline.valid = false;
 		if (resv_ptr->flags & RESERVE_FLAG_PROM)
 			(void)list_remove_first(
 				prom_resv_list, _find_resv_ptr, resv_ptr);
@@ -2509,6 +2535,12 @@ extern void resv_fini(void)
 {
 	FREE_NULL_LIST(prom_resv_list);
 	FREE_NULL_LIST(resv_list);
+
+	slurm_mutex_lock(&resv_timeline_mutex);
+	xfree(resv_timeline.resv);
+	xfree(resv_timeline.start_time);
+	memset(&resv_timeline, 0, sizeof(resv_timeline_t));
+	slurm_mutex_unlock(&resv_timeline_mutex);
 }
 
 /* Update an exiting resource reservation */
@@ -3976,6 +4008,7 @@ static int _select_nodes(resv_desc_msg_t *resv_desc_ptr,
 				}
 			}
 		}
+		feature_cache_free(&job_ptr->details->feature_cache);
 		FREE_NULL_LIST(job_ptr->details->feature_list);
 		xfree(job_ptr->details);
 		xfree(job_ptr);
@@ -5056,6 +5089,103 @@ extern uint32_t job_test_watts_resv(job_record_t *job_ptr, time_t when,
 	return resv_cnt;
 }
 
+static int _resv_start_sort(const void *x, const void *y)
+{
+	slurmctld_resv_t *resv_ptr1 = *(slurmctld_resv_t **) x;
+	slurmctld_resv_t *resv_ptr2 = *(slurmctld_resv_t **) y;
+
+	if (resv_ptr1->start_time_first < resv_ptr2->start_time_first)
+		return -1;
+	if (resv_ptr1->start_time_first > resv_ptr2->start_time_first)
+		return 1;
+	return 0;
+}
+
+/* Rebuild resv_timeline from resv_list, advancing expired reservations */
+static void _resv_timeline_build(time_t now)
+{
+	ListIterator iter;
+	slurmctld_resv_t *resv_ptr;
+	int cnt = list_count(resv_list), i;
+
+	if (cnt > resv_timeline.resv_size) {
+		resv_timeline.resv_size = cnt;
+		xrealloc(resv_timeline.resv,
+			 sizeof(slurmctld_resv_t *) * cnt);
+		xrealloc(resv_timeline.start_time, sizeof(time_t) * cnt);
+	}
+
+	resv_timeline.float_cnt = 0;
+	resv_timeline.resv_cnt = 0;
+	resv_timeline.max_boot_time = 0;
+	resv_timeline.next_end_time = (time_t) 0;
+
+	iter = list_iterator_create(resv_list);
+	while ((resv_ptr = list_next(iter))) {
+		resv_timeline.max_boot_time = MAX(resv_timeline.max_boot_time,
+						  resv_ptr->boot_time);
+		if (resv_ptr->flags & RESERVE_FLAG_TIME_FLOAT) {
+			/* Keep float records at the front of the array */
+			i = resv_timeline.resv_cnt++;
+			resv_timeline.resv[i] =
+				resv_timeline.resv[resv_timeline.float_cnt];
+			resv_timeline.resv[resv_timeline.float_cnt++] =
+				resv_ptr;
+			continue;
+		}
+		if (resv_ptr->end_time <= now)
+			_advance_resv_time(resv_ptr);
+		if ((resv_ptr->end_time > now) &&
+		    (!resv_timeline.next_end_time ||
+		     (resv_ptr->end_time < resv_timeline.next_end_time)))
+			resv_timeline.next_end_time = resv_ptr->end_time;
+		resv_timeline.resv[resv_timeline.resv_cnt++] = resv_ptr;
+	}
+	list_iterator_destroy(iter);
+
+	qsort(resv_timeline.resv + resv_timeline.float_cnt,
+	      resv_timeline.resv_cnt - resv_timeline.float_cnt,
+	      sizeof(slurmctld_resv_t *), _resv_start_sort);
+	for (i = 0; i < resv_timeline.resv_cnt; i++) {
+		resv_timeline.start_time[i] =
+			resv_timeline.resv[i]->start_time_first;
+	}
+
+	resv_timeline.build_time = now;
+	resv_timeline.valid = true;
+}
+
+/*
+ * Return the count of leading resv_timeline.resv[] records which can overlap
+ * a job ending at end_time (before adding a reservation's boot_time).
+ * resv_timeline_mutex must be locked.
+ */
+static int _resv_timeline_get(time_t end_time, time_t now)
+{
+	int lo, hi, mid;
+
+	if (!resv_timeline.valid ||
+	    (last_resv_update >= resv_timeline.build_time) ||
+	    (resv_timeline.resv_cnt != list_count(resv_list)) ||
+	    (resv_timeline.next_end_time &&
+	     (resv_timeline.next_end_time <= now)))
+		_resv_timeline_build(now);
+
+	/* Find first record starting at or after the job's end */
+	end_time += resv_timeline.max_boot_time;
+	lo = resv_timeline.float_cnt;
+	hi = resv_timeline.resv_cnt;
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (resv_timeline.start_time[mid] < end_time)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
 /*
  * Determine which nodes a job can use based upon reservations
  * IN job_ptr      - job to test
@@ -5089,7 +5219,7 @@ extern int job_test_resv(job_record_t *job_ptr, time_t *when,
 	time_t start_relative, end_relative;
 	time_t now = time(NULL);
 	ListIterator iter;
-	int i, rc = SLURM_SUCCESS, rc2;
+	int i, j, resv_cnt, rc = SLURM_SUCCESS, rc2;
 
 	*resv_overlap = false;	/* initialize to false */
 	job_start_time = *when;
@@ -5236,8 +5366,10 @@ extern int job_test_resv(job_record_t *job_ptr, time_t *when,
 	for (i = 0; ; i++) {
 		lic_resv_time = (time_t) 0;
 
-		iter = list_iterator_create(resv_list);
-		while ((resv_ptr = list_next(iter))) {
+		slurm_mutex_lock(&resv_timeline_mutex);
+		resv_cnt = _resv_timeline_get(job_end_time, now);
+		for (j = 0; j < resv_cnt; j++) {
+			resv_ptr = resv_timeline.resv[j];
 			if (resv_ptr->flags & RESERVE_FLAG_TIME_FLOAT) {
 				start_relative = resv_ptr->start_time + now;
 				if (resv_ptr->duration == INFINITE)
@@ -5347,7 +5479,7 @@ extern int job_test_resv(job_record_t *job_ptr, time_t *when,
 				continue;
 			}
 		}
-		list_iterator_destroy(iter);
+		slurm_mutex_unlock(&resv_timeline_mutex);
 
 		if ((rc == SLURM_SUCCESS) && move_time) {
 			if (license_job_test(job_ptr, job_start_time, reboot)
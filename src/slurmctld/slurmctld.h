@@ -165,6 +165,8 @@ typedef struct diag_stats {
 	uint32_t schedule_cycle_counter;
 	uint32_t schedule_cycle_depth;
 	uint32_t schedule_queue_len;
+	uint32_t schedule_array_tasks_last;
+	uint32_t schedule_array_tasks_sum;
 
 	uint32_t jobs_submitted;
 	uint32_t jobs_started;
@@ -175,6 +177,8 @@ typedef struct diag_stats {
 	uint32_t job_states_ts;
 	uint32_t jobs_pending;
 	uint32_t jobs_running;
+	uint32_t job_records_cnt;
+	uint64_t job_records_mem;
 
 	uint32_t backfilled_jobs;
 	uint32_t last_backfilled_jobs;
@@ -195,6 +199,11 @@ typedef struct diag_stats {
 	time_t   bf_when_last_cycle;
 
 	uint32_t latency;
+
+	uint32_t reg_batch_cnt;		/* tree_registration batches */
+	uint32_t reg_node_cnt;		/* registrations in those batches */
+	uint64_t reg_storm_last_usec;	/* last registration request cycle */
+	uint64_t reg_storm_max_usec;	/* longest registration cycle */
 } diag_stats_t;
 
 /* This is used to point out constants that exist in the
@@ -252,6 +261,8 @@ typedef struct node_features {
 
 extern List active_feature_list;/* list of currently active node features */
 extern List avail_feature_list;	/* list of available node features */
+extern uint32_t node_features_gen;/* incremented on any change to
+				 * active_feature_list or avail_feature_list */
 
 /*****************************************************************************\
  *  NODE states and bitmaps
@@ -497,8 +508,26 @@ typedef struct job_feature {
 	bitstr_t *node_bitmap_active;	/* nodes with this feature active */
 	bitstr_t *node_bitmap_avail;	/* nodes with this feature available */
 	uint16_t paren;			/* count of enclosing parenthesis */
+	uint32_t feature_gen;		/* node_features_gen when node bitmaps
+					 * were last built */
+	bool can_reboot;		/* node_bitmap_avail built for a user
+					 * able to change node features */
 } job_feature_t;
 
+/*
+ * Result of evaluating a job's AND/OR feature expression against every node.
+ * Built on demand and reused until node_features_gen changes, so scheduling
+ * passes only need to AND it with their candidate node bitmap.
+ */
+typedef struct job_feature_cache {
+	bitstr_t *active_bitmap;	/* nodes matching with active features */
+	bitstr_t *avail_bitmap;		/* nodes matching with avail features */
+	bool can_reboot;		/* user able to change node features */
+	uint32_t feature_gen;		/* node_features_gen when built */
+	bool has_count;			/* some feature has a node count */
+	bool has_xor;			/* XOR/XAND found in expression */
+} job_feature_cache_t;
+
 /*
  * these related to the JOB_SHARED_ macros in slurm.h
  * but with the logic for zero vs one inverted
@@ -545,6 +574,8 @@ struct job_details {
 	char *exc_nodes;		/* excluded nodes */
 	uint32_t expanding_jobid;	/* ID of job to be expanded */
 	char *extra;			/* extra field, unused */
+	job_feature_cache_t *feature_cache; /* evaluated feature_list,
+					 * not saved/restored, but rebuilt */
 	List feature_list;		/* required features with node counts */
 	char *features;			/* required features */
 	uint32_t max_cpus;		/* maximum number of cpus */
@@ -597,7 +628,8 @@ struct job_details {
 	uint8_t whole_node;		/* WHOLE_NODE_REQUIRED: 1: --exclusive
 					 * WHOLE_NODE_USER: 2: --exclusive=user
 					 * WHOLE_NODE_MCS:  3: --exclusive=mcs */
-	char *work_dir;			/* pathname of working directory */
+	char *work_dir;			/* pathname of working directory,
+					 * shared */
 	uint16_t x11;			/* --x11 flags */
 	char *x11_magic_cookie;		/* x11 magic cookie */
 	char *x11_target;		/* target host, or socket if port == 0 */
@@ -656,7 +688,7 @@ typedef struct job_record job_record_t;
 struct job_record {
 	uint32_t magic;			/* magic cookie for data integrity */
 					/* DO NOT ALPHABETIZE */
-	char    *account;		/* account number to charge */
+	char    *account;		/* account number to charge, shared */
 	char    *admin_comment;		/* administrator's arbitrary comment */
 	char	*alias_list;		/* node name to address aliases */
 	char    *alloc_node;		/* local node making resource alloc */
@@ -876,7 +908,7 @@ struct job_record {
 	uint16_t warn_signal;		/* signal to send before end_time */
 	uint16_t warn_time;		/* when to send signal before
 					 * end_time (secs) */
-	char *wckey;			/* optional wckey */
+	char *wckey;			/* optional wckey, shared */
 
 	/* Request number of switches support */
 	uint32_t req_switch;  /* Minimum number of switches                */
@@ -1217,6 +1249,12 @@ extern void make_node_avail(int node_inx);
  */
 extern List feature_list_copy(List feature_list_src);
 
+/*
+ * Free a job's cached feature expression evaluation
+ * IN/OUT cache_pptr - pointer to the cache, set to NULL on return
+ */
+extern void feature_cache_free(job_feature_cache_t **cache_pptr);
+
 /*
  * find_job_array_rec - return a pointer to the job record with the given
  *	array_job_id/array_task_id
@@ -1437,6 +1475,15 @@ extern void job_array_start(job_record_t *job_ptr);
 /* Return true if a job array task can be started */
 extern bool job_array_start_test(job_record_t *job_ptr);
 
+/*
+ * Return an estimate of the memory held by a job record, its details and
+ * the strings they reference, in bytes.
+ */
+extern uint64_t job_record_mem_size(job_record_t *job_ptr);
+
+/* Return the memory held by strings shared between job records, in bytes */
+extern uint64_t job_str_mem_size(void);
+
 /* Clear job's CONFIGURING flag and advance end time as needed */
 extern void job_config_fini(job_record_t *job_ptr);
 
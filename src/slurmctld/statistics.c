@@ -42,6 +42,8 @@
 #include "src/slurmctld/slurmctld.h"
 #include "src/common/list.h"
 #include "src/common/pack.h"
+#include "src/common/slurm_auth.h"
+#include "src/common/slurm_route.h"
 #include "src/common/xstring.h"
 #include "src/common/slurmdbd_defs.h"
 
@@ -57,6 +59,8 @@ extern void pack_all_stat(int resp, char **buffer_ptr, int *buffer_size,
 	int agent_count;
 	int agent_thread_count;
 	int slurmdbd_queue_size;
+	uint32_t auth_stats[AUTH_STAT_CNT];
+	route_stats_t route_stats;
 	time_t now = time(NULL);
 
 	buffer_ptr[0] = NULL;
@@ -105,6 +109,8 @@ extern void pack_all_stat(int resp, char **buffer_ptr, int *buffer_size,
 			pack32(slurmctld_diag_stats.jobs_pending, buffer);
 			pack32(slurmctld_diag_stats.jobs_running, buffer);
 			pack_time(slurmctld_diag_stats.job_states_ts, buffer);
+			pack32(slurmctld_diag_stats.job_records_cnt, buffer);
+			pack64(slurmctld_diag_stats.job_records_mem, buffer);
 
 			pack32(slurmctld_diag_stats.schedule_cycle_max,
 			       buffer);
@@ -117,6 +123,10 @@ extern void pack_all_stat(int resp, char **buffer_ptr, int *buffer_size,
 			pack32(slurmctld_diag_stats.schedule_cycle_depth,
 			       buffer);
 			pack32(slurmctld_diag_stats.schedule_queue_len, buffer);
+			pack32(slurmctld_diag_stats.schedule_array_tasks_last,
+			       buffer);
+			pack32(slurmctld_diag_stats.schedule_array_tasks_sum,
+			       buffer);
 
 			pack32(slurmctld_diag_stats.backfilled_jobs, buffer);
 			pack32(slurmctld_diag_stats.last_backfilled_jobs,
@@ -140,6 +150,24 @@ extern void pack_all_stat(int resp, char **buffer_ptr, int *buffer_size,
 			pack32(slurmctld_diag_stats.bf_active, buffer);
 			pack32(slurmctld_diag_stats.backfilled_het_jobs,
 			       buffer);
+
+			slurm_auth_stats_get(auth_stats, false);
+			pack32(auth_stats[AUTH_STAT_ENCODE], buffer);
+			pack32(auth_stats[AUTH_STAT_DECODE], buffer);
+			pack32(auth_stats[AUTH_STAT_DECODE_CACHED], buffer);
+
+			route_stats_get(&route_stats, false);
+			pack32(route_stats.split_cnt, buffer);
+			pack64(route_stats.split_usec, buffer);
+			pack32(route_stats.split_max_usec, buffer);
+			pack32(route_stats.cache_hits, buffer);
+
+			pack32(slurmctld_diag_stats.reg_batch_cnt, buffer);
+			pack32(slurmctld_diag_stats.reg_node_cnt, buffer);
+			pack64(slurmctld_diag_stats.reg_storm_last_usec,
+			       buffer);
+			pack64(slurmctld_diag_stats.reg_storm_max_usec,
+			       buffer);
 		}
 	} else if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
 		parts_packed = resp;
@@ -217,12 +245,15 @@ extern void pack_all_stat(int resp, char **buffer_ptr, int *buffer_size,
  * level IN - clear backfilled_jobs count if set */
 extern void reset_stats(int level)
 {
+	uint32_t auth_stats[AUTH_STAT_CNT];
+
 	slurmctld_diag_stats.proc_req_raw = 0;
 	slurmctld_diag_stats.proc_req_threads = 0;
 	slurmctld_diag_stats.schedule_cycle_max = 0;
 	slurmctld_diag_stats.schedule_cycle_sum = 0;
 	slurmctld_diag_stats.schedule_cycle_counter = 0;
 	slurmctld_diag_stats.schedule_cycle_depth = 0;
+	slurmctld_diag_stats.schedule_array_tasks_sum = 0;
 	slurmctld_diag_stats.jobs_submitted = 0;
 	slurmctld_diag_stats.jobs_started = 0;
 	slurmctld_diag_stats.jobs_completed = 0;
@@ -247,6 +278,13 @@ extern void reset_stats(int level)
 	slurmctld_diag_stats.bf_last_depth = 0;
 	slurmctld_diag_stats.bf_last_depth_try = 0;
 	slurmctld_diag_stats.bf_active = 0;
+	slurmctld_diag_stats.reg_batch_cnt = 0;
+	slurmctld_diag_stats.reg_node_cnt = 0;
+	slurmctld_diag_stats.reg_storm_last_usec = 0;
+	slurmctld_diag_stats.reg_storm_max_usec = 0;
+
+	slurm_auth_stats_get(auth_stats, true);
+	route_stats_get(NULL, true);
 
 	last_proc_req_start = time(NULL);
 }
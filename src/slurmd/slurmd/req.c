@@ -198,6 +198,7 @@ static int  _file_bcast_register_file(slurm_msg_t *msg,
 				      sbcast_cred_arg_t *cred_arg,
 				      file_bcast_info_t *key);
 static int  _rpc_ping(slurm_msg_t *);
+static void _rpc_node_registration(slurm_msg_t *msg);
 static int  _rpc_health_check(slurm_msg_t *);
 static int  _rpc_acct_gather_update(slurm_msg_t *);
 static int  _rpc_acct_gather_energy(slurm_msg_t *);
@@ -382,6 +383,17 @@ slurmd_req(slurm_msg_t *msg)
 		break;
 	case REQUEST_NODE_REGISTRATION_STATUS:
 		debug2("Processing RPC: REQUEST_NODE_REGISTRATION_STATUS");
+		/*
+		 * slurmctld gathers registrations through the forwarding
+		 * tree, unless we still need the TRES list it only sends in
+		 * response to a separate registration
+		 */
+		if ((msg->flags & SLURM_MSG_REG_REPLY) && !get_reg_resp &&
+		    (msg->protocol_version == SLURM_PROTOCOL_VERSION)) {
+			_rpc_node_registration(msg);
+			last_slurmctld_msg = time(NULL);
+			break;
+		}
 		get_reg_resp = 1;
 		/* Treat as ping (for slurmctld agent, just return SUCCESS) */
 		rc = _rpc_ping(msg);
@@ -1928,6 +1940,24 @@ static int _notify_slurmctld_prolog_fini(
 	slurm_msg_t req_msg;
 	complete_prolog_msg_t req;
 
+	if (msg_aggr_type_enabled(REQUEST_COMPLETE_PROLOG)) {
+		slurm_msg_t *aggr_msg = xmalloc_nz(sizeof(slurm_msg_t));
+		complete_prolog_msg_t *aggr_req =
+			xmalloc(sizeof(complete_prolog_msg_t));
+
+		aggr_req->job_id = job_id;
+		aggr_req->prolog_rc = prolog_return_code;
+		slurm_msg_t_init(aggr_msg);
+		aggr_msg->msg_type = REQUEST_COMPLETE_PROLOG;
+		aggr_msg->data = aggr_req;
+
+		/* No reply within MessageTimeout is retried by the caller */
+		if ((ret_c = msg_aggr_add_msg(aggr_msg, 1, NULL)))
+			error("No reply to aggregated prolog completion notification for JobId=%u",
+			      job_id);
+		return ret_c;
+	}
+
 	slurm_msg_t_init(&req_msg);
 	memset(&req, 0, sizeof(req));
 	req.job_id	= job_id;
@@ -2751,8 +2781,10 @@ _rpc_reconfig(slurm_msg_t *msg)
 	if (!_slurm_authorized_user(req_uid))
 		error("Security violation, reconfig RPC from uid %d",
 		      req_uid);
-	else
+	else {
+		reconfig_reg_request(msg->flags & SLURM_MSG_REG_REPLY);
 		kill(conf->pid, SIGHUP);
+	}
 	forward_wait(msg);
 	/* Never return a message, slurmctld does not expect one */
 }
@@ -2776,6 +2808,7 @@ static void _rpc_reconfig_with_config(slurm_msg_t *msg)
 			 */
 			write_configs_to_conf_cache(configs, conf->conf_cache);
 		}
+		reconfig_reg_request(msg->flags & SLURM_MSG_REG_REPLY);
 		kill(conf->pid, SIGHUP);
 	}
 	forward_wait(msg);
@@ -3188,6 +3221,25 @@ _rpc_ping(slurm_msg_t *msg)
 	return rc;
 }
 
+/*
+ * Reply to a registration request with the registration itself, which
+ * slurmctld validates in batches (SlurmctldParameters=tree_registration)
+ */
+static void _rpc_node_registration(slurm_msg_t *msg)
+{
+	uid_t req_uid = g_slurm_auth_get_uid(msg->auth_cred);
+
+	if (!_slurm_authorized_user(req_uid)) {
+		error("Security violation, node registration RPC from uid %d",
+		      req_uid);
+		slurm_send_rc_msg(msg, ESLURM_USER_ID_MISSING);
+		return;
+	}
+
+	if (send_registration_reply(msg) != SLURM_SUCCESS)
+		error("Error responding to node registration request: %m");
+}
+
 static int
 _rpc_health_check(slurm_msg_t *msg)
 {
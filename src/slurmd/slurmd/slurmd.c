@@ -53,6 +53,7 @@
 #include <dlfcn.h>
 #include <fcntl.h>
 #include <grp.h>
+#include <poll.h>
 #include <pthread.h>
 #include <sched.h>
 #include <stdlib.h>
@@ -60,6 +61,7 @@
 #include <sys/mman.h>
 #include <sys/param.h>
 #include <sys/resource.h>
+#include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/time.h>
 #include <sys/types.h>
@@ -152,8 +154,21 @@ static pthread_mutex_t fork_mutex     = PTHREAD_MUTEX_INITIALIZER;
 typedef struct connection {
 	int fd;
 	slurm_addr_t *cli_addr;
+	time_t idle_since;	/* set while kept open for reuse */
 } conn_t;
 
+/*
+ * Connections slurmctld flagged with SLURM_MSG_KEEP_CONN, watched by
+ * _msg_engine() between messages instead of holding a thread each.
+ * Only _msg_engine() removes entries, writing to idle_conn_pipe wakes it
+ * after one is added.
+ */
+#define MAX_IDLE_CONNS	64
+static conn_t         *idle_conns[MAX_IDLE_CONNS];
+static int             idle_conn_cnt  = 0;
+static int             idle_conn_pipe[2] = { -1, -1 };
+static pthread_mutex_t idle_conn_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 /*
  * Global data for resource specialization
  */
@@ -176,6 +191,26 @@ static sig_atomic_t _update_log = 0;
 static pthread_t msg_pthread = (pthread_t) 0;
 static time_t sent_reg_time = (time_t) 0;
 
+/*
+ * Registration after a reconfigure which slurmctld requests through the
+ * forwarding tree (SlurmctldParameters=tree_registration):
+ * RECONFIG_REG_PENDING  - reconfigure RPC received, SIGHUP not handled yet
+ * RECONFIG_REG_STALE    - as above, and a registration request was answered
+ *                         with the old config meanwhile
+ * RECONFIG_REG_APPLIED  - reconfigured, waiting for the registration request
+ */
+typedef enum {
+	RECONFIG_REG_NONE,
+	RECONFIG_REG_PENDING,
+	RECONFIG_REG_STALE,
+	RECONFIG_REG_APPLIED,
+} reconfig_reg_state_t;
+
+static pthread_mutex_t reconfig_reg_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  reconfig_reg_cond = PTHREAD_COND_INITIALIZER;
+static reconfig_reg_state_t reconfig_reg_state = RECONFIG_REG_NONE;
+static uint32_t reconfig_reg_gen = 0;	/* counts RECONFIG_REG_APPLIED */
+
 static void      _atfork_final(void);
 static void      _atfork_prepare(void);
 static int       _convert_spec_cores(void);
@@ -202,6 +237,8 @@ static void      _print_gres(void);
 static void      _process_cmdline(int ac, char **av);
 static void      _read_config(void);
 static void      _reconfigure(void);
+static void      _reconfig_reg_applied(void);
+static void     *_reconfig_reg_timeout(void *arg);
 static void     *_registration_engine(void *arg);
 static void      _resource_spec_fini(void);
 static int       _resource_spec_init(void);
@@ -219,6 +256,8 @@ static void      _usage(void);
 static void      _usr_handler(int);
 static int       _validate_and_convert_cpu_list(void);
 static void      _wait_for_all_threads(int secs);
+static bool      _keep_conn(conn_t *con);
+static bool      _wait_for_conn(void);
 
 /**************************************************************************\
  * To test for memory leaks, set MEMORY_LEAK_DEBUG to 1 using
@@ -393,7 +432,8 @@ main (int argc, char **argv)
 
 	msg_aggr_sender_init(conf->hostname, conf->port,
 			     conf->msg_aggr_window_time,
-			     conf->msg_aggr_window_msgs);
+			     conf->msg_aggr_window_msgs,
+			     conf->msg_aggr_window_bytes);
 
 	slurm_thread_create_detached(NULL, _registration_engine, NULL);
 
@@ -453,6 +493,16 @@ _msg_engine(void)
 
 	msg_pthread = pthread_self();
 	slurmd_req(NULL);	/* initialize timer */
+	if (pipe(idle_conn_pipe)) {
+		error("%s: pipe: %m, connections will not be kept open",
+		      __func__);
+		idle_conn_pipe[0] = idle_conn_pipe[1] = -1;
+	} else {
+		fd_set_nonblocking(idle_conn_pipe[0]);
+		fd_set_nonblocking(idle_conn_pipe[1]);
+		fd_set_close_on_exec(idle_conn_pipe[0]);
+		fd_set_close_on_exec(idle_conn_pipe[1]);
+	}
 	while (!_shutdown) {
 		if (_reconfig) {
 			int rpc_wait = MAX(5, slurm_get_msg_timeout() / 2);
@@ -465,6 +515,8 @@ _msg_engine(void)
 		}
 		if (_update_log)
 			_update_logging();
+		if (!_wait_for_conn())
+			continue;
 		cli = xmalloc (sizeof (slurm_addr_t));
 		if ((sock = slurm_accept_msg_conn(conf->lfd, cli)) >= 0) {
 			_handle_connection(sock, cli);
@@ -480,6 +532,15 @@ _msg_engine(void)
 	}
 	verbose("got shutdown request");
 	close(conf->lfd);
+
+	slurm_mutex_lock(&idle_conn_mutex);
+	while (idle_conn_cnt) {
+		conn_t *con = idle_conns[--idle_conn_cnt];
+		(void) close(con->fd);
+		xfree(con->cli_addr);
+		xfree(con);
+	}
+	slurm_mutex_unlock(&idle_conn_mutex);
 	return;
 }
 
@@ -552,6 +613,101 @@ static void _handle_connection(int fd, slurm_addr_t *cli)
 	slurm_thread_create_detached(NULL, _service_connection, arg);
 }
 
+/*
+ * Keep a connection open for slurmctld to send another message on
+ * RET true if con now belongs to _msg_engine()
+ */
+static bool _keep_conn(conn_t *con)
+{
+	char c = 0;
+
+	slurm_mutex_lock(&idle_conn_mutex);
+	if (_shutdown || (idle_conn_pipe[1] < 0) ||
+	    (idle_conn_cnt >= MAX_IDLE_CONNS)) {
+		slurm_mutex_unlock(&idle_conn_mutex);
+		return false;
+	}
+	con->idle_since = time(NULL);
+	idle_conns[idle_conn_cnt++] = con;
+	slurm_mutex_unlock(&idle_conn_mutex);
+
+	/* Nothing lost if full, _msg_engine() is awake then anyway */
+	(void) write(idle_conn_pipe[1], &c, 1);
+	return true;
+}
+
+/*
+ * Wait for a new connection on conf->lfd. Meanwhile hand kept connections
+ * on which another message arrived to a new thread, and close those idle
+ * too long or closed by the remote end.
+ * RET true if accept() on conf->lfd will not block
+ */
+static bool _wait_for_conn(void)
+{
+	struct pollfd pfds[MAX_IDLE_CONNS + 2];
+	conn_t *ready[MAX_IDLE_CONNS];
+	int i, nfds, nready = 0, timeout = -1;
+	int keep_time = slurm_get_keep_conn_time() + KEEP_CONN_SLACK;
+	time_t now = time(NULL);
+	char buf[64];
+
+	pfds[0].fd = conf->lfd;
+	pfds[0].events = POLLIN;
+	pfds[1].fd = idle_conn_pipe[0];
+	pfds[1].events = POLLIN;
+	slurm_mutex_lock(&idle_conn_mutex);
+	for (i = 0; i < idle_conn_cnt; i++) {
+		int left = keep_time - (now - idle_conns[i]->idle_since);
+		pfds[i + 2].fd = idle_conns[i]->fd;
+		pfds[i + 2].events = POLLIN;
+		left = MAX(left, 0) * 1000;
+		if ((timeout < 0) || (left < timeout))
+			timeout = left;
+	}
+	nfds = idle_conn_cnt + 2;
+	slurm_mutex_unlock(&idle_conn_mutex);
+
+	if (poll(pfds, nfds, timeout) < 0) {
+		if (errno != EINTR)
+			error("%s: poll: %m", __func__);
+		return false;
+	}
+	if (pfds[1].revents)
+		while (read(idle_conn_pipe[0], buf, sizeof(buf)) > 0)
+			;
+
+	/* Entries past nfds - 2 were added while polling, keep them */
+	now = time(NULL);
+	slurm_mutex_lock(&idle_conn_mutex);
+	for (i = nfds - 3; i >= 0; i--) {
+		conn_t *con = idle_conns[i];
+
+		if (!pfds[i + 2].revents &&
+		    ((now - con->idle_since) < keep_time))
+			continue;
+		idle_conns[i] = idle_conns[--idle_conn_cnt];
+		/* A readable socket with no data is the remote close */
+		if ((pfds[i + 2].revents & POLLIN) &&
+		    (recv(con->fd, buf, 1, MSG_PEEK) > 0)) {
+			ready[nready++] = con;
+			continue;
+		}
+		(void) close(con->fd);
+		xfree(con->cli_addr);
+		xfree(con);
+	}
+	slurm_mutex_unlock(&idle_conn_mutex);
+
+	for (i = 0; i < nready; i++) {
+		debug3("%s: next message on kept connection", __func__);
+		_increment_thd_count();
+		slurm_thread_create_detached(NULL, _service_connection,
+					     ready[i]);
+	}
+
+	return (pfds[0].revents != 0);
+}
+
 static void *
 _service_connection(void *arg)
 {
@@ -577,6 +733,19 @@ _service_connection(void *arg)
 	if (msg->msg_type != MESSAGE_COMPOSITE)
 		slurmd_req(msg);
 
+	/*
+	 * slurmctld may send further messages on this connection, unless
+	 * the RPC handler already closed it.
+	 */
+	if ((msg->flags & SLURM_MSG_KEEP_CONN) && (msg->conn_fd >= 0) &&
+	    _keep_conn(con)) {
+		debug2("Finish processing RPC: %s, keeping connection",
+		       rpc_num2string(msg->msg_type));
+		slurm_free_msg(msg);
+		_decrement_thd_count();
+		return NULL;
+	}
+
 cleanup:
 	if ((msg->conn_fd >= 0) && close(msg->conn_fd) < 0)
 		error ("close(%d): %m", con->fd);
@@ -705,6 +874,108 @@ fail:
 	return ret_val;
 }
 
+extern void reconfig_reg_request(bool by_ctld)
+{
+	slurm_mutex_lock(&reconfig_reg_mutex);
+	reconfig_reg_state = by_ctld ? RECONFIG_REG_PENDING : RECONFIG_REG_NONE;
+	slurm_cond_broadcast(&reconfig_reg_cond);
+	slurm_mutex_unlock(&reconfig_reg_mutex);
+}
+
+/*
+ * The reconfigure requested by reconfig_reg_request() is done, register
+ * once slurmctld asks for it, or by ourselves if it does not ask within
+ * two ping intervals (e.g. the node was not responding when it did) or if
+ * it already asked before the reconfigure was applied
+ */
+static void _reconfig_reg_applied(void)
+{
+	uint32_t *gen;
+
+	slurm_mutex_lock(&reconfig_reg_mutex);
+	if (reconfig_reg_state != RECONFIG_REG_PENDING) {
+		reconfig_reg_state = RECONFIG_REG_NONE;
+		slurm_mutex_unlock(&reconfig_reg_mutex);
+		send_registration_msg(SLURM_SUCCESS, false);
+		return;
+	}
+	reconfig_reg_state = RECONFIG_REG_APPLIED;
+	gen = xmalloc(sizeof(uint32_t));
+	*gen = ++reconfig_reg_gen;
+	slurm_cond_broadcast(&reconfig_reg_cond);
+	slurm_mutex_unlock(&reconfig_reg_mutex);
+
+	slurm_thread_create_detached(NULL, _reconfig_reg_timeout, gen);
+}
+
+static void *_reconfig_reg_timeout(void *arg)
+{
+	uint32_t gen = *(uint32_t *) arg;
+	struct timespec ts = {0, 0};
+	bool send = false;
+
+	xfree(arg);
+	ts.tv_sec = time(NULL) + (2 * slurm_get_ping_interval());
+	slurm_mutex_lock(&reconfig_reg_mutex);
+	while (!_shutdown && (reconfig_reg_state == RECONFIG_REG_APPLIED) &&
+	       (reconfig_reg_gen == gen)) {
+		if (pthread_cond_timedwait(&reconfig_reg_cond,
+					   &reconfig_reg_mutex, &ts) ==
+		    ETIMEDOUT)
+			break;
+	}
+	if (!_shutdown && (reconfig_reg_state == RECONFIG_REG_APPLIED) &&
+	    (reconfig_reg_gen == gen)) {
+		reconfig_reg_state = RECONFIG_REG_NONE;
+		send = true;
+	}
+	slurm_mutex_unlock(&reconfig_reg_mutex);
+
+	if (send) {
+		debug("%s: no registration request since reconfigure, registering",
+		      __func__);
+		send_registration_msg(SLURM_SUCCESS, false);
+	}
+	return NULL;
+}
+
+extern int send_registration_reply(slurm_msg_t *req)
+{
+	slurm_msg_t resp_msg;
+	slurm_node_registration_status_msg_t *msg;
+	int rc;
+
+	/*
+	 * Not waiting for a pending reconfigure here, slurmd waits for the
+	 * RPCs in progress before reconfiguring. Have _reconfig_reg_applied()
+	 * register again instead, as this reply still has the old config.
+	 */
+	slurm_mutex_lock(&reconfig_reg_mutex);
+	if (reconfig_reg_state == RECONFIG_REG_PENDING) {
+		reconfig_reg_state = RECONFIG_REG_STALE;
+	} else if (reconfig_reg_state == RECONFIG_REG_APPLIED) {
+		reconfig_reg_state = RECONFIG_REG_NONE;
+		slurm_cond_broadcast(&reconfig_reg_cond);
+	}
+	slurm_mutex_unlock(&reconfig_reg_mutex);
+
+	msg = xmalloc(sizeof(slurm_node_registration_status_msg_t));
+	_fill_registration_msg(msg);
+	msg->status = SLURM_SUCCESS;
+
+	slurm_msg_t_copy(&resp_msg, req);
+	resp_msg.msg_type = MESSAGE_NODE_REGISTRATION_STATUS;
+	resp_msg.data = msg;
+	rc = slurm_send_node_msg(req->conn_fd, &resp_msg);
+	slurm_free_node_registration_status_msg(msg);
+
+	if (rc >= 0) {
+		sent_reg_time = time(NULL);
+		rc = SLURM_SUCCESS;
+	}
+	return rc;
+}
+
 static void
 _fill_registration_msg(slurm_node_registration_status_msg_t *msg)
 {
@@ -1159,7 +1430,8 @@ _reconfigure(void)
 	cpu_freq_reconfig();
 
 	msg_aggr_sender_reconfig(conf->msg_aggr_window_time,
-				 conf->msg_aggr_window_msgs);
+				 conf->msg_aggr_window_msgs,
+				 conf->msg_aggr_window_bytes);
 
 	/*
 	 * In case the administrator changed the cpu frequency set capabilities
@@ -1207,7 +1479,8 @@ _reconfigure(void)
 
 	_build_conf_buf();
 
-	send_registration_msg(SLURM_SUCCESS, false);
+	/* With tree_registration slurmctld asks for it through the tree */
+	_reconfig_reg_applied();
 
 	acct_gather_reconfig();
 
@@ -2353,6 +2626,10 @@ static uint64_t _parse_msg_aggr_params(int type, char *params)
 		if ((sub_str = xstrcasestr(params, "WindowMsgs=")))
 			value = _get_int(sub_str + 11);
 		break;
+	case WINDOW_BYTES:
+		if ((sub_str = xstrcasestr(params, "WindowBytes=")))
+			value = _get_int(sub_str + 12);
+		break;
 	default:
 		fatal("invalid message aggregation parameters: %s", params);
 	}
@@ -2365,14 +2642,19 @@ static void _set_msg_aggr_params(void)
 			       conf->msg_aggr_params);
 	conf->msg_aggr_window_msgs = _parse_msg_aggr_params(WINDOW_MSGS,
 			       conf->msg_aggr_params);
+	conf->msg_aggr_window_bytes = _parse_msg_aggr_params(WINDOW_BYTES,
+			       conf->msg_aggr_params);
 
 	if (conf->msg_aggr_window_time == NO_VAL)
 		conf->msg_aggr_window_time = DEFAULT_MSG_AGGR_WINDOW_TIME;
 	if (conf->msg_aggr_window_msgs == NO_VAL)
 		conf->msg_aggr_window_msgs = DEFAULT_MSG_AGGR_WINDOW_MSGS;
+	if (conf->msg_aggr_window_bytes == NO_VAL)
+		conf->msg_aggr_window_bytes = DEFAULT_MSG_AGGR_WINDOW_BYTES;
 	if (conf->msg_aggr_window_msgs > 1) {
-		info("Message aggregation enabled: WindowMsgs=%"PRIu64", WindowTime=%"PRIu64,
-		     conf->msg_aggr_window_msgs, conf->msg_aggr_window_time);
+		info("Message aggregation enabled: WindowMsgs=%"PRIu64", WindowTime=%"PRIu64", WindowBytes=%"PRIu64,
+		     conf->msg_aggr_window_msgs, conf->msg_aggr_window_time,
+		     conf->msg_aggr_window_bytes);
 	} else
 		info("Message aggregation disabled");
 }
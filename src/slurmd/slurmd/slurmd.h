@@ -61,7 +61,8 @@ extern bool get_reg_resp;
  */
 typedef enum {
 	WINDOW_TIME,
-	WINDOW_MSGS
+	WINDOW_MSGS,
+	WINDOW_BYTES
 } msg_aggr_param_type_t;
 
 /*
@@ -159,6 +160,7 @@ typedef struct slurmd_config {
 	char           *msg_aggr_params;      /* message aggregation params */
 	uint64_t        msg_aggr_window_msgs; /* msg aggr window size in msgs */
 	uint64_t        msg_aggr_window_time; /* msg aggr window size in time */
+	uint64_t        msg_aggr_window_bytes; /* msg aggr window size in bytes */
 	uint16_t	use_pam;
 	uint32_t	task_plugin_param; /* TaskPluginParams, expressed
 					 * using cpu_bind_type_t flags */
@@ -191,6 +193,18 @@ extern bool tres_packed;
  */
 int send_registration_msg(uint32_t status, bool startup);
 
+/* Reply to REQUEST_NODE_REGISTRATION_STATUS with our registration, which
+ * then returns to slurmctld through the message forwarding tree
+ * IN req - the registration request
+ */
+extern int send_registration_reply(slurm_msg_t *req);
+
+/* Called on a reconfigure RPC before signaling the reconfigure
+ * IN by_ctld - slurmctld will request the registration afterwards
+ *              (SLURM_MSG_REG_REPLY), else slurmd registers by itself
+ */
+extern void reconfig_reg_request(bool by_ctld);
+
 /*
  * save_cred_state - save the current credential list to a file
  * IN list - list of credentials
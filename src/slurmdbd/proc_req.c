@@ -263,10 +263,16 @@ proc_req(void *conn, persist_msg_t *msg,
 	int rc = SLURM_SUCCESS;
 	char *comment = NULL;
 	slurmdb_rpc_obj_t *rpc_obj;
+	dbd_rpc_class_t rpc_class = DBD_RPC_CLASS_NONE;
 
 	DEF_TIMERS;
 	START_TIMER;
 
+	/* The messages of a DBD_SEND_MULT_MSG share its slot */
+	if (!slurmdbd_conn->in_mult_msg)
+		rpc_class = rpc_mgr_class(msg->msg_type);
+	rpc_mgr_class_enter(rpc_class);
+
 	switch (msg->msg_type) {
 	case REQUEST_PERSIST_INIT:
 		rc = _unpack_persist_init(
@@ -557,19 +563,54 @@ proc_req(void *conn, persist_msg_t *msg,
 		      slurmdbd_conn->conn->fd,
 		      slurmdbd_msg_type_2_str(msg->msg_type, 1));
 	else if (slurmdbd_conn->conn->rem_port
-		 && !slurmdbd_conf->commit_delay) {
+		 && !slurmdbd_conf->commit_delay
+		 && !slurmdbd_conn->in_mult_msg
+		 && (msg->msg_type != DBD_SEND_MULT_MSG)) {
 		/* If we are dealing with the slurmctld do the
 		   commit (SUCCESS or NOT) afterwards since we
 		   do transactions for performance reasons.
 		   (don't ever use autocommit with innodb)
+		   The messages of a DBD_SEND_MULT_MSG are all
+		   committed together by _send_mult_msg().
+		   Deferred job and step writes are only made by
+		   the commit, so a failure is returned instead of
+		   the reply to have the slurmctld resend them.
+		   With CommitDelay the reply was already sent, so
+		   a failed commit loses the messages since the
+		   previous one (see slurmdbd.conf(5)).
 		*/
-		acct_storage_g_commit(slurmdbd_conn->db_conn, 1);
+		if ((acct_storage_g_commit(slurmdbd_conn->db_conn, 1) !=
+		     SLURM_SUCCESS) && (rc == SLURM_SUCCESS)) {
+			comment = "Failed to commit";
+			error("CONN:%u %s %s", slurmdbd_conn->conn->fd,
+			      comment,
+			      slurmdbd_msg_type_2_str(msg->msg_type, 1));
+			free_buf(*out_buffer);
+			rc = SLURM_ERROR;
+			*out_buffer = slurm_persist_make_rc_msg(
+				slurmdbd_conn->conn, rc, comment,
+				msg->msg_type);
+		}
 	}
 
+	rpc_mgr_class_exit(rpc_class);
+
 	END_TIMER;
 
 	slurm_mutex_lock(&rpc_mutex);
 
+	if (msg->msg_type == DBD_SEND_MULT_MSG) {
+		dbd_list_msg_t *list_msg = msg->data;
+
+		rpc_stats.batch_cnt++;
+		if (list_msg && list_msg->my_list)
+			rpc_stats.batch_msg_cnt +=
+				list_count(list_msg->my_list);
+		rpc_stats.batch_time += DELTA_TIMER;
+		if (rpc_stats.batch_time_max < DELTA_TIMER)
+			rpc_stats.batch_time_max = DELTA_TIMER;
+	}
+
 	if (!(rpc_obj = list_find_first(rpc_stats.rpc_list,
 					_find_rpc_obj_in_list,
 					&msg->msg_type))) {
@@ -3358,6 +3399,7 @@ static int   _send_mult_msg(slurmdbd_conn_t *slurmdbd_conn,
 	ListIterator itr = NULL;
 	Buf req_buf = NULL, ret_buf = NULL;
 	int rc = SLURM_SUCCESS;
+	bool in_mult_msg;
 	/* DEF_TIMERS; */
 
 	if (!_validate_slurm_user(*uid)) {
@@ -3371,6 +3413,12 @@ static int   _send_mult_msg(slurmdbd_conn_t *slurmdbd_conn,
 	}
 
 	list_msg.my_list = list_create(slurmdbd_free_buffer);
+	/*
+	 * Process all messages in one transaction, which lets the storage
+	 * plugin send their job and step records to the database together
+	 */
+	in_mult_msg = slurmdbd_conn->in_mult_msg;
+	slurmdbd_conn->in_mult_msg = true;
 	/* START_TIMER; */
 	itr = list_iterator_create(get_msg->my_list);
 	while ((req_buf = list_next(itr))) {
@@ -3394,9 +3442,28 @@ static int   _send_mult_msg(slurmdbd_conn_t *slurmdbd_conn,
 			break;
 	}
 	list_iterator_destroy(itr);
+	slurmdbd_conn->in_mult_msg = in_mult_msg;
 	/* END_TIMER; */
 	/* info("%d multi took %s", list_count(get_msg->my_list), TIME_STR); */
 
+	/*
+	 * Job and step records may only have been written to the database by
+	 * the commit, so commit before replying, even with CommitDelay. Should
+	 * it fail, none of the messages are acknowledged and the slurmctld
+	 * sends them all again.
+	 */
+	if (!in_mult_msg && slurmdbd_conn->conn->rem_port &&
+	    (acct_storage_g_commit(slurmdbd_conn->db_conn, 1) !=
+	     SLURM_SUCCESS)) {
+		comment = "Failed to commit DBD_SEND_MULT_MSG";
+		error("CONN:%u %s", slurmdbd_conn->conn->fd, comment);
+		FREE_NULL_LIST(list_msg.my_list);
+		*out_buffer = slurm_persist_make_rc_msg(slurmdbd_conn->conn,
+							SLURM_ERROR, comment,
+							DBD_SEND_MULT_MSG);
+		return SLURM_ERROR;
+	}
+
 	*out_buffer = init_buf(1024);
 	pack16((uint16_t) DBD_GOT_MULT_MSG, *out_buffer);
 	slurmdbd_pack_list_msg(&list_msg, slurmdbd_conn->conn->version,
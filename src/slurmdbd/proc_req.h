@@ -46,6 +46,7 @@
 typedef struct {
 	slurm_persist_conn_t *conn;
 	void *db_conn; /* database connection */
+	bool in_mult_msg; /* processing the messages of a DBD_SEND_MULT_MSG */
 	char *tres_str;
 } slurmdbd_conn_t;
 
@@ -85,6 +85,7 @@ extern void free_slurmdbd_conf(void)
 static void _clear_slurmdbd_conf(void)
 {
 	if (slurmdbd_conf) {
+		slurmdbd_conf->archive_columnar = false;
 		xfree(slurmdbd_conf->archive_dir);
 		xfree(slurmdbd_conf->archive_script);
 		xfree(slurmdbd_conf->auth_info);
@@ -99,6 +100,11 @@ static void _clear_slurmdbd_conf(void)
 		xfree(slurmdbd_conf->default_qos);
 		xfree(slurmdbd_conf->log_file);
 		slurmdbd_conf->syslog_debug = LOG_LEVEL_END;
+		slurmdbd_conf->max_admin_rpcs =
+			DEFAULT_SLURMDBD_MAX_ADMIN_RPCS;
+		slurmdbd_conf->max_ingest_rpcs = 0;
+		slurmdbd_conf->max_query_rpcs =
+			DEFAULT_SLURMDBD_MAX_QUERY_RPCS;
 		xfree(slurmdbd_conf->parameters);
 		xfree(slurmdbd_conf->pid_file);
 		xfree(slurmdbd_conf->plugindir);
@@ -191,7 +197,7 @@ extern int read_slurmdbd_conf(void)
 		{NULL} };
 	s_p_hashtbl_t *tbl = NULL;
 	char *conf_path = NULL;
-	char *temp_str = NULL;
+	char *temp_str = NULL, *tmp_ptr;
 	struct stat buf;
 
 	/* Set initial values */
@@ -315,10 +321,25 @@ extern int read_slurmdbd_conf(void)
 
 		s_p_get_string(&slurmdbd_conf->parameters, "Parameters", tbl);
 		if (slurmdbd_conf->parameters) {
+			if (xstrcasestr(slurmdbd_conf->parameters,
+					"archive_columnar"))
+				slurmdbd_conf->archive_columnar = true;
 			if (xstrcasestr(slurmdbd_conf->parameters,
 					"PreserveCaseUser"))
 				slurmdbd_conf->persist_conn_rc_flags |=
 					PERSIST_FLAG_P_USER_CASE;
+			if ((tmp_ptr = xstrcasestr(slurmdbd_conf->parameters,
+						   "max_admin_rpcs=")))
+				slurmdbd_conf->max_admin_rpcs =
+					atoi(tmp_ptr + 15);
+			if ((tmp_ptr = xstrcasestr(slurmdbd_conf->parameters,
+						   "max_ingest_rpcs=")))
+				slurmdbd_conf->max_ingest_rpcs =
+					atoi(tmp_ptr + 16);
+			if ((tmp_ptr = xstrcasestr(slurmdbd_conf->parameters,
+						   "max_query_rpcs=")))
+				slurmdbd_conf->max_query_rpcs =
+					atoi(tmp_ptr + 15);
 		}
 
 		s_p_get_string(&slurmdbd_conf->pid_file, "PidFile", tbl);
@@ -656,6 +677,9 @@ extern void log_config(void)
 	debug2("DefaultQOS        = %s", slurmdbd_conf->default_qos);
 
 	debug2("LogFile           = %s", slurmdbd_conf->log_file);
+	debug2("MaxAdminRPCs      = %u", slurmdbd_conf->max_admin_rpcs);
+	debug2("MaxIngestRPCs     = %u", slurmdbd_conf->max_ingest_rpcs);
+	debug2("MaxQueryRPCs      = %u", slurmdbd_conf->max_query_rpcs);
 	debug2("MessageTimeout    = %u", slurmdbd_conf->msg_timeout);
 	debug2("Parameters        = %s", slurmdbd_conf->parameters);
 	debug2("PidFile           = %s", slurmdbd_conf->pid_file);
@@ -50,11 +50,15 @@
 //#define DEFAULT_SLURMDBD_JOB_PURGE	12
 #define DEFAULT_SLURMDBD_PIDFILE	"/var/run/slurmdbd.pid"
 #define DEFAULT_SLURMDBD_ARCHIVE_DIR	"/tmp"
+#define DEFAULT_SLURMDBD_MAX_ADMIN_RPCS	4
+#define DEFAULT_SLURMDBD_MAX_QUERY_RPCS	16
 //#define DEFAULT_SLURMDBD_STEP_PURGE	1
 
 /* SlurmDBD configuration parameters */
 typedef struct {
 	time_t		last_update;	/* time slurmdbd.conf read	*/
+	bool		archive_columnar; /* also write columnar job
+					   * archives			*/
 	char *		archive_dir;    /* location to locally store
 					 * data if not using a script   */
 	char *		archive_script;	/* script to archive old data	*/
@@ -75,6 +79,9 @@ typedef struct {
 	char *		log_file;	/* Log file			*/
 	uint16_t	syslog_debug;	/* output to both logfile and syslog*/
 	uint16_t        log_fmt;        /* Log file timestamt format    */
+	uint16_t	max_admin_rpcs;	/* max concurrent admin RPCs	*/
+	uint16_t	max_ingest_rpcs;/* max concurrent slurmctld RPCs */
+	uint16_t	max_query_rpcs;	/* max concurrent query RPCs	*/
 	uint32_t	max_time_range;	/* max time range for user queries */
 	uint16_t        msg_timeout;    /* message timeout		*/
 	char *		parameters;	/* parameters to change behavior with
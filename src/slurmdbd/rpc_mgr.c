@@ -51,6 +51,7 @@
 #include "src/common/slurm_protocol_api.h"
 #include "src/common/slurm_accounting_storage.h"
 #include "src/common/slurmdbd_defs.h"
+#include "src/common/timers.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xsignal.h"
 #include "src/slurmdbd/proc_req.h"
@@ -64,6 +65,129 @@ static void _connection_fini_callback(void *arg);
 /* Local variables */
 static pthread_t       master_thread_id = 0;
 
+static pthread_mutex_t rpc_class_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  rpc_class_cond = PTHREAD_COND_INITIALIZER;
+static uint32_t        rpc_class_active[DBD_RPC_CLASS_COUNT];
+
+static char *_rpc_class_str(dbd_rpc_class_t rpc_class)
+{
+	switch (rpc_class) {
+	case DBD_RPC_CLASS_INGEST:
+		return "ingest";
+	case DBD_RPC_CLASS_QUERY:
+		return "query";
+	case DBD_RPC_CLASS_ADMIN:
+		return "admin";
+	default:
+		return "none";
+	}
+}
+
+/* Return the limit of concurrent RPCs for a class, 0 if unlimited */
+static uint16_t _rpc_class_max(dbd_rpc_class_t rpc_class)
+{
+	switch (rpc_class) {
+	case DBD_RPC_CLASS_INGEST:
+		return slurmdbd_conf->max_ingest_rpcs;
+	case DBD_RPC_CLASS_QUERY:
+		return slurmdbd_conf->max_query_rpcs;
+	case DBD_RPC_CLASS_ADMIN:
+		return slurmdbd_conf->max_admin_rpcs;
+	default:
+		return 0;
+	}
+}
+
+extern dbd_rpc_class_t rpc_mgr_class(uint16_t msg_type)
+{
+	switch (msg_type) {
+	case REQUEST_PERSIST_INIT:
+	case DBD_CLEAR_STATS:
+	case DBD_FINI:
+	case DBD_GET_CONFIG:
+	case DBD_GET_STATS:
+	case DBD_RECONFIG:
+	case DBD_SHUTDOWN:
+		return DBD_RPC_CLASS_NONE;
+	case DBD_ADD_RESV:
+	case DBD_CLUSTER_TRES:
+	case DBD_FLUSH_JOBS:
+	case DBD_JOB_COMPLETE:
+	case DBD_JOB_START:
+	case DBD_JOB_SUSPEND:
+	case DBD_MODIFY_RESV:
+	case DBD_NODE_STATE:
+	case DBD_REGISTER_CTLD:
+	case DBD_REMOVE_RESV:
+	case DBD_SEND_MULT_JOB_START:
+	case DBD_SEND_MULT_MSG:
+	case DBD_STEP_COMPLETE:
+	case DBD_STEP_START:
+		return DBD_RPC_CLASS_INGEST;
+	case DBD_GET_ACCOUNTS:
+	case DBD_GET_ASSOCS:
+	case DBD_GET_ASSOC_USAGE:
+	case DBD_GET_CLUSTERS:
+	case DBD_GET_CLUSTER_USAGE:
+	case DBD_GET_EVENTS:
+	case DBD_GET_FEDERATIONS:
+	case DBD_GET_JOBS_COND:
+	case DBD_GET_PROBS:
+	case DBD_GET_QOS:
+	case DBD_GET_RES:
+	case DBD_GET_RESVS:
+	case DBD_GET_TRES:
+	case DBD_GET_TXN:
+	case DBD_GET_USERS:
+	case DBD_GET_WCKEYS:
+	case DBD_GET_WCKEY_USAGE:
+		return DBD_RPC_CLASS_QUERY;
+	default:
+		return DBD_RPC_CLASS_ADMIN;
+	}
+}
+
+extern void rpc_mgr_class_enter(dbd_rpc_class_t rpc_class)
+{
+	uint16_t max_rpcs;
+	bool waited = false;
+	DEF_TIMERS;
+
+	if (rpc_class == DBD_RPC_CLASS_NONE)
+		return;
+
+	slurm_mutex_lock(&rpc_class_mutex);
+	while (!shutdown_time && (max_rpcs = _rpc_class_max(rpc_class)) &&
+	       (rpc_class_active[rpc_class] >= max_rpcs)) {
+		if (!waited) {
+			START_TIMER;
+			waited = true;
+		}
+		slurm_cond_wait(&rpc_class_cond, &rpc_class_mutex);
+	}
+	rpc_class_active[rpc_class]++;
+	slurm_mutex_unlock(&rpc_class_mutex);
+
+	if (waited) {
+		END_TIMER;
+		debug2("%s: %s RPC waited %s for one of %u slots",
+		       __func__, _rpc_class_str(rpc_class), TIME_STR,
+		       _rpc_class_max(rpc_class));
+	}
+}
+
+extern void rpc_mgr_class_exit(dbd_rpc_class_t rpc_class)
+{
+	if (rpc_class == DBD_RPC_CLASS_NONE)
+		return;
+
+	slurm_mutex_lock(&rpc_class_mutex);
+	xassert(rpc_class_active[rpc_class]);
+	rpc_class_active[rpc_class]--;
+	slurm_cond_broadcast(&rpc_class_cond);
+	slurm_mutex_unlock(&rpc_class_mutex);
+}
+
 /* Process incoming RPCs. Meant to execute as a pthread */
 extern void *rpc_mgr(void *no_data)
 {
@@ -130,6 +254,9 @@ extern void rpc_mgr_wake(void)
 {
 	if (master_thread_id)
 		pthread_kill(master_thread_id, SIGUSR1);
+	slurm_mutex_lock(&rpc_class_mutex);
+	slurm_cond_broadcast(&rpc_class_cond);
+	slurm_mutex_unlock(&rpc_class_mutex);
 	slurm_persist_conn_recv_server_fini();
 }
 
@@ -42,6 +42,29 @@
 #include "src/common/pack.h"
 #include "src/common/assoc_mgr.h"
 
+/*
+ * Classes of RPCs, each with its own limit on how many are processed at
+ * once so that neither can starve the others of database and lock time
+ */
+typedef enum {
+	DBD_RPC_CLASS_NONE,	/* connection and daemon control, never wait */
+	DBD_RPC_CLASS_INGEST,	/* job, step and node records from slurmctld */
+	DBD_RPC_CLASS_QUERY,	/* requests for data, e.g. sacct */
+	DBD_RPC_CLASS_ADMIN,	/* changes to the database, e.g. sacctmgr */
+	DBD_RPC_CLASS_COUNT
+} dbd_rpc_class_t;
+
+/* Return the class of an RPC */
+extern dbd_rpc_class_t rpc_mgr_class(uint16_t msg_type);
+
+/*
+ * Wait until an RPC of the given class may be processed, as set by
+ * Parameters=max_admin_rpcs,max_ingest_rpcs,max_query_rpcs in slurmdbd.conf.
+ * Every call must be paired with rpc_mgr_class_exit().
+ */
+extern void rpc_mgr_class_enter(dbd_rpc_class_t rpc_class);
+extern void rpc_mgr_class_exit(dbd_rpc_class_t rpc_class);
+
 /* Process incoming RPCs. Meant to execute as a pthread */
 extern void *rpc_mgr(void *no_data);
 
@@ -0,0 +1,132 @@
+#include <arpa/inet.h>
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "src/common/slurm_protocol_api.h"
+#include "src/common/slurm_protocol_common.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+
+#define MSG_LEN (64 * 1024)
+
+static char conf_file[] = "/tmp/compress_msg-test.XXXXXX";
+
+/*
+ * Send a large SRUN_USER_MSG as if replying to a peer which advertised
+ * peer_flags, return the number of bytes on the wire after checking that
+ * the message received on the other end matches what was sent.
+ */
+static uint32_t _round_trip(uint16_t peer_flags)
+{
+	int fds[2], rc;
+	uint32_t wire_len;
+	slurm_msg_t msg, recv_msg;
+	srun_user_msg_t user_msg = {0}, *recv_user_msg;
+
+	ck_assert_int_eq(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+
+	user_msg.job_id = 1234;
+	user_msg.msg = xmalloc(MSG_LEN + 1);
+	memset(user_msg.msg, 'x', MSG_LEN);
+
+	slurm_msg_t_init(&msg);
+	msg.msg_type = SRUN_USER_MSG;
+	msg.flags = peer_flags;
+	msg.data = &user_msg;
+	rc = slurm_send_node_msg(fds[0], &msg);
+	ck_assert_int_gt(rc, 0);
+
+	ck_assert_int_eq(recv(fds[1], &wire_len, sizeof(wire_len), MSG_PEEK),
+			 sizeof(wire_len));
+
+	slurm_msg_t_init(&recv_msg);
+	rc = slurm_receive_msg(fds[1], &recv_msg, 0);
+	ck_assert_int_eq(rc, SLURM_SUCCESS);
+	ck_assert_int_eq(recv_msg.msg_type, SRUN_USER_MSG);
+	ck_assert(!(recv_msg.flags & SLURM_MSG_COMPRESSED));
+	recv_user_msg = recv_msg.data;
+	ck_assert_uint_eq(recv_user_msg->job_id, user_msg.job_id);
+	ck_assert_str_eq(recv_user_msg->msg, user_msg.msg);
+
+	slurm_free_msg_members(&recv_msg);
+	xfree(user_msg.msg);
+	close(fds[0]);
+	close(fds[1]);
+
+	return ntohl(wire_len);
+}
+
+START_TEST(peer_accepts_zlib)
+{
+	ck_assert_uint_lt(_round_trip(SLURM_MSG_ACCEPT_ZLIB), MSG_LEN / 10);
+}
+END_TEST
+
+START_TEST(peer_accepts_nothing)
+{
+	ck_assert_uint_gt(_round_trip(SLURM_PROTOCOL_NO_FLAGS), MSG_LEN);
+}
+END_TEST
+
+START_TEST(peer_accepts_other)
+{
+	ck_assert_uint_gt(_round_trip(SLURM_MSG_ACCEPT_LZ4), MSG_LEN);
+}
+END_TEST
+
+/*****************************************************************************
+ * TEST SUITE                                                                *
+ ****************************************************************************/
+
+Suite *suite(void)
+{
+	Suite *s = suite_create("Compress messages");
+	TCase *tc_core = tcase_create("Compress messages");
+	tcase_add_test(tc_core, peer_accepts_zlib);
+	tcase_add_test(tc_core, peer_accepts_nothing);
+	tcase_add_test(tc_core, peer_accepts_other);
+	suite_add_tcase(s, tc_core);
+	return s;
+}
+
+/*****************************************************************************
+ * TEST RUNNER                                                               *
+ ****************************************************************************/
+
+int main(void)
+{
+	int number_failed, fd;
+	char *conf = NULL;
+	SRunner *sr;
+
+#if !HAVE_LIBZ
+	printf("Can't perform compression tests without zlib.\n");
+	return EXIT_SUCCESS;
+#endif
+
+	xstrfmtcat(conf, "ClusterName=test\n"
+		   "SlurmctldHost=localhost\n"
+		   "AuthType=auth/none\n"
+		   "PluginDir=%s\n"
+		   "CommunicationParameters=CompressMsgs=zlib,CompressMsgsMin=1024\n",
+		   AUTH_NONE_DIR);
+	if (((fd = mkstemp(conf_file)) < 0) ||
+	    (write(fd, conf, strlen(conf)) != strlen(conf))) {
+		perror(conf_file);
+		return EXIT_FAILURE;
+	}
+	close(fd);
+	xfree(conf);
+	setenv("SLURM_CONF", conf_file, 1);
+
+	sr = srunner_create(suite());
+	srunner_run_all(sr, CK_VERBOSE);
+	number_failed = srunner_ntests_failed(sr);
+	srunner_free(sr);
+	unlink(conf_file);
+
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
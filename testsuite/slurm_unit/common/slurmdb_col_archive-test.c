@@ -0,0 +1,390 @@
+#include <check.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "src/common/list.h"
+#include "src/common/pack.h"
+#include "src/common/slurmdb_col_archive.h"
+#include "src/common/slurmdb_defs.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+
+/* More jobs than fit in one block (4096 rows), last block partial */
+#define JOB_CNT		(3 * 4096 + 100)
+#define BLOCK_ROWS	4096
+#define BASE_TIME	1500000000
+
+static char *archive_file = NULL;
+
+/*
+ * Fill job as the i'th job of the archive. Users and accounts change in the
+ * middle of blocks, times go up with i and a few jobs of the first and last
+ * blocks are still running.
+ */
+static void _init_job(slurmdb_job_rec_t *job, int i)
+{
+	job->jobid = i + 1;
+	job->uid = 1000 + (i / 3000);
+	job->gid = 100 + (i % 4);
+	job->account = xstrdup_printf("acct%d", i / 5000);
+	job->partition = xstrdup((i % 2) ? "gpu" : "debug");
+	job->jobname = xstrdup_printf("job%d", i);
+	job->nodes = xstrdup_printf("node[%d-%d]", i % 10, (i % 10) + 1);
+	job->constraints = (i % 2) ? NULL : xstrdup("intel");
+	job->wckey = xstrdup("");
+	job->work_dir = xstrdup("/home/user");
+	job->tres_alloc_str = xstrdup_printf("1=%d,4=2", (i % 8) + 1);
+	job->tres_req_str = xstrdup("1=1,4=2");
+	job->alloc_nodes = 2;
+	job->array_job_id = (i % 10) ? 0 : i + 1;
+	job->array_task_id = (i % 10) ? NO_VAL : 0;
+	job->derived_ec = i % 3;
+	job->exitcode = i % 256;
+	job->flags = SLURMDB_JOB_FLAG_SCHED;
+	job->het_job_id = 0;
+	job->het_job_offset = NO_VAL;
+	job->priority = i * 7;
+	job->qosid = 1;
+	job->req_cpus = (i % 8) + 1;
+	job->req_mem = 1024;
+	job->submit = BASE_TIME + (i * 60);
+	job->eligible = job->submit + 10;
+	job->start = job->submit + 30;
+	job->suspended = i % 5;
+	job->timelimit = 60;
+	job->track_steps = 0;
+	if (!((i / BLOCK_ROWS) % 3) && !(i % 97)) {
+		job->state = JOB_RUNNING;
+		job->end = 0;
+	} else {
+		job->state = (i % 3) ? JOB_COMPLETE : JOB_FAILED;
+		job->end = job->start + 600;
+	}
+}
+
+/* Brute force copy of the default -S/-E rule of the database */
+static bool _in_window(slurmdb_job_rec_t *job, time_t start, time_t end)
+{
+	return (job->eligible && (job->eligible < end) &&
+		(!job->end || (job->end >= start)));
+}
+
+static void _check_job(slurmdb_job_rec_t *job, int i)
+{
+	slurmdb_job_rec_t *exp = slurmdb_create_job_rec();
+
+	_init_job(exp, i);
+	ck_assert_int_eq(job->jobid, exp->jobid);
+	ck_assert_int_eq(job->uid, exp->uid);
+	ck_assert_int_eq(job->gid, exp->gid);
+	ck_assert_str_eq(job->account, exp->account);
+	ck_assert_str_eq(job->partition, exp->partition);
+	ck_assert_str_eq(job->jobname, exp->jobname);
+	ck_assert_str_eq(job->nodes, exp->nodes);
+	ck_assert(!xstrcmp(job->constraints, exp->constraints));
+	ck_assert(!xstrcmp(job->wckey, exp->wckey));
+	ck_assert_str_eq(job->work_dir, exp->work_dir);
+	ck_assert_str_eq(job->tres_alloc_str, exp->tres_alloc_str);
+	ck_assert_str_eq(job->tres_req_str, exp->tres_req_str);
+	ck_assert_int_eq(job->alloc_nodes, exp->alloc_nodes);
+	ck_assert_int_eq(job->array_job_id, exp->array_job_id);
+	ck_assert_int_eq(job->array_task_id, exp->array_task_id);
+	ck_assert_int_eq(job->derived_ec, exp->derived_ec);
+	ck_assert_int_eq(job->exitcode, exp->exitcode);
+	ck_assert_int_eq(job->flags, exp->flags);
+	ck_assert_int_eq(job->het_job_id, exp->het_job_id);
+	ck_assert_int_eq(job->het_job_offset, exp->het_job_offset);
+	ck_assert_int_eq(job->priority, exp->priority);
+	ck_assert_int_eq(job->qosid, exp->qosid);
+	ck_assert_int_eq(job->req_cpus, exp->req_cpus);
+	ck_assert(job->req_mem == exp->req_mem);
+	ck_assert(job->submit == exp->submit);
+	ck_assert(job->eligible == exp->eligible);
+	ck_assert(job->start == exp->start);
+	ck_assert(job->end == exp->end);
+	ck_assert_int_eq(job->suspended, exp->suspended);
+	ck_assert_int_eq(job->state, exp->state);
+	ck_assert_int_eq(job->timelimit, exp->timelimit);
+	ck_assert_int_eq(job->track_steps, exp->track_steps);
+	slurmdb_destroy_job_rec(exp);
+}
+
+/*
+ * Read the archive with job_cond and check that exactly the jobs for which
+ * match() is true come back, in order and with all of their fields.
+ */
+static void _check_read(slurmdb_job_cond_t *job_cond,
+			bool (*match)(slurmdb_job_rec_t *job,
+				      slurmdb_job_cond_t *job_cond))
+{
+	slurmdb_job_rec_t *job, *exp;
+	ListIterator itr;
+	List job_list;
+	int i, cnt = 0;
+
+	job_list = slurmdb_col_archive_read_jobs(archive_file, job_cond,
+						 NULL, NULL);
+	ck_assert(job_list != NULL);
+
+	itr = list_iterator_create(job_list);
+	for (i = 0; i < JOB_CNT; i++) {
+		exp = slurmdb_create_job_rec();
+		_init_job(exp, i);
+		if (match(exp, job_cond)) {
+			job = list_next(itr);
+			ck_assert(job != NULL);
+			_check_job(job, i);
+			cnt++;
+		}
+		slurmdb_destroy_job_rec(exp);
+	}
+	ck_assert(list_next(itr) == NULL);
+	list_iterator_destroy(itr);
+
+	ck_assert_int_eq(list_count(job_list), cnt);
+	ck_assert_int_gt(cnt, 0);
+	FREE_NULL_LIST(job_list);
+}
+
+static void _write_archive(void)
+{
+	slurmdb_col_writer_t *writer;
+	slurmdb_job_rec_t *job;
+	slurmdb_tres_rec_t *tres;
+	slurmdb_qos_rec_t *qos;
+	List tres_list, qos_list;
+	Buf buffer;
+	char *data;
+	uint32_t len;
+	int fd, i;
+
+	tres_list = list_create(slurmdb_destroy_tres_rec);
+	tres = xmalloc(sizeof(*tres));
+	tres->id = TRES_CPU;
+	tres->type = xstrdup("cpu");
+	list_append(tres_list, tres);
+	tres = xmalloc(sizeof(*tres));
+	tres->id = TRES_NODE;
+	tres->type = xstrdup("node");
+	list_append(tres_list, tres);
+
+	qos_list = list_create(slurmdb_destroy_qos_rec);
+	qos = xmalloc(sizeof(*qos));
+	slurmdb_init_qos_rec(qos, 0, NO_VAL);
+	qos->id = 1;
+	qos->name = xstrdup("normal");
+	list_append(qos_list, qos);
+
+	writer = slurmdb_col_writer_create("cluster1", tres_list, qos_list);
+	for (i = 0; i < JOB_CNT; i++) {
+		job = slurmdb_create_job_rec();
+		_init_job(job, i);
+		slurmdb_col_writer_add_job(writer, job);
+		slurmdb_destroy_job_rec(job);
+	}
+	buffer = slurmdb_col_writer_fini(writer);
+	FREE_NULL_LIST(tres_list);
+	FREE_NULL_LIST(qos_list);
+
+	archive_file = xstrdup_printf("/tmp/slurmdb_col_archive-test.%d",
+				      (int) getpid());
+	if ((fd = open(archive_file, O_CREAT | O_EXCL | O_WRONLY, 0600)) < 0) {
+		perror("open");
+		exit(EXIT_FAILURE);
+	}
+	data = get_buf_data(buffer);
+	len = get_buf_offset(buffer);
+	while (len > 0) {
+		ssize_t wrote = write(fd, data, len);
+		if (wrote <= 0) {
+			perror("write");
+			unlink(archive_file);
+			exit(EXIT_FAILURE);
+		}
+		data += wrote;
+		len -= wrote;
+	}
+	close(fd);
+	free_buf(buffer);
+}
+
+static bool _match_all(slurmdb_job_rec_t *job, slurmdb_job_cond_t *job_cond)
+{
+	return true;
+}
+
+START_TEST(read_all)
+{
+	_check_read(NULL, _match_all);
+}
+END_TEST
+
+START_TEST(read_dict)
+{
+	List tres_list = NULL, qos_list = NULL;
+	slurmdb_tres_rec_t *tres;
+	slurmdb_qos_rec_t *qos;
+	int rc;
+
+	rc = slurmdb_col_archive_read_dict(archive_file, &tres_list,
+					   &qos_list);
+	ck_assert_int_eq(rc, SLURM_SUCCESS);
+	ck_assert_int_eq(list_count(tres_list), 2);
+	tres = list_peek(tres_list);
+	ck_assert_int_eq(tres->id, TRES_CPU);
+	ck_assert_str_eq(tres->type, "cpu");
+	ck_assert_int_eq(list_count(qos_list), 1);
+	qos = list_peek(qos_list);
+	ck_assert_int_eq(qos->id, 1);
+	ck_assert_str_eq(qos->name, "normal");
+	FREE_NULL_LIST(tres_list);
+	FREE_NULL_LIST(qos_list);
+}
+END_TEST
+
+static bool _match_window(slurmdb_job_rec_t *job, slurmdb_job_cond_t *job_cond)
+{
+	return _in_window(job, job_cond->usage_start, job_cond->usage_end);
+}
+
+/*
+ * The window only covers the second and third blocks. The last block is
+ * skipped, the first one can't be as its running jobs still match.
+ */
+START_TEST(read_time_window)
+{
+	slurmdb_job_cond_t job_cond;
+
+	memset(&job_cond, 0, sizeof(job_cond));
+	job_cond.db_flags = SLURMDB_JOB_FLAG_NOTSET;
+	job_cond.usage_start = BASE_TIME + (5000 * 60);
+	job_cond.usage_end = BASE_TIME + (11000 * 60);
+	_check_read(&job_cond, _match_window);
+}
+END_TEST
+
+static bool _match_user(slurmdb_job_rec_t *job, slurmdb_job_cond_t *job_cond)
+{
+	return ((job->uid == 1001) &&
+		_in_window(job, job_cond->usage_start, job_cond->usage_end));
+}
+
+/* uid 1001 ran jobs 3000 to 5999, across the first two blocks */
+START_TEST(read_user)
+{
+	slurmdb_job_cond_t job_cond;
+
+	memset(&job_cond, 0, sizeof(job_cond));
+	job_cond.db_flags = SLURMDB_JOB_FLAG_NOTSET;
+	job_cond.usage_end = BASE_TIME + (JOB_CNT * 60);
+	job_cond.userid_list = list_create(xfree_ptr);
+	list_append(job_cond.userid_list, xstrdup("1001"));
+	_check_read(&job_cond, _match_user);
+	FREE_NULL_LIST(job_cond.userid_list);
+}
+END_TEST
+
+static bool _match_acct_part(slurmdb_job_rec_t *job,
+			     slurmdb_job_cond_t *job_cond)
+{
+	return (!xstrcmp(job->account, "acct1") &&
+		!xstrcmp(job->partition, "gpu") &&
+		_in_window(job, job_cond->usage_start, job_cond->usage_end));
+}
+
+START_TEST(read_account_partition)
+{
+	slurmdb_job_cond_t job_cond;
+
+	memset(&job_cond, 0, sizeof(job_cond));
+	job_cond.db_flags = SLURMDB_JOB_FLAG_NOTSET;
+	job_cond.usage_end = BASE_TIME + (JOB_CNT * 60);
+	job_cond.acct_list = list_create(xfree_ptr);
+	list_append(job_cond.acct_list, xstrdup("acct1"));
+	job_cond.partition_list = list_create(xfree_ptr);
+	list_append(job_cond.partition_list, xstrdup("gpu"));
+	_check_read(&job_cond, _match_acct_part);
+	FREE_NULL_LIST(job_cond.acct_list);
+	FREE_NULL_LIST(job_cond.partition_list);
+}
+END_TEST
+
+static bool _match_state(slurmdb_job_rec_t *job, slurmdb_job_cond_t *job_cond)
+{
+	return ((job->state == JOB_FAILED) && job->end &&
+		(job->end >= job_cond->usage_start) &&
+		(job->end <= job_cond->usage_end));
+}
+
+/* Jobs which failed *in* the window, which turns off block skipping */
+START_TEST(read_state)
+{
+	slurmdb_job_cond_t job_cond;
+
+	memset(&job_cond, 0, sizeof(job_cond));
+	job_cond.db_flags = SLURMDB_JOB_FLAG_NOTSET;
+	job_cond.usage_start = BASE_TIME + (2000 * 60);
+	job_cond.usage_end = BASE_TIME + (9000 * 60);
+	job_cond.state_list = list_create(xfree_ptr);
+	list_append(job_cond.state_list, xstrdup_printf("%d", JOB_FAILED));
+	_check_read(&job_cond, _match_state);
+	FREE_NULL_LIST(job_cond.state_list);
+}
+END_TEST
+
+START_TEST(read_other_cluster)
+{
+	slurmdb_job_cond_t job_cond;
+	List job_list;
+
+	memset(&job_cond, 0, sizeof(job_cond));
+	job_cond.db_flags = SLURMDB_JOB_FLAG_NOTSET;
+	job_cond.cluster_list = list_create(xfree_ptr);
+	list_append(job_cond.cluster_list, xstrdup("cluster2"));
+	job_list = slurmdb_col_archive_read_jobs(archive_file, &job_cond,
+						 NULL, NULL);
+	ck_assert(job_list != NULL);
+	ck_assert_int_eq(list_count(job_list), 0);
+	FREE_NULL_LIST(job_list);
+	FREE_NULL_LIST(job_cond.cluster_list);
+}
+END_TEST
+
+Suite *suite(void)
+{
+	Suite *s = suite_create("Columnar job archive");
+	TCase *tc_core = tcase_create("Columnar job archive");
+	tcase_add_test(tc_core, read_all);
+	tcase_add_test(tc_core, read_dict);
+	tcase_add_test(tc_core, read_time_window);
+	tcase_add_test(tc_core, read_user);
+	tcase_add_test(tc_core, read_account_partition);
+	tcase_add_test(tc_core, read_state);
+	tcase_add_test(tc_core, read_other_cluster);
+	suite_add_tcase(s, tc_core);
+	return s;
+}
+
+/*****************************************************************************
+ * TEST RUNNER                                                               *
+ ****************************************************************************/
+
+int main(void)
+{
+	int number_failed;
+	SRunner *sr = srunner_create(suite());
+
+	_write_archive();
+
+	srunner_run_all(sr, CK_VERBOSE);
+	number_failed = srunner_ntests_failed(sr);
+	srunner_free(sr);
+
+	unlink(archive_file);
+	xfree(archive_file);
+
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
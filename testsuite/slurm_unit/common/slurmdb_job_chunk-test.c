@@ -0,0 +1,305 @@
+#include <check.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "src/common/list.h"
+#include "src/common/slurmdb_defs.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+
+#define CHUNK_SIZE	10
+#define MAX_RECORDS	100
+
+/*
+ * Database records of a cluster in id_job order.  Records with the same job
+ * id after the first one are duplicates and hidden records are filtered out
+ * after the query, like jobs of other users with PrivateData=jobs.
+ */
+typedef struct {
+	uint32_t jobid;
+	bool hidden;
+} fake_record_t;
+
+typedef struct {
+	char *name;
+	int record_cnt;
+	fake_record_t records[MAX_RECORDS];
+} fake_cluster_t;
+
+typedef struct {
+	int cluster_cnt;
+	fake_cluster_t *clusters;
+} fake_db_t;
+
+/* Add jobs first_jobid to last_jobid to a cluster */
+static void _add_jobs(fake_cluster_t *cluster, uint32_t first_jobid,
+		      uint32_t last_jobid, bool hidden)
+{
+	uint32_t jobid;
+
+	for (jobid = first_jobid; jobid <= last_jobid; jobid++) {
+		ck_assert(cluster->record_cnt < MAX_RECORDS);
+		cluster->records[cluster->record_cnt].jobid = jobid;
+		cluster->records[cluster->record_cnt].hidden = hidden;
+		cluster->record_cnt++;
+	}
+}
+
+/* Same as _cluster_get_jobs() does with the database */
+static int _get_cluster_jobs(char *cluster_name, uint32_t limit,
+			     uint32_t *after_jobid, bool *exhausted,
+			     List job_list, void *arg)
+{
+	fake_db_t *db = (fake_db_t *)arg;
+	fake_cluster_t *cluster = NULL;
+	slurmdb_job_rec_t *job;
+	uint32_t end_jobid = 0, last_jobid = 0, match_cnt = 0;
+	int i;
+
+	for (i = 0; i < db->cluster_cnt; i++) {
+		if (!xstrcmp(db->clusters[i].name, cluster_name))
+			cluster = &db->clusters[i];
+	}
+	ck_assert(cluster != NULL);
+
+	*exhausted = true;
+	if (limit) {
+		for (i = 0; i < cluster->record_cnt; i++) {
+			if ((cluster->records[i].jobid > *after_jobid) &&
+			    (++match_cnt == limit)) {
+				end_jobid = cluster->records[i].jobid;
+				*exhausted = false;
+				break;
+			}
+		}
+	}
+
+	for (i = 0; i < cluster->record_cnt; i++) {
+		fake_record_t *record = &cluster->records[i];
+
+		if ((record->jobid <= *after_jobid) ||
+		    (end_jobid && (record->jobid > end_jobid)))
+			continue;
+		if (limit)
+			*after_jobid = record->jobid;
+		if (record->jobid == last_jobid)
+			continue;
+		last_jobid = record->jobid;
+		if (record->hidden)
+			continue;
+
+		job = slurmdb_create_job_rec();
+		job->cluster = xstrdup(cluster_name);
+		job->jobid = record->jobid;
+		list_append(job_list, job);
+	}
+
+	return SLURM_SUCCESS;
+}
+
+static List _cluster_list(fake_db_t *db)
+{
+	List cluster_list = list_create(NULL);
+	int i;
+
+	for (i = 0; i < db->cluster_cnt; i++)
+		list_append(cluster_list, db->clusters[i].name);
+	return cluster_list;
+}
+
+/*
+ * Get all the jobs of db at once and chunk by chunk like sacct does, and
+ * check both return the same jobs in the same order.
+ * RET number of chunks with jobs
+ */
+static int _check_chunks(fake_db_t *db)
+{
+	slurmdb_job_cond_t job_cond;
+	List cluster_list = _cluster_list(db);
+	List all_list = list_create(slurmdb_destroy_job_rec);
+	List chunk_list = NULL;
+	ListIterator itr;
+	slurmdb_job_rec_t *job, *chunk_job;
+	int chunk_cnt = 0, job_cnt;
+
+	memset(&job_cond, 0, sizeof(job_cond));
+	slurmdb_job_chunk_get(&job_cond, cluster_list, _get_cluster_jobs, db,
+			      all_list);
+
+	job_cond.chunk_size = CHUNK_SIZE;
+	itr = list_iterator_create(all_list);
+	do {
+		FREE_NULL_LIST(chunk_list);
+		chunk_list = list_create(slurmdb_destroy_job_rec);
+		slurmdb_job_chunk_get(&job_cond, cluster_list,
+				      _get_cluster_jobs, db, chunk_list);
+		slurmdb_job_chunk_set_cursor(&job_cond, chunk_list);
+		if ((job_cnt = list_count(chunk_list)))
+			chunk_cnt++;
+		ck_assert(job_cnt <= CHUNK_SIZE);
+
+		while ((chunk_job = list_pop(chunk_list))) {
+			job = list_next(itr);
+			ck_assert(job != NULL);
+			ck_assert_str_eq(chunk_job->cluster, job->cluster);
+			ck_assert_int_eq(chunk_job->jobid, job->jobid);
+			slurmdb_destroy_job_rec(chunk_job);
+		}
+	} while (job_cnt);
+	ck_assert(list_next(itr) == NULL);
+	list_iterator_destroy(itr);
+
+	FREE_NULL_LIST(chunk_list);
+	FREE_NULL_LIST(all_list);
+	FREE_NULL_LIST(cluster_list);
+	xfree(job_cond.cursor_cluster);
+
+	return chunk_cnt;
+}
+
+/* The last chunk ends exactly on the last job, the next one is empty */
+START_TEST(chunk_ends_on_limit)
+{
+	fake_cluster_t cluster = { .name = "cluster1" };
+	fake_db_t db = { .cluster_cnt = 1, .clusters = &cluster };
+
+	_add_jobs(&cluster, 1, 2 * CHUNK_SIZE, false);
+	ck_assert_int_eq(_check_chunks(&db), 2);
+}
+END_TEST
+
+START_TEST(chunk_partial)
+{
+	fake_cluster_t cluster = { .name = "cluster1" };
+	fake_db_t db = { .cluster_cnt = 1, .clusters = &cluster };
+
+	_add_jobs(&cluster, 1, (2 * CHUNK_SIZE) + 3, false);
+	ck_assert_int_eq(_check_chunks(&db), 3);
+}
+END_TEST
+
+/* Chunks go on in the next cluster, also when one ends on the limit */
+START_TEST(chunk_clusters)
+{
+	fake_cluster_t clusters[4] = {
+		{ .name = "cluster1" }, { .name = "cluster2" },
+		{ .name = "cluster3" }, { .name = "cluster4" },
+	};
+	fake_db_t db = { .cluster_cnt = 4, .clusters = clusters };
+
+	_add_jobs(&clusters[0], 1, CHUNK_SIZE + 4, false);
+	/* cluster2 has no jobs */
+	_add_jobs(&clusters[2], 100, 100 + CHUNK_SIZE - 1, false);
+	_add_jobs(&clusters[3], 5, 7, false);
+	ck_assert_int_eq(_check_chunks(&db), 3);
+}
+END_TEST
+
+/* All the records of a job id come in the same chunk, even past the limit */
+START_TEST(chunk_duplicates)
+{
+	fake_cluster_t cluster = { .name = "cluster1" };
+	fake_db_t db = { .cluster_cnt = 1, .clusters = &cluster };
+
+	_add_jobs(&cluster, 1, CHUNK_SIZE - 1, false);
+	_add_jobs(&cluster, CHUNK_SIZE, CHUNK_SIZE, false);
+	_add_jobs(&cluster, CHUNK_SIZE, CHUNK_SIZE, false);
+	_add_jobs(&cluster, CHUNK_SIZE, CHUNK_SIZE, false);
+	_add_jobs(&cluster, CHUNK_SIZE + 1, CHUNK_SIZE + 5, false);
+	ck_assert_int_eq(_check_chunks(&db), 2);
+}
+END_TEST
+
+/* Records filtered after the query don't end the jobs early */
+START_TEST(chunk_hidden)
+{
+	fake_cluster_t clusters[2] = {
+		{ .name = "cluster1" }, { .name = "cluster2" },
+	};
+	fake_db_t db = { .cluster_cnt = 2, .clusters = clusters };
+
+	_add_jobs(&clusters[0], 1, 5, false);
+	_add_jobs(&clusters[0], 6, 5 + (3 * CHUNK_SIZE), true);
+	_add_jobs(&clusters[0], 6 + (3 * CHUNK_SIZE), 8 + (3 * CHUNK_SIZE),
+		  false);
+	_add_jobs(&clusters[1], 1, CHUNK_SIZE, true);
+	_add_jobs(&clusters[1], CHUNK_SIZE + 1, CHUNK_SIZE + 2, false);
+	ck_assert_int_eq(_check_chunks(&db), 2);
+}
+END_TEST
+
+START_TEST(chunk_no_jobs)
+{
+	fake_cluster_t clusters[2] = {
+		{ .name = "cluster1" }, { .name = "cluster2" },
+	};
+	fake_db_t db = { .cluster_cnt = 2, .clusters = clusters };
+
+	ck_assert_int_eq(_check_chunks(&db), 0);
+}
+END_TEST
+
+/* A cursor on a cluster which is no longer asked for ends the jobs */
+START_TEST(chunk_unknown_cursor)
+{
+	fake_cluster_t cluster = { .name = "cluster1" };
+	fake_db_t db = { .cluster_cnt = 1, .clusters = &cluster };
+	slurmdb_job_cond_t job_cond;
+	List cluster_list = _cluster_list(&db);
+	List job_list = list_create(slurmdb_destroy_job_rec);
+
+	_add_jobs(&cluster, 1, 5, false);
+	memset(&job_cond, 0, sizeof(job_cond));
+	job_cond.chunk_size = CHUNK_SIZE;
+	job_cond.cursor_cluster = xstrdup("cluster2");
+	job_cond.cursor_jobid = 3;
+	slurmdb_job_chunk_get(&job_cond, cluster_list, _get_cluster_jobs, &db,
+			      job_list);
+	ck_assert_int_eq(list_count(job_list), 0);
+
+	/* An empty chunk leaves the cursor alone */
+	slurmdb_job_chunk_set_cursor(&job_cond, job_list);
+	ck_assert_str_eq(job_cond.cursor_cluster, "cluster2");
+	ck_assert_int_eq(job_cond.cursor_jobid, 3);
+
+	xfree(job_cond.cursor_cluster);
+	FREE_NULL_LIST(job_list);
+	FREE_NULL_LIST(cluster_list);
+}
+END_TEST
+
+/*****************************************************************************
+ * TEST SUITE                                                                *
+ ****************************************************************************/
+
+Suite *suite(void)
+{
+	Suite *s = suite_create("Job chunks");
+	TCase *tc_core = tcase_create("Job chunks");
+	tcase_add_test(tc_core, chunk_ends_on_limit);
+	tcase_add_test(tc_core, chunk_partial);
+	tcase_add_test(tc_core, chunk_clusters);
+	tcase_add_test(tc_core, chunk_duplicates);
+	tcase_add_test(tc_core, chunk_hidden);
+	tcase_add_test(tc_core, chunk_no_jobs);
+	tcase_add_test(tc_core, chunk_unknown_cursor);
+	suite_add_tcase(s, tc_core);
+	return s;
+}
+
+/*****************************************************************************
+ * TEST RUNNER                                                               *
+ ****************************************************************************/
+
+int main(void)
+{
+	int number_failed;
+	SRunner *sr = srunner_create(suite());
+
+	srunner_run_all(sr, CK_VERBOSE);
+	number_failed = srunner_ntests_failed(sr);
+	srunner_free(sr);
+
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,303 @@
+#include <check.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "src/common/slurmdb_defs.h"
+#include "src/common/slurmdb_pack.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+#include "src/common/slurm_protocol_common.h"
+#include "src/common/slurm_protocol_defs.h"
+#include "src/common/list.h"
+#include "src/common/pack.h"
+
+START_TEST(invalid_protocol)
+{
+	int rc;
+	uint32_t x;
+
+	slurmdb_job_cond_t *cond_rec = xmalloc(sizeof(slurmdb_job_cond_t));
+	Buf buf = init_buf(1024);
+
+	pack32(22, buf);
+	set_buf_offset(buf, 0);
+
+	slurmdb_job_cond_t *acr;
+
+	slurmdb_pack_job_cond((void *)cond_rec, 0, buf);
+	unpack32(&x, buf);
+	rc = slurmdb_unpack_job_cond((void **)&acr, 0, buf);
+	ck_assert_int_eq(rc, SLURM_ERROR);
+	ck_assert(x == 22);
+	free_buf(buf);
+	slurmdb_destroy_job_cond(cond_rec);
+}
+END_TEST
+
+static List _str_list(char *str1, char *str2)
+{
+	List list = list_create(xfree_ptr);
+
+	list_append(list, xstrdup(str1));
+	list_append(list, xstrdup(str2));
+	return list;
+}
+
+static void _init_job_cond(slurmdb_job_cond_t *pack)
+{
+	slurmdb_selected_step_t *step;
+
+	pack->acct_list = _str_list("acct1", "acct2");
+	pack->associd_list = _str_list("1", "2");
+	pack->chunk_size = 1000;
+	pack->cluster_list = _str_list("cluster1", "cluster2");
+	pack->constraint_list = _str_list("intel", "knl");
+	pack->cpus_max = 3;
+	pack->cpus_min = 4;
+	pack->cursor_cluster = xstrdup("cluster2");
+	pack->cursor_jobid = 4242;
+	pack->db_flags = SLURMDB_JOB_FLAG_SCHED;
+	pack->exitcode = 5;
+	pack->flags = JOBCOND_FLAG_DUP;
+	pack->format_list = _str_list("format1", "format2");
+	pack->groupid_list = _str_list("100", "101");
+	pack->jobname_list = _str_list("name1", "name2");
+	pack->nodes_max = 6;
+	pack->nodes_min = 7;
+	pack->partition_list = _str_list("part1", "part2");
+	pack->qos_list = _str_list("1", "3");
+	pack->reason_list = _str_list("reason1", "reason2");
+	pack->resv_list = _str_list("resv1", "resv2");
+	pack->resvid_list = _str_list("8", "9");
+	pack->state_list = _str_list("3", "5");
+
+	pack->step_list = list_create(slurmdb_destroy_selected_step);
+	step = xmalloc(sizeof(*step));
+	step->array_task_id = NO_VAL;
+	step->het_job_offset = NO_VAL;
+	step->jobid = 123;
+	step->stepid = NO_VAL;
+	list_append(pack->step_list, step);
+
+	pack->timelimit_max = 10;
+	pack->timelimit_min = 11;
+	pack->usage_end = 12;
+	pack->usage_start = 13;
+	pack->used_nodes = xstrdup("node[1-2]");
+	pack->userid_list = _str_list("1000", "1001");
+	pack->wckey_list = _str_list("wckey1", "wckey2");
+}
+
+static void _test_list_str_eq(List a, List b)
+{
+	char *str;
+
+	if (!a && !b)
+		return;
+
+	ck_assert(a);
+	ck_assert(b);
+
+	ck_assert(list_count(a) == list_count(b));
+
+	ListIterator itr_a = list_iterator_create(a);
+	while ((str = list_next(itr_a)))
+		ck_assert(list_find_first(b, slurm_find_char_in_list, str));
+	list_iterator_destroy(itr_a);
+}
+
+static slurmdb_job_cond_t *_pack_unpack(uint16_t protocol_version,
+					slurmdb_job_cond_t *pack)
+{
+	int rc;
+	uint32_t len;
+	Buf buf = init_buf(1024);
+	slurmdb_job_cond_t *unpack;
+
+	slurmdb_pack_job_cond(pack, protocol_version, buf);
+	len = get_buf_offset(buf);
+	set_buf_offset(buf, 0);
+
+	rc = slurmdb_unpack_job_cond((void **)&unpack, protocol_version, buf);
+	ck_assert(rc == SLURM_SUCCESS);
+	/* Everything packed was unpacked, and nothing more */
+	ck_assert(get_buf_offset(buf) == len);
+	free_buf(buf);
+
+	return unpack;
+}
+
+/* Fields sent by every protocol version */
+static void _test_cond_eq(slurmdb_job_cond_t *pack,
+			  slurmdb_job_cond_t *unpack)
+{
+	slurmdb_selected_step_t *pack_step, *unpack_step;
+
+	ck_assert(pack->cpus_max == unpack->cpus_max);
+	ck_assert(pack->cpus_min == unpack->cpus_min);
+	ck_assert(pack->exitcode == unpack->exitcode);
+	ck_assert(pack->flags == unpack->flags);
+	ck_assert(pack->nodes_max == unpack->nodes_max);
+	ck_assert(pack->nodes_min == unpack->nodes_min);
+	ck_assert(pack->timelimit_max == unpack->timelimit_max);
+	ck_assert(pack->timelimit_min == unpack->timelimit_min);
+	ck_assert(pack->usage_end == unpack->usage_end);
+	ck_assert(pack->usage_start == unpack->usage_start);
+	ck_assert_str_eq(pack->used_nodes, unpack->used_nodes);
+
+	_test_list_str_eq(pack->acct_list, unpack->acct_list);
+	_test_list_str_eq(pack->associd_list, unpack->associd_list);
+	_test_list_str_eq(pack->cluster_list, unpack->cluster_list);
+	_test_list_str_eq(pack->format_list, unpack->format_list);
+	_test_list_str_eq(pack->groupid_list, unpack->groupid_list);
+	_test_list_str_eq(pack->jobname_list, unpack->jobname_list);
+	_test_list_str_eq(pack->partition_list, unpack->partition_list);
+	_test_list_str_eq(pack->qos_list, unpack->qos_list);
+	_test_list_str_eq(pack->resv_list, unpack->resv_list);
+	_test_list_str_eq(pack->resvid_list, unpack->resvid_list);
+	_test_list_str_eq(pack->state_list, unpack->state_list);
+	_test_list_str_eq(pack->userid_list, unpack->userid_list);
+	_test_list_str_eq(pack->wckey_list, unpack->wckey_list);
+
+	ck_assert(list_count(unpack->step_list) == 1);
+	pack_step = list_peek(pack->step_list);
+	unpack_step = list_peek(unpack->step_list);
+	ck_assert(pack_step->array_task_id == unpack_step->array_task_id);
+	ck_assert(pack_step->het_job_offset == unpack_step->het_job_offset);
+	ck_assert(pack_step->jobid == unpack_step->jobid);
+	ck_assert(pack_step->stepid == unpack_step->stepid);
+}
+
+START_TEST(pack_2002_job_cond)
+{
+	slurmdb_job_cond_t *pack = xmalloc(sizeof(slurmdb_job_cond_t));
+	slurmdb_job_cond_t *unpack;
+
+	_init_job_cond(pack);
+	unpack = _pack_unpack(SLURM_20_02_PROTOCOL_VERSION, pack);
+	_test_cond_eq(pack, unpack);
+	ck_assert(pack->db_flags == unpack->db_flags);
+	_test_list_str_eq(pack->constraint_list, unpack->constraint_list);
+	_test_list_str_eq(pack->reason_list, unpack->reason_list);
+
+	ck_assert(pack->chunk_size == unpack->chunk_size);
+	ck_assert_str_eq(pack->cursor_cluster, unpack->cursor_cluster);
+	ck_assert(pack->cursor_jobid == unpack->cursor_jobid);
+
+	slurmdb_destroy_job_cond(unpack);
+	slurmdb_destroy_job_cond(pack);
+}
+END_TEST
+
+/* A job_cond without a cursor asks for the first chunk */
+START_TEST(pack_2002_job_cond_no_cursor)
+{
+	slurmdb_job_cond_t *pack = xmalloc(sizeof(slurmdb_job_cond_t));
+	slurmdb_job_cond_t *unpack;
+
+	_init_job_cond(pack);
+	xfree(pack->cursor_cluster);
+	pack->cursor_jobid = 0;
+	unpack = _pack_unpack(SLURM_20_02_PROTOCOL_VERSION, pack);
+	_test_cond_eq(pack, unpack);
+	ck_assert(unpack->chunk_size == 1000);
+	ck_assert(unpack->cursor_cluster == NULL);
+	ck_assert(unpack->cursor_jobid == 0);
+
+	slurmdb_destroy_job_cond(unpack);
+	slurmdb_destroy_job_cond(pack);
+}
+END_TEST
+
+START_TEST(pack_2002_null_job_cond)
+{
+	slurmdb_job_cond_t *unpack;
+
+	unpack = _pack_unpack(SLURM_20_02_PROTOCOL_VERSION, NULL);
+	ck_assert(unpack->acct_list == NULL);
+	ck_assert(unpack->chunk_size == 0);
+	ck_assert(unpack->cluster_list == NULL);
+	ck_assert(unpack->cursor_cluster == NULL);
+	ck_assert(unpack->cursor_jobid == 0);
+	ck_assert(unpack->db_flags == SLURMDB_JOB_FLAG_NOTSET);
+	ck_assert(unpack->step_list == NULL);
+	ck_assert(unpack->used_nodes == NULL);
+
+	slurmdb_destroy_job_cond(unpack);
+}
+END_TEST
+
+/* Older peers know nothing of chunks, they always get all the jobs */
+START_TEST(pack_1905_job_cond)
+{
+	slurmdb_job_cond_t *pack = xmalloc(sizeof(slurmdb_job_cond_t));
+	slurmdb_job_cond_t *unpack;
+
+	_init_job_cond(pack);
+	unpack = _pack_unpack(SLURM_19_05_PROTOCOL_VERSION, pack);
+	_test_cond_eq(pack, unpack);
+	ck_assert(pack->db_flags == unpack->db_flags);
+	_test_list_str_eq(pack->constraint_list, unpack->constraint_list);
+	_test_list_str_eq(pack->reason_list, unpack->reason_list);
+
+	ck_assert(unpack->chunk_size == 0);
+	ck_assert(unpack->cursor_cluster == NULL);
+	ck_assert(unpack->cursor_jobid == 0);
+
+	slurmdb_destroy_job_cond(unpack);
+	slurmdb_destroy_job_cond(pack);
+}
+END_TEST
+
+START_TEST(pack_MIN_job_cond)
+{
+	slurmdb_job_cond_t *pack = xmalloc(sizeof(slurmdb_job_cond_t));
+	slurmdb_job_cond_t *unpack;
+
+	_init_job_cond(pack);
+	unpack = _pack_unpack(SLURM_MIN_PROTOCOL_VERSION, pack);
+	_test_cond_eq(pack, unpack);
+
+	ck_assert(unpack->chunk_size == 0);
+	ck_assert(unpack->cursor_cluster == NULL);
+	ck_assert(unpack->cursor_jobid == 0);
+
+	slurmdb_destroy_job_cond(unpack);
+	slurmdb_destroy_job_cond(pack);
+}
+END_TEST
+
+/*****************************************************************************
+ * TEST SUITE                                                                *
+ ****************************************************************************/
+
+Suite *suite(void)
+{
+	Suite *s = suite_create("Pack slurmdb_job_cond_t");
+	TCase *tc_core = tcase_create("Pack slurmdb_job_cond_t");
+	tcase_add_test(tc_core, invalid_protocol);
+	tcase_add_test(tc_core, pack_2002_job_cond);
+	tcase_add_test(tc_core, pack_2002_job_cond_no_cursor);
+	tcase_add_test(tc_core, pack_2002_null_job_cond);
+	tcase_add_test(tc_core, pack_1905_job_cond);
+	tcase_add_test(tc_core, pack_MIN_job_cond);
+	suite_add_tcase(s, tc_core);
+	return s;
+}
+
+/*****************************************************************************
+ * TEST RUNNER                                                               *
+ ****************************************************************************/
+
+int main(void)
+{
+	int number_failed;
+	SRunner *sr = srunner_create(suite());
+
+	srunner_run_all(sr, CK_VERBOSE);
+	number_failed = srunner_ntests_failed(sr);
+	srunner_free(sr);
+
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}